@@ -103,6 +103,9 @@ class TestHadrwareMethods(unittest.TestCase):
     def test_hrt(self):
         self.assertTrue(do_test(self.TEST_DEVICE, self.TEST_BAUDRATE, "hrt"))
 
+    def test_IntrusiveMPSCQueue(self):
+        self.assertTrue(do_test(self.TEST_DEVICE, self.TEST_BAUDRATE, "IntrusiveMPSCQueue"))
+
     def test_IntrusiveQueue(self):
         self.assertTrue(do_test(self.TEST_DEVICE, self.TEST_BAUDRATE, "IntrusiveQueue"))
 
@@ -115,6 +118,9 @@ class TestHadrwareMethods(unittest.TestCase):
     def test_matrix(self):
         self.assertTrue(do_test(self.TEST_DEVICE, self.TEST_BAUDRATE, "matrix"))
 
+    def test_microbench_filter(self):
+        self.assertTrue(do_test(self.TEST_DEVICE, self.TEST_BAUDRATE, "microbench_filter"))
+
     def test_microbench_hrt(self):
         self.assertTrue(do_test(self.TEST_DEVICE, self.TEST_BAUDRATE, "microbench_hrt"))
 
@@ -157,6 +163,9 @@ class TestHadrwareMethods(unittest.TestCase):
     def test_versioning(self):
         self.assertTrue(do_test(self.TEST_DEVICE, self.TEST_BAUDRATE, "versioning"))
 
+    def test_WorkQueue(self):
+        self.assertTrue(do_test(self.TEST_DEVICE, self.TEST_BAUDRATE, "WorkQueue"))
+
 def main():
     parser = ArgumentParser(description=__doc__)
     parser.add_argument('--device', "-d", nargs='?', default = None, help='')
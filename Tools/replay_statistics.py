@@ -0,0 +1,116 @@
+#! /usr/bin/env python3
+"""
+Aggregates the innovation test ratio statistics written by EKF2 replay (replay_ekf2_statistics.csv).
+
+Each given directory is one candidate (e.g. one parameter set), and contains the working directories
+of the replays that were run with it. The statistics of all replays found below a directory are
+combined, weighted by the number of samples.
+
+Running the replays is left to the caller. uORB, the parameters and the replay clock are global to a
+px4 process, so every replay needs its own px4 instance and working directory.
+
+Example:
+    Tools/replay_statistics.py -o statistics.csv sweep/candidate_a sweep/candidate_b
+"""
+
+import argparse
+import csv
+import glob
+import math
+import os
+import sys
+
+STATISTICS_FILE = 'replay_ekf2_statistics.csv'
+
+
+def get_arguments():
+    parser = argparse.ArgumentParser(description='Aggregate EKF2 replay innovation statistics')
+    parser.add_argument('directories', nargs='+',
+                        help='one directory per candidate, searched recursively for ' + STATISTICS_FILE)
+    parser.add_argument('-o', '--output', default=None,
+                        help='write the per replay and aggregated statistics to this CSV file')
+    return parser.parse_args()
+
+
+def read_statistics(file_name):
+    """ returns {test ratio name: (samples, mean, rms, max, rejected)} """
+    statistics = {}
+    with open(file_name, 'r') as csv_file:
+        for row in csv.DictReader(csv_file):
+            statistics[row['test_ratio']] = (int(row['samples']), float(row['mean']), float(row['rms']),
+                                             float(row['max']), int(row['rejected']))
+    return statistics
+
+
+def combine_statistics(statistics_list):
+    """ combine the statistics of several replays into one (weighted by the number of samples) """
+    combined = {}
+    for statistics in statistics_list:
+        for name, (samples, mean, rms, max_value, rejected) in statistics.items():
+            total = combined.setdefault(name, [0, 0., 0., 0., 0])
+            total[0] += samples
+            total[1] += mean * samples
+            total[2] += rms * rms * samples
+            total[3] = max(total[3], max_value)
+            total[4] += rejected
+
+    result = {}
+    for name, (samples, sum_mean, sum_sq, max_value, rejected) in combined.items():
+        if samples > 0:
+            result[name] = (samples, sum_mean / samples, math.sqrt(sum_sq / samples), max_value, rejected)
+        else:
+            result[name] = (0, 0., 0., 0., 0)
+    return result
+
+
+def write_statistics(file_name, rows):
+    with open(file_name, 'w', newline='') as csv_file:
+        writer = csv.writer(csv_file)
+        writer.writerow(['candidate', 'replay', 'test_ratio', 'samples', 'mean', 'rms', 'max', 'rejected'])
+        for candidate, replay, statistics in rows:
+            for name, (samples, mean, rms, max_value, rejected) in sorted(statistics.items()):
+                writer.writerow([candidate, replay, name, samples, '{:.6f}'.format(mean),
+                                 '{:.6f}'.format(rms), '{:.6f}'.format(max_value), rejected])
+
+
+def main() -> None:
+
+    args = get_arguments()
+
+    rows = []
+
+    for directory in args.directories:
+        candidate = os.path.basename(os.path.normpath(directory))
+        files = sorted(glob.glob(os.path.join(directory, '**', STATISTICS_FILE), recursive=True))
+
+        if not files:
+            print('{:s}: no {:s} found'.format(directory, STATISTICS_FILE), file=sys.stderr)
+            continue
+
+        replays = []
+        for file_name in files:
+            replay = os.path.relpath(os.path.dirname(file_name), directory)
+            statistics = read_statistics(file_name)
+            replays.append(statistics)
+            rows.append((candidate, replay, statistics))
+
+        combined = combine_statistics(replays)
+        rows.append((candidate, '*', combined))
+
+        print('')
+        print('{:s} ({:d} replays): test ratio, samples, mean, rms, max, rejected'.format(candidate, len(files)))
+        for name, (samples, mean, rms, max_value, rejected) in sorted(combined.items()):
+            if samples > 0:
+                print('  {:5s} {:9d} {:7.3f} {:7.3f} {:8.3f} {:7d}'.format(name, samples, mean, rms, max_value, rejected))
+
+    if not rows:
+        sys.exit('no statistics found')
+
+    if args.output:
+        write_statistics(args.output, rows)
+        print('')
+        print('statistics written to {:s}'.format(args.output))
+
+
+if __name__ == '__main__':
+    main()
@@ -37,8 +37,13 @@ if [ "$model" != none ]; then
 fi
 
 if [ "$model" == "" ] || [ "$model" == "none" ]; then
-	echo "empty model, setting iris as default"
-	model="iris"
+	if [ "$program" == "sih" ]; then
+		echo "empty model, setting sihquad as default"
+		model="sihquad"
+	else
+		echo "empty model, setting iris as default"
+		model="iris"
+	fi
 fi
 
 if [ "$#" -lt 6 ]; then
@@ -111,6 +116,12 @@ echo SITL COMMAND: $sitl_command
 
 export PX4_SIM_MODEL=${model}
 
+if [ "$program" == "sih" ]; then
+	# headless lockstep simulation inside PX4 (no simulator link),
+	# PX4_SIM_SPEED_FACTOR limits the speed (default: as fast as possible)
+	export PX4_SIMULATOR=sih
+fi
+
 
 if [[ -n "$DONT_RUN" ]]; then
 	echo "Not running simulation (\$DONT_RUN is set)."
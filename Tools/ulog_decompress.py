@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+
+"""
+Convert a compressed ULog container (.ulgz, written with SDLOG_COMPRESS=1) back into a
+regular ULog file. See src/lib/ulog_compression/ulog_block_format.h for the format.
+
+The blocks are read sequentially, so incompletely written files (no trailer) are converted
+up to the last complete block.
+"""
+
+from __future__ import print_function
+import argparse
+import os
+import struct
+import sys
+
+FILE_MAGIC = b'ULogZ\x01\x12'
+BLOCK_MAGIC = b'UB'
+FILE_HEADER_LEN = 16
+BLOCK_HEADER_LEN = 12
+
+BLOCK_STORED = 0
+BLOCK_COMPRESSED = 1
+BLOCK_INDEX = 2
+
+
+def lz4_decompress_block(src, raw_size):
+    """ decompress an LZ4 block """
+    dst = bytearray()
+    ip = 0
+
+    def read_length(ip, length):
+        while True:
+            b = src[ip]
+            ip += 1
+            length += b
+            if b != 255:
+                return ip, length
+
+    while ip < len(src):
+        token = src[ip]
+        ip += 1
+        literal_length = token >> 4
+        if literal_length == 15:
+            ip, literal_length = read_length(ip, literal_length)
+        dst += src[ip:ip + literal_length]
+        ip += literal_length
+        if ip >= len(src):
+            break
+        offset = src[ip] | (src[ip + 1] << 8)
+        ip += 2
+        match_length = token & 15
+        if match_length == 15:
+            ip, match_length = read_length(ip, match_length)
+        match_length += 4
+        if offset == 0 or offset > len(dst):
+            raise ValueError('invalid match offset')
+        start = len(dst) - offset
+        if offset >= match_length:
+            dst += dst[start:start + match_length]
+        else:
+            for i in range(match_length):
+                dst.append(dst[start + i])
+
+    if len(dst) != raw_size:
+        raise ValueError('unexpected block size')
+    return bytes(dst)
+
+
+def decompress(input_file, output_file):
+    """ convert a compressed ULog container, returns the number of data blocks """
+    with open(input_file, 'rb') as f:
+        data = f.read()
+
+    if len(data) < FILE_HEADER_LEN or data[:7] != FILE_MAGIC:
+        raise ValueError('not a compressed ULog file')
+
+    version, _block_size, codec = struct.unpack_from('<BIB', data, 7)
+    if version != 1 or codec != 1:
+        raise ValueError('unsupported version {:} / codec {:}'.format(version, codec))
+
+    num_blocks = 0
+    offset = FILE_HEADER_LEN
+    with open(output_file, 'wb') as out:
+        while offset + BLOCK_HEADER_LEN <= len(data):
+            magic, block_type, _, size, raw_size = struct.unpack_from('<2sBBII', data, offset)
+            payload_start = offset + BLOCK_HEADER_LEN
+            if magic != BLOCK_MAGIC or payload_start + size > len(data):
+                break  # trailer or incompletely written block
+            payload = data[payload_start:payload_start + size]
+            if block_type == BLOCK_STORED:
+                out.write(payload)
+                num_blocks += 1
+            elif block_type == BLOCK_COMPRESSED:
+                out.write(lz4_decompress_block(payload, raw_size))
+                num_blocks += 1
+            offset = payload_start + size
+
+    return num_blocks
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decompress a compressed ULog file (.ulgz)')
+    parser.add_argument('input', help='compressed log file')
+    parser.add_argument('output', nargs='?', help='output ULog file (default: input with .ulg extension)')
+    args = parser.parse_args()
+
+    output = args.output
+    if output is None:
+        output = os.path.splitext(args.input)[0] + '.ulg'
+        if output == args.input:
+            output = os.path.splitext(args.input)[0] + '_decompressed.ulg'
+
+    try:
+        num_blocks = decompress(args.input, output)
+    except (IOError, ValueError) as e:
+        print('Error: {:}'.format(e))
+        sys.exit(1)
+
+    print('Wrote {:} ({:} blocks)'.format(output, num_blocks))
+
+
+if __name__ == '__main__':
+    main()
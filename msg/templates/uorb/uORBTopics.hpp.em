@@ -0,0 +1,71 @@
+@###############################################
+@#
+@# EmPy template for generating uORBTopics.hpp file
+@# with the compile-time topic ids
+@#
+@###############################################
+@# Start of Template
+@#
+@# Context:
+@#  - msgs (List) list of all msg files
+@#  - multi_topics (List) list of all multi-topic names
+@###############################################
+/****************************************************************************
+ *
+ *   Copyright (C) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+@{
+msg_names = [mn.replace(".msg", "") for mn in msgs]
+msg_names_all = sorted(list(set(msg_names + multi_topics))) # set() filters duplicates, sorted() keeps ids stable
+msgs_count_all = len(msg_names_all)
+if msgs_count_all >= 255:
+    raise Exception('too many uORB topics (%i), ORB_ID is limited to uint8_t' % msgs_count_all)
+}@
+
+static constexpr size_t ORB_TOPICS_COUNT{@(msgs_count_all)};
+
+/*
+ * Compile-time id of every generated topic, used by the uORB::DeviceMaster
+ * node table. The id is equal to the index in the array of orb_get_topics().
+ * Topics that are not generated from msg/ (e.g. uORB tests) use INVALID.
+ */
+enum class ORB_ID : uint8_t {
+@[for idx, msg_name in enumerate(msg_names_all)]@
+	@(msg_name) = @(idx),
+@[end for]@
+	INVALID
+};
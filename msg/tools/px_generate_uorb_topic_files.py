@@ -72,7 +72,7 @@ __email__ = "thomasgubler@gmail.com"
 
 
 TEMPLATE_FILE = ['msg.h.em', 'msg.cpp.em']
-TOPICS_LIST_TEMPLATE_FILE = 'uORBTopics.cpp.em'
+TOPICS_LIST_TEMPLATE_FILE = ['uORBTopics.hpp.em', 'uORBTopics.cpp.em']
 OUTPUT_FILE_EXT = ['.h', '.cpp']
 INCL_DEFAULT = ['std_msgs:./msg/std_msgs']
 PACKAGE = 'px4'
@@ -433,37 +433,40 @@ def convert_dir_save(format_idx, inputdir, outputdir, package, templatedir, temp
     """
     # Create new headers in temporary output directory
     convert_dir(format_idx, inputdir, temporarydir, package, templatedir)
-    if generate_idx == 1:
-        generate_topics_list_file(inputdir, temporarydir, templatedir)
+    generate_topics_list_file(format_idx, inputdir, temporarydir, templatedir)
     # Copy changed headers from temporary dir to output dir
     copy_changed(temporarydir, outputdir, prefix, quiet)
 
 
-def generate_topics_list_file(msgdir, outputdir, templatedir):
-    # generate cpp file with topics list
+def generate_topics_list_file(format_idx, msgdir, outputdir, templatedir):
+    # generate cpp file with topics list (or hpp file with topic ids)
     msgs = get_msgs_list(msgdir)
     multi_topics = []
     for msg in msgs:
         msg_filename = os.path.join(msgdir, msg)
         multi_topics.extend(get_multi_topics(msg_filename))
     tl_globals = {"msgs": msgs, "multi_topics": multi_topics}
-    tl_template_file = os.path.join(templatedir, TOPICS_LIST_TEMPLATE_FILE)
+    tl_template_file = os.path.join(templatedir, TOPICS_LIST_TEMPLATE_FILE[format_idx])
+    if not os.path.isfile(tl_template_file):
+        return
     tl_out_file = os.path.join(
-        outputdir, TOPICS_LIST_TEMPLATE_FILE.replace(".em", ""))
+        outputdir, TOPICS_LIST_TEMPLATE_FILE[format_idx].replace(".em", ""))
     generate_by_template(tl_out_file, tl_template_file, tl_globals)
 
 
-def generate_topics_list_file_from_files(files, outputdir, templatedir):
-    # generate cpp file with topics list
+def generate_topics_list_file_from_files(format_idx, files, outputdir, templatedir):
+    # generate cpp file with topics list (or hpp file with topic ids)
     filenames = [os.path.basename(
         p) for p in files if os.path.basename(p).endswith(".msg")]
     multi_topics = []
     for msg_filename in files:
         multi_topics.extend(get_multi_topics(msg_filename))
     tl_globals = {"msgs": filenames, "multi_topics": multi_topics}
-    tl_template_file = os.path.join(templatedir, TOPICS_LIST_TEMPLATE_FILE)
+    tl_template_file = os.path.join(templatedir, TOPICS_LIST_TEMPLATE_FILE[format_idx])
+    if not os.path.isfile(tl_template_file):
+        return
     tl_out_file = os.path.join(
-        outputdir, TOPICS_LIST_TEMPLATE_FILE.replace(".em", ""))
+        outputdir, TOPICS_LIST_TEMPLATE_FILE[format_idx].replace(".em", ""))
     generate_by_template(tl_out_file, tl_template_file, tl_globals)
 
 
@@ -520,9 +523,14 @@ if __name__ == "__main__":
         for f in args.file:
             generate_output_from_file(
                 generate_idx, f, args.temporarydir, args.package, args.templatedir, INCL_DEFAULT)
-        if generate_idx == 1:
+        if generate_idx == 0:
+            # the topic ids header goes through the temporary dir, so that
+            # unchanged ids do not trigger a full rebuild
             generate_topics_list_file_from_files(
-                args.file, args.outputdir, args.templatedir)
+                generate_idx, args.file, args.temporarydir, args.templatedir)
+        else:
+            generate_topics_list_file_from_files(
+                generate_idx, args.file, args.outputdir, args.templatedir)
         copy_changed(args.temporarydir, args.outputdir,
                      args.prefix, args.quiet)
     elif args.dir is not None:
@@ -36,7 +36,8 @@
 #include "WorkQueueManager.hpp"
 #include "WorkQueue.hpp"
 
-#include <containers/IntrusiveQueue.hpp>
+#include <containers/IntrusiveMPSCQueue.hpp>
+#include <px4_platform_common/atomic.h>
 #include <px4_platform_common/defines.h>
 #include <drivers/drv_hrt.h>
 
@@ -45,7 +46,7 @@
 namespace px4
 {
 
-class WorkItem : public ListNode<WorkItem *>, public IntrusiveQueueNode<WorkItem *>
+class WorkItem : public ListNode<WorkItem *>, public IntrusiveMPSCQueueNode<WorkItem *>
 {
 public:
 
@@ -59,9 +60,16 @@ public:
 
 	inline void ScheduleNow()
 	{
-		if (_wq != nullptr) {
-			_wq->Add(this);
+		// Deinit() waits for calls in progress, so the item is not added after it was removed
+		_schedule_now_active.fetch_add(1);
+
+		WorkQueue *wq = _wq.load();
+
+		if (wq != nullptr) {
+			wq->Add(this);
 		}
+
+		_schedule_now_active.fetch_sub(1);
 	}
 
 	virtual void print_run_status() const;
@@ -110,7 +118,8 @@ protected:
 
 private:
 
-	WorkQueue	*_wq{nullptr};
+	px4::atomic<WorkQueue *>	_wq{nullptr};
+	px4::atomic_int			_schedule_now_active{0};	///< ScheduleNow() calls in progress
 
 };
 
@@ -37,7 +37,8 @@
 
 #include <containers/BlockingList.hpp>
 #include <containers/List.hpp>
-#include <containers/IntrusiveQueue.hpp>
+#include <containers/IntrusiveMPSCQueue.hpp>
+#include <drivers/drv_hrt.h>
 #include <px4_platform_common/atomic.h>
 #include <px4_platform_common/defines.h>
 #include <px4_platform_common/sem.h>
@@ -58,6 +59,12 @@ public:
 
 	const char *get_name() { return _config.name; }
 
+	const wq_config_t &get_config() const { return _config; }
+
+#if defined(__PX4_LINUX)
+	pid_t get_tid() const { return _tid; }
+#endif
+
 	bool Attach(WorkItem *item);
 	void Detach(WorkItem *item);
 
@@ -78,8 +85,10 @@ private:
 
 	inline void signal_worker_thread();
 
+	void update_latency(uint32_t latency);
+
+	// Add() is lock-free, the lock serializes the consumer side of the queue (pop, remove) and Attach/Detach
 #ifdef __PX4_NUTTX
-	// In NuttX work can be enqueued from an ISR
 	void work_lock() { _flags = enter_critical_section(); }
 	void work_unlock() { leave_critical_section(_flags); }
 	irqstate_t _flags;
@@ -89,12 +98,24 @@ private:
 	px4_sem_t _qlock;
 #endif
 
-	IntrusiveQueue<WorkItem *>	_q;
+	IntrusiveMPSCQueue<WorkItem *>	_q;
 	px4_sem_t			_process_lock;
+	px4::atomic_bool		_worker_waiting{false};
 	const wq_config_t		&_config;
 	BlockingList<WorkItem *>	_work_items;
 	px4::atomic_bool		_should_exit{false};
 
+	// run latency: time from the first Add() to the start of the next item run
+	px4::atomic<uint32_t>		_time_queued{0}; // lower 32 bits of hrt_absolute_time(), 0 if not set
+	uint32_t			_latency_count{0};
+	uint32_t			_latency_max{0};
+	float				_latency_mean{0.f};
+	float				_latency_M2{0.f};
+
+#if defined(__PX4_LINUX)
+	pid_t				_tid {-1};
+#endif
+
 };
 
 } // namespace px4
@@ -44,6 +44,7 @@ struct wq_config_t {
 	const char *name;
 	uint16_t stacksize;
 	int8_t relative_priority; // relative to max
+	uint32_t cpu_affinity{0}; // bitmask of CPUs the thread may run on (Linux only), 0: not restricted
 };
 
 namespace wq_configurations
@@ -67,6 +68,12 @@ static constexpr wq_config_t I2C4{"wq:I2C4", 1400, -12};
 // PX4 att/pos controllers, highest priority after sensors.
 static constexpr wq_config_t att_pos_ctrl{"wq:att_pos_ctrl", 7200, -13};
 
+// estimator instances (ekf2 multi-instance mode), one per IMU. Same priority as att_pos_ctrl, where a single ekf2
+// instance runs, so the priorities of all other queues are unchanged.
+static constexpr wq_config_t INS0{"wq:INS0", 6000, -13};
+static constexpr wq_config_t INS1{"wq:INS1", 6000, -13};
+static constexpr wq_config_t INS2{"wq:INS2", 6000, -13};
+
 static constexpr wq_config_t hp_default{"wq:hp_default", 1900, -14};
 
 static constexpr wq_config_t uavcan{"wq:uavcan", 2400, -15};
@@ -104,6 +111,19 @@ int WorkQueueManagerStop();
  */
 int WorkQueueManagerStatus();
 
+/**
+ * Reserve CPUs for the real-time work queues (Linux only).
+ *
+ * Work queues with a priority of at least INS2 (rate_ctrl, SPI, I2C,
+ * att_pos_ctrl, INS) are pinned to the isolated CPUs, all other threads of the
+ * process (and the threads they create later) are moved to the remaining CPUs.
+ * A cpu_affinity set in the work queue configuration takes precedence.
+ *
+ * @param cpus		Bitmask of the CPUs to isolate.
+ * @return		PX4_OK on success.
+ */
+int WorkQueueManagerIsolateCpus(uint32_t cpus);
+
 /**
  * Create (or find) a work queue with a particular configuration.
  *
@@ -128,5 +148,13 @@ const wq_config_t &device_bus_to_wq(uint32_t device_id);
  */
 const wq_config_t &serial_port_to_wq(const char *serial);
 
+/**
+ * Map an estimator instance to a work queue.
+ *
+ * @param instance		The estimator instance (0 based).
+ * @return		A work queue configuration.
+ */
+const wq_config_t &ins_instance_to_wq(uint8_t instance);
+
 
 } // namespace px4
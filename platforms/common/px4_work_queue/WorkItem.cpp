@@ -37,6 +37,7 @@
 #include <px4_platform_common/px4_work_queue/WorkQueueManager.hpp>
 
 #include <px4_platform_common/log.h>
+#include <px4_platform_common/time.h>
 #include <drivers/drv_hrt.h>
 
 namespace px4
@@ -64,7 +65,7 @@ WorkItem::Init(const wq_config_t &config)
 	px4::WorkQueue *wq = WorkQueueFindOrCreate(config);
 
 	if ((wq != nullptr) && wq->Attach(this)) {
-		_wq = wq;
+		_wq.store(wq);
 		_start_time = hrt_absolute_time();
 		return true;
 	}
@@ -77,10 +78,17 @@ void
 WorkItem::Deinit()
 {
 	// remove any currently queued work
-	if (_wq != nullptr) {
+	px4::WorkQueue *wq_temp = _wq.load();
+
+	if (wq_temp != nullptr) {
 		// prevent additional insertions
-		px4::WorkQueue *wq_temp = _wq;
-		_wq = nullptr;
+		_wq.store(nullptr);
+
+		// ScheduleNow() calls that read _wq before it was cleared might not have added the item yet,
+		// wait for them so that it is not left on the queue after removal
+		while (_schedule_now_active.load() != 0) {
+			system_usleep(1);
+		}
 
 		// remove any queued work
 		wq_temp->Remove(this);
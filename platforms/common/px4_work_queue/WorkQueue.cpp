@@ -34,8 +34,15 @@
 #include <px4_platform_common/px4_work_queue/WorkQueue.hpp>
 #include <px4_platform_common/px4_work_queue/WorkItem.hpp>
 
+#include <math.h>
 #include <string.h>
 
+#if defined(__PX4_LINUX)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include <px4_platform_common/tasks.h>
 #include <px4_platform_common/time.h>
 #include <drivers/drv_hrt.h>
@@ -53,6 +60,10 @@ WorkQueue::WorkQueue(const wq_config_t &config) :
 	pthread_setname_np(pthread_self(), _config.name);
 #endif
 
+#if defined(__PX4_LINUX)
+	_tid = syscall(SYS_gettid);
+#endif
+
 #ifndef __PX4_NUTTX
 	px4_sem_init(&_qlock, 0, 1);
 #endif /* __PX4_NUTTX */
@@ -108,11 +119,23 @@ WorkQueue::Detach(WorkItem *item)
 void
 WorkQueue::Add(WorkItem *item)
 {
-	work_lock();
-	_q.push(item);
-	work_unlock();
+	// lock-free, the queue ignores items that are already queued
+	if (!_q.push(item)) {
+		return;
+	}
+
+	if (_time_queued.load() == 0) {
+		uint32_t expected = 0;
+		const uint32_t now = hrt_absolute_time();
+		_time_queued.compare_exchange(&expected, (now != 0) ? now : 1);
+	}
+
+	// only post the semaphore if the worker thread is (about to be) sleeping
+	bool waiting = true;
 
-	signal_worker_thread();
+	if (_worker_waiting.load() && _worker_waiting.compare_exchange(&waiting, false)) {
+		px4_sem_post(&_process_lock);
+	}
 }
 
 void
@@ -149,31 +172,82 @@ void
 WorkQueue::Run()
 {
 	while (!should_exit()) {
-		px4_sem_wait(&_process_lock);
-
 		work_lock();
+		WorkItem *work = _q.pop();
+		work_unlock();
+
+		if (work == nullptr) {
+			// Announce that the worker goes to sleep, then check again for items pushed
+			// in the meantime. A producer either sees the flag (and posts), or its item is
+			// seen here.
+			_worker_waiting.store(true);
 
-		// process queued work
-		while (!_q.empty()) {
-			WorkItem *work = _q.pop();
+			if (_q.pending()) {
+				_worker_waiting.store(false);
 
-			work_unlock(); // unlock work queue to run (item may requeue itself)
-			work->RunPreamble();
-			work->Run();
-			work_lock(); // re-lock
+			} else {
+				px4_sem_wait(&_process_lock);
+			}
+
+			continue;
 		}
 
-		work_unlock();
+		uint32_t time_queued = _time_queued.load();
+
+		if ((time_queued != 0) && _time_queued.compare_exchange(&time_queued, 0)) {
+			update_latency((uint32_t)hrt_absolute_time() - time_queued);
+		}
+
+		work->RunPreamble();
+		work->Run();
 	}
 
 	PX4_DEBUG("%s: exiting", _config.name);
 }
 
+void
+WorkQueue::update_latency(uint32_t latency)
+{
+	_latency_count++;
+
+	if (latency > _latency_max) {
+		_latency_max = latency;
+	}
+
+	// Knuth/Welford recursive mean and variance
+	const float delta = latency - _latency_mean;
+	_latency_mean += delta / _latency_count;
+	_latency_M2 += delta * (latency - _latency_mean);
+}
+
 void
 WorkQueue::print_status(bool last)
 {
 	const size_t num_items = _work_items.size();
-	PX4_INFO_RAW("%-16s\n", get_name());
+	const float jitter = (_latency_count > 1) ? sqrtf(_latency_M2 / (_latency_count - 1)) : 0.f;
+
+	PX4_INFO_RAW("%-16s latency %6.1f us avg, %6u us max, %6.1f us jitter", get_name(),
+		     (double)_latency_mean, (unsigned)_latency_max, (double)jitter);
+
+#if defined(__PX4_LINUX)
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+
+	if (sched_getaffinity(_tid, sizeof(cpus), &cpus) == 0) {
+		uint32_t cpu_mask = 0;
+
+		for (int cpu = 0; cpu < 32; cpu++) {
+			if (CPU_ISSET(cpu, &cpus)) {
+				cpu_mask |= 1u << cpu;
+			}
+		}
+
+		PX4_INFO_RAW(", cpus 0x%02x", (unsigned)cpu_mask);
+	}
+
+#endif
+
+	PX4_INFO_RAW("\n");
 	size_t i = 0;
 
 	for (WorkItem *item : _work_items) {
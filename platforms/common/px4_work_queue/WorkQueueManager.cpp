@@ -48,6 +48,13 @@
 #include <limits.h>
 #include <string.h>
 
+#if defined(__PX4_LINUX)
+#include <dirent.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
 using namespace time_literals;
 
 namespace px4
@@ -61,6 +68,45 @@ static BlockingQueue<const wq_config_t *, 1> *_wq_manager_create_queue{nullptr};
 
 static px4::atomic_bool _wq_manager_should_exit{true};
 
+#if defined(__PX4_LINUX)
+// CPUs reserved for the real-time work queues (0: no isolation)
+static px4::atomic<uint32_t> _wq_manager_isolated_cpus{0};
+
+static bool
+WorkQueueIsRealtime(const wq_config_t &config)
+{
+	return config.relative_priority >= wq_configurations::INS2.relative_priority;
+}
+
+static uint32_t
+WorkQueueCpuAffinity(const wq_config_t &config)
+{
+	if (config.cpu_affinity != 0) {
+		return config.cpu_affinity;
+	}
+
+	const uint32_t isolated_cpus = _wq_manager_isolated_cpus.load();
+
+	if (isolated_cpus == 0) {
+		return 0;
+	}
+
+	return WorkQueueIsRealtime(config) ? isolated_cpus : ~isolated_cpus;
+}
+
+static void
+CpuMaskToSet(uint32_t cpu_mask, cpu_set_t *cpus)
+{
+	CPU_ZERO(cpus);
+
+	for (int cpu = 0; cpu < 32; cpu++) {
+		if (cpu_mask & (1u << cpu)) {
+			CPU_SET(cpu, cpus);
+		}
+	}
+}
+#endif // __PX4_LINUX
+
 
 static WorkQueue *
 FindWorkQueueByName(const char *name)
@@ -201,6 +247,22 @@ serial_port_to_wq(const char *serial)
 	return wq_configurations::UART_UNKNOWN;
 }
 
+const wq_config_t &
+ins_instance_to_wq(uint8_t instance)
+{
+	switch (instance) {
+	case 0: return wq_configurations::INS0;
+
+	case 1: return wq_configurations::INS1;
+
+	case 2: return wq_configurations::INS2;
+	}
+
+	PX4_WARN("no INS%d wq configuration, using INS0", instance);
+
+	return wq_configurations::INS0;
+}
+
 static void *
 WorkQueueRunner(void *context)
 {
@@ -263,6 +325,29 @@ WorkQueueManagerRun(int, char **)
 				PX4_ERR("setting stack size for %s failed (%i)", wq->name, ret_setstacksize);
 			}
 
+#if defined(__PX4_LINUX)
+			// use the policy and priority below instead of inheriting them from the wq:manager task
+			int ret_setinheritsched = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+
+			if (ret_setinheritsched != 0) {
+				PX4_ERR("setting inherit sched for %s failed (%i)", wq->name, ret_setinheritsched);
+			}
+
+			// CPU affinity
+			const uint32_t cpu_affinity = WorkQueueCpuAffinity(*wq);
+
+			if (cpu_affinity != 0) {
+				cpu_set_t cpus;
+				CpuMaskToSet(cpu_affinity, &cpus);
+				int ret_setaffinity = pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+
+				if (ret_setaffinity != 0) {
+					PX4_ERR("setting cpu affinity 0x%x for %s failed (%i)", (unsigned)cpu_affinity, wq->name, ret_setaffinity);
+				}
+			}
+
+#endif // __PX4_LINUX
+
 #ifndef __PX4_QURT
 
 			// schedule policy FIFO
@@ -286,6 +371,17 @@ WorkQueueManagerRun(int, char **)
 			pthread_t thread;
 			int ret_create = pthread_create(&thread, &attr, WorkQueueRunner, (void *)wq);
 
+#if defined(__PX4_LINUX)
+
+			if (ret_create == EPERM) {
+				// not allowed to use real-time scheduling (not running as root), keep everything else
+				PX4_DEBUG("no permission for SCHED_FIFO, %s inherits the scheduling policy", wq->name);
+				pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+				ret_create = pthread_create(&thread, &attr, WorkQueueRunner, (void *)wq);
+			}
+
+#endif // __PX4_LINUX
+
 			if (ret_create == 0) {
 				PX4_DEBUG("starting: %s, priority: %d, stack: %zu bytes", wq->name, param.sched_priority, stacksize);
 
@@ -384,6 +480,69 @@ WorkQueueManagerStop()
 	return PX4_OK;
 }
 
+int
+WorkQueueManagerIsolateCpus(uint32_t cpus)
+{
+#if defined(__PX4_LINUX)
+	const long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	const uint32_t online_cpus = (num_cpus >= 32) ? UINT32_MAX : ((1u << num_cpus) - 1);
+
+	if ((cpus & online_cpus) == 0 || (~cpus & online_cpus) == 0) {
+		PX4_ERR("invalid cpu set 0x%x (%ld cpus online)", (unsigned)cpus, num_cpus);
+		return PX4_ERROR;
+	}
+
+	_wq_manager_isolated_cpus.store(cpus);
+
+	// move all threads of the process off the isolated CPUs. Threads inherit the
+	// affinity of their creator, so tasks spawned later stay off as well.
+	cpu_set_t others;
+	CpuMaskToSet(~cpus, &others);
+
+	DIR *dir = opendir("/proc/self/task");
+
+	if (dir == nullptr) {
+		PX4_ERR("failed to open /proc/self/task");
+		return PX4_ERROR;
+	}
+
+	struct dirent *entry;
+
+	while ((entry = readdir(dir)) != nullptr) {
+		if (entry->d_name[0] != '.') {
+			const pid_t tid = atoi(entry->d_name);
+
+			// ESRCH: the thread exited in the meantime
+			if (sched_setaffinity(tid, sizeof(others), &others) != 0 && errno != ESRCH) {
+				PX4_WARN("setting cpu affinity for thread %i failed (%i)", tid, errno);
+			}
+		}
+	}
+
+	closedir(dir);
+
+	// then pin the existing work queues
+	if (_wq_manager_wqs_list != nullptr) {
+		LockGuard lg{_wq_manager_wqs_list->mutex()};
+
+		for (WorkQueue *wq : *_wq_manager_wqs_list) {
+			cpu_set_t wq_cpus;
+			CpuMaskToSet(WorkQueueCpuAffinity(wq->get_config()), &wq_cpus);
+
+			if (sched_setaffinity(wq->get_tid(), sizeof(wq_cpus), &wq_cpus) != 0) {
+				PX4_ERR("setting cpu affinity for %s failed (%i)", wq->get_name(), errno);
+			}
+		}
+	}
+
+	return PX4_OK;
+#else
+	(void)cpus;
+	PX4_ERR("not supported");
+	return PX4_ERROR;
+#endif // __PX4_LINUX
+}
+
 int
 WorkQueueManagerStatus()
 {
@@ -58,14 +58,15 @@ ExternalProject_Add(mavsdk_tests
 )
 
 # create targets for each viewer/model/debugger combination
-set(viewers none jmavsim gazebo)
+set(viewers none jmavsim gazebo sih)
 set(debuggers none ide gdb lldb ddd valgrind callgrind)
 set(models none shell
 	if750a iris iris_opt_flow iris_opt_flow_mockup iris_vision iris_rplidar iris_irlock iris_obs_avoid iris_rtps solo typhoon_h480
 	plane plane_catapult
 	standard_vtol tailsitter tiltrotor
 	rover boat
-	uuv_hippocampus)
+	uuv_hippocampus
+	sihquad)
 set(all_posix_vmd_make_targets)
 foreach(viewer ${viewers})
 	foreach(debugger ${debuggers})
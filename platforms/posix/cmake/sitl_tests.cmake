@@ -15,10 +15,12 @@ set(tests
 	float
 	hrt
 	int
+	IntrusiveMPSCQueue
 	IntrusiveQueue
 	List
 	mathlib
 	matrix
+	microbench_filter
 	microbench_hrt
 	microbench_math
 	microbench_matrix
@@ -34,6 +36,7 @@ set(tests
 	sleep
 	uorb
 	versioning
+	WorkQueue
 	)
 
 if (${CMAKE_SYSTEM_NAME} MATCHES "Darwin")
@@ -103,6 +106,23 @@ if(NOT CMAKE_SYSTEM_NAME STREQUAL "CYGWIN")
 	sanitizer_fail_test_on_error(shutdown)
 endif()
 
+# Dataman memory mapped file backend (Linux only), including persistence across a restart
+if (CMAKE_SYSTEM_NAME STREQUAL "Linux")
+	add_test(NAME dataman_mmap
+		COMMAND ${PX4_SOURCE_DIR}/Tools/sitl_run.sh
+			$<TARGET_FILE:px4>
+			none
+			none
+			test_dataman_mmap
+			${PX4_SOURCE_DIR}
+			${PX4_BINARY_DIR}
+		WORKING_DIRECTORY ${SITL_WORKING_DIR})
+
+	set_tests_properties(dataman_mmap PROPERTIES FAIL_REGULAR_EXPRESSION "dataman FAILED|dataman start failed|Unflushed [1-9]")
+	set_tests_properties(dataman_mmap PROPERTIES PASS_REGULAR_EXPRESSION "dataman_mmap PASSED")
+	sanitizer_fail_test_on_error(dataman_mmap)
+endif()
+
 # Dynamic module loading test
 add_test(NAME dyn
 	COMMAND ${PX4_SOURCE_DIR}/Tools/sitl_run.sh
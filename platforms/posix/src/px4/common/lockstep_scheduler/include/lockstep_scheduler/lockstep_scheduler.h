@@ -37,10 +37,10 @@ private:
 			}
 
 			// If a thread quickly exits after a cond_timedwait(), the
-			// thread_local object can still be in the linked list. In that case
-			// we need to wait until it's removed.
-			while (!removed) {
-				system_usleep(5000);
+			// thread_local object can still be in the heap (until its deadline
+			// passes). In that case we need to remove it.
+			if (!removed) {
+				scheduler->remove_timed_wait(this);
 			}
 		}
 
@@ -51,12 +51,33 @@ private:
 		std::atomic<bool> done{false};
 		std::atomic<bool> removed{true};
 
-		TimedWait *next{nullptr}; ///< linked list
+		LockstepScheduler *scheduler{nullptr}; ///< scheduler this is queued in (if not removed)
+		size_t heap_index{0}; ///< position in _timed_waits (if not removed)
 	};
 
+	/**
+	 * Remove a timed wait from the heap (takes _timed_waits_mutex)
+	 */
+	void remove_timed_wait(TimedWait *timed_wait);
+
+	// binary min-heap operations on _timed_waits, ordered by time_us.
+	// _timed_waits_mutex must be held.
+	void heap_push(TimedWait *timed_wait);
+	void heap_erase(size_t index);
+	void heap_update(size_t index);
+	void heap_sift_up(size_t index);
+	void heap_sift_down(size_t index);
+	inline void heap_set(size_t index, TimedWait *timed_wait)
+	{
+		_timed_waits[index] = timed_wait;
+		timed_wait->heap_index = index;
+	}
+
 	std::atomic<uint64_t> _time_us{0};
 
-	TimedWait *_timed_waits{nullptr}; ///< head of linked list
+	/// pending timed waits, ordered by deadline (binary heap), so that set_absolute_time() only needs to visit
+	/// the expired ones. Waits that ended before their deadline are kept until it passes or they are re-used.
+	std::vector<TimedWait *> _timed_waits;
 	std::mutex _timed_waits_mutex;
 	std::atomic<bool> _setting_time{false}; ///< true if set_absolute_time() is currently being executed
 };
@@ -318,3 +318,76 @@ TEST(LockstepScheduler, All)
 		test_multiple_semaphores_waiting();
 	}
 }
+
+void benchmark_set_absolute_time(int num_waiters)
+{
+	LockstepScheduler ls;
+	ls.set_absolute_time(some_time_us);
+
+	struct Waiter {
+		pthread_cond_t cond;
+		pthread_mutex_t lock;
+		std::atomic<bool> started{false};
+		std::atomic<bool> exited{false};
+		std::thread thread;
+	};
+
+	std::vector<std::unique_ptr<Waiter>> waiters;
+
+	// Threads blocked with a timeout (e.g. in px4_poll() or px4_sem_timedwait()), which does not expire during
+	// the benchmark. They are all registered when the timing starts.
+	for (int i = 0; i < num_waiters; ++i) {
+		waiters.emplace_back(new Waiter());
+		Waiter &waiter = *waiters.back();
+		pthread_cond_init(&waiter.cond, NULL);
+		pthread_mutex_init(&waiter.lock, NULL);
+
+		waiter.thread = std::thread([&ls, &waiter, i]() {
+			pthread_mutex_lock(&waiter.lock);
+			waiter.started = true;
+			ls.cond_timedwait(&waiter.cond, &waiter.lock, some_time_us + 3600000000ULL + i);
+			pthread_mutex_unlock(&waiter.lock);
+			waiter.exited = true;
+		});
+
+		WAIT_FOR(waiter.started);
+		// the lock is released once the thread waits on the condition
+		pthread_mutex_lock(&waiter.lock);
+		pthread_mutex_unlock(&waiter.lock);
+	}
+
+	// simulator steps of 250 us
+	constexpr int num_steps = 20000;
+	constexpr uint64_t step_us = 250;
+	uint64_t time_us = some_time_us;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int step = 0; step < num_steps; ++step) {
+		time_us += step_us;
+		ls.set_absolute_time(time_us);
+	}
+
+	const auto end = std::chrono::steady_clock::now();
+
+	for (auto &waiter : waiters) {
+		pthread_mutex_lock(&waiter->lock);
+		pthread_cond_broadcast(&waiter->cond);
+		pthread_mutex_unlock(&waiter->lock);
+
+		// the deadline has not passed, the wait is removed from the heap when the thread exits
+		waiter->thread.join();
+		pthread_mutex_destroy(&waiter->lock);
+		pthread_cond_destroy(&waiter->cond);
+	}
+
+	const double elapsed_s = std::chrono::duration<double>(end - start).count();
+	std::cout << "waiters: " << num_waiters << ", steps/s: " << (int)(num_steps / elapsed_s) << "\n";
+}
+
+TEST(LockstepScheduler, BenchmarkSetAbsoluteTime)
+{
+	for (int num_waiters : {1, 10, 100, 1000}) {
+		benchmark_set_absolute_time(num_waiters);
+	}
+}
@@ -0,0 +1,199 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file IntrusiveMPSCQueue.hpp
+ *
+ * Intrusive FIFO queue with lock-free push from multiple producers (threads or
+ * interrupts) and a single consumer.
+ *
+ * Producers push onto an atomic LIFO stack. The consumer takes the whole stack
+ * at once and appends it in order to its private FIFO. All consumer side methods
+ * (empty, pop, remove) must be serialized by the caller, push needs no lock.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+
+#include <px4_platform_common/atomic.h>
+
+template<class T>
+class IntrusiveMPSCQueue
+{
+public:
+
+	/**
+	 * Add a node to the queue. Safe to call concurrently from any context.
+	 *
+	 * @return false if the node is already queued
+	 */
+	bool push(T newNode)
+	{
+		bool queued = false;
+
+		if (!newNode->_mpsc_queued.compare_exchange(&queued, true)) {
+			return false;
+		}
+
+		T top = _stack.load();
+
+		do {
+			newNode->_mpsc_next = top;
+		} while (!_stack.compare_exchange(&top, newNode));
+
+		return true;
+	}
+
+	/**
+	 * Check for nodes pushed but not yet taken by the consumer. Safe to call from any context.
+	 */
+	bool pending() const { return _stack.load() != nullptr; }
+
+	bool empty() const { return (_head == nullptr) && !pending(); }
+
+	T pop()
+	{
+		if (_head == nullptr) {
+			collect();
+		}
+
+		T ret = _head;
+
+		if (ret != nullptr) {
+			_head = ret->_mpsc_next;
+
+			if (_head == nullptr) {
+				_tail = nullptr;
+			}
+
+			// clear next and queued in popped (it might be re-inserted later)
+			ret->_mpsc_next = nullptr;
+			ret->_mpsc_queued.store(false);
+		}
+
+		return ret;
+	}
+
+	/**
+	 * Remove a node from the queue.
+	 *
+	 * A node that a producer is pushing concurrently might not be on the stack yet, and is then added
+	 * after remove() returned. Before a node is freed, the caller has to make sure no push of it is in
+	 * progress (see WorkItem::Deinit()).
+	 *
+	 * @return true if the node was queued
+	 */
+	bool remove(T removeNode)
+	{
+		collect();
+
+		T prev = nullptr;
+
+		for (T node = _head; node != nullptr; node = node->_mpsc_next) {
+			if (node == removeNode) {
+				if (prev == nullptr) {
+					_head = node->_mpsc_next;
+
+				} else {
+					prev->_mpsc_next = node->_mpsc_next;
+				}
+
+				if (_tail == node) {
+					_tail = prev;
+				}
+
+				node->_mpsc_next = nullptr;
+				node->_mpsc_queued.store(false);
+				return true;
+			}
+
+			prev = node;
+		}
+
+		return false;
+	}
+
+private:
+
+	/**
+	 * Move all pushed nodes from the stack to the end of the FIFO.
+	 */
+	void collect()
+	{
+		T top = _stack.load();
+
+		while ((top != nullptr) && !_stack.compare_exchange(&top, nullptr)) {}
+
+		if (top == nullptr) {
+			return;
+		}
+
+		// the stack is newest first, reverse it
+		T newest = top;
+		T oldest = nullptr;
+
+		while (top != nullptr) {
+			T next = top->_mpsc_next;
+			top->_mpsc_next = oldest;
+			oldest = top;
+			top = next;
+		}
+
+		if (_tail != nullptr) {
+			_tail->_mpsc_next = oldest;
+
+		} else {
+			_head = oldest;
+		}
+
+		_tail = newest;
+	}
+
+	px4::atomic<T>	_stack{nullptr};	// pushed nodes, newest first
+
+	T _head{nullptr};			// consumer FIFO, oldest first
+	T _tail{nullptr};
+
+};
+
+template<class T>
+class IntrusiveMPSCQueueNode
+{
+private:
+	friend IntrusiveMPSCQueue<T>;
+
+	T _mpsc_next{nullptr};
+	px4::atomic_bool _mpsc_queued{false};
+};
@@ -305,6 +305,8 @@ void PX4Gyroscope::updateFIFO(const FIFOSample &sample)
 	fifo.dt = dt;
 	fifo.scale = _scale;
 	fifo.samples = N;
+	fifo.rotation = _rotation;
+	_calibration_offset.copyTo(fifo.calibration_offset);
 
 	memcpy(fifo.x, sample.x, sizeof(sample.x[0]) * N);
 	memcpy(fifo.y, sample.y, sizeof(sample.y[0]) * N);
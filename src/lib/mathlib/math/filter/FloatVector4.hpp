@@ -0,0 +1,278 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file FloatVector4.hpp
+ *
+ * @brief Minimal portable 4 lane float vector and the biquad state used to filter
+ * blocks of samples of up to 4 channels at once
+ *
+ * Uses SSE (x86) or NEON (ARMv7-A/ARMv8) when available and plain scalar code
+ * otherwise (e.g. Cortex-M).
+ */
+
+#pragma once
+
+#include <px4_platform_common/defines.h>
+
+#include <float.h>
+#include <math.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace math
+{
+
+class FloatVector4
+{
+public:
+	FloatVector4() : FloatVector4(0.f) {}
+
+	// all lanes set to value
+	explicit FloatVector4(float value)
+	{
+#if defined(__SSE__)
+		_v = _mm_set1_ps(value);
+#elif defined(__ARM_NEON)
+		_v = vdupq_n_f32(value);
+#else
+
+		for (int i = 0; i < 4; i++) {
+			_v[i] = value;
+		}
+
+#endif
+	}
+
+	// load 4 consecutive floats (no alignment required)
+	static inline FloatVector4 load(const float data[4])
+	{
+		FloatVector4 r;
+#if defined(__SSE__)
+		r._v = _mm_loadu_ps(data);
+#elif defined(__ARM_NEON)
+		r._v = vld1q_f32(data);
+#else
+
+		for (int i = 0; i < 4; i++) {
+			r._v[i] = data[i];
+		}
+
+#endif
+		return r;
+	}
+
+	// store to 4 consecutive floats (no alignment required)
+	inline void store(float data[4]) const
+	{
+#if defined(__SSE__)
+		_mm_storeu_ps(data, _v);
+#elif defined(__ARM_NEON)
+		vst1q_f32(data, _v);
+#else
+
+		for (int i = 0; i < 4; i++) {
+			data[i] = _v[i];
+		}
+
+#endif
+	}
+
+	inline FloatVector4 operator+(const FloatVector4 &other) const
+	{
+		FloatVector4 r;
+#if defined(__SSE__)
+		r._v = _mm_add_ps(_v, other._v);
+#elif defined(__ARM_NEON)
+		r._v = vaddq_f32(_v, other._v);
+#else
+
+		for (int i = 0; i < 4; i++) {
+			r._v[i] = _v[i] + other._v[i];
+		}
+
+#endif
+		return r;
+	}
+
+	inline FloatVector4 operator-(const FloatVector4 &other) const
+	{
+		FloatVector4 r;
+#if defined(__SSE__)
+		r._v = _mm_sub_ps(_v, other._v);
+#elif defined(__ARM_NEON)
+		r._v = vsubq_f32(_v, other._v);
+#else
+
+		for (int i = 0; i < 4; i++) {
+			r._v[i] = _v[i] - other._v[i];
+		}
+
+#endif
+		return r;
+	}
+
+	inline FloatVector4 operator*(const FloatVector4 &other) const
+	{
+		FloatVector4 r;
+#if defined(__SSE__)
+		r._v = _mm_mul_ps(_v, other._v);
+#elif defined(__ARM_NEON)
+		r._v = vmulq_f32(_v, other._v);
+#else
+
+		for (int i = 0; i < 4; i++) {
+			r._v[i] = _v[i] * other._v[i];
+		}
+
+#endif
+		return r;
+	}
+
+private:
+#if defined(__SSE__)
+	__m128 _v;
+#elif defined(__ARM_NEON)
+	float32x4_t _v;
+#else
+	float _v[4];
+#endif
+};
+
+/**
+ * State of a Direct Form II biquad over 4 interleaved channels sharing the same coefficients.
+ */
+class BiquadState4
+{
+public:
+	void zero()
+	{
+		_delay_element_1 = {};
+		_delay_element_2 = {};
+	}
+
+	/**
+	 * Filter interleaved samples (samples[4 * n + channel]) in place
+	 *
+	 * A channel with non-finite state after the block is reset to its last input sample,
+	 * so bad values don't propagate beyond the block they appeared in.
+	 */
+	inline void apply(float samples[], int num_samples, float b0, float b1, float b2, float a1, float a2)
+	{
+		if (num_samples <= 0) {
+			return;
+		}
+
+		float last_sample[4];
+
+		for (int i = 0; i < 4; i++) {
+			last_sample[i] = samples[4 * (num_samples - 1) + i];
+		}
+
+		const FloatVector4 b0_v{b0};
+		const FloatVector4 b1_v{b1};
+		const FloatVector4 b2_v{b2};
+		const FloatVector4 a1_v{a1};
+		const FloatVector4 a2_v{a2};
+
+		FloatVector4 d1{_delay_element_1};
+		FloatVector4 d2{_delay_element_2};
+
+		for (int n = 0; n < num_samples; n++) {
+			const FloatVector4 delay_element_0{FloatVector4::load(&samples[4 * n]) - d1 * a1_v - d2 * a2_v};
+			const FloatVector4 output{delay_element_0 * b0_v + d1 * b1_v + d2 * b2_v};
+			output.store(&samples[4 * n]);
+
+			d2 = d1;
+			d1 = delay_element_0;
+		}
+
+		_delay_element_1 = d1;
+		_delay_element_2 = d2;
+
+		// don't allow bad values to propagate via the filter
+		float state_1[4];
+		float state_2[4];
+		_delay_element_1.store(state_1);
+		_delay_element_2.store(state_2);
+
+		bool state_valid = true;
+		const float dc_gain = b0 + b1 + b2;
+
+		for (int i = 0; i < 4; i++) {
+			if (!PX4_ISFINITE(state_1[i]) || !PX4_ISFINITE(state_2[i])) {
+				const float sample = PX4_ISFINITE(last_sample[i]) ? last_sample[i] : 0.f;
+				state_1[i] = (fabsf(dc_gain) > FLT_EPSILON) ? sample / dc_gain : sample;
+				state_2[i] = state_1[i];
+				samples[4 * (num_samples - 1) + i] = sample;
+				state_valid = false;
+			}
+		}
+
+		if (!state_valid) {
+			_delay_element_1 = FloatVector4::load(state_1);
+			_delay_element_2 = FloatVector4::load(state_2);
+		}
+	}
+
+	/**
+	 * Reset the state of all channels to the steady state of the given samples
+	 */
+	inline void reset(const float sample[4], float b0, float b1, float b2)
+	{
+		const float dc_gain = b0 + b1 + b2;
+		float dval[4];
+
+		for (int i = 0; i < 4; i++) {
+			dval[i] = PX4_ISFINITE(sample[i]) ? sample[i] : 0.f;
+
+			if (fabsf(dc_gain) > FLT_EPSILON) {
+				dval[i] /= dc_gain;
+			}
+		}
+
+		_delay_element_1 = FloatVector4::load(dval);
+		_delay_element_2 = _delay_element_1;
+	}
+
+private:
+	FloatVector4 _delay_element_1{};	// buffered sample -1
+	FloatVector4 _delay_element_2{};	// buffered sample -2
+};
+
+} // namespace math
@@ -91,6 +91,13 @@ float LowPassFilter2p::apply(float sample)
 	return output;
 }
 
+void LowPassFilter2p::applyArray(float samples[], int num_samples)
+{
+	for (int n = 0; n < num_samples; n++) {
+		samples[n] = apply(samples[n]);
+	}
+}
+
 float LowPassFilter2p::reset(float sample)
 {
 	const float dval = sample / (_b0 + _b1 + _b2);
@@ -60,6 +60,11 @@ public:
 	 */
 	float apply(float sample);
 
+	/**
+	 * Filter an array of consecutive samples in place
+	 */
+	void applyArray(float samples[], int num_samples);
+
 	// Return the cutoff frequency
 	float get_cutoff_freq() const { return _cutoff_freq; }
 
@@ -37,6 +37,7 @@
 #pragma once
 
 #include "LowPassFilter2p.hpp"
+#include "FloatVector4.hpp"
 
 #include <px4_platform_common/defines.h>
 
@@ -84,4 +85,41 @@ public:
 
 };
 
+/**
+ * Second order low pass filter on blocks of 4 interleaved channels (e.g. x, y, z and one unused channel),
+ * all channels are processed at once (SIMD where available).
+ * Only the coefficients are shared with LowPassFilter2p, the scalar state and apply() are not exposed.
+ */
+class LowPassFilter2pArray4 : private LowPassFilter2p
+{
+public:
+
+	LowPassFilter2pArray4(float sample_freq, float cutoff_freq) : LowPassFilter2p(sample_freq, cutoff_freq)
+	{
+	}
+
+	using LowPassFilter2p::get_cutoff_freq;
+
+	// Change filter parameters
+	void set_cutoff_frequency(float sample_freq, float cutoff_freq)
+	{
+		LowPassFilter2p::set_cutoff_frequency(sample_freq, cutoff_freq);
+		_state.zero();
+	}
+
+	/**
+	 * Filter interleaved samples (samples[4 * n + channel]) in place
+	 */
+	inline void applyArray(float samples[], int num_samples)
+	{
+		_state.apply(samples, num_samples, _b0, _b1, _b2, _a1, _a2);
+	}
+
+	// Reset the filter state of each channel to this value
+	void reset(const float sample[4]) { _state.reset(sample, _b0, _b1, _b2); }
+
+private:
+	BiquadState4 _state{};
+};
+
 } // namespace math
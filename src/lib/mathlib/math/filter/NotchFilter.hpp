@@ -68,6 +68,11 @@ public:
 
 	void setParameters(float sample_freq, float notch_freq, float bandwidth);
 
+	/**
+	 * Change the filter parameters without resetting the filter state (e.g. to follow a moving notch frequency)
+	 */
+	void updateParameters(float sample_freq, float notch_freq, float bandwidth);
+
 	/**
 	 * Add a new raw value to the filter
 	 *
@@ -120,12 +125,18 @@ protected:
 template<typename T>
 void NotchFilter<T>::setParameters(float sample_freq, float notch_freq, float bandwidth)
 {
-	_notch_freq = notch_freq;
-	_bandwidth = bandwidth;
-
 	_delay_element_1 = {};
 	_delay_element_2 = {};
 
+	updateParameters(sample_freq, notch_freq, bandwidth);
+}
+
+template<typename T>
+void NotchFilter<T>::updateParameters(float sample_freq, float notch_freq, float bandwidth)
+{
+	_notch_freq = notch_freq;
+	_bandwidth = bandwidth;
+
 	if (notch_freq <= 0.f) {
 		// no filtering
 		_b0 = 1.0f;
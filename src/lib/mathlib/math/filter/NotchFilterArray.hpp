@@ -42,6 +42,7 @@
 #pragma once
 
 #include "NotchFilter.hpp"
+#include "FloatVector4.hpp"
 
 namespace math
 {
@@ -85,4 +86,42 @@ public:
 	}
 };
 
+/**
+ * Notch filter on blocks of 4 interleaved channels (e.g. x, y, z and one unused channel),
+ * all channels are processed at once (SIMD where available).
+ * Only the coefficients are shared with NotchFilter, the scalar state and apply() are not exposed.
+ */
+class NotchFilterArray4 : private NotchFilter<float>
+{
+public:
+
+	NotchFilterArray4() = default;
+	~NotchFilterArray4() = default;
+
+	using NotchFilter<float>::updateParameters;
+	using NotchFilter<float>::getNotchFreq;
+	using NotchFilter<float>::getBandwidth;
+	using NotchFilter<float>::getCoefficients;
+
+	void setParameters(float sample_freq, float notch_freq, float bandwidth)
+	{
+		NotchFilter<float>::setParameters(sample_freq, notch_freq, bandwidth);
+		_state.zero();
+	}
+
+	/**
+	 * Filter interleaved samples (samples[4 * n + channel]) in place
+	 */
+	inline void applyArray(float samples[], int num_samples)
+	{
+		_state.apply(samples, num_samples, _b0, _b1, _b2, _a1, _a2);
+	}
+
+	// Reset the filter state of each channel to this value
+	void reset(const float sample[4]) { _state.reset(sample, _b0, _b1, _b2); }
+
+private:
+	BiquadState4 _state{};
+};
+
 } // namespace math
@@ -40,6 +40,8 @@
 #include <matrix/matrix/math.hpp>
 
 #include "NotchFilter.hpp"
+#include "NotchFilterArray.hpp"
+#include "LowPassFilter2pArray.hpp"
 
 using namespace math;
 using matrix::Vector3f;
@@ -211,3 +213,89 @@ TEST_F(NotchFilterTest, disabled)
 		EXPECT_EQ(out, input);
 	}
 }
+
+TEST_F(NotchFilterTest, array4MatchesScalar)
+{
+	// Filter blocks of 4 interleaved channels and compare against one scalar filter per channel
+	NotchFilterArray4 notch_array4;
+	notch_array4.setParameters(_sample_freq, _notch_freq, _bandwidth);
+
+	NotchFilter<float> notch_scalar[4];
+	LowPassFilter2pArray4 lpf_array4(_sample_freq, 30.f);
+	LowPassFilter2p lpf_scalar[4] {{_sample_freq, 30.f}, {_sample_freq, 30.f}, {_sample_freq, 30.f}, {_sample_freq, 30.f}};
+
+	for (auto &notch : notch_scalar) {
+		notch.setParameters(_sample_freq, _notch_freq, _bandwidth);
+	}
+
+	const float signal_freq[4] {25.f, 50.f, 98.4f, 200.f};
+	const float dt = 1.f / _sample_freq;
+	const int block_size = 7;
+
+	for (int block = 0; block < 100; block++) {
+		float samples_notch[block_size * 4];
+		float samples_lpf[block_size * 4];
+
+		for (int n = 0; n < block_size; n++) {
+			const float t = (block * block_size + n) * dt;
+
+			for (int channel = 0; channel < 4; channel++) {
+				samples_notch[4 * n + channel] = sinf(2.f * M_PI_F * signal_freq[channel] * t);
+				samples_lpf[4 * n + channel] = samples_notch[4 * n + channel];
+			}
+		}
+
+		notch_array4.applyArray(samples_notch, block_size);
+		lpf_array4.applyArray(samples_lpf, block_size);
+
+		for (int n = 0; n < block_size; n++) {
+			const float t = (block * block_size + n) * dt;
+
+			for (int channel = 0; channel < 4; channel++) {
+				const float input = sinf(2.f * M_PI_F * signal_freq[channel] * t);
+				EXPECT_NEAR(samples_notch[4 * n + channel], notch_scalar[channel].apply(input), _epsilon_near);
+				EXPECT_NEAR(samples_lpf[4 * n + channel], lpf_scalar[channel].apply(input), _epsilon_near);
+			}
+		}
+	}
+}
+
+TEST_F(NotchFilterTest, array4BadValue)
+{
+	// A bad sample on one channel must not propagate into the following blocks or the other channels
+	NotchFilterArray4 notch_array4;
+	notch_array4.setParameters(_sample_freq, _notch_freq, _bandwidth);
+
+	const float reset_value[4] {1.f, 1.f, 1.f, 1.f};
+	notch_array4.reset(reset_value);
+
+	float samples[2 * 4] {1.f, NAN, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f};
+	notch_array4.applyArray(samples, 2);
+
+	for (int i = 0; i < 2 * 4; i++) {
+		if (i != 1) {
+			EXPECT_NEAR(samples[i], 1.f, _epsilon_near);
+		}
+	}
+
+	float samples_next[4] {1.f, 1.f, 1.f, 1.f};
+	notch_array4.applyArray(samples_next, 1);
+
+	for (int channel = 0; channel < 4; channel++) {
+		EXPECT_NEAR(samples_next[channel], 1.f, _epsilon_near);
+	}
+}
+
+TEST_F(NotchFilterTest, updateParametersKeepsState)
+{
+	// Retuning with updateParameters() keeps the filter state (only a small transient on a DC signal)
+	_notch_float.setParameters(_sample_freq, _notch_freq, _bandwidth);
+	_notch_float.reset(1.f);
+
+	for (int i = 0; i < 100; i++) {
+		const float notch_freq = _notch_freq + i;
+		_notch_float.updateParameters(_sample_freq, notch_freq, _bandwidth);
+		EXPECT_EQ(_notch_float.getNotchFreq(), notch_freq);
+		EXPECT_NEAR(_notch_float.apply(1.f), 1.f, 0.1f);
+	}
+}
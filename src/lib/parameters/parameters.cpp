@@ -133,9 +133,15 @@ get_param_info_count()
 	return param_info_count;
 }
 
-/** flexible array holding modified parameter values */
+/** flexible array holding modified parameter values (unordered) */
 UT_array *param_values{nullptr};
 
+/**
+ * Index of each parameter into param_values (offset by 1, 0 means the parameter
+ * is not modified). Allocated together with param_values.
+ */
+static uint16_t *param_values_index{nullptr};
+
 /** array info for the modified parameters array */
 const UT_icd param_icd = {sizeof(param_wbuf_s), nullptr, nullptr, nullptr};
 
@@ -244,48 +250,52 @@ handle_in_range(param_t param)
 }
 
 /**
- * Compare two modifid parameter structures to determine ordering.
+ * Locate the modified parameter structure for a parameter, if it exists.
  *
- * This function is suitable for passing to qsort or bsearch.
+ * @param param			The parameter being searched.
+ * @return			The structure holding the modified value, or
+ *				nullptr if the parameter has not been modified.
  */
-static int
-param_compare_values(const void *a, const void *b)
+static param_wbuf_s *
+param_find_changed(param_t param)
 {
-	struct param_wbuf_s *pa = (struct param_wbuf_s *)a;
-	struct param_wbuf_s *pb = (struct param_wbuf_s *)b;
+	param_wbuf_s	*s = nullptr;
 
-	if (pa->param < pb->param) {
-		return -1;
-	}
+	param_assert_locked();
 
-	if (pa->param > pb->param) {
-		return 1;
+	if (param_values != nullptr && param < param_info_count) {
+		const unsigned index = param_values_index[param];
+
+		if (index > 0) {
+			s = (param_wbuf_s *)utarray_eltptr(param_values, index - 1);
+		}
 	}
 
-	return 0;
+	return s;
 }
 
 /**
- * Locate the modified parameter structure for a parameter, if it exists.
+ * Remove the modified value of a parameter. The last element is moved into the
+ * freed slot, so the other modified values keep their storage but may change position.
  *
- * @param param			The parameter being searched.
- * @return			The structure holding the modified value, or
- *				nullptr if the parameter has not been modified.
+ * @param s			The structure holding the modified value.
  */
-static param_wbuf_s *
-param_find_changed(param_t param)
+static void
+param_erase_changed(param_wbuf_s *s)
 {
-	param_wbuf_s	*s = nullptr;
-
 	param_assert_locked();
 
-	if (param_values != nullptr) {
-		param_wbuf_s key{};
-		key.param = param;
-		s = (param_wbuf_s *)utarray_find(param_values, &key, param_compare_values);
+	const unsigned index = utarray_eltidx(param_values, s);
+	const unsigned last = utarray_len(param_values) - 1;
+
+	param_values_index[s->param] = 0;
+
+	if (index != last) {
+		*s = *(param_wbuf_s *)utarray_eltptr(param_values, last);
+		param_values_index[s->param] = index + 1;
 	}
 
-	return s;
+	utarray_pop_back(param_values);
 }
 
 static void
@@ -318,33 +328,21 @@ param_find_internal(const char *name, bool notification)
 {
 	perf_begin(param_find_perf);
 
-	param_t middle;
-	param_t front = 0;
-	param_t last = get_param_info_count();
-
-	/* perform a binary search of the known parameters */
+	if (get_param_info_count() > 0) {
+		/* look up the candidate in the generated perfect hash, see px_generate_params.py */
+		const int16_t seed = px4_parameters_hash_seeds[px4_parameters_hash(0, name) % PX4_PARAMETERS_HASH_SIZE];
+		const unsigned slot = (seed < 0) ? (unsigned)(-seed - 1) :
+				      px4_parameters_hash(seed, name) % PX4_PARAMETERS_HASH_SIZE;
+		const param_t param = px4_parameters_hash_slots[slot];
 
-	while (front <= last) {
-		middle = front + (last - front) / 2;
-		int ret = strcmp(name, param_info_base[middle].name);
-
-		if (ret == 0) {
+		/* any name maps to some parameter, so it still needs to be compared */
+		if (param < param_info_count && strcmp(name, param_info_base[param].name) == 0) {
 			if (notification) {
-				param_set_used_internal(middle);
+				param_set_used_internal(param);
 			}
 
 			perf_end(param_find_perf);
-			return middle;
-
-		} else if (middle == front) {
-			/* An end point has been hit, but there has been no match */
-			break;
-
-		} else if (ret < 0) {
-			last = middle;
-
-		} else {
-			front = middle;
+			return param;
 		}
 	}
 
@@ -686,7 +684,16 @@ param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_
 	perf_begin(param_set_perf);
 
 	if (param_values == nullptr) {
-		utarray_new(param_values, &param_icd);
+		param_values_index = (uint16_t *)calloc(param_info_count, sizeof(uint16_t));
+
+		if (param_values_index != nullptr) {
+			utarray_new(param_values, &param_icd);
+
+			if (param_values == nullptr) {
+				free(param_values_index);
+				param_values_index = nullptr;
+			}
+		}
 	}
 
 	if (param_values == nullptr) {
@@ -706,11 +713,10 @@ param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_
 
 			params_changed = true;
 
-			/* add it to the array and sort */
+			/* append it to the array */
 			utarray_push_back(param_values, &buf);
-			utarray_sort(param_values, param_compare_values);
+			param_values_index[param] = utarray_len(param_values);
 
-			/* find it after sorting */
 			s = param_find_changed(param);
 		}
 
@@ -845,8 +851,7 @@ param_reset(param_t param)
 
 		/* if we found one, erase it */
 		if (s != nullptr) {
-			int pos = utarray_eltidx(param_values, s);
-			utarray_erase(param_values, pos, 1);
+			param_erase_changed(s);
 		}
 
 		param_found = true;
@@ -871,8 +876,11 @@ param_reset_all_internal(bool auto_save)
 		utarray_free(param_values);
 	}
 
+	free(param_values_index);
+
 	/* mark as reset / deleted */
 	param_values = nullptr;
+	param_values_index = nullptr;
 
 	if (auto_save) {
 		param_autosave();
@@ -1066,7 +1074,14 @@ param_export(int fd, bool only_unsaved)
 		goto out;
 	}
 
-	while ((s = (struct param_wbuf_s *)utarray_next(param_values, s)) != nullptr) {
+	/* export in parameter order, param_values is unordered */
+	for (param_t param = 0; handle_in_range(param); param++) {
+		s = param_find_changed(param);
+
+		if (s == nullptr) {
+			continue;
+		}
+
 		/*
 		 * If we are only saving values changed since last save, and this
 		 * one hasn't, then skip it
@@ -1384,7 +1399,8 @@ void param_print_status()
 
 	if (param_values != nullptr) {
 		PX4_INFO("storage array: %d/%d elements (%zu bytes total)",
-			 utarray_len(param_values), param_values->n, param_values->n * sizeof(UT_icd));
+			 utarray_len(param_values), param_values->n,
+			 param_values->n * sizeof(param_wbuf_s) + param_info_count * sizeof(*param_values_index));
 	}
 
 	PX4_INFO("auto save: %s", autosave_disabled ? "off" : "on");
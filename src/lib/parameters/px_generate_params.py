@@ -20,6 +20,86 @@ except ImportError as e:
 
 import os
 
+def param_name_hash(seed, name):
+    """
+    32 bit FNV-1a hash of a parameter name.
+    This must match px4_parameters_hash() in px4_parameters.h.jinja.
+    """
+    h = (0x811c9dc5 ^ seed) & 0xffffffff
+    for c in name.encode('ascii'):
+        h ^= c
+        h = (h * 0x01000193) & 0xffffffff
+    return h
+
+def generate_perfect_hash(names):
+    """
+    Generate a minimal perfect hash over the (sorted) parameter names
+    using hash and displace.
+
+    A name is looked up in two steps: seed = seeds[hash(0, name) % n],
+    then the parameter index is slots[hash(seed, name) % n] if seed >= 0,
+    or slots[-seed - 1] otherwise. The caller still has to compare the name,
+    as any unknown name also maps to a valid index.
+
+    @param names: list of parameter names, index in the list is the handle
+    @return: (seeds, slots) lists with n entries each (at least 1)
+    """
+    size = max(len(names), 1)
+    buckets = [[] for _ in range(size)]
+
+    for index, name in enumerate(names):
+        buckets[param_name_hash(0, name) % size].append(index)
+
+    seeds = [0] * size
+    slots = [None] * size
+
+    # place the largest buckets first, while most of the slots are still free
+    buckets = sorted(buckets, key=len, reverse=True)
+
+    for bucket in buckets:
+        if len(bucket) <= 1:
+            break
+
+        seed = 1
+        item = 0
+        bucket_slots = []
+
+        while item < len(bucket):
+            slot = param_name_hash(seed, names[bucket[item]]) % size
+
+            if slots[slot] is not None or slot in bucket_slots:
+                seed += 1
+                item = 0
+                bucket_slots = []
+
+                if seed > 0x7fff:
+                    raise Exception("failed to generate parameter hash")
+
+            else:
+                bucket_slots.append(slot)
+                item += 1
+
+        seeds[param_name_hash(0, names[bucket[0]]) % size] = seed
+
+        for index, slot in zip(bucket, bucket_slots):
+            slots[slot] = index
+
+    # buckets with a single entry directly reference a free slot
+    free_slots = [slot for slot in range(size) if slots[slot] is None]
+
+    for bucket in buckets:
+        if len(bucket) != 1:
+            continue
+
+        slot = free_slots.pop()
+        seeds[param_name_hash(0, names[bucket[0]]) % size] = -slot - 1
+        slots[slot] = bucket[0]
+
+    # unused slots (only if there are no parameters at all)
+    slots = [0 if slot is None else slot for slot in slots]
+
+    return seeds, slots
+
 def generate(xml_file, dest='.'):
     """
     Generate px4 param source from xml.
@@ -40,6 +120,9 @@ def generate(xml_file, dest='.'):
 
     params = sorted(params, key=lambda name: name.attrib["name"])
 
+    hash_seeds, hash_slots = generate_perfect_hash(
+        [param.attrib["name"] for param in params])
+
     script_path = os.path.dirname(os.path.realpath(__file__))
 
     # for jinja docs see: http://jinja.pocoo.org/docs/2.9/api/
@@ -58,7 +141,8 @@ def generate(xml_file, dest='.'):
         template = env.get_template(template_file)
         with open(os.path.join(
                 dest, template_file.replace('.jinja','')), 'w') as fid:
-            fid.write(template.render(params=params))
+            fid.write(template.render(params=params,
+                hash_seeds=hash_seeds, hash_slots=hash_slots))
 
 if __name__ == "__main__":
     arg_parser = argparse.ArgumentParser()
@@ -40,7 +40,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/queue.h>
+#include <new>
 #include <drivers/drv_hrt.h>
 #include <math.h>
 #include <pthread.h>
@@ -53,28 +53,51 @@
 #define dprintf(_fd, _text, ...) ((_fd) == 1 ? PX4_INFO((_text), ##__VA_ARGS__) : (void)(_fd))
 #endif
 
+/**
+ * Number of per-thread shards of a counter.
+ *
+ * On multi-core targets every thread updates its own copy of the counter data
+ * (assigned round-robin, so threads only share a shard if there are more threads
+ * than shards), and the shards are merged when the counter is read.
+ */
+#if defined(__PX4_POSIX) && !defined(__PX4_QURT)
+#define PERF_SHARD_COUNT 8
+#define PERF_SHARD_ALIGN 64 // cache line size
+#else
+#define PERF_SHARD_COUNT 1
+#endif
+
+/**
+ * PC_HISTOGRAM bucket layout (log-linear, HDR-style): values below
+ * 2^(PERF_HISTOGRAM_SUB_BITS + 1) us are exact, larger values are split into
+ * 2^PERF_HISTOGRAM_SUB_BITS buckets per power of two (<= 12.5% error).
+ * Values of 2^PERF_HISTOGRAM_MAX_BITS us (~16.8s) and above go into the last bucket.
+ */
+#define PERF_HISTOGRAM_SUB_BITS 3
+#define PERF_HISTOGRAM_MAX_BITS 24
+#define PERF_HISTOGRAM_BUCKETS ((PERF_HISTOGRAM_MAX_BITS - PERF_HISTOGRAM_SUB_BITS + 1) << PERF_HISTOGRAM_SUB_BITS)
+
 /**
  * Header common to all counters.
  */
 struct perf_ctr_header {
-	sq_entry_t		link;	/**< list linkage */
-	enum perf_counter_type	type;	/**< counter type */
-	const char		*name;	/**< counter name */
+	perf_ctr_header		*next{nullptr};	/**< list linkage */
+	enum perf_counter_type	type;		/**< counter type */
+	const char		*name;		/**< counter name */
 };
 
 /**
- * PC_EVENT counter.
+ * PC_EVENT counter data.
  */
-struct perf_ctr_count : public perf_ctr_header {
+struct perf_count_data {
 	uint64_t		event_count{0};
 };
 
 /**
- * PC_ELAPSED counter.
+ * PC_ELAPSED counter data.
  */
-struct perf_ctr_elapsed : public perf_ctr_header {
+struct perf_elapsed_data {
 	uint64_t		event_count{0};
-	uint64_t		time_start{0};
 	uint64_t		time_total{0};
 	uint32_t		time_least{0};
 	uint32_t		time_most{0};
@@ -82,8 +105,147 @@ struct perf_ctr_elapsed : public perf_ctr_header {
 	float			M2{0.0f};
 };
 
+/**
+ * PC_HISTOGRAM counter data.
+ */
+struct perf_histogram_data {
+	uint64_t		event_count{0};
+	uint64_t		time_total{0};
+	uint32_t		time_most{0};
+	uint32_t		buckets[PERF_HISTOGRAM_BUCKETS] {};
+};
+
+/**
+ * Counter with per-thread data shards.
+ *
+ * Shard 0 is stored inline, the others are allocated (cache-line aligned) by perf_alloc(),
+ * so that updating a counter never allocates.
+ */
+template<typename T>
+struct perf_ctr_sharded : public perf_ctr_header {
+	T			data;
+#if PERF_SHARD_COUNT > 1
+	struct alignas(PERF_SHARD_ALIGN) aligned_shard {
+		T		data;
+	};
+
+	aligned_shard		*shards{nullptr};	/**< shards 1..PERF_SHARD_COUNT-1, nullptr if the allocation failed */
+
+	perf_ctr_sharded()
+	{
+		void *mem = nullptr;
+
+		if (posix_memalign(&mem, PERF_SHARD_ALIGN, (PERF_SHARD_COUNT - 1) * sizeof(aligned_shard)) == 0) {
+			shards = static_cast<aligned_shard *>(mem);
+
+			for (int i = 0; i < PERF_SHARD_COUNT - 1; i++) {
+				new (&shards[i]) aligned_shard();
+			}
+		}
+	}
+
+	~perf_ctr_sharded()
+	{
+		if (shards != nullptr) {
+			for (int i = 0; i < PERF_SHARD_COUNT - 1; i++) {
+				shards[i].~aligned_shard();
+			}
+
+			free(shards);
+		}
+	}
+#endif
+
+	/**
+	 * Get a shard for reading (nullptr if not allocated).
+	 */
+	const T *shard(int index) const
+	{
+#if PERF_SHARD_COUNT > 1
+
+		if (index > 0) {
+			return (shards != nullptr) ? &shards[index - 1].data : nullptr;
+		}
+
+#else
+		(void)index;
+#endif
+		return &data;
+	}
+
+	/**
+	 * Get the shard of the calling thread.
+	 */
+	T &local();
+
+	template<typename F>
+	void for_each_shard(F f)
+	{
+		for (int i = 0; i < PERF_SHARD_COUNT; i++) {
+			T *s = const_cast<T *>(shard(i));
+
+			if (s != nullptr) {
+				f(*s);
+			}
+		}
+	}
+};
+
+#if PERF_SHARD_COUNT > 1
+/**
+ * Shard index of the calling thread.
+ */
+static int
+perf_shard_index()
+{
+	static int next_index = 0;
+	static thread_local int index = -1;
+
+	if (index < 0) {
+		index = __atomic_fetch_add(&next_index, 1, __ATOMIC_RELAXED) % PERF_SHARD_COUNT;
+	}
+
+	return index;
+}
+
+template<typename T>
+T &perf_ctr_sharded<T>::local()
+{
+	const int index = perf_shard_index();
+
+	if ((index == 0) || (shards == nullptr)) {
+		return data;
+	}
+
+	return shards[index - 1].data;
+}
+#else
+template<typename T>
+T &perf_ctr_sharded<T>::local()
+{
+	return data;
+}
+#endif
+
+/**
+ * Sharded counter measuring time ranges (perf_begin/perf_end).
+ *
+ * The start time is not sharded, so perf_begin and perf_end can be called from different threads.
+ */
+template<typename T>
+struct perf_ctr_timed : public perf_ctr_sharded<T> {
+	uint64_t		time_start{0};
+};
+
+typedef perf_ctr_sharded<perf_count_data> perf_ctr_count;
+typedef perf_ctr_timed<perf_elapsed_data> perf_ctr_elapsed;
+typedef perf_ctr_timed<perf_histogram_data> perf_ctr_histogram;
+
 /**
  * PC_INTERVAL counter.
+ *
+ * Not sharded: the interval is measured between consecutive events, regardless
+ * of the thread they come from.
  */
 struct perf_ctr_interval : public perf_ctr_header {
 	uint64_t		event_count{0};
@@ -98,20 +260,207 @@ struct perf_ctr_interval : public perf_ctr_header {
 
 /**
  * List of all known counters.
+ *
+ * New counters are pushed to the head with a compare-and-swap, so perf_alloc()
+ * does not take the mutex. Removal and traversal still do.
  */
-static sq_queue_t	perf_counters = { nullptr, nullptr };
+static perf_counter_t	perf_counters = nullptr;
 
 /**
- * mutex protecting access to the perf_counters linked list (which is read from & written to by different threads)
+ * mutex protecting removal from and traversal of the perf_counters list
  */
 pthread_mutex_t perf_counters_mutex = PTHREAD_MUTEX_INITIALIZER;
 // FIXME: the mutex does **not** protect against access to/from the perf
 // counter's data. It can still happen that a counter is updated while it is
 // printed. This can lead to inconsistent output, or completely bogus values
 // (especially the 64bit values which are in general not atomically updated).
-// The same holds for shared perf counters (perf_alloc_once), that can be updated
-// concurrently (this affects the 'ctrl_latency' counter).
+// Threads sharing a shard (more threads than shards, or single-core targets) can
+// still update the same data concurrently (this affects the 'ctrl_latency' counter).
+
+static void
+perf_counters_push(perf_counter_t ctr)
+{
+	perf_counter_t head = __atomic_load_n(&perf_counters, __ATOMIC_RELAXED);
+
+	do {
+		ctr->next = head;
+	} while (!__atomic_compare_exchange_n(&perf_counters, &head, ctr, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static inline perf_counter_t
+perf_counters_head()
+{
+	return __atomic_load_n(&perf_counters, __ATOMIC_ACQUIRE);
+}
+
+static void
+elapsed_add(perf_elapsed_data &d, int64_t elapsed)
+{
+	d.event_count++;
+	d.time_total += elapsed;
+
+	if ((d.time_least > (uint32_t)elapsed) || (d.time_least == 0)) {
+		d.time_least = elapsed;
+	}
+
+	if (d.time_most < (uint32_t)elapsed) {
+		d.time_most = elapsed;
+	}
+
+	// maintain mean and variance of the elapsed time in seconds
+	// Knuth/Welford recursive mean and variance of update intervals (via Wikipedia)
+	float dt = elapsed / 1e6f;
+	float delta_intvl = dt - d.mean;
+	d.mean += delta_intvl / d.event_count;
+	d.M2 += delta_intvl * (dt - d.mean);
+}
+
+/**
+ * Merge the shards of an elapsed counter.
+ */
+static perf_elapsed_data
+elapsed_merge(perf_ctr_elapsed *pce)
+{
+	perf_elapsed_data sum;
+
+	pce->for_each_shard([&sum](const perf_elapsed_data & d) {
+		if (d.event_count == 0) {
+			return;
+		}
+
+		if (sum.event_count == 0 || d.time_least < sum.time_least) {
+			sum.time_least = d.time_least;
+		}
+
+		if (d.time_most > sum.time_most) {
+			sum.time_most = d.time_most;
+		}
+
+		// combine mean and variance of two sets (Chan et al.)
+		const uint64_t n = sum.event_count + d.event_count;
+		const float delta = d.mean - sum.mean;
+		sum.mean += delta * d.event_count / n;
+		sum.M2 += d.M2 + delta * delta * sum.event_count * d.event_count / n;
+
+		sum.event_count = n;
+		sum.time_total += d.time_total;
+	});
+
+	return sum;
+}
+
+static int
+histogram_bucket(uint32_t value)
+{
+	if (value < (1u << PERF_HISTOGRAM_SUB_BITS)) {
+		return value;
+	}
+
+	const int msb = 31 - __builtin_clz(value);
+
+	if (msb >= PERF_HISTOGRAM_MAX_BITS) {
+		return PERF_HISTOGRAM_BUCKETS - 1;
+	}
+
+	const int shift = msb - PERF_HISTOGRAM_SUB_BITS;
+	return ((shift + 1) << PERF_HISTOGRAM_SUB_BITS) + ((value >> shift) & ((1 << PERF_HISTOGRAM_SUB_BITS) - 1));
+}
+
+/**
+ * Largest value that falls into a bucket.
+ */
+static uint32_t
+histogram_bucket_max(int bucket)
+{
+	if (bucket < (1 << PERF_HISTOGRAM_SUB_BITS)) {
+		return bucket;
+	}
+
+	const int shift = (bucket >> PERF_HISTOGRAM_SUB_BITS) - 1;
+	const uint32_t sub = bucket & ((1 << PERF_HISTOGRAM_SUB_BITS) - 1);
+	return (((1u << PERF_HISTOGRAM_SUB_BITS) + sub + 1) << shift) - 1;
+}
 
+static void
+histogram_add(perf_histogram_data &d, int64_t elapsed)
+{
+	const uint32_t value = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+
+	d.event_count++;
+	d.time_total += elapsed;
+
+	if (d.time_most < value) {
+		d.time_most = value;
+	}
+
+	d.buckets[histogram_bucket(value)]++;
+}
+
+struct perf_histogram_summary {
+	uint64_t		event_count{0};
+	uint64_t		time_total{0};
+	uint32_t		time_most{0};
+	uint32_t		p50{0};
+	uint32_t		p99{0};
+};
+
+/**
+ * Merge the shards of a histogram counter and compute the percentiles.
+ * Percentiles are reported as the upper bound of the bucket, capped at the maximum.
+ */
+static perf_histogram_summary
+histogram_summarize(perf_ctr_histogram *pch)
+{
+	perf_histogram_summary sum;
+	const perf_histogram_data *shards[PERF_SHARD_COUNT];
+	int num_shards = 0;
+
+	for (int i = 0; i < PERF_SHARD_COUNT; i++) {
+		const perf_histogram_data *d = pch->shard(i);
+
+		if (d != nullptr && d->event_count > 0) {
+			shards[num_shards++] = d;
+			sum.event_count += d->event_count;
+			sum.time_total += d->time_total;
+
+			if (d->time_most > sum.time_most) {
+				sum.time_most = d->time_most;
+			}
+		}
+	}
+
+	if (sum.event_count == 0) {
+		return sum;
+	}
+
+	const uint64_t rank_p50 = (sum.event_count + 1) / 2;
+	const uint64_t rank_p99 = (sum.event_count * 99 + 99) / 100;
+	uint64_t cumulative = 0;
+
+	for (int bucket = 0; bucket < PERF_HISTOGRAM_BUCKETS && cumulative < rank_p99; bucket++) {
+		const uint64_t prev = cumulative;
+
+		for (int i = 0; i < num_shards; i++) {
+			cumulative += shards[i]->buckets[bucket];
+		}
+
+		uint32_t value = histogram_bucket_max(bucket);
+
+		if (value > sum.time_most) {
+			value = sum.time_most;
+		}
+
+		if (prev < rank_p50 && cumulative >= rank_p50) {
+			sum.p50 = value;
+		}
+
+		if (cumulative >= rank_p99) {
+			sum.p99 = value;
+		}
+	}
+
+	return sum;
+}
 
 perf_counter_t
 perf_alloc(enum perf_counter_type type, const char *name)
@@ -131,6 +480,10 @@ perf_alloc(enum perf_counter_type type, const char *name)
 		ctr = new perf_ctr_interval();
 		break;
 
+	case PC_HISTOGRAM:
+		ctr = new perf_ctr_histogram();
+		break;
+
 	default:
 		break;
 	}
@@ -138,9 +491,7 @@ perf_alloc(enum perf_counter_type type, const char *name)
 	if (ctr != nullptr) {
 		ctr->type = type;
 		ctr->name = name;
-		pthread_mutex_lock(&perf_counters_mutex);
-		sq_addfirst(&ctr->link, &perf_counters);
-		pthread_mutex_unlock(&perf_counters_mutex);
+		perf_counters_push(ctr);
 	}
 
 	return ctr;
@@ -149,8 +500,10 @@ perf_alloc(enum perf_counter_type type, const char *name)
 perf_counter_t
 perf_alloc_once(enum perf_counter_type type, const char *name)
 {
+	// hold the mutex until the new counter is added, so that two concurrent
+	// callers cannot both create the counter
 	pthread_mutex_lock(&perf_counters_mutex);
-	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+	perf_counter_t handle = perf_counters_head();
 
 	while (handle != nullptr) {
 		if (!strcmp(handle->name, name)) {
@@ -166,13 +519,14 @@ perf_alloc_once(enum perf_counter_type type, const char *name)
 			}
 		}
 
-		handle = (perf_counter_t)sq_next(&handle->link);
+		handle = handle->next;
 	}
 
+	/* if the execution reaches here, no existing counter of that name was found */
+	handle = perf_alloc(type, name);
 	pthread_mutex_unlock(&perf_counters_mutex);
 
-	/* if the execution reaches here, no existing counter of that name was found */
-	return perf_alloc(type, name);
+	return handle;
 }
 
 void
@@ -183,10 +537,42 @@ perf_free(perf_counter_t handle)
 	}
 
 	pthread_mutex_lock(&perf_counters_mutex);
-	sq_rem(&handle->link, &perf_counters);
+
+	// the head can change concurrently (perf_alloc), the rest of the list only with the mutex held
+	perf_counter_t expected = handle;
+
+	if (!__atomic_compare_exchange_n(&perf_counters, &expected, handle->next, false, __ATOMIC_ACQ_REL,
+					 __ATOMIC_ACQUIRE)) {
+		perf_counter_t prev = expected;
+
+		while (prev != nullptr && prev->next != handle) {
+			prev = prev->next;
+		}
+
+		if (prev != nullptr) {
+			prev->next = handle->next;
+		}
+	}
+
 	pthread_mutex_unlock(&perf_counters_mutex);
 
-	delete handle;
+	switch (handle->type) {
+	case PC_COUNT:
+		delete (perf_ctr_count *)handle;
+		break;
+
+	case PC_ELAPSED:
+		delete (perf_ctr_elapsed *)handle;
+		break;
+
+	case PC_INTERVAL:
+		delete (perf_ctr_interval *)handle;
+		break;
+
+	case PC_HISTOGRAM:
+		delete (perf_ctr_histogram *)handle;
+		break;
+	}
 }
 
 void
@@ -198,7 +584,7 @@ perf_count(perf_counter_t handle)
 
 	switch (handle->type) {
 	case PC_COUNT:
-		((struct perf_ctr_count *)handle)->event_count++;
+		((perf_ctr_count *)handle)->local().event_count++;
 		break;
 
 	case PC_INTERVAL:
@@ -219,7 +605,11 @@ perf_begin(perf_counter_t handle)
 
 	switch (handle->type) {
 	case PC_ELAPSED:
-		((struct perf_ctr_elapsed *)handle)->time_start = hrt_absolute_time();
+		((perf_ctr_elapsed *)handle)->time_start = hrt_absolute_time();
+		break;
+
+	case PC_HISTOGRAM:
+		((perf_ctr_histogram *)handle)->time_start = hrt_absolute_time();
 		break;
 
 	default:
@@ -236,33 +626,31 @@ perf_end(perf_counter_t handle)
 
 	switch (handle->type) {
 	case PC_ELAPSED: {
-			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
+			perf_ctr_elapsed *pce = (perf_ctr_elapsed *)handle;
 
 			if (pce->time_start != 0) {
 				int64_t elapsed = hrt_absolute_time() - pce->time_start;
 
 				if (elapsed >= 0) {
+					elapsed_add(pce->local(), elapsed);
+				}
 
-					pce->event_count++;
-					pce->time_total += elapsed;
-
-					if ((pce->time_least > (uint32_t)elapsed) || (pce->time_least == 0)) {
-						pce->time_least = elapsed;
-					}
+				pce->time_start = 0;
+			}
+		}
+		break;
 
-					if (pce->time_most < (uint32_t)elapsed) {
-						pce->time_most = elapsed;
-					}
+	case PC_HISTOGRAM: {
+			perf_ctr_histogram *pch = (perf_ctr_histogram *)handle;
 
-					// maintain mean and variance of the elapsed time in seconds
-					// Knuth/Welford recursive mean and variance of update intervals (via Wikipedia)
-					float dt = elapsed / 1e6f;
-					float delta_intvl = dt - pce->mean;
-					pce->mean += delta_intvl / pce->event_count;
-					pce->M2 += delta_intvl * (dt - pce->mean);
+			if (pch->time_start != 0) {
+				int64_t elapsed = hrt_absolute_time() - pch->time_start;
 
-					pce->time_start = 0;
+				if (elapsed >= 0) {
+					histogram_add(pch->local(), elapsed);
 				}
+
+				pch->time_start = 0;
 			}
 		}
 		break;
@@ -280,32 +668,20 @@ perf_set_elapsed(perf_counter_t handle, int64_t elapsed)
 	}
 
 	switch (handle->type) {
-	case PC_ELAPSED: {
-			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
-
-			if (elapsed >= 0) {
-
-				pce->event_count++;
-				pce->time_total += elapsed;
-
-				if ((pce->time_least > (uint32_t)elapsed) || (pce->time_least == 0)) {
-					pce->time_least = elapsed;
-				}
-
-				if (pce->time_most < (uint32_t)elapsed) {
-					pce->time_most = elapsed;
-				}
+	case PC_ELAPSED:
+		if (elapsed >= 0) {
+			elapsed_add(((perf_ctr_elapsed *)handle)->local(), elapsed);
+		}
 
-				// maintain mean and variance of the elapsed time in seconds
-				// Knuth/Welford recursive mean and variance of update intervals (via Wikipedia)
-				float dt = elapsed / 1e6f;
-				float delta_intvl = dt - pce->mean;
-				pce->mean += delta_intvl / pce->event_count;
-				pce->M2 += delta_intvl * (dt - pce->mean);
+		((perf_ctr_elapsed *)handle)->time_start = 0;
+		break;
 
-				pce->time_start = 0;
-			}
+	case PC_HISTOGRAM:
+		if (elapsed >= 0) {
+			histogram_add(((perf_ctr_histogram *)handle)->local(), elapsed);
 		}
+
+		((perf_ctr_histogram *)handle)->time_start = 0;
 		break;
 
 	default:
@@ -376,7 +752,9 @@ perf_set_count(perf_counter_t handle, uint64_t count)
 
 	switch (handle->type) {
 	case PC_COUNT: {
-			((struct perf_ctr_count *)handle)->event_count = count;
+			perf_ctr_count *pcc = (perf_ctr_count *)handle;
+			pcc->for_each_shard([](perf_count_data & d) { d.event_count = 0; });
+			pcc->data.event_count = count;
 		}
 		break;
 
@@ -394,11 +772,12 @@ perf_cancel(perf_counter_t handle)
 	}
 
 	switch (handle->type) {
-	case PC_ELAPSED: {
-			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
+	case PC_ELAPSED:
+		((perf_ctr_elapsed *)handle)->time_start = 0;
+		break;
 
-			pce->time_start = 0;
-		}
+	case PC_HISTOGRAM:
+		((perf_ctr_histogram *)handle)->time_start = 0;
 		break;
 
 	default:
@@ -415,18 +794,20 @@ perf_reset(perf_counter_t handle)
 
 	switch (handle->type) {
 	case PC_COUNT:
-		((struct perf_ctr_count *)handle)->event_count = 0;
+		((perf_ctr_count *)handle)->for_each_shard([](perf_count_data & d) { d.event_count = 0; });
 		break;
 
-	case PC_ELAPSED: {
-			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
-			pce->event_count = 0;
-			pce->time_start = 0;
-			pce->time_total = 0;
-			pce->time_least = 0;
-			pce->time_most = 0;
-			break;
-		}
+	case PC_ELAPSED:
+		((perf_ctr_elapsed *)handle)->time_start = 0;
+		((perf_ctr_elapsed *)handle)->for_each_shard([](perf_elapsed_data & d) {
+			d.event_count = 0;
+			d.time_total = 0;
+			d.time_least = 0;
+			d.time_most = 0;
+			d.mean = 0.0f;
+			d.M2 = 0.0f;
+		});
+		break;
 
 	case PC_INTERVAL: {
 			struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
@@ -438,9 +819,27 @@ perf_reset(perf_counter_t handle)
 			pci->time_most = 0;
 			break;
 		}
+
+	case PC_HISTOGRAM:
+		((perf_ctr_histogram *)handle)->time_start = 0;
+		((perf_ctr_histogram *)handle)->for_each_shard([](perf_histogram_data & d) {
+			d.event_count = 0;
+			d.time_total = 0;
+			d.time_most = 0;
+			memset(d.buckets, 0, sizeof(d.buckets));
+		});
+		break;
 	}
 }
 
+static uint64_t
+count_merge(perf_ctr_count *pcc)
+{
+	uint64_t event_count = 0;
+	pcc->for_each_shard([&event_count](const perf_count_data & d) { event_count += d.event_count; });
+	return event_count;
+}
+
 void
 perf_print_counter(perf_counter_t handle)
 {
@@ -462,19 +861,19 @@ perf_print_counter_fd(int fd, perf_counter_t handle)
 	case PC_COUNT:
 		dprintf(fd, "%s: %llu events\n",
 			handle->name,
-			(unsigned long long)((struct perf_ctr_count *)handle)->event_count);
+			(unsigned long long)count_merge((perf_ctr_count *)handle));
 		break;
 
 	case PC_ELAPSED: {
-			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
-			float rms = sqrtf(pce->M2 / (pce->event_count - 1));
+			const perf_elapsed_data pce = elapsed_merge((perf_ctr_elapsed *)handle);
+			float rms = sqrtf(pce.M2 / (pce.event_count - 1));
 			dprintf(fd, "%s: %llu events, %lluus elapsed, %.2fus avg, min %lluus max %lluus %5.3fus rms\n",
 				handle->name,
-				(unsigned long long)pce->event_count,
-				(unsigned long long)pce->time_total,
-				(pce->event_count == 0) ? 0 : (double)pce->time_total / (double)pce->event_count,
-				(unsigned long long)pce->time_least,
-				(unsigned long long)pce->time_most,
+				(unsigned long long)pce.event_count,
+				(unsigned long long)pce.time_total,
+				(pce.event_count == 0) ? 0 : (double)pce.time_total / (double)pce.event_count,
+				(unsigned long long)pce.time_least,
+				(unsigned long long)pce.time_most,
 				(double)(1e6f * rms));
 			break;
 		}
@@ -493,6 +892,18 @@ perf_print_counter_fd(int fd, perf_counter_t handle)
 			break;
 		}
 
+	case PC_HISTOGRAM: {
+			const perf_histogram_summary pch = histogram_summarize((perf_ctr_histogram *)handle);
+			dprintf(fd, "%s: %llu events, %.2fus avg, p50 %lluus p99 %lluus max %lluus\n",
+				handle->name,
+				(unsigned long long)pch.event_count,
+				(pch.event_count == 0) ? 0 : (double)pch.time_total / (double)pch.event_count,
+				(unsigned long long)pch.p50,
+				(unsigned long long)pch.p99,
+				(unsigned long long)pch.time_most);
+			break;
+		}
+
 	default:
 		break;
 	}
@@ -512,19 +923,19 @@ perf_print_counter_buffer(char *buffer, int length, perf_counter_t handle)
 	case PC_COUNT:
 		num_written = snprintf(buffer, length, "%s: %llu events",
 				       handle->name,
-				       (unsigned long long)((struct perf_ctr_count *)handle)->event_count);
+				       (unsigned long long)count_merge((perf_ctr_count *)handle));
 		break;
 
 	case PC_ELAPSED: {
-			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
-			float rms = sqrtf(pce->M2 / (pce->event_count - 1));
+			const perf_elapsed_data pce = elapsed_merge((perf_ctr_elapsed *)handle);
+			float rms = sqrtf(pce.M2 / (pce.event_count - 1));
 			num_written = snprintf(buffer, length, "%s: %llu events, %lluus elapsed, %.2fus avg, min %lluus max %lluus %5.3fus rms",
 					       handle->name,
-					       (unsigned long long)pce->event_count,
-					       (unsigned long long)pce->time_total,
-					       (pce->event_count == 0) ? 0 : (double)pce->time_total / (double)pce->event_count,
-					       (unsigned long long)pce->time_least,
-					       (unsigned long long)pce->time_most,
+					       (unsigned long long)pce.event_count,
+					       (unsigned long long)pce.time_total,
+					       (pce.event_count == 0) ? 0 : (double)pce.time_total / (double)pce.event_count,
+					       (unsigned long long)pce.time_least,
+					       (unsigned long long)pce.time_most,
 					       (double)(1e6f * rms));
 			break;
 		}
@@ -543,6 +954,18 @@ perf_print_counter_buffer(char *buffer, int length, perf_counter_t handle)
 			break;
 		}
 
+	case PC_HISTOGRAM: {
+			const perf_histogram_summary pch = histogram_summarize((perf_ctr_histogram *)handle);
+			num_written = snprintf(buffer, length, "%s: %llu events, %.2fus avg, p50 %lluus p99 %lluus max %lluus",
+					       handle->name,
+					       (unsigned long long)pch.event_count,
+					       (pch.event_count == 0) ? 0 : (double)pch.time_total / (double)pch.event_count,
+					       (unsigned long long)pch.p50,
+					       (unsigned long long)pch.p99,
+					       (unsigned long long)pch.time_most);
+			break;
+		}
+
 	default:
 		break;
 	}
@@ -560,11 +983,12 @@ perf_event_count(perf_counter_t handle)
 
 	switch (handle->type) {
 	case PC_COUNT:
-		return ((struct perf_ctr_count *)handle)->event_count;
+		return count_merge((perf_ctr_count *)handle);
 
 	case PC_ELAPSED: {
-			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
-			return pce->event_count;
+			uint64_t event_count = 0;
+			((perf_ctr_elapsed *)handle)->for_each_shard([&event_count](const perf_elapsed_data & d) { event_count += d.event_count; });
+			return event_count;
 		}
 
 	case PC_INTERVAL: {
@@ -572,6 +996,12 @@ perf_event_count(perf_counter_t handle)
 			return pci->event_count;
 		}
 
+	case PC_HISTOGRAM: {
+			uint64_t event_count = 0;
+			((perf_ctr_histogram *)handle)->for_each_shard([&event_count](const perf_histogram_data & d) { event_count += d.event_count; });
+			return event_count;
+		}
+
 	default:
 		break;
 	}
@@ -587,16 +1017,24 @@ perf_mean(perf_counter_t handle)
 	}
 
 	switch (handle->type) {
-	case PC_ELAPSED: {
-			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
-			return pce->mean;
-		}
+	case PC_ELAPSED:
+		return elapsed_merge((perf_ctr_elapsed *)handle).mean;
 
 	case PC_INTERVAL: {
 			struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
 			return pci->mean;
 		}
 
+	case PC_HISTOGRAM: {
+			uint64_t event_count = 0;
+			uint64_t time_total = 0;
+			((perf_ctr_histogram *)handle)->for_each_shard([&](const perf_histogram_data & d) {
+				event_count += d.event_count;
+				time_total += d.time_total;
+			});
+			return (event_count == 0) ? 0.0f : (float)(time_total / 1e6 / event_count);
+		}
+
 	default:
 		break;
 	}
@@ -608,11 +1046,11 @@ void
 perf_iterate_all(perf_callback cb, void *user)
 {
 	pthread_mutex_lock(&perf_counters_mutex);
-	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+	perf_counter_t handle = perf_counters_head();
 
 	while (handle != nullptr) {
 		cb(handle, user);
-		handle = (perf_counter_t)sq_next(&handle->link);
+		handle = handle->next;
 	}
 
 	pthread_mutex_unlock(&perf_counters_mutex);
@@ -622,11 +1060,11 @@ void
 perf_print_all(int fd)
 {
 	pthread_mutex_lock(&perf_counters_mutex);
-	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+	perf_counter_t handle = perf_counters_head();
 
 	while (handle != nullptr) {
 		perf_print_counter_fd(fd, handle);
-		handle = (perf_counter_t)sq_next(&handle->link);
+		handle = handle->next;
 	}
 
 	pthread_mutex_unlock(&perf_counters_mutex);
@@ -649,11 +1087,11 @@ void
 perf_reset_all(void)
 {
 	pthread_mutex_lock(&perf_counters_mutex);
-	perf_counter_t handle = (perf_counter_t)sq_peek(&perf_counters);
+	perf_counter_t handle = perf_counters_head();
 
 	while (handle != nullptr) {
 		perf_reset(handle);
-		handle = (perf_counter_t)sq_next(&handle->link);
+		handle = handle->next;
 	}
 
 	pthread_mutex_unlock(&perf_counters_mutex);
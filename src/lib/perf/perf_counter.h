@@ -48,7 +48,8 @@
 enum perf_counter_type {
 	PC_COUNT,		/**< count the number of times an event occurs */
 	PC_ELAPSED,		/**< measure the time elapsed performing an event */
-	PC_INTERVAL		/**< measure the interval between instances of an event */
+	PC_INTERVAL,		/**< measure the interval between instances of an event */
+	PC_HISTOGRAM		/**< latency distribution of an event (p50/p99/max) */
 };
 
 struct perf_ctr_header;
@@ -98,6 +99,8 @@ __EXPORT extern void		perf_count(perf_counter_t handle);
  * Begin a performance event.
  *
  * This call applies to counters that operate over ranges of time; PC_ELAPSED etc.
+ * perf_begin and the matching perf_end may be called from different threads,
+ * but only one range per counter can be measured at a time.
  *
  * @param handle		The handle returned from perf_alloc.
  */
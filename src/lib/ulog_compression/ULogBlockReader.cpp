@@ -0,0 +1,323 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "ULogBlockReader.hpp"
+#include "lz4_block.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ulog_compression
+{
+
+ULogBlockReader::~ULogBlockReader()
+{
+	close();
+}
+
+bool ULogBlockReader::is_compressed_file(const char *path)
+{
+	int fd = ::open(path, O_RDONLY);
+
+	if (fd < 0) {
+		return false;
+	}
+
+	ulog_block_file_header_s header;
+	const bool ret = ::read(fd, &header, sizeof(header)) == sizeof(header)
+			 && memcmp(header.magic, ULOG_BLOCK_FILE_MAGIC, sizeof(header.magic)) == 0;
+	::close(fd);
+	return ret;
+}
+
+bool ULogBlockReader::open(const char *path)
+{
+	close();
+
+	_fd = ::open(path, O_RDONLY);
+
+	if (_fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	ulog_block_file_header_s header;
+
+	if (fstat(_fd, &st) != 0 || !read_at(0, &header, sizeof(header))
+	    || memcmp(header.magic, ULOG_BLOCK_FILE_MAGIC, sizeof(header.magic)) != 0
+	    || header.version != ULOG_BLOCK_FILE_VERSION || header.codec != (uint8_t)ULogBlockCodec::LZ4
+	    || header.block_size == 0 || header.block_size > ULOG_BLOCK_SIZE_MAX) {
+		close();
+		return false;
+	}
+
+	_block_size = header.block_size;
+	_compressed = new uint8_t[lz4_compress_bound(_block_size)];
+	_block = new uint8_t[_block_size];
+
+	if (!_compressed || !_block) {
+		close();
+		return false;
+	}
+
+	const uint64_t file_size = st.st_size;
+
+	if (!load_index(file_size)) {
+		_num_blocks = 0;
+		_index_rebuilt = true;
+
+		if (!scan_blocks(file_size)) {
+			close();
+			return false;
+		}
+	}
+
+	_size = 0;
+
+	if (_num_blocks > 0) {
+		ulog_block_header_s last;
+
+		if (!read_at(_offsets[_num_blocks - 1], &last, sizeof(last))) {
+			close();
+			return false;
+		}
+
+		_size = (uint64_t)(_num_blocks - 1) * _block_size + last.raw_size;
+	}
+
+	return true;
+}
+
+void ULogBlockReader::close()
+{
+	if (_fd >= 0) {
+		::close(_fd);
+		_fd = -1;
+	}
+
+	free(_offsets);
+	_offsets = nullptr;
+	_offsets_capacity = 0;
+	_num_blocks = 0;
+	_size = 0;
+	_index_rebuilt = false;
+
+	delete[] _compressed;
+	delete[] _block;
+	_compressed = nullptr;
+	_block = nullptr;
+	_cached_block = -1;
+}
+
+bool ULogBlockReader::read_at(uint64_t offset, void *buffer, size_t size)
+{
+	return ::pread(_fd, buffer, size, (off_t)offset) == (ssize_t)size;
+}
+
+bool ULogBlockReader::add_block(uint64_t offset)
+{
+	if (_num_blocks == _offsets_capacity) {
+		const uint32_t capacity = _offsets_capacity ? _offsets_capacity * 2 : 256;
+		uint64_t *offsets = (uint64_t *)realloc(_offsets, capacity * sizeof(uint64_t));
+
+		if (!offsets) {
+			return false;
+		}
+
+		_offsets = offsets;
+		_offsets_capacity = capacity;
+	}
+
+	_offsets[_num_blocks++] = offset;
+	return true;
+}
+
+bool ULogBlockReader::load_index(uint64_t file_size)
+{
+	ulog_block_trailer_s trailer;
+
+	if (file_size < sizeof(ulog_block_file_header_s) + sizeof(trailer)
+	    || !read_at(file_size - sizeof(trailer), &trailer, sizeof(trailer))
+	    || memcmp(trailer.magic, ULOG_BLOCK_TRAILER_MAGIC, sizeof(trailer.magic)) != 0) {
+		return false;
+	}
+
+	const uint32_t capacity = (trailer.num_blocks > 0) ? trailer.num_blocks : 1;
+	_offsets = (uint64_t *)malloc(capacity * sizeof(uint64_t));
+
+	if (!_offsets) {
+		return false;
+	}
+
+	_offsets_capacity = capacity;
+	_num_blocks = trailer.num_blocks;
+
+	// fill the index from the back
+	uint32_t missing = trailer.num_blocks;
+	uint64_t index_offset = trailer.index_offset;
+
+	while (missing > 0) {
+		ulog_block_header_s header;
+		ulog_block_index_s index;
+
+		if (index_offset < sizeof(ulog_block_file_header_s) || index_offset >= file_size
+		    || !read_at(index_offset, &header, sizeof(header))
+		    || header.type != (uint8_t)ULogBlockType::Index
+		    || !read_at(index_offset + sizeof(header), &index, sizeof(index))
+		    || index.num_blocks == 0 || index.num_blocks > missing
+		    || index.first_block + index.num_blocks != missing
+		    || !read_at(index_offset + sizeof(header) + sizeof(index), &_offsets[index.first_block],
+				index.num_blocks * sizeof(uint64_t))) {
+			return false;
+		}
+
+		missing = index.first_block;
+		index_offset = index.prev_index_offset;
+	}
+
+	return true;
+}
+
+bool ULogBlockReader::scan_blocks(uint64_t file_size)
+{
+	uint64_t offset = sizeof(ulog_block_file_header_s);
+	ulog_block_header_s header;
+	bool previous_partial = false;
+
+	while (offset + sizeof(header) <= file_size && read_at(offset, &header, sizeof(header))) {
+		if (memcmp(header.magic, ULOG_BLOCK_MAGIC, sizeof(header.magic)) != 0) {
+			break;
+		}
+
+		const uint64_t next = offset + sizeof(header) + header.size;
+
+		if (next > file_size) {
+			// incompletely written block
+			break;
+		}
+
+		if (header.type != (uint8_t)ULogBlockType::Index) {
+			// only the last block can be smaller than the block size
+			if (previous_partial || header.raw_size > _block_size) {
+				break;
+			}
+
+			if (!add_block(offset)) {
+				return false;
+			}
+
+			previous_partial = header.raw_size != _block_size;
+		}
+
+		offset = next;
+	}
+
+	return true;
+}
+
+const uint8_t *ULogBlockReader::get_block(uint32_t block, size_t &size)
+{
+	if (block >= _num_blocks) {
+		return nullptr;
+	}
+
+	if (_cached_block == block) {
+		size = _cached_size;
+		return _block;
+	}
+
+	_cached_block = -1;
+
+	ulog_block_header_s header;
+
+	if (!read_at(_offsets[block], &header, sizeof(header))
+	    || memcmp(header.magic, ULOG_BLOCK_MAGIC, sizeof(header.magic)) != 0
+	    || header.raw_size > _block_size || (block + 1 < _num_blocks && header.raw_size != _block_size)) {
+		return nullptr;
+	}
+
+	if (header.type == (uint8_t)ULogBlockType::Stored) {
+		if (header.size != header.raw_size || !read_at(_offsets[block] + sizeof(header), _block, header.size)) {
+			return nullptr;
+		}
+
+	} else if (header.type == (uint8_t)ULogBlockType::Compressed) {
+		if (header.size > lz4_compress_bound(_block_size)
+		    || !read_at(_offsets[block] + sizeof(header), _compressed, header.size)
+		    || lz4_decompress_block(_compressed, header.size, _block, _block_size) != (int)header.raw_size) {
+			return nullptr;
+		}
+
+	} else {
+		return nullptr;
+	}
+
+	_cached_block = block;
+	_cached_size = header.raw_size;
+	size = _cached_size;
+	return _block;
+}
+
+ssize_t ULogBlockReader::read(uint64_t offset, void *buffer, size_t size)
+{
+	uint8_t *dst = (uint8_t *)buffer;
+	size_t total = 0;
+
+	while (total < size && offset < _size) {
+		size_t block_data_size;
+		const uint8_t *block_data = get_block(offset / _block_size, block_data_size);
+
+		if (!block_data) {
+			return -1;
+		}
+
+		const size_t block_offset = offset % _block_size;
+		size_t n = block_data_size - block_offset;
+
+		if (n > size - total) {
+			n = size - total;
+		}
+
+		memcpy(&dst[total], &block_data[block_offset], n);
+		total += n;
+		offset += n;
+	}
+
+	return total;
+}
+
+} // namespace ulog_compression
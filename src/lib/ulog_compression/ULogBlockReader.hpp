@@ -0,0 +1,125 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file ULogBlockReader.hpp
+ * Random access to the ULog data stored in a compressed ULog container (see ulog_block_format.h).
+ */
+
+#pragma once
+
+#include "ulog_block_format.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace ulog_compression
+{
+
+class ULogBlockReader
+{
+public:
+	ULogBlockReader() = default;
+	~ULogBlockReader();
+
+	ULogBlockReader(const ULogBlockReader &) = delete;
+	ULogBlockReader &operator=(const ULogBlockReader &) = delete;
+
+	/**
+	 * Check whether a file is a compressed ULog container
+	 */
+	static bool is_compressed_file(const char *path);
+
+	/**
+	 * Open a file and load the block index.
+	 * @return false if the file cannot be opened or is not a valid container
+	 */
+	bool open(const char *path);
+
+	void close();
+
+	bool is_open() const { return _fd >= 0; }
+
+	/** size of the uncompressed ULog data */
+	uint64_t size() const { return _size; }
+
+	uint32_t block_size() const { return _block_size; }
+	uint32_t num_blocks() const { return _num_blocks; }
+
+	/** whether the index was rebuilt because the trailer is missing (incompletely written file) */
+	bool index_rebuilt() const { return _index_rebuilt; }
+
+	/**
+	 * Decompress a block. The previous block is cached, so sequential access decompresses each block once.
+	 * @param block block number (the block at ULog offset x is x / block_size())
+	 * @param size set to the uncompressed size of the block
+	 * @return block data, valid until the next call, or nullptr on error
+	 */
+	const uint8_t *get_block(uint32_t block, size_t &size);
+
+	/**
+	 * Read uncompressed data.
+	 * @return number of bytes read (less than size at the end of the data), -1 on error
+	 */
+	ssize_t read(uint64_t offset, void *buffer, size_t size);
+
+private:
+	bool read_at(uint64_t offset, void *buffer, size_t size);
+
+	/** load the index by following the index blocks backwards from the trailer */
+	bool load_index(uint64_t file_size);
+
+	/** rebuild the index by walking all block headers */
+	bool scan_blocks(uint64_t file_size);
+
+	bool add_block(uint64_t offset);
+
+	int _fd{-1};
+
+	uint32_t _block_size{0};
+	uint64_t _size{0};
+
+	uint64_t *_offsets{nullptr}; ///< file offsets of the data blocks
+	uint32_t _num_blocks{0};
+	uint32_t _offsets_capacity{0};
+	bool _index_rebuilt{false};
+
+	uint8_t *_compressed{nullptr};
+	uint8_t *_block{nullptr}; ///< decompressed data of _cached_block
+	size_t _cached_size{0};
+	int64_t _cached_block{-1};
+};
+
+} // namespace ulog_compression
@@ -0,0 +1,216 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "ULogBlockWriter.hpp"
+#include "lz4_block.h"
+
+#include <string.h>
+
+namespace ulog_compression
+{
+
+ULogBlockWriter::~ULogBlockWriter()
+{
+	delete[] _block;
+	delete[] _hash_table;
+	delete[] _output;
+}
+
+bool ULogBlockWriter::init(uint32_t block_size)
+{
+	if (block_size == 0 || block_size > ULOG_BLOCK_SIZE_MAX) {
+		return false;
+	}
+
+	if (_block && block_size == _block_size) {
+		return true;
+	}
+
+	delete[] _block;
+	delete[] _hash_table;
+	delete[] _output;
+
+	_block_size = block_size;
+
+	// worst case output of finish(): the last data block, an index block and the trailer
+	const size_t output_capacity = sizeof(ulog_block_header_s) + lz4_compress_bound(_block_size)
+				       + sizeof(ulog_block_header_s) + sizeof(ulog_block_index_s) + sizeof(_index)
+				       + sizeof(ulog_block_trailer_s);
+
+	_block = new uint8_t[_block_size];
+	_hash_table = new uint16_t[LZ4_HASH_TABLE_SIZE];
+	_output = new uint8_t[output_capacity];
+
+	if (!_block || !_hash_table || !_output) {
+		delete[] _block;
+		delete[] _hash_table;
+		delete[] _output;
+		_block = nullptr;
+		_hash_table = nullptr;
+		_output = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+size_t ULogBlockWriter::begin(const uint8_t **data)
+{
+	_block_fill = 0;
+	_index_count = 0;
+	_last_index_offset = 0;
+	_num_blocks = 0;
+	_raw_bytes = 0;
+
+	ulog_block_file_header_s header{};
+	memcpy(header.magic, ULOG_BLOCK_FILE_MAGIC, sizeof(header.magic));
+	header.version = ULOG_BLOCK_FILE_VERSION;
+	header.block_size = _block_size;
+	header.codec = (uint8_t)ULogBlockCodec::LZ4;
+
+	memcpy(_output, &header, sizeof(header));
+	_file_offset = sizeof(header);
+
+	*data = _output;
+	return sizeof(header);
+}
+
+size_t ULogBlockWriter::append(const void *data, size_t size)
+{
+	const size_t n = (size < _block_size - _block_fill) ? size : _block_size - _block_fill;
+	memcpy(&_block[_block_fill], data, n);
+	_block_fill += n;
+	_raw_bytes += n;
+	return n;
+}
+
+size_t ULogBlockWriter::flush_block(const uint8_t **data)
+{
+	_output_size = 0;
+
+	if (_block_fill > 0) {
+		write_data_block();
+
+		if (_index_count == ULOG_BLOCK_INDEX_ENTRIES) {
+			write_index_block();
+		}
+	}
+
+	*data = _output;
+	return _output_size;
+}
+
+size_t ULogBlockWriter::finish(const uint8_t **data)
+{
+	_output_size = 0;
+
+	if (_block_fill > 0) {
+		write_data_block();
+	}
+
+	if (_index_count > 0) {
+		write_index_block();
+	}
+
+	ulog_block_trailer_s trailer{};
+	trailer.index_offset = _last_index_offset;
+	trailer.num_blocks = _num_blocks;
+	memcpy(trailer.magic, ULOG_BLOCK_TRAILER_MAGIC, sizeof(trailer.magic));
+
+	memcpy(&_output[_output_size], &trailer, sizeof(trailer));
+	_output_size += sizeof(trailer);
+	_file_offset += sizeof(trailer);
+
+	*data = _output;
+	return _output_size;
+}
+
+void ULogBlockWriter::write_data_block()
+{
+	uint8_t *out = &_output[_output_size];
+	uint8_t *payload = out + sizeof(ulog_block_header_s);
+
+	ulog_block_header_s header{};
+	memcpy(header.magic, ULOG_BLOCK_MAGIC, sizeof(header.magic));
+	header.raw_size = _block_fill;
+
+	// store the block as-is if it does not get smaller
+	size_t size = lz4_compress_block(_block, _block_fill, payload, _block_fill - 1, _hash_table);
+
+	if (size > 0) {
+		header.type = (uint8_t)ULogBlockType::Compressed;
+
+	} else {
+		header.type = (uint8_t)ULogBlockType::Stored;
+		size = _block_fill;
+		memcpy(payload, _block, size);
+	}
+
+	header.size = size;
+	memcpy(out, &header, sizeof(header));
+
+	_index[_index_count++] = _file_offset;
+	++_num_blocks;
+
+	_output_size += sizeof(header) + size;
+	_file_offset += sizeof(header) + size;
+	_block_fill = 0;
+}
+
+void ULogBlockWriter::write_index_block()
+{
+	uint8_t *out = &_output[_output_size];
+
+	ulog_block_index_s index{};
+	index.prev_index_offset = _last_index_offset;
+	index.first_block = _num_blocks - _index_count;
+	index.num_blocks = _index_count;
+
+	ulog_block_header_s header{};
+	memcpy(header.magic, ULOG_BLOCK_MAGIC, sizeof(header.magic));
+	header.type = (uint8_t)ULogBlockType::Index;
+	header.size = sizeof(index) + _index_count * sizeof(_index[0]);
+
+	memcpy(out, &header, sizeof(header));
+	memcpy(out + sizeof(header), &index, sizeof(index));
+	memcpy(out + sizeof(header) + sizeof(index), _index, _index_count * sizeof(_index[0]));
+
+	_last_index_offset = _file_offset;
+	_index_count = 0;
+
+	_output_size += sizeof(header) + header.size;
+	_file_offset += sizeof(header) + header.size;
+}
+
+} // namespace ulog_compression
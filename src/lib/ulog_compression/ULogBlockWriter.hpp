@@ -0,0 +1,125 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file ULogBlockWriter.hpp
+ * Produces the compressed ULog container (see ulog_block_format.h) from a ULog byte stream.
+ *
+ * The writer does not do any I/O: it returns the data to be appended to the file, so that the
+ * caller is in control of when (and from which thread) compression and writing happen.
+ */
+
+#pragma once
+
+#include "ulog_block_format.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ulog_compression
+{
+
+class ULogBlockWriter
+{
+public:
+	ULogBlockWriter() = default;
+	~ULogBlockWriter();
+
+	ULogBlockWriter(const ULogBlockWriter &) = delete;
+	ULogBlockWriter &operator=(const ULogBlockWriter &) = delete;
+
+	/**
+	 * Allocate the buffers
+	 * @param block_size uncompressed block size (at most ULOG_BLOCK_SIZE_MAX)
+	 * @return false on allocation failure or invalid block size
+	 */
+	bool init(uint32_t block_size = ULOG_BLOCK_SIZE_DEFAULT);
+
+	/**
+	 * Start a new file.
+	 * @param data set to the file header, valid until the next call
+	 * @return size of the file header
+	 */
+	size_t begin(const uint8_t **data);
+
+	/**
+	 * Copy data into the current block.
+	 * @return number of bytes consumed, less than size if the block got full
+	 */
+	size_t append(const void *data, size_t size);
+
+	bool block_full() const { return _block_fill == _block_size; }
+
+	/**
+	 * Compress the current (full) block.
+	 * @param data set to the output (the block, possibly followed by an index block), valid until the next call
+	 * @return output size
+	 */
+	size_t flush_block(const uint8_t **data);
+
+	/**
+	 * Finish the file: compress the remaining data and write the last index block and the trailer.
+	 * @param data set to the output, valid until the next call
+	 * @return output size
+	 */
+	size_t finish(const uint8_t **data);
+
+	uint64_t raw_bytes() const { return _raw_bytes; }
+	uint64_t file_bytes() const { return _file_offset; }
+
+private:
+	/** compress the current block into the output buffer */
+	void write_data_block();
+
+	/** write the index block for the data blocks since the last one into the output buffer */
+	void write_index_block();
+
+	uint32_t _block_size{0};
+	uint32_t _block_fill{0};
+	uint8_t *_block{nullptr}; ///< uncompressed data of the current block
+	uint16_t *_hash_table{nullptr};
+
+	uint8_t *_output{nullptr};
+	size_t _output_size{0}; ///< bytes in _output
+
+	uint64_t _index[ULOG_BLOCK_INDEX_ENTRIES] {}; ///< file offsets of the data blocks since the last index block
+	uint32_t _index_count{0};
+	uint64_t _last_index_offset{0};
+	uint32_t _num_blocks{0};
+
+	uint64_t _file_offset{0}; ///< file offset of the next output byte
+	uint64_t _raw_bytes{0};
+};
+
+} // namespace ulog_compression
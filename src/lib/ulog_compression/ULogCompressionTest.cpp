@@ -0,0 +1,300 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file ULogCompressionTest.cpp
+ * Tests for the LZ4 block codec and the compressed ULog container.
+ */
+
+#include <gtest/gtest.h>
+
+#include "lz4_block.h"
+#include "ULogBlockReader.hpp"
+#include "ULogBlockWriter.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace ulog_compression;
+
+// ULog-like data: repeating messages with a few changing bytes (timestamp and sensor noise)
+static void fill_log_data(uint8_t *data, size_t size, unsigned seed)
+{
+	srand(seed);
+	uint64_t timestamp = 1000000;
+
+	for (size_t i = 0; i < size;) {
+		uint8_t message[40] {};
+		message[0] = sizeof(message) - 3;
+		message[2] = 'D';
+		message[3] = (uint8_t)(rand() % 4);
+		timestamp += 4000 + rand() % 3;
+		memcpy(&message[5], &timestamp, sizeof(timestamp));
+
+		message[20 + message[3]] = 0x3f;
+
+		for (size_t j = 32; j < sizeof(message); j += 2) {
+			message[j] = (uint8_t)rand();
+		}
+
+		const size_t n = (size - i < sizeof(message)) ? size - i : sizeof(message);
+		memcpy(&data[i], message, n);
+		i += n;
+	}
+}
+
+static void lz4_round_trip(const uint8_t *data, size_t size, bool expect_compressed)
+{
+	uint16_t hash_table[LZ4_HASH_TABLE_SIZE];
+	uint8_t *compressed = new uint8_t[lz4_compress_bound(size)];
+	uint8_t *decompressed = new uint8_t[size + 1];
+
+	const size_t compressed_size = lz4_compress_block(data, size, compressed, lz4_compress_bound(size), hash_table);
+	ASSERT_GT(compressed_size, 0u);
+
+	if (expect_compressed) {
+		EXPECT_LT(compressed_size, size / 2);
+	}
+
+	EXPECT_EQ(lz4_decompress_block(compressed, compressed_size, decompressed, size + 1), (int)size);
+	EXPECT_EQ(memcmp(data, decompressed, size), 0);
+
+	// the output must not fit into a smaller buffer
+	if (size > 0) {
+		EXPECT_EQ(lz4_decompress_block(compressed, compressed_size, decompressed, size - 1), -1);
+	}
+
+	delete[] compressed;
+	delete[] decompressed;
+}
+
+TEST(LZ4Block, RoundTrip)
+{
+	static constexpr size_t SIZE = 16 * 1024;
+	uint8_t *data = new uint8_t[SIZE];
+
+	fill_log_data(data, SIZE, 1);
+	lz4_round_trip(data, SIZE, true);
+
+	// short inputs are stored as literals only
+	for (size_t size = 0; size < 20; ++size) {
+		lz4_round_trip(data, size, false);
+	}
+
+	// long runs use overlapping matches and long length encodings
+	memset(data, 0xaa, SIZE);
+	lz4_round_trip(data, SIZE, true);
+
+	// incompressible data
+	srand(2);
+
+	for (size_t i = 0; i < SIZE; ++i) {
+		data[i] = (uint8_t)rand();
+	}
+
+	lz4_round_trip(data, SIZE, false);
+
+	delete[] data;
+}
+
+TEST(LZ4Block, CorruptInput)
+{
+	static constexpr size_t SIZE = 4096;
+	uint8_t data[SIZE];
+	uint8_t compressed[lz4_compress_bound(SIZE)];
+	uint8_t decompressed[SIZE];
+	uint16_t hash_table[LZ4_HASH_TABLE_SIZE];
+
+	fill_log_data(data, SIZE, 3);
+	const size_t compressed_size = lz4_compress_block(data, SIZE, compressed, sizeof(compressed), hash_table);
+	ASSERT_GT(compressed_size, 0u);
+
+	// truncated input
+	EXPECT_EQ(lz4_decompress_block(compressed, compressed_size / 2, decompressed, SIZE), -1);
+
+	// random corruption must never write outside of the output buffer (checked by ASan)
+	srand(4);
+
+	for (int i = 0; i < 1000; ++i) {
+		uint8_t corrupt[sizeof(compressed)];
+		memcpy(corrupt, compressed, compressed_size);
+		corrupt[rand() % compressed_size] = (uint8_t)rand();
+		lz4_decompress_block(corrupt, compressed_size, decompressed, SIZE);
+	}
+
+	// output too small for compression
+	EXPECT_EQ(lz4_compress_block(data, SIZE, compressed, 16, hash_table), 0u);
+}
+
+class ULogBlockContainerTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		snprintf(_file_name, sizeof(_file_name), "ulog_compression_test_%i.ulgz", (int)getpid());
+	}
+
+	void TearDown() override
+	{
+		unlink(_file_name);
+	}
+
+	/** compress data into the test file, optionally without finishing it */
+	size_t write_file(const uint8_t *data, size_t size, uint32_t block_size, bool finish)
+	{
+		ULogBlockWriter writer;
+		EXPECT_TRUE(writer.init(block_size));
+
+		FILE *f = fopen(_file_name, "wb");
+		const uint8_t *out;
+		size_t out_size = writer.begin(&out);
+		fwrite(out, 1, out_size, f);
+
+		// feed the data in odd chunk sizes
+		size_t pos = 0;
+
+		while (pos < size) {
+			const size_t chunk = (size - pos < 777) ? size - pos : 777;
+			size_t consumed = 0;
+
+			while (consumed < chunk) {
+				consumed += writer.append(&data[pos + consumed], chunk - consumed);
+
+				if (writer.block_full()) {
+					out_size = writer.flush_block(&out);
+					fwrite(out, 1, out_size, f);
+				}
+			}
+
+			pos += chunk;
+		}
+
+		if (finish) {
+			out_size = writer.finish(&out);
+			fwrite(out, 1, out_size, f);
+			EXPECT_EQ(writer.raw_bytes(), size);
+		}
+
+		const size_t file_size = ftell(f);
+		fclose(f);
+		return file_size;
+	}
+
+	void check_file(const uint8_t *data, size_t size, bool expect_rebuilt)
+	{
+		ASSERT_TRUE(ULogBlockReader::is_compressed_file(_file_name));
+
+		ULogBlockReader reader;
+		ASSERT_TRUE(reader.open(_file_name));
+		EXPECT_EQ(reader.index_rebuilt(), expect_rebuilt);
+		ASSERT_EQ(reader.size(), size);
+
+		uint8_t *read_data = new uint8_t[size + 1];
+
+		// sequential
+		EXPECT_EQ(reader.read(0, read_data, size + 1), (ssize_t)size);
+		EXPECT_EQ(memcmp(read_data, data, size), 0);
+
+		// random access across block boundaries
+		srand(5);
+
+		for (int i = 0; i < 200 && size > 0; ++i) {
+			const uint64_t offset = rand() % size;
+			const size_t len = rand() % 3000;
+			const size_t expected = (len < size - offset) ? len : size - offset;
+			ASSERT_EQ(reader.read(offset, read_data, len), (ssize_t)expected);
+			EXPECT_EQ(memcmp(read_data, &data[offset], expected), 0);
+		}
+
+		delete[] read_data;
+	}
+
+	char _file_name[64];
+};
+
+TEST_F(ULogBlockContainerTest, RoundTrip)
+{
+	// more blocks than index entries per index block, last block partial
+	static constexpr uint32_t BLOCK_SIZE = 1024;
+	static constexpr size_t SIZE = BLOCK_SIZE * (ULOG_BLOCK_INDEX_ENTRIES * 2 + 3) + 100;
+	uint8_t *data = new uint8_t[SIZE];
+	fill_log_data(data, SIZE, 6);
+
+	const size_t file_size = write_file(data, SIZE, BLOCK_SIZE, true);
+	EXPECT_LT(file_size, SIZE * 3 / 4);
+	check_file(data, SIZE, false);
+
+	// exact multiple of the block size and of the index size
+	write_file(data, BLOCK_SIZE * ULOG_BLOCK_INDEX_ENTRIES, BLOCK_SIZE, true);
+	check_file(data, BLOCK_SIZE * ULOG_BLOCK_INDEX_ENTRIES, false);
+
+	// empty log
+	write_file(data, 0, BLOCK_SIZE, true);
+	check_file(data, 0, false);
+
+	delete[] data;
+}
+
+TEST_F(ULogBlockContainerTest, Unfinished)
+{
+	// the writer got interrupted: no trailer and the partial block is lost
+	static constexpr uint32_t BLOCK_SIZE = 2048;
+	static constexpr size_t SIZE = BLOCK_SIZE * 70 + 500;
+	uint8_t *data = new uint8_t[SIZE];
+	fill_log_data(data, SIZE, 7);
+
+	const size_t file_size = write_file(data, SIZE, BLOCK_SIZE, false);
+	check_file(data, BLOCK_SIZE * 70, true);
+
+	// cut into the last block
+	ASSERT_EQ(truncate(_file_name, file_size - 10), 0);
+	check_file(data, BLOCK_SIZE * 69, true);
+
+	delete[] data;
+}
+
+TEST_F(ULogBlockContainerTest, NotCompressed)
+{
+	FILE *f = fopen(_file_name, "wb");
+	const char ulog_header[] = {'U', 'L', 'o', 'g', 0x01, 0x12, 0x35, 0x01};
+	fwrite(ulog_header, 1, sizeof(ulog_header), f);
+	fclose(f);
+
+	EXPECT_FALSE(ULogBlockReader::is_compressed_file(_file_name));
+
+	ULogBlockReader reader;
+	EXPECT_FALSE(reader.open(_file_name));
+}
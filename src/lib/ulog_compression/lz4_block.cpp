@@ -0,0 +1,267 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "lz4_block.h"
+
+#include <string.h>
+
+namespace ulog_compression
+{
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t LAST_LITERALS = 5; ///< the last bytes of a block are always literals
+static constexpr size_t MATCH_FIND_LIMIT = 12; ///< the last match must start at least this many bytes before the end
+static constexpr size_t MAX_OFFSET = 65535;
+
+static inline uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t hash_sequence(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+/**
+ * Write a length continuation (the token nibble holds the first 15)
+ */
+static inline uint8_t *write_length(uint8_t *op, size_t length)
+{
+	while (length >= 255) {
+		*op++ = 255;
+		length -= 255;
+	}
+
+	*op++ = (uint8_t)length;
+	return op;
+}
+
+/**
+ * Write a sequence of literals, optionally followed by a match (match_length == 0 for the last sequence)
+ * @return end of the output, or nullptr if it does not fit
+ */
+static uint8_t *write_sequence(uint8_t *op, const uint8_t *op_end, const uint8_t *literals, size_t literal_length,
+			       size_t offset, size_t match_length)
+{
+	// worst case output size of the sequence
+	const size_t max_size = 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1;
+
+	if ((size_t)(op_end - op) < max_size) {
+		return nullptr;
+	}
+
+	uint8_t *token = op++;
+
+	if (literal_length >= 15) {
+		*token = 15 << 4;
+		op = write_length(op, literal_length - 15);
+
+	} else {
+		*token = (uint8_t)(literal_length << 4);
+	}
+
+	memcpy(op, literals, literal_length);
+	op += literal_length;
+
+	if (match_length == 0) {
+		return op;
+	}
+
+	*op++ = (uint8_t)(offset & 0xff);
+	*op++ = (uint8_t)(offset >> 8);
+
+	const size_t length = match_length - MIN_MATCH;
+
+	if (length >= 15) {
+		*token |= 15;
+		op = write_length(op, length - 15);
+
+	} else {
+		*token |= (uint8_t)length;
+	}
+
+	return op;
+}
+
+size_t lz4_compress_block(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity,
+			  uint16_t *hash_table)
+{
+	uint8_t *op = dst;
+	const uint8_t *op_end = dst + dst_capacity;
+	size_t anchor = 0;
+
+	if (src_size > MATCH_FIND_LIMIT) {
+		memset(hash_table, 0, LZ4_HASH_TABLE_SIZE * sizeof(hash_table[0]));
+
+		const size_t match_find_end = src_size - MATCH_FIND_LIMIT;
+		size_t ip = 1; // all hash table entries initially point to position 0
+
+		while (ip < match_find_end) {
+			const uint32_t sequence = read32(&src[ip]);
+			const uint32_t h = hash_sequence(sequence);
+			const size_t ref = hash_table[h];
+			hash_table[h] = (uint16_t)ip;
+
+			if (ip - ref > MAX_OFFSET || read32(&src[ref]) != sequence) {
+				// skip faster through incompressible data
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+
+			size_t match_length = MIN_MATCH;
+			const size_t max_match_length = src_size - LAST_LITERALS - ip;
+
+			while (match_length < max_match_length && src[ref + match_length] == src[ip + match_length]) {
+				++match_length;
+			}
+
+			op = write_sequence(op, op_end, &src[anchor], ip - anchor, ip - ref, match_length);
+
+			if (!op) {
+				return 0;
+			}
+
+			ip += match_length;
+			anchor = ip;
+
+			// the position right before the end of the match is likely to start a repetition again
+			if (ip < match_find_end) {
+				hash_table[hash_sequence(read32(&src[ip - 2]))] = (uint16_t)(ip - 2);
+			}
+		}
+	}
+
+	op = write_sequence(op, op_end, &src[anchor], src_size - anchor, 0, 0);
+
+	if (!op) {
+		return 0;
+	}
+
+	return op - dst;
+}
+
+/**
+ * Read a length continuation
+ * @return false if the input ends
+ */
+static inline bool read_length(const uint8_t *&ip, const uint8_t *ip_end, size_t &length)
+{
+	uint8_t b;
+
+	do {
+		if (ip >= ip_end) {
+			return false;
+		}
+
+		b = *ip++;
+		length += b;
+	} while (b == 255);
+
+	return true;
+}
+
+int lz4_decompress_block(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity)
+{
+	const uint8_t *ip = src;
+	const uint8_t *ip_end = src + src_size;
+	size_t op = 0;
+
+	while (ip < ip_end) {
+		const uint8_t token = *ip++;
+
+		size_t literal_length = token >> 4;
+
+		if (literal_length == 15 && !read_length(ip, ip_end, literal_length)) {
+			return -1;
+		}
+
+		if (literal_length > (size_t)(ip_end - ip) || literal_length > dst_capacity - op) {
+			return -1;
+		}
+
+		memcpy(&dst[op], ip, literal_length);
+		ip += literal_length;
+		op += literal_length;
+
+		if (ip == ip_end) {
+			// the last sequence has no match
+			return (int)op;
+		}
+
+		if (ip_end - ip < 2) {
+			return -1;
+		}
+
+		const size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+
+		if (offset == 0 || offset > op) {
+			return -1;
+		}
+
+		size_t match_length = token & 15;
+
+		if (match_length == 15 && !read_length(ip, ip_end, match_length)) {
+			return -1;
+		}
+
+		match_length += MIN_MATCH;
+
+		if (match_length > dst_capacity - op) {
+			return -1;
+		}
+
+		const size_t match = op - offset;
+
+		if (offset >= match_length) {
+			memcpy(&dst[op], &dst[match], match_length);
+
+		} else {
+			// overlapping copy (repeating pattern)
+			for (size_t i = 0; i < match_length; ++i) {
+				dst[op + i] = dst[match + i];
+			}
+		}
+
+		op += match_length;
+	}
+
+	// a block must end with literals
+	return -1;
+}
+
+} // namespace ulog_compression
@@ -0,0 +1,85 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file lz4_block.h
+ * Compressor and decompressor for the LZ4 block format.
+ *
+ * The compressor is a greedy single pass over a hash table of 4 byte sequences, which is
+ * fast enough to run on the logger writer thread. The output can be decompressed by any
+ * LZ4 implementation (LZ4_decompress_safe()).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ulog_compression
+{
+
+static constexpr int LZ4_HASH_LOG = 12;
+static constexpr size_t LZ4_HASH_TABLE_SIZE = 1 << LZ4_HASH_LOG; ///< number of hash table entries
+
+/**
+ * Maximum compressed size for an input of a given size (incompressible data).
+ */
+static constexpr size_t lz4_compress_bound(size_t src_size)
+{
+	return src_size + src_size / 255 + 16;
+}
+
+/**
+ * Compress a block.
+ * @param src input data (at most 64 KiB)
+ * @param src_size input size
+ * @param dst output buffer
+ * @param dst_capacity size of the output buffer
+ * @param hash_table work memory of LZ4_HASH_TABLE_SIZE entries
+ * @return compressed size, or 0 if the output does not fit into dst_capacity
+ */
+size_t lz4_compress_block(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity,
+			  uint16_t *hash_table);
+
+/**
+ * Decompress a block. The input is fully validated, corrupt data never accesses memory outside of the buffers.
+ * @param src compressed data
+ * @param src_size compressed size
+ * @param dst output buffer
+ * @param dst_capacity size of the output buffer
+ * @return decompressed size, or -1 on corrupt input or if the output does not fit into dst_capacity
+ */
+int lz4_decompress_block(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity);
+
+} // namespace ulog_compression
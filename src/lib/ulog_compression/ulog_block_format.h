@@ -0,0 +1,120 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file ulog_block_format.h
+ * Definitions of the compressed ULog container.
+ *
+ * The container wraps a regular ULog byte stream in independently compressed blocks,
+ * so that any part of the log can be accessed by decompressing a single block:
+ *
+ *   file header | block | block | ... | index block | block | ... | index block | trailer
+ *
+ * All data blocks except the last have an uncompressed size of block_size, so the block
+ * holding a given ULog offset is offset / block_size. An index block is written after every
+ * ULOG_BLOCK_INDEX_ENTRIES data blocks and lists their file offsets. The index blocks are
+ * chained backwards and the trailer (last bytes of the file) points to the last one.
+ * If the trailer is missing (e.g. power loss while logging), the index is rebuilt by
+ * walking the block headers from the start of the file.
+ *
+ * The payload of a compressed block uses the LZ4 block format. All fields are little endian.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace ulog_compression
+{
+
+static constexpr uint8_t ULOG_BLOCK_FILE_MAGIC[7] = {'U', 'L', 'o', 'g', 'Z', 0x01, 0x12};
+static constexpr uint8_t ULOG_BLOCK_FILE_VERSION = 1;
+static constexpr uint8_t ULOG_BLOCK_MAGIC[2] = {'U', 'B'};
+static constexpr uint8_t ULOG_BLOCK_TRAILER_MAGIC[4] = {'U', 'L', 'Z', 'E'};
+
+static constexpr uint32_t ULOG_BLOCK_SIZE_DEFAULT = 8 * 1024;
+static constexpr uint32_t ULOG_BLOCK_SIZE_MAX = 64 * 1024; ///< match offsets and the hash table are 16 bit
+static constexpr uint32_t ULOG_BLOCK_INDEX_ENTRIES = 64;
+
+enum class ULogBlockCodec : uint8_t {
+	LZ4 = 1,
+};
+
+enum class ULogBlockType : uint8_t {
+	Stored = 0, ///< uncompressed data (incompressible block)
+	Compressed = 1, ///< data compressed with the file codec
+	Index = 2, ///< file offsets of the preceding data blocks
+};
+
+/* declare structs with byte alignment (no padding) */
+#pragma pack(push, 1)
+
+/** first bytes of the file */
+struct ulog_block_file_header_s {
+	uint8_t magic[7];
+	uint8_t version;
+	uint32_t block_size; ///< uncompressed size of all data blocks except the last one
+	uint8_t codec; ///< ULogBlockCodec
+	uint8_t reserved[3];
+};
+
+struct ulog_block_header_s {
+	uint8_t magic[2];
+	uint8_t type; ///< ULogBlockType
+	uint8_t reserved;
+	uint32_t size; ///< size of the payload following the header
+	uint32_t raw_size; ///< uncompressed size of the payload (data blocks)
+};
+
+/** payload of an index block, followed by num_blocks uint64_t file offsets of the block headers */
+struct ulog_block_index_s {
+	uint64_t prev_index_offset; ///< file offset of the previous index block (0 if none)
+	uint32_t first_block; ///< block number of the first entry
+	uint32_t num_blocks;
+};
+
+/** last bytes of a completely written file */
+struct ulog_block_trailer_s {
+	uint64_t index_offset; ///< file offset of the last index block (0 if there are no blocks)
+	uint32_t num_blocks; ///< total number of data blocks
+	uint8_t magic[4];
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(ulog_block_file_header_s) == 16, "unexpected file header size");
+static_assert(sizeof(ulog_block_header_s) == 12, "unexpected block header size");
+static_assert(sizeof(ulog_block_trailer_s) == 16, "unexpected trailer size");
+
+} // namespace ulog_compression
@@ -38,6 +38,7 @@
 #include <lib/parameters/param.h>
 #include <systemlib/mavlink_log.h>
 #include <uORB/Subscription.hpp>
+#include <uORB/topics/estimator_selector_status.h>
 #include <uORB/topics/estimator_status.h>
 #include <uORB/topics/subsystem_info.h>
 
@@ -54,8 +55,18 @@ bool PreFlightCheck::ekf2Check(orb_advert_t *mavlink_log_pub, vehicle_status_s &
 	bool gps_success = true;
 	bool gps_present = true;
 
+	// use the primary estimator instance (ekf2 multi-instance mode)
+	uORB::SubscriptionData<estimator_selector_status_s> selector_status_sub{ORB_ID(estimator_selector_status)};
+	uint8_t estimator_instance = 0;
+
+	if ((selector_status_sub.get().timestamp != 0)
+	    && (selector_status_sub.get().primary_instance < ORB_MULTI_MAX_INSTANCES)) {
+
+		estimator_instance = selector_status_sub.get().primary_instance;
+	}
+
 	// Get estimator status data if available and exit with a fail recorded if not
-	uORB::SubscriptionData<estimator_status_s> status_sub{ORB_ID(estimator_status)};
+	uORB::SubscriptionData<estimator_status_s> status_sub{ORB_ID(estimator_status), estimator_instance};
 	status_sub.update();
 	const estimator_status_s &status = status_sub.get();
 
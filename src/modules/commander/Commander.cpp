@@ -3851,6 +3851,17 @@ void Commander::estimator_check()
 	const vehicle_local_position_s &lpos = _local_position_sub.get();
 	const vehicle_global_position_s &gpos = _global_position_sub.get();
 
+	// follow the primary estimator instance (ekf2 multi-instance mode)
+	if (_estimator_selector_status_sub.updated()) {
+		estimator_selector_status_s selector_status;
+
+		if (_estimator_selector_status_sub.copy(&selector_status)
+		    && (selector_status.primary_instance < ORB_MULTI_MAX_INSTANCES)) {
+
+			_estimator_status_sub.change_instance(selector_status.primary_instance);
+		}
+	}
+
 	const bool mag_fault_prev = (_estimator_status_sub.get().control_mode_flags & (1 << estimator_status_s::CS_MAG_FAULT));
 
 	if (_estimator_status_sub.update()) {
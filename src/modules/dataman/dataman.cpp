@@ -42,12 +42,14 @@
  */
 
 #include <px4_platform_common/px4_config.h>
+#include <px4_platform_common/atomic.h>
 #include <px4_platform_common/defines.h>
 #include <px4_platform_common/module.h>
 #include <px4_platform_common/posix.h>
 #include <px4_platform_common/tasks.h>
 #include <px4_platform_common/getopt.h>
 #include <drivers/drv_hrt.h>
+#include <lib/mathlib/mathlib.h>
 #include <lib/parameters/param.h>
 #include <lib/perf/perf_counter.h>
 
@@ -58,6 +60,13 @@
 #include <nuttx/progmem.h>
 #endif
 
+#if defined(__PX4_LINUX)
+/* memory mapped file backend */
+#define MMAP_BASED_DATAMAN
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 __BEGIN_DECLS
 __EXPORT int dataman_main(int argc, char *argv[]);
 __END_DECLS
@@ -68,6 +77,9 @@ static constexpr int TASK_STACK_SIZE = 1220;
 static ssize_t _file_write(dm_item_t item, unsigned index, dm_persitence_t persistence, const void *buf,
 			   size_t count);
 static ssize_t _file_read(dm_item_t item, unsigned index, void *buf, size_t count);
+static ssize_t _file_write_range(dm_item_t item, unsigned index, unsigned num_items, dm_persitence_t persistence,
+				 const void *buf, size_t item_size);
+static ssize_t _file_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_size);
 static int  _file_clear(dm_item_t item);
 static int  _file_restart(dm_reset_reason reason);
 static int _file_initialize(unsigned max_offset);
@@ -77,6 +89,9 @@ static void _file_shutdown();
 static ssize_t _ram_write(dm_item_t item, unsigned index, dm_persitence_t persistence, const void *buf,
 			  size_t count);
 static ssize_t _ram_read(dm_item_t item, unsigned index, void *buf, size_t count);
+static ssize_t _ram_write_range(dm_item_t item, unsigned index, unsigned num_items, dm_persitence_t persistence,
+				const void *buf, size_t item_size);
+static ssize_t _ram_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_size);
 static int  _ram_clear(dm_item_t item);
 static int  _ram_restart(dm_reset_reason reason);
 static int _ram_initialize(unsigned max_offset);
@@ -89,6 +104,9 @@ static void _ram_shutdown();
 static ssize_t _ram_flash_write(dm_item_t item, unsigned index, dm_persitence_t persistence, const void *buf,
 				size_t count);
 static ssize_t _ram_flash_read(dm_item_t item, unsigned index, void *buf, size_t count);
+static ssize_t _ram_flash_write_range(dm_item_t item, unsigned index, unsigned num_items, dm_persitence_t persistence,
+				      const void *buf, size_t item_size);
+static ssize_t _ram_flash_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_size);
 static int  _ram_flash_clear(dm_item_t item);
 static int  _ram_flash_restart(dm_reset_reason reason);
 static int _ram_flash_initialize(unsigned max_offset);
@@ -96,9 +114,29 @@ static void _ram_flash_shutdown();
 static int _ram_flash_wait(px4_sem_t *sem);
 #endif
 
+#if defined(MMAP_BASED_DATAMAN)
+/* Private memory mapped file based Operations */
+#define MMAP_FLUSH_TIMEOUT_USEC 1000000
+
+static ssize_t _mmap_write(dm_item_t item, unsigned index, dm_persitence_t persistence, const void *buf,
+			   size_t count);
+static ssize_t _mmap_read(dm_item_t item, unsigned index, void *buf, size_t count);
+static ssize_t _mmap_write_range(dm_item_t item, unsigned index, unsigned num_items, dm_persitence_t persistence,
+				 const void *buf, size_t item_size);
+static ssize_t _mmap_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_size);
+static int  _mmap_clear(dm_item_t item);
+static int  _mmap_restart(dm_reset_reason reason);
+static int _mmap_initialize(unsigned max_offset);
+static void _mmap_shutdown();
+static int _mmap_wait(px4_sem_t *sem);
+#endif
+
 typedef struct dm_operations_t {
 	ssize_t (*write)(dm_item_t item, unsigned index, dm_persitence_t persistence, const void *buf, size_t count);
 	ssize_t (*read)(dm_item_t item, unsigned index, void *buf, size_t count);
+	ssize_t (*write_range)(dm_item_t item, unsigned index, unsigned num_items, dm_persitence_t persistence,
+			       const void *buf, size_t item_size);
+	ssize_t (*read_range)(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_size);
 	int (*clear)(dm_item_t item);
 	int (*restart)(dm_reset_reason reason);
 	int (*initialize)(unsigned max_offset);
@@ -109,6 +147,8 @@ typedef struct dm_operations_t {
 static constexpr dm_operations_t dm_file_operations = {
 	.write   = _file_write,
 	.read    = _file_read,
+	.write_range = _file_write_range,
+	.read_range = _file_read_range,
 	.clear   = _file_clear,
 	.restart = _file_restart,
 	.initialize = _file_initialize,
@@ -119,6 +159,8 @@ static constexpr dm_operations_t dm_file_operations = {
 static constexpr dm_operations_t dm_ram_operations = {
 	.write   = _ram_write,
 	.read    = _ram_read,
+	.write_range = _ram_write_range,
+	.read_range = _ram_read_range,
 	.clear   = _ram_clear,
 	.restart = _ram_restart,
 	.initialize = _ram_initialize,
@@ -130,6 +172,8 @@ static constexpr dm_operations_t dm_ram_operations = {
 static constexpr dm_operations_t dm_ram_flash_operations = {
 	.write   = _ram_flash_write,
 	.read    = _ram_flash_read,
+	.write_range = _ram_flash_write_range,
+	.read_range = _ram_flash_read_range,
 	.clear   = _ram_flash_clear,
 	.restart = _ram_flash_restart,
 	.initialize = _ram_flash_initialize,
@@ -138,12 +182,27 @@ static constexpr dm_operations_t dm_ram_flash_operations = {
 };
 #endif
 
+#if defined(MMAP_BASED_DATAMAN)
+static constexpr dm_operations_t dm_mmap_operations = {
+	.write   = _mmap_write,
+	.read    = _mmap_read,
+	.write_range = _mmap_write_range,
+	.read_range = _mmap_read_range,
+	.clear   = _mmap_clear,
+	.restart = _mmap_restart,
+	.initialize = _mmap_initialize,
+	.shutdown = _mmap_shutdown,
+	.wait = _mmap_wait,
+};
+#endif
+
 static const dm_operations_t *g_dm_ops;
 
 static struct {
 	union {
 		struct {
 			int fd;
+			uint8_t *range_buffer;	/* staging buffer for the range operations, DM_RANGE_BUFFER_SIZE bytes */
 		} file;
 		struct {
 			uint8_t *data;
@@ -156,6 +215,18 @@ static struct {
 			/* sync above with RAM backend */
 			timespec flush_timeout;
 		} ram_flash;
+#endif
+#if defined(MMAP_BASED_DATAMAN)
+		struct {
+			uint8_t *data;
+			uint8_t *data_end;
+			/* sync above with RAM backend */
+			timespec flush_timeout;
+			int fd;
+			uint8_t *dirty_begin;	/* range written since the last flush */
+			uint8_t *dirty_end;
+			unsigned flushes;	/* number of msync() calls */
+		} mmap_file;
 #endif
 	};
 	bool running;
@@ -167,6 +238,8 @@ typedef enum {
 	dm_read_func,
 	dm_clear_func,
 	dm_restart_func,
+	dm_write_range_func,
+	dm_read_range_func,
 	dm_number_of_funcs
 } dm_function_t;
 
@@ -197,6 +270,21 @@ typedef struct {
 		struct {
 			dm_reset_reason reason;
 		} restart_params;
+		struct {
+			dm_item_t item;
+			unsigned index;
+			unsigned num_items;
+			dm_persitence_t persistence;
+			const void *buf;
+			size_t item_size;
+		} write_range_params;
+		struct {
+			dm_item_t item;
+			unsigned index;
+			unsigned num_items;
+			void *buf;
+			size_t item_size;
+		} read_range_params;
 	};
 } work_q_item_t;
 
@@ -229,9 +317,35 @@ static constexpr size_t g_per_item_size[DM_KEY_NUM_KEYS] = {
 	sizeof(struct dataman_compat_s) + DM_SECTOR_HDR_SIZE
 };
 
+/* Size of the buffer used by the file backend to transfer a range of items with a single read or write */
+#if defined(__PX4_NUTTX)
+static constexpr size_t DM_RANGE_BUFFER_SIZE = 512;
+#else
+static constexpr size_t DM_RANGE_BUFFER_SIZE = 8192;
+#endif
+
+static constexpr size_t max_per_item_size(unsigned item = 0)
+{
+	return (item >= DM_KEY_NUM_KEYS) ? 0 :
+	       (g_per_item_size[item] > max_per_item_size(item + 1) ? g_per_item_size[item] : max_per_item_size(item + 1));
+}
+
+static_assert(DM_RANGE_BUFFER_SIZE >= max_per_item_size(), "DM_RANGE_BUFFER_SIZE too small");
+
 /* Table of offset for index 0 of each item type */
 static unsigned int g_key_offsets[DM_KEY_NUM_KEYS];
 
+/* Generation of each item type, incremented by the worker on every write, clear and restart */
+static px4::atomic<uint32_t> g_item_generation[DM_KEY_NUM_KEYS] {
+	px4::atomic<uint32_t>{0},
+	px4::atomic<uint32_t>{0},
+	px4::atomic<uint32_t>{0},
+	px4::atomic<uint32_t>{0},
+	px4::atomic<uint32_t>{0},
+	px4::atomic<uint32_t>{0},
+	px4::atomic<uint32_t>{0}
+};
+
 /* Item type lock mutexes */
 static px4_sem_t *g_item_locks[DM_KEY_NUM_KEYS];
 static px4_sem_t g_sys_state_mutex_mission;
@@ -254,6 +368,9 @@ static enum {
 	BACKEND_RAM,
 #if defined(FLASH_BASED_DATAMAN)
 	BACKEND_RAM_FLASH,
+#endif
+#if defined(MMAP_BASED_DATAMAN)
+	BACKEND_MMAP,
 #endif
 	BACKEND_LAST
 } backend = BACKEND_NONE;
@@ -436,6 +553,25 @@ calculate_offset(dm_item_t item, unsigned index)
 	return g_key_offsets[item] + (index * g_per_item_size[item]);
 }
 
+/* Check the items [index, index + num_items) of a type, each item_size bytes long */
+static int
+check_range(dm_item_t item, unsigned index, unsigned num_items, size_t item_size)
+{
+	if (calculate_offset(item, index) < 0) {
+		return -1;
+	}
+
+	if (num_items > g_per_item_max_index[item] - index) {
+		return -1;
+	}
+
+	if (item_size > (g_per_item_size[item] - DM_SECTOR_HDR_SIZE)) {
+		return -E2BIG;
+	}
+
+	return 0;
+}
+
 /* Each data item is stored as follows
  *
  * byte 0: Length of user data item
@@ -665,6 +801,188 @@ _ram_flash_read(dm_item_t item, unsigned index, void *buf, size_t count)
 }
 #endif
 
+/* write a range of items to the data manager RAM buffer */
+static ssize_t
+_ram_write_range(dm_item_t item, unsigned index, unsigned num_items, dm_persitence_t persistence, const void *buf,
+		 size_t item_size)
+{
+	const int ret = check_range(item, index, num_items, item_size);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	const uint8_t *data = (const uint8_t *)buf;
+
+	for (unsigned i = 0; i < num_items; i++) {
+		if (_ram_write(item, index + i, persistence, &data[i * item_size], item_size) != (ssize_t)item_size) {
+			return -1;
+		}
+	}
+
+	return num_items;
+}
+
+/* Retrieve a range of items from the data manager RAM buffer */
+static ssize_t
+_ram_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_size)
+{
+	const int ret = check_range(item, index, num_items, item_size);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	uint8_t *data = (uint8_t *)buf;
+	unsigned i = 0;
+
+	/* stop at the first item with a different length */
+	while ((i < num_items) && (_ram_read(item, index + i, &data[i * item_size], item_size) == (ssize_t)item_size)) {
+		i++;
+	}
+
+	return i;
+}
+
+/* write a range of items to the data manager file, staged in the range buffer */
+static ssize_t
+_file_write_range(dm_item_t item, unsigned index, unsigned num_items, dm_persitence_t persistence, const void *buf,
+		  size_t item_size)
+{
+	const int ret = check_range(item, index, num_items, item_size);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	const uint8_t *data = (const uint8_t *)buf;
+	uint8_t *buffer = dm_operations_data.file.range_buffer;
+
+	if (buffer == nullptr) {
+		/* no staging buffer, write the items one by one */
+		for (unsigned i = 0; i < num_items; i++) {
+			if (_file_write(item, index + i, persistence, &data[i * item_size], item_size) != (ssize_t)item_size) {
+				return -1;
+			}
+		}
+
+		return num_items;
+	}
+
+	const size_t per_item_size = g_per_item_size[item];
+	const unsigned items_per_write = DM_RANGE_BUFFER_SIZE / per_item_size;
+	ssize_t result = num_items;
+
+	for (unsigned first = 0; first < num_items; first += items_per_write) {
+		const unsigned count = math::min(num_items - first, items_per_write);
+
+		/* Lay out the items as in the file: length and persistence level followed by the data */
+		for (unsigned i = 0; i < count; i++) {
+			uint8_t *sector = &buffer[i * per_item_size];
+			sector[0] = item_size;
+			sector[1] = persistence;
+			sector[2] = 0;
+			sector[3] = 0;
+			memcpy(sector + DM_SECTOR_HDR_SIZE, &data[(first + i) * item_size], item_size);
+			memset(sector + DM_SECTOR_HDR_SIZE + item_size, 0, per_item_size - DM_SECTOR_HDR_SIZE - item_size);
+		}
+
+		const int offset = calculate_offset(item, index + first);
+		const ssize_t len = count * per_item_size;
+
+		if ((lseek(dm_operations_data.file.fd, offset, SEEK_SET) != offset)
+		    || (write(dm_operations_data.file.fd, buffer, len) != len)) {
+			result = -1;
+			break;
+		}
+	}
+
+	/* Make sure data is written to physical media, once for the whole range */
+	fsync(dm_operations_data.file.fd);
+
+	return result;
+}
+
+/* Retrieve a range of items from the data manager file, staged in the range buffer */
+static ssize_t
+_file_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_size)
+{
+	const int ret = check_range(item, index, num_items, item_size);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	uint8_t *data = (uint8_t *)buf;
+	uint8_t *buffer = dm_operations_data.file.range_buffer;
+
+	if (buffer == nullptr) {
+		/* no staging buffer, read the items one by one */
+		unsigned i = 0;
+
+		while ((i < num_items) && (_file_read(item, index + i, &data[i * item_size], item_size) == (ssize_t)item_size)) {
+			i++;
+		}
+
+		return i;
+	}
+
+	const size_t per_item_size = g_per_item_size[item];
+	const unsigned items_per_read = DM_RANGE_BUFFER_SIZE / per_item_size;
+
+	for (unsigned first = 0; first < num_items; first += items_per_read) {
+		const unsigned count = math::min(num_items - first, items_per_read);
+		const int offset = calculate_offset(item, index + first);
+		ssize_t len = -1;
+
+		if (lseek(dm_operations_data.file.fd, offset, SEEK_SET) == offset) {
+			len = read(dm_operations_data.file.fd, buffer, count * per_item_size);
+		}
+
+		if (len < 0) {
+			return (first > 0) ? first : -errno;
+		}
+
+		for (unsigned i = 0; i < count; i++) {
+			const uint8_t *sector = &buffer[i * per_item_size];
+
+			/* stop at the end of the file or the first item with a different length */
+			if (((ssize_t)((i * per_item_size) + DM_SECTOR_HDR_SIZE + item_size) > len) || (sector[0] != item_size)) {
+				return first + i;
+			}
+
+			memcpy(&data[(first + i) * item_size], sector + DM_SECTOR_HDR_SIZE, item_size);
+		}
+	}
+
+	return num_items;
+}
+
+#if defined(FLASH_BASED_DATAMAN)
+static ssize_t
+_ram_flash_write_range(dm_item_t item, unsigned index, unsigned num_items, dm_persitence_t persistence,
+		       const void *buf, size_t item_size)
+{
+	ssize_t ret = dm_ram_operations.write_range(item, index, num_items, persistence, buf, item_size);
+
+	if (ret < 1) {
+		return ret;
+	}
+
+	if (persistence == DM_PERSIST_POWER_ON_RESET) {
+		_ram_flash_update_flush_timeout();
+	}
+
+	return ret;
+}
+
+static ssize_t
+_ram_flash_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_size)
+{
+	return dm_ram_operations.read_range(item, index, num_items, buf, item_size);
+}
+#endif
+
 static int  _ram_clear(dm_item_t item)
 {
 	int i;
@@ -931,6 +1249,10 @@ _file_initialize(unsigned max_offset)
 	}
 
 	fsync(dm_operations_data.file.fd);
+
+	/* Without the range buffer, the range operations fall back to single item operations */
+	dm_operations_data.file.range_buffer = (uint8_t *)malloc(DM_RANGE_BUFFER_SIZE);
+
 	dm_operations_data.running = true;
 
 	return 0;
@@ -997,6 +1319,8 @@ static void
 _file_shutdown()
 {
 	close(dm_operations_data.file.fd);
+	free(dm_operations_data.file.range_buffer);
+	dm_operations_data.file.range_buffer = nullptr;
 	dm_operations_data.running = false;
 }
 
@@ -1067,6 +1391,222 @@ _ram_flash_wait(px4_sem_t *sem)
 }
 #endif
 
+#if defined(MMAP_BASED_DATAMAN)
+/*
+ * The memory mapped file backend uses the RAM backend on the mapping of the data manager file.
+ * Written items are persisted to the file by a msync() of the written range, at the latest
+ * MMAP_FLUSH_TIMEOUT_USEC after the first write since the last flush.
+ */
+static void
+_mmap_mark_dirty(unsigned offset, size_t len)
+{
+	uint8_t *begin = &dm_operations_data.mmap_file.data[offset];
+	uint8_t *end = begin + len;
+
+	if ((dm_operations_data.mmap_file.dirty_begin == nullptr) || (begin < dm_operations_data.mmap_file.dirty_begin)) {
+		dm_operations_data.mmap_file.dirty_begin = begin;
+	}
+
+	if (end > dm_operations_data.mmap_file.dirty_end) {
+		dm_operations_data.mmap_file.dirty_end = end;
+	}
+
+	/* schedule a flush, unless one is already pending (px4_sem_timedwait() waits against CLOCK_MONOTONIC) */
+	timespec &abstime = dm_operations_data.mmap_file.flush_timeout;
+
+	if ((abstime.tv_sec == 0) && (px4_clock_gettime(CLOCK_MONOTONIC, &abstime) == 0)) {
+		const unsigned billion = 1000 * 1000 * 1000;
+		uint64_t nsecs = abstime.tv_nsec + (uint64_t)MMAP_FLUSH_TIMEOUT_USEC * 1000;
+		abstime.tv_sec += nsecs / billion;
+		nsecs -= (nsecs / billion) * billion;
+		abstime.tv_nsec = nsecs;
+	}
+}
+
+static ssize_t
+_mmap_write(dm_item_t item, unsigned index, dm_persitence_t persistence, const void *buf, size_t count)
+{
+	ssize_t ret = dm_ram_operations.write(item, index, persistence, buf, count);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	_mmap_mark_dirty(calculate_offset(item, index), g_per_item_size[item]);
+	return ret;
+}
+
+static ssize_t
+_mmap_read(dm_item_t item, unsigned index, void *buf, size_t count)
+{
+	return dm_ram_operations.read(item, index, buf, count);
+}
+
+static ssize_t
+_mmap_write_range(dm_item_t item, unsigned index, unsigned num_items, dm_persitence_t persistence, const void *buf,
+		  size_t item_size)
+{
+	ssize_t ret = dm_ram_operations.write_range(item, index, num_items, persistence, buf, item_size);
+
+	if (ret < 1) {
+		return ret;
+	}
+
+	_mmap_mark_dirty(calculate_offset(item, index), num_items * g_per_item_size[item]);
+	return ret;
+}
+
+static ssize_t
+_mmap_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_size)
+{
+	return dm_ram_operations.read_range(item, index, num_items, buf, item_size);
+}
+
+static int
+_mmap_clear(dm_item_t item)
+{
+	int ret = dm_ram_operations.clear(item);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	_mmap_mark_dirty(calculate_offset(item, 0), g_per_item_max_index[item] * g_per_item_size[item]);
+	return ret;
+}
+
+static int
+_mmap_restart(dm_reset_reason reason)
+{
+	int ret = dm_ram_operations.restart(reason);
+
+	_mmap_mark_dirty(0, dm_operations_data.mmap_file.data_end - dm_operations_data.mmap_file.data + 1);
+	return ret;
+}
+
+static int
+_mmap_initialize(unsigned max_offset)
+{
+	/* Open or create the data manager file, it has the same layout as with the file backend */
+	int fd = open(k_data_manager_device_path, O_RDWR | O_CREAT | O_BINARY, PX4_O_MODE_666);
+
+	if (fd < 0) {
+		PX4_WARN("Could not open data manager file %s", k_data_manager_device_path);
+		px4_sem_post(&g_init_sema); /* Don't want to hang startup */
+		return -1;
+	}
+
+	/* Extend the file to hold all items, the mapping must not reach beyond the end of the file */
+	struct stat st;
+
+	if ((fstat(fd, &st) != 0) || ((st.st_size < (off_t)max_offset) && (ftruncate(fd, max_offset) != 0))) {
+		close(fd);
+		PX4_WARN("Could not resize data manager file %s", k_data_manager_device_path);
+		px4_sem_post(&g_init_sema); /* Don't want to hang startup */
+		return -1;
+	}
+
+	void *data = mmap(nullptr, max_offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if (data == MAP_FAILED) {
+		close(fd);
+		PX4_WARN("Could not map data manager file %s (%i)", k_data_manager_device_path, errno);
+		px4_sem_post(&g_init_sema); /* Don't want to hang startup */
+		return -1;
+	}
+
+	dm_operations_data.mmap_file.data = (uint8_t *)data;
+	dm_operations_data.mmap_file.data_end = &dm_operations_data.mmap_file.data[max_offset - 1];
+	dm_operations_data.mmap_file.flush_timeout = {};
+	dm_operations_data.mmap_file.fd = fd;
+	dm_operations_data.mmap_file.dirty_begin = nullptr;
+	dm_operations_data.mmap_file.dirty_end = nullptr;
+	dm_operations_data.mmap_file.flushes = 0;
+
+	struct dataman_compat_s compat_state;
+	int ret = g_dm_ops->read(DM_KEY_COMPAT, 0, &compat_state, sizeof(compat_state));
+
+	if (ret != sizeof(compat_state) || compat_state.key != DM_COMPAT_KEY) {
+		/* Not compatible: clear the file and write DM_KEY_COMPAT */
+		memset(dm_operations_data.mmap_file.data, 0, max_offset);
+		_mmap_mark_dirty(0, max_offset);
+
+		compat_state.key = DM_COMPAT_KEY;
+		ret = g_dm_ops->write(DM_KEY_COMPAT, 0, DM_PERSIST_POWER_ON_RESET, &compat_state, sizeof(compat_state));
+
+		if (ret != sizeof(compat_state)) {
+			PX4_ERR("Failed writing compat: %d", ret);
+		}
+	}
+
+	dm_operations_data.running = true;
+
+	return 0;
+}
+
+static void
+_mmap_flush()
+{
+	dm_operations_data.mmap_file.flush_timeout = {};
+
+	uint8_t *begin = dm_operations_data.mmap_file.dirty_begin;
+	uint8_t *end = dm_operations_data.mmap_file.dirty_end;
+
+	if (begin == nullptr) {
+		return;
+	}
+
+	dm_operations_data.mmap_file.dirty_begin = nullptr;
+	dm_operations_data.mmap_file.dirty_end = nullptr;
+
+	/* msync() needs a page aligned address (the mapping itself is page aligned) */
+	const uintptr_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+	begin = (uint8_t *)((uintptr_t)begin & ~page_mask);
+
+	if (msync(begin, end - begin, MS_SYNC) != 0) {
+		PX4_WARN("Error syncing data manager file (%i)", errno);
+	}
+
+	dm_operations_data.mmap_file.flushes++;
+}
+
+static void
+_mmap_shutdown()
+{
+	_mmap_flush();
+
+	munmap(dm_operations_data.mmap_file.data,
+	       dm_operations_data.mmap_file.data_end - dm_operations_data.mmap_file.data + 1);
+	close(dm_operations_data.mmap_file.fd);
+	dm_operations_data.running = false;
+}
+
+static int
+_mmap_wait(px4_sem_t *sem)
+{
+	if (!dm_operations_data.mmap_file.flush_timeout.tv_sec) {
+		px4_sem_wait(sem);
+		return 0;
+	}
+
+	int ret;
+
+	while ((ret = px4_sem_timedwait(sem, &dm_operations_data.mmap_file.flush_timeout)) == -1 && errno == EINTR);
+
+	/* flush on timeout, but also if work keeps getting queued beyond the flush time */
+	const timespec &abstime = dm_operations_data.mmap_file.flush_timeout;
+	timespec now{};
+	px4_clock_gettime(CLOCK_MONOTONIC, &now);
+
+	if ((ret != 0) || (now.tv_sec > abstime.tv_sec)
+	    || ((now.tv_sec == abstime.tv_sec) && (now.tv_nsec >= abstime.tv_nsec))) {
+		_mmap_flush();
+	}
+
+	return 0;
+}
+#endif
+
 /** Write to the data manager file */
 __EXPORT ssize_t
 dm_write(dm_item_t item, unsigned index, dm_persitence_t persistence, const void *buf, size_t count)
@@ -1130,6 +1670,62 @@ dm_read(dm_item_t item, unsigned index, void *buf, size_t count)
 	return ret;
 }
 
+/** Write a range of items to the data manager file */
+__EXPORT ssize_t
+dm_write_range(dm_item_t item, unsigned index, unsigned num_items, dm_persitence_t persistence, const void *buf,
+	       size_t item_size)
+{
+	work_q_item_t *work;
+
+	/* Make sure data manager has been started and is not shutting down */
+	if (!is_running() || g_task_should_exit) {
+		return -1;
+	}
+
+	/* get a work item and queue up a range write request */
+	if ((work = create_work_item()) == nullptr) {
+		return -1;
+	}
+
+	work->func = dm_write_range_func;
+	work->write_range_params.item = item;
+	work->write_range_params.index = index;
+	work->write_range_params.num_items = num_items;
+	work->write_range_params.persistence = persistence;
+	work->write_range_params.buf = buf;
+	work->write_range_params.item_size = item_size;
+
+	/* Enqueue the item on the work queue and wait for the worker thread to complete processing it */
+	return (ssize_t)enqueue_work_item_and_wait_for_result(work);
+}
+
+/** Retrieve a range of items from the data manager file */
+__EXPORT ssize_t
+dm_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_size)
+{
+	work_q_item_t *work;
+
+	/* Make sure data manager has been started and is not shutting down */
+	if (!is_running() || g_task_should_exit) {
+		return -1;
+	}
+
+	/* get a work item and queue up a range read request */
+	if ((work = create_work_item()) == nullptr) {
+		return -1;
+	}
+
+	work->func = dm_read_range_func;
+	work->read_range_params.item = item;
+	work->read_range_params.index = index;
+	work->read_range_params.num_items = num_items;
+	work->read_range_params.buf = buf;
+	work->read_range_params.item_size = item_size;
+
+	/* Enqueue the item on the work queue and wait for the worker thread to complete processing it */
+	return (ssize_t)enqueue_work_item_and_wait_for_result(work);
+}
+
 /** Clear a data Item */
 __EXPORT int
 dm_clear(dm_item_t item)
@@ -1215,6 +1811,17 @@ dm_unlock(dm_item_t item)
 	}
 }
 
+/** Generation of an item type */
+__EXPORT uint32_t
+dm_generation(dm_item_t item)
+{
+	if (item >= DM_KEY_NUM_KEYS) {
+		return 0;
+	}
+
+	return g_item_generation[item].load();
+}
+
 /** Tell the data manager about the type of the last reset */
 __EXPORT int
 dm_restart(dm_reset_reason reason)
@@ -1267,6 +1874,13 @@ task_main(int argc, char *argv[])
 		break;
 #endif
 
+#if defined(MMAP_BASED_DATAMAN)
+
+	case BACKEND_MMAP:
+		g_dm_ops = &dm_mmap_operations;
+		break;
+#endif
+
 	default:
 		PX4_WARN("No valid backend set.");
 		return -1;
@@ -1358,6 +1972,14 @@ task_main(int argc, char *argv[])
 		break;
 #endif
 
+#if defined(MMAP_BASED_DATAMAN)
+
+	case BACKEND_MMAP:
+		PX4_INFO("%s, data manager memory mapped file '%s' size is %d bytes",
+			 restart_type_str, k_data_manager_device_path, max_offset);
+		break;
+#endif
+
 	default:
 		break;
 	}
@@ -1385,6 +2007,11 @@ task_main(int argc, char *argv[])
 					g_dm_ops->write(work->write_params.item, work->write_params.index, work->write_params.persistence,
 							work->write_params.buf,
 							work->write_params.count);
+
+				if (work->write_params.item < DM_KEY_NUM_KEYS) {
+					g_item_generation[work->write_params.item].fetch_add(1);
+				}
+
 				break;
 
 			case dm_read_func:
@@ -1393,14 +2020,45 @@ task_main(int argc, char *argv[])
 					g_dm_ops->read(work->read_params.item, work->read_params.index, work->read_params.buf, work->read_params.count);
 				break;
 
+			case dm_write_range_func:
+				g_func_counts[dm_write_range_func]++;
+				work->result =
+					g_dm_ops->write_range(work->write_range_params.item, work->write_range_params.index,
+							      work->write_range_params.num_items, work->write_range_params.persistence,
+							      work->write_range_params.buf, work->write_range_params.item_size);
+
+				if (work->write_range_params.item < DM_KEY_NUM_KEYS) {
+					g_item_generation[work->write_range_params.item].fetch_add(1);
+				}
+
+				break;
+
+			case dm_read_range_func:
+				g_func_counts[dm_read_range_func]++;
+				work->result =
+					g_dm_ops->read_range(work->read_range_params.item, work->read_range_params.index,
+							     work->read_range_params.num_items, work->read_range_params.buf,
+							     work->read_range_params.item_size);
+				break;
+
 			case dm_clear_func:
 				g_func_counts[dm_clear_func]++;
 				work->result = g_dm_ops->clear(work->clear_params.item);
+
+				if (work->clear_params.item < DM_KEY_NUM_KEYS) {
+					g_item_generation[work->clear_params.item].fetch_add(1);
+				}
+
 				break;
 
 			case dm_restart_func:
 				g_func_counts[dm_restart_func]++;
 				work->result = g_dm_ops->restart(work->restart_params.reason);
+
+				for (auto &generation : g_item_generation) {
+					generation.fetch_add(1);
+				}
+
 				break;
 
 			default: /* should never happen */
@@ -1482,7 +2140,20 @@ status()
 	PX4_INFO("Reads    %d", g_func_counts[dm_read_func]);
 	PX4_INFO("Clears   %d", g_func_counts[dm_clear_func]);
 	PX4_INFO("Restarts %d", g_func_counts[dm_restart_func]);
+	PX4_INFO("Range writes %d, reads %d", g_func_counts[dm_write_range_func], g_func_counts[dm_read_range_func]);
 	PX4_INFO("Max Q lengths work %d, free %d", g_work_q.max_size, g_free_q.max_size);
+
+#if defined(MMAP_BASED_DATAMAN)
+
+	if (backend == BACKEND_MMAP) {
+		const uint8_t *dirty_begin = dm_operations_data.mmap_file.dirty_begin;
+		const uint8_t *dirty_end = dm_operations_data.mmap_file.dirty_end;
+		PX4_INFO("Unflushed %d bytes, flushes %u", dirty_begin ? (int)(dirty_end - dirty_begin) : 0,
+			 dm_operations_data.mmap_file.flushes);
+	}
+
+#endif
+
 	perf_print_counter(_dm_read_perf);
 	perf_print_counter(_dm_write_perf);
 }
@@ -1504,6 +2175,7 @@ usage()
 Module to provide persistent storage for the rest of the system in form of a simple database through a C API.
 Multiple backends are supported:
 - a file (eg. on the SD card)
+- a memory mapped file (Linux), read at RAM speed and synced to the file periodically
 - FLASH (if the board supports it)
 - FRAM
 - RAM (this is obviously not persistent)
@@ -1527,7 +2199,8 @@ check for geofence violations.
 	PRINT_MODULE_USAGE_PARAM_STRING('f', nullptr, "<file>", "Storage file", true);
 	PRINT_MODULE_USAGE_PARAM_FLAG('r', "Use RAM backend (NOT persistent)", true);
 	PRINT_MODULE_USAGE_PARAM_FLAG('i', "Use FLASH backend", true);
-	PRINT_MODULE_USAGE_PARAM_COMMENT("The options -f, -r and -i are mutually exclusive. If nothing is specified, a file 'dataman' is used");
+	PRINT_MODULE_USAGE_PARAM_STRING('m', nullptr, "<file>", "Memory mapped storage file (Linux only)", true);
+	PRINT_MODULE_USAGE_PARAM_COMMENT("The options -f, -r, -i and -m are mutually exclusive. If nothing is specified, a file 'dataman' is used");
 
 	PRINT_MODULE_USAGE_COMMAND_DESCR("poweronrestart", "Restart dataman (on power on)");
 	PRINT_MODULE_USAGE_COMMAND_DESCR("inflightrestart", "Restart dataman (in flight)");
@@ -1537,7 +2210,7 @@ check for geofence violations.
 static int backend_check()
 {
 	if (backend != BACKEND_NONE) {
-		PX4_WARN("-f, -r and -i are mutually exclusive");
+		PX4_WARN("-f, -r, -i and -m are mutually exclusive");
 		usage();
 		return -1;
 	}
@@ -1566,7 +2239,7 @@ dataman_main(int argc, char *argv[])
 
 		/* jump over start and look at options first */
 
-		while ((ch = px4_getopt(argc, argv, "f:ri", &dmoptind, &dmoptarg)) != EOF) {
+		while ((ch = px4_getopt(argc, argv, "f:rim:", &dmoptind, &dmoptarg)) != EOF) {
 			switch (ch) {
 			case 'f':
 				if (backend_check()) {
@@ -1604,6 +2277,21 @@ dataman_main(int argc, char *argv[])
 				return -1;
 #endif
 
+			case 'm':
+#if defined(MMAP_BASED_DATAMAN)
+				if (backend_check()) {
+					return -1;
+				}
+
+				backend = BACKEND_MMAP;
+				k_data_manager_device_path = strdup(dmoptarg);
+				PX4_INFO("dataman memory mapped file set to: %s", k_data_manager_device_path);
+				break;
+#else
+				PX4_WARN("Memory mapped file backend is not available");
+				return -1;
+#endif
+
 			//no break
 			default:
 				usage();
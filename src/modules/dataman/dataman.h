@@ -125,6 +125,36 @@ dm_write(
 	size_t buflen			/* Length in bytes of data to retrieve */
 );
 
+/**
+ * Retrieve the items [index, index + num_items) of a type in one request.
+ * The items are stored back to back in buffer, each item_size bytes long.
+ * @return number of items read, which is less than num_items if an item is empty or has a different
+ * length than item_size (its data and the data after it are undefined), or negative on error
+ */
+__EXPORT ssize_t
+dm_read_range(
+	dm_item_t item,			/* The item type to retrieve */
+	unsigned index,			/* The index of the first item */
+	unsigned num_items,		/* The number of items to retrieve */
+	void *buffer,			/* Pointer to caller data buffer (num_items * item_size bytes) */
+	size_t item_size		/* Length in bytes of each item */
+);
+
+/**
+ * Write the items [index, index + num_items) of a type in one request, with a single sync
+ * to the storage for all of them.
+ * @return number of items written, or negative on error
+ */
+__EXPORT ssize_t
+dm_write_range(
+	dm_item_t item,			/* The item type to store */
+	unsigned index,			/* The index of the first item */
+	unsigned num_items,		/* The number of items to store */
+	dm_persitence_t persistence,	/* The persistence level of these items */
+	const void *buffer,		/* Pointer to caller data buffer (num_items * item_size bytes) */
+	size_t item_size		/* Length in bytes of each item */
+);
+
 /**
  * Lock all items of a type. Can be used for atomic updates of multiple items (single items are always updated
  * atomically).
@@ -157,6 +187,15 @@ dm_clear(
 	dm_item_t item			/* The item type to clear */
 );
 
+/**
+ * Generation of an item type. It is incremented on every write and clear of the item type
+ * (and on restart), so that readers keeping a copy of the items can detect changes.
+ */
+__EXPORT uint32_t
+dm_generation(
+	dm_item_t item			/* The item type */
+);
+
 /** Tell the data manager about the type of the last reset */
 __EXPORT int
 dm_restart(
@@ -0,0 +1,471 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include "EKF2Selector.hpp"
+
+#include <matrix/math.hpp>
+#include <px4_platform_common/log.h>
+#include <px4_platform_common/time.h>
+
+using matrix::Quatf;
+
+EKF2Selector::EKF2Selector() :
+	ScheduledWorkItem(MODULE_NAME"_selector", px4::wq_configurations::att_pos_ctrl)
+{
+}
+
+EKF2Selector::~EKF2Selector()
+{
+	Stop();
+	perf_free(_cycle_perf);
+}
+
+bool EKF2Selector::Start()
+{
+	ScheduleNow();
+	return true;
+}
+
+void EKF2Selector::Stop()
+{
+	if (_stopped.load()) {
+		return;
+	}
+
+	_should_stop.store(true);
+	ScheduleNow();
+
+	// wait at most 2 seconds for a running cycle to finish
+	for (int i = 0; (i < 100) && !_stopped.load(); i++) {
+		px4_usleep(20_ms);
+	}
+}
+
+void EKF2Selector::Run()
+{
+	if (_should_stop.load()) {
+		for (auto &inst : _instance) {
+			inst.estimator_attitude_sub.unregisterCallback();
+			inst.estimator_local_position_sub.unregisterCallback();
+		}
+
+		// off the work queue, the selector can be deleted once _stopped is set
+		ScheduleClear();
+		Deinit();
+		_stopped.store(true);
+		return;
+	}
+
+	perf_begin(_cycle_perf);
+
+	// watchdog, runs even if the primary instance stops publishing
+	ScheduleDelayed(FILTER_UPDATE_TIMEOUT);
+
+	const hrt_abstime now = hrt_absolute_time();
+
+	UpdateInstances(now);
+	UpdateSelection(now);
+
+	if (_selected_instance != INVALID_INSTANCE) {
+		PublishVehicleAttitude();
+		PublishVehicleLocalPosition();
+		PublishVehicleGlobalPosition();
+		PublishVehicleOdometry();
+	}
+
+	PublishSelectorStatus(now);
+
+	perf_end(_cycle_perf);
+}
+
+void EKF2Selector::UpdateInstances(const hrt_abstime &now)
+{
+	bool primary_updated = false;
+	_available_instances = 0;
+
+	for (uint8_t i = 0; i < MAX_INSTANCES; i++) {
+		EstimatorInstance &inst = _instance[i];
+
+		estimator_sensor_bias_s bias;
+
+		if (inst.estimator_sensor_bias_sub.update(&bias)) {
+			inst.accel_device_id = bias.accel_device_id;
+			inst.gyro_device_id = bias.gyro_device_id;
+		}
+
+		// the initial (empty) publication of each instance is ignored
+		if (inst.estimator_status_sub.update(&inst.estimator_status) && (inst.estimator_status.timestamp != 0)) {
+			const estimator_status_s &status = inst.estimator_status;
+
+			const bool tilt_align = status.control_mode_flags & (1 << estimator_status_s::CS_TILT_ALIGN);
+			const bool yaw_align = status.control_mode_flags & (1 << estimator_status_s::CS_YAW_ALIGN);
+
+			inst.time_last_status = now;
+			inst.healthy = tilt_align && (status.filter_fault_flags == 0);
+
+			if (tilt_align && yaw_align) {
+				// the innovation test ratios are only meaningful once the filter is aligned
+				inst.combined_test_ratio = fmaxf(0.5f * (status.vel_test_ratio + status.pos_test_ratio), status.hgt_test_ratio);
+
+			} else {
+				inst.combined_test_ratio = NAN;
+			}
+
+			if (i == _selected_instance) {
+				primary_updated = true;
+			}
+
+		} else if ((inst.time_last_status > 0) && (now > inst.time_last_status + FILTER_UPDATE_TIMEOUT)) {
+			// instance stopped publishing
+			inst.healthy = false;
+			inst.combined_test_ratio = NAN;
+		}
+
+		if (inst.time_last_status > 0) {
+			_available_instances++;
+		}
+	}
+
+	if (!primary_updated) {
+		return;
+	}
+
+	// accumulate the test ratio difference of every other instance relative to the primary
+	const float dt = (_last_relative_update > 0) ? math::constrain((now - _last_relative_update) * 1e-6f, 0.f, 0.1f) : 0.f;
+	_last_relative_update = now;
+
+	const float primary_test_ratio = _instance[_selected_instance].combined_test_ratio;
+
+	for (uint8_t i = 0; i < MAX_INSTANCES; i++) {
+		EstimatorInstance &inst = _instance[i];
+
+		if ((i != _selected_instance) && inst.healthy
+		    && PX4_ISFINITE(inst.combined_test_ratio) && PX4_ISFINITE(primary_test_ratio)) {
+
+			inst.relative_test_ratio = math::constrain(inst.relative_test_ratio + dt * (inst.combined_test_ratio - primary_test_ratio),
+						   -RELATIVE_TEST_RATIO_LIMIT, RELATIVE_TEST_RATIO_LIMIT);
+
+		} else {
+			inst.relative_test_ratio = 0.f;
+		}
+	}
+}
+
+void EKF2Selector::UpdateSelection(const hrt_abstime &now)
+{
+	const bool primary_healthy = (_selected_instance != INVALID_INSTANCE) && _instance[_selected_instance].healthy;
+
+	if (!primary_healthy) {
+		// select the healthy instance with the lowest combined test ratio (prefer aligned instances)
+		uint8_t best = INVALID_INSTANCE;
+		float best_test_ratio = INFINITY;
+
+		for (uint8_t i = 0; i < MAX_INSTANCES; i++) {
+			const EstimatorInstance &inst = _instance[i];
+
+			if (inst.healthy) {
+				const float test_ratio = PX4_ISFINITE(inst.combined_test_ratio) ? inst.combined_test_ratio : FLT_MAX;
+
+				if ((best == INVALID_INSTANCE) || (test_ratio < best_test_ratio)) {
+					best = i;
+					best_test_ratio = test_ratio;
+				}
+			}
+		}
+
+		if (best != INVALID_INSTANCE) {
+			if (_selected_instance != INVALID_INSTANCE) {
+				PX4_WARN("primary instance %d unhealthy, switching to %d", _selected_instance, best);
+			}
+
+			SelectInstance(best, now);
+		}
+
+	} else if (now > _last_instance_change + MIN_SWITCH_INTERVAL) {
+		// switch to a healthy instance that has been consistently better than the primary
+		for (uint8_t i = 0; i < MAX_INSTANCES; i++) {
+			if ((i != _selected_instance) && (_instance[i].relative_test_ratio < -RELATIVE_TEST_RATIO_SWITCH)) {
+				PX4_INFO("instance %d performs better than %d, switching", i, _selected_instance);
+				SelectInstance(i, now);
+				break;
+			}
+		}
+	}
+}
+
+bool EKF2Selector::SelectInstance(uint8_t instance, const hrt_abstime &now)
+{
+	if ((instance >= MAX_INSTANCES) || (instance == _selected_instance)) {
+		return false;
+	}
+
+	if (_selected_instance != INVALID_INSTANCE) {
+		_instance[_selected_instance].estimator_attitude_sub.unregisterCallback();
+		_instance[_selected_instance].estimator_local_position_sub.unregisterCallback();
+
+		_instance_changed_count++;
+
+		// the output of the new instance is published like a reset
+		_attitude_reset_pending = true;
+		_local_position_reset_pending = true;
+		_global_position_reset_pending = true;
+	}
+
+	EstimatorInstance &inst = _instance[instance];
+
+	inst.estimator_attitude_sub.registerCallback();
+	inst.estimator_local_position_sub.registerCallback();
+
+	_selected_instance = instance;
+	_last_instance_change = now;
+	_last_relative_update = 0;
+
+	for (auto &i : _instance) {
+		i.relative_test_ratio = 0.f;
+	}
+
+	return true;
+}
+
+void EKF2Selector::PublishVehicleAttitude()
+{
+	vehicle_attitude_s attitude;
+
+	if (_instance[_selected_instance].estimator_attitude_sub.update(&attitude) && (attitude.timestamp != 0)) {
+		const uint8_t instance_reset_counter = attitude.quat_reset_counter;
+
+		if (_attitude_reset_pending && (_attitude_last.timestamp != 0)) {
+			// change from the previously published attitude
+			const Quatf delta_q_reset{Quatf(attitude.q) * Quatf(_attitude_last.q).inversed()};
+			delta_q_reset.normalized().copyTo(attitude.delta_q_reset);
+			_attitude_last.quat_reset_counter++;
+
+		} else if ((_attitude_last.timestamp != 0) && (instance_reset_counter == _instance_quat_reset_counter)) {
+			// no reset, keep the delta of the last reset
+			memcpy(attitude.delta_q_reset, _attitude_last.delta_q_reset, sizeof(attitude.delta_q_reset));
+
+		} else if (_attitude_last.timestamp != 0) {
+			// reset of the selected instance
+			_attitude_last.quat_reset_counter++;
+		}
+
+		_attitude_reset_pending = false;
+		_instance_quat_reset_counter = instance_reset_counter;
+
+		attitude.quat_reset_counter = _attitude_last.quat_reset_counter;
+		_attitude_last = attitude;
+
+		_vehicle_attitude_pub.publish(attitude);
+	}
+}
+
+void EKF2Selector::PublishVehicleLocalPosition()
+{
+	vehicle_local_position_s local_position;
+
+	if (_instance[_selected_instance].estimator_local_position_sub.update(&local_position)
+	    && (local_position.timestamp != 0)) {
+		vehicle_local_position_s &last = _local_position_last;
+		const bool initialized = (last.timestamp != 0);
+
+		const uint8_t xy_reset_counter = local_position.xy_reset_counter;
+		const uint8_t z_reset_counter = local_position.z_reset_counter;
+		const uint8_t vxy_reset_counter = local_position.vxy_reset_counter;
+		const uint8_t vz_reset_counter = local_position.vz_reset_counter;
+
+		if (_local_position_reset_pending && initialized) {
+			// change from the previously published local position
+			local_position.delta_xy[0] = local_position.x - last.x;
+			local_position.delta_xy[1] = local_position.y - last.y;
+			local_position.delta_z = local_position.z - last.z;
+			local_position.delta_vxy[0] = local_position.vx - last.vx;
+			local_position.delta_vxy[1] = local_position.vy - last.vy;
+			local_position.delta_vz = local_position.vz - last.vz;
+
+			last.xy_reset_counter++;
+			last.z_reset_counter++;
+			last.vxy_reset_counter++;
+			last.vz_reset_counter++;
+
+		} else if (initialized) {
+			// resets of the selected instance are passed through, otherwise keep the last deltas
+			if (xy_reset_counter != _instance_xy_reset_counter) {
+				last.xy_reset_counter++;
+
+			} else {
+				local_position.delta_xy[0] = last.delta_xy[0];
+				local_position.delta_xy[1] = last.delta_xy[1];
+			}
+
+			if (z_reset_counter != _instance_z_reset_counter) {
+				last.z_reset_counter++;
+
+			} else {
+				local_position.delta_z = last.delta_z;
+			}
+
+			if (vxy_reset_counter != _instance_vxy_reset_counter) {
+				last.vxy_reset_counter++;
+
+			} else {
+				local_position.delta_vxy[0] = last.delta_vxy[0];
+				local_position.delta_vxy[1] = last.delta_vxy[1];
+			}
+
+			if (vz_reset_counter != _instance_vz_reset_counter) {
+				last.vz_reset_counter++;
+
+			} else {
+				local_position.delta_vz = last.delta_vz;
+			}
+		}
+
+		_local_position_reset_pending = false;
+		_instance_xy_reset_counter = xy_reset_counter;
+		_instance_z_reset_counter = z_reset_counter;
+		_instance_vxy_reset_counter = vxy_reset_counter;
+		_instance_vz_reset_counter = vz_reset_counter;
+
+		if (initialized) {
+			local_position.xy_reset_counter = last.xy_reset_counter;
+			local_position.z_reset_counter = last.z_reset_counter;
+			local_position.vxy_reset_counter = last.vxy_reset_counter;
+			local_position.vz_reset_counter = last.vz_reset_counter;
+		}
+
+		last = local_position;
+
+		_vehicle_local_position_pub.publish(local_position);
+	}
+}
+
+void EKF2Selector::PublishVehicleGlobalPosition()
+{
+	vehicle_global_position_s global_position;
+
+	if (_instance[_selected_instance].estimator_global_position_sub.update(&global_position)
+	    && (global_position.timestamp != 0)) {
+		vehicle_global_position_s &last = _global_position_last;
+		const bool initialized = (last.timestamp != 0);
+
+		const uint8_t lat_lon_reset_counter = global_position.lat_lon_reset_counter;
+		const uint8_t alt_reset_counter = global_position.alt_reset_counter;
+
+		if (_global_position_reset_pending && initialized) {
+			global_position.delta_alt = global_position.alt - last.alt;
+			last.lat_lon_reset_counter++;
+			last.alt_reset_counter++;
+
+		} else if (initialized) {
+			if (lat_lon_reset_counter != _instance_lat_lon_reset_counter) {
+				last.lat_lon_reset_counter++;
+			}
+
+			if (alt_reset_counter != _instance_alt_reset_counter) {
+				last.alt_reset_counter++;
+
+			} else {
+				global_position.delta_alt = last.delta_alt;
+			}
+		}
+
+		_global_position_reset_pending = false;
+		_instance_lat_lon_reset_counter = lat_lon_reset_counter;
+		_instance_alt_reset_counter = alt_reset_counter;
+
+		if (initialized) {
+			global_position.lat_lon_reset_counter = last.lat_lon_reset_counter;
+			global_position.alt_reset_counter = last.alt_reset_counter;
+		}
+
+		last = global_position;
+
+		_vehicle_global_position_pub.publish(global_position);
+	}
+}
+
+void EKF2Selector::PublishVehicleOdometry()
+{
+	vehicle_odometry_s odometry;
+
+	if (_instance[_selected_instance].estimator_odometry_sub.update(&odometry) && (odometry.timestamp != 0)) {
+		_vehicle_odometry_pub.publish(odometry);
+	}
+}
+
+void EKF2Selector::PublishSelectorStatus(const hrt_abstime &now)
+{
+	// publish on a change of the primary instance, otherwise at 1 Hz
+	if ((now < _last_status_publish + 1_s) && (_last_status_publish > _last_instance_change)) {
+		return;
+	}
+
+	estimator_selector_status_s selector_status{};
+	selector_status.primary_instance = _selected_instance;
+	selector_status.instances_available = _available_instances;
+	selector_status.instance_changed_count = _instance_changed_count;
+	selector_status.last_instance_change = _last_instance_change;
+
+	for (uint8_t i = 0; i < MAX_INSTANCES; i++) {
+		const EstimatorInstance &inst = _instance[i];
+
+		selector_status.accel_device_id[i] = inst.accel_device_id;
+		selector_status.gyro_device_id[i] = inst.gyro_device_id;
+		selector_status.combined_test_ratio[i] = inst.combined_test_ratio;
+		selector_status.relative_test_ratio[i] = inst.relative_test_ratio;
+		selector_status.healthy[i] = inst.healthy;
+	}
+
+	selector_status.timestamp = hrt_absolute_time();
+	_estimator_selector_status_pub.publish(selector_status);
+
+	_last_status_publish = now;
+}
+
+void EKF2Selector::PrintStatus()
+{
+	PX4_INFO("selector: primary instance %d, %d instances available, %d changes",
+		 (_selected_instance != INVALID_INSTANCE) ? _selected_instance : -1, _available_instances,
+		 _instance_changed_count);
+
+	for (uint8_t i = 0; i < MAX_INSTANCES; i++) {
+		const EstimatorInstance &inst = _instance[i];
+
+		if (inst.time_last_status > 0) {
+			PX4_INFO("instance %d: %s, test ratio: %.3f (relative %.3f)", i, inst.healthy ? "healthy" : "unhealthy",
+				 (double)inst.combined_test_ratio, (double)inst.relative_test_ratio);
+		}
+	}
+
+	perf_print_counter(_cycle_perf);
+}
@@ -0,0 +1,181 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file EKF2Selector.hpp
+ * Selects one of the ekf2 instances (multi-instance mode) and republishes its
+ * output as vehicle_attitude, vehicle_local_position, vehicle_global_position
+ * and vehicle_odometry.
+ *
+ * The primary instance is changed immediately if it becomes unhealthy, or if
+ * another instance has had a lower combined innovation test ratio for long enough.
+ * The reset counters of the republished topics are incremented on every change,
+ * so that downstream modules handle the step like an estimator reset.
+ */
+
+#pragma once
+
+#include <drivers/drv_hrt.h>
+#include <lib/mathlib/mathlib.h>
+#include <lib/perf/perf_counter.h>
+#include <px4_platform_common/atomic.h>
+#include <px4_platform_common/px4_work_queue/ScheduledWorkItem.hpp>
+#include <uORB/Publication.hpp>
+#include <uORB/Subscription.hpp>
+#include <uORB/SubscriptionCallback.hpp>
+#include <uORB/topics/estimator_selector_status.h>
+#include <uORB/topics/estimator_sensor_bias.h>
+#include <uORB/topics/estimator_status.h>
+#include <uORB/topics/vehicle_attitude.h>
+#include <uORB/topics/vehicle_global_position.h>
+#include <uORB/topics/vehicle_local_position.h>
+#include <uORB/topics/vehicle_odometry.h>
+
+using namespace time_literals;
+
+class EKF2Selector : public px4::ScheduledWorkItem
+{
+public:
+	static constexpr uint8_t MAX_INSTANCES = 3;
+
+	EKF2Selector();
+	~EKF2Selector() override;
+
+	bool Start();
+
+	/**
+	 * Stop the selector and wait (at most 2 seconds) until it is no longer running.
+	 */
+	void Stop();
+
+	/**
+	 * @return true once the selector is off its work queue (after Stop()) and can be deleted
+	 */
+	bool Stopped() const { return _stopped.load(); }
+
+	void PrintStatus();
+
+private:
+	static constexpr uint8_t INVALID_INSTANCE = UINT8_MAX;
+
+	static constexpr hrt_abstime FILTER_UPDATE_TIMEOUT = 100_ms;	///< instance is unhealthy if it does not publish within this time
+	static constexpr hrt_abstime MIN_SWITCH_INTERVAL = 10_s;	///< minimum time between switches to a better (but healthy) instance
+	static constexpr float RELATIVE_TEST_RATIO_LIMIT = 1.f;		///< limit of the accumulated test ratio difference
+	static constexpr float RELATIVE_TEST_RATIO_SWITCH = 0.5f;	///< accumulated test ratio difference to switch to a better instance
+
+	void Run() override;
+
+	void UpdateInstances(const hrt_abstime &now);
+	void UpdateSelection(const hrt_abstime &now);
+	bool SelectInstance(uint8_t instance, const hrt_abstime &now);
+
+	void PublishVehicleAttitude();
+	void PublishVehicleLocalPosition();
+	void PublishVehicleGlobalPosition();
+	void PublishVehicleOdometry();
+	void PublishSelectorStatus(const hrt_abstime &now);
+
+	struct EstimatorInstance {
+		EstimatorInstance(EKF2Selector *selector, uint8_t i) :
+			estimator_attitude_sub{selector, ORB_ID(estimator_attitude), i},
+			estimator_local_position_sub{selector, ORB_ID(estimator_local_position), i},
+			estimator_global_position_sub{ORB_ID(estimator_global_position), i},
+			estimator_odometry_sub{ORB_ID(estimator_odometry), i},
+			estimator_sensor_bias_sub{ORB_ID(estimator_sensor_bias), i},
+			estimator_status_sub{ORB_ID(estimator_status), i}
+		{}
+
+		uORB::SubscriptionCallbackWorkItem estimator_attitude_sub;
+		uORB::SubscriptionCallbackWorkItem estimator_local_position_sub;
+		uORB::Subscription estimator_global_position_sub;
+		uORB::Subscription estimator_odometry_sub;
+		uORB::Subscription estimator_sensor_bias_sub;
+		uORB::Subscription estimator_status_sub;
+
+		estimator_status_s estimator_status{};
+
+		hrt_abstime time_last_status{0};
+
+		uint32_t accel_device_id{0};
+		uint32_t gyro_device_id{0};
+
+		float combined_test_ratio{NAN};
+		float relative_test_ratio{0.f};
+
+		bool healthy{false};
+	};
+
+	EstimatorInstance _instance[MAX_INSTANCES] {
+		{this, 0},
+		{this, 1},
+		{this, 2},
+	};
+
+	uint8_t _selected_instance{INVALID_INSTANCE};
+	uint8_t _available_instances{0};
+
+	uint32_t _instance_changed_count{0};
+	hrt_abstime _last_instance_change{0};
+	hrt_abstime _last_status_publish{0};
+	hrt_abstime _last_relative_update{0};
+
+	// republished output, the reset counters are owned by the selector
+	vehicle_attitude_s _attitude_last{};
+	vehicle_local_position_s _local_position_last{};
+	vehicle_global_position_s _global_position_last{};
+
+	// reset counters of the selected instance at the last publication
+	uint8_t _instance_quat_reset_counter{0};
+	uint8_t _instance_xy_reset_counter{0};
+	uint8_t _instance_z_reset_counter{0};
+	uint8_t _instance_vxy_reset_counter{0};
+	uint8_t _instance_vz_reset_counter{0};
+	uint8_t _instance_lat_lon_reset_counter{0};
+	uint8_t _instance_alt_reset_counter{0};
+
+	// set when the primary instance changed, applied on the next publication
+	bool _attitude_reset_pending{false};
+	bool _local_position_reset_pending{false};
+	bool _global_position_reset_pending{false};
+
+	px4::atomic_bool _should_stop{false};
+	px4::atomic_bool _stopped{false};
+
+	perf_counter_t _cycle_perf{perf_alloc(PC_ELAPSED, "ekf2 selector: cycle")};
+
+	uORB::Publication<estimator_selector_status_s>	_estimator_selector_status_pub{ORB_ID(estimator_selector_status)};
+	uORB::Publication<vehicle_attitude_s>		_vehicle_attitude_pub{ORB_ID(vehicle_attitude)};
+	uORB::Publication<vehicle_global_position_s>	_vehicle_global_position_pub{ORB_ID(vehicle_global_position)};
+	uORB::Publication<vehicle_local_position_s>	_vehicle_local_position_pub{ORB_ID(vehicle_local_position)};
+	uORB::Publication<vehicle_odometry_s>		_vehicle_odometry_pub{ORB_ID(vehicle_odometry)};
+};
@@ -79,6 +79,7 @@
 #include <uORB/topics/vehicle_status.h>
 #include <uORB/topics/wind_estimate.h>
 
+#include "EKF2Selector.hpp"
 #include "Utility/PreFlightChecker.hpp"
 
 // defines used to specify the mask position for use of different accuracy metrics in the GPS blending algorithm
@@ -90,13 +91,20 @@
 #define GPS_MAX_RECEIVERS 2
 #define GPS_BLENDED_INSTANCE 2
 
+// perf counter names of the estimator instances (multi-instance mode)
+static const char *const ekf_update_perf_name[EKF2Selector::MAX_INSTANCES] {
+	MODULE_NAME"0: update",
+	MODULE_NAME"1: update",
+	MODULE_NAME"2: update",
+};
+
 using math::constrain;
 using namespace time_literals;
 
 class Ekf2 final : public ModuleBase<Ekf2>, public ModuleParams, public px4::ScheduledWorkItem
 {
 public:
-	explicit Ekf2(bool replay_mode = false);
+	Ekf2(bool multi_mode, uint8_t instance, const px4::wq_config_t &config, bool replay_mode);
 	~Ekf2() override;
 
 	/** @see ModuleBase */
@@ -113,8 +121,21 @@ public:
 	int print_status() override;
 
 private:
+	static constexpr uint8_t MAX_INSTANCES = EKF2Selector::MAX_INSTANCES;
+
 	void Run() override;
 
+	/**
+	 * Advertise the per instance topics, so that the uORB instance of each topic
+	 * matches the estimator instance (multi-instance mode).
+	 */
+	void advertise_topics();
+
+	/**
+	 * Stop the selector and all other estimator instances (called by instance 0).
+	 */
+	void stop_instances();
+
 	int getRangeSubIndex(); ///< get subscription index of first downward-facing range sensor
 	void fillGpsMsgWithVehicleGpsPosData(gps_message &msg, const vehicle_gps_position_s &data);
 
@@ -173,6 +194,14 @@ private:
 	inline float sq(float x) { return x * x; };
 
 	const bool 	_replay_mode;			///< true when we use replay data from a log
+	const bool	_multi_mode;			///< true when running one estimator instance per IMU
+	const uint8_t	_instance;			///< estimator instance, always 0 if not in multi-instance mode
+
+	// multi-instance mode: the other instances and the output selector are owned by instance 0
+	Ekf2 *_instances[MAX_INSTANCES] {};
+	EKF2Selector *_selector{nullptr};
+
+	px4::atomic_bool _stopped{false};	///< set by a secondary instance once it no longer runs
 
 	// time slip monitoring
 	uint64_t _integrated_time_us = 0;	///< integral of gyro delta time from start (uSec)
@@ -265,20 +294,24 @@ private:
 	vehicle_status_s		_vehicle_status{};
 
 	uORB::Publication<ekf2_timestamps_s>			_ekf2_timestamps_pub{ORB_ID(ekf2_timestamps)};
-	uORB::Publication<ekf_gps_drift_s>			_ekf_gps_drift_pub{ORB_ID(ekf_gps_drift)};
 	uORB::Publication<ekf_gps_position_s>			_blended_gps_pub{ORB_ID(ekf_gps_position)};
-	uORB::Publication<estimator_innovations_s>		_estimator_innovation_test_ratios_pub{ORB_ID(estimator_innovation_test_ratios)};
-	uORB::Publication<estimator_innovations_s>		_estimator_innovation_variances_pub{ORB_ID(estimator_innovation_variances)};
-	uORB::Publication<estimator_innovations_s>		_estimator_innovations_pub{ORB_ID(estimator_innovations)};
-	uORB::Publication<estimator_sensor_bias_s>		_estimator_sensor_bias_pub{ORB_ID(estimator_sensor_bias)};
-	uORB::Publication<estimator_status_s>			_estimator_status_pub{ORB_ID(estimator_status)};
-	uORB::Publication<vehicle_attitude_s>			_att_pub{ORB_ID(vehicle_attitude)};
-	uORB::Publication<vehicle_odometry_s>			_vehicle_odometry_pub{ORB_ID(vehicle_odometry)};
-	uORB::PublicationData<vehicle_global_position_s>	_vehicle_global_position_pub{ORB_ID(vehicle_global_position)};
-	uORB::PublicationData<vehicle_local_position_s>		_vehicle_local_position_pub{ORB_ID(vehicle_local_position)};
-	uORB::PublicationData<vehicle_odometry_s>		_vehicle_visual_odometry_aligned_pub{ORB_ID(vehicle_visual_odometry_aligned)};
+
+	// published by every estimator instance
+	uORB::PublicationMulti<ekf_gps_drift_s>			_ekf_gps_drift_pub{ORB_ID(ekf_gps_drift)};
+	uORB::PublicationMulti<estimator_innovations_s>		_estimator_innovation_test_ratios_pub{ORB_ID(estimator_innovation_test_ratios)};
+	uORB::PublicationMulti<estimator_innovations_s>		_estimator_innovation_variances_pub{ORB_ID(estimator_innovation_variances)};
+	uORB::PublicationMulti<estimator_innovations_s>		_estimator_innovations_pub{ORB_ID(estimator_innovations)};
+	uORB::PublicationMulti<estimator_sensor_bias_s>		_estimator_sensor_bias_pub{ORB_ID(estimator_sensor_bias)};
+	uORB::PublicationMulti<estimator_status_s>		_estimator_status_pub{ORB_ID(estimator_status)};
+	uORB::PublicationMulti<vehicle_odometry_s>		_vehicle_visual_odometry_aligned_pub{ORB_ID(vehicle_visual_odometry_aligned)};
 	uORB::PublicationMulti<wind_estimate_s>			_wind_pub{ORB_ID(wind_estimate)};
 
+	// vehicle_* or estimator_* (multi-instance mode, republished by the selector)
+	uORB::PublicationMulti<vehicle_attitude_s>		_att_pub;
+	uORB::PublicationMulti<vehicle_odometry_s>		_vehicle_odometry_pub;
+	uORB::PublicationMultiData<vehicle_global_position_s>	_vehicle_global_position_pub;
+	uORB::PublicationMultiData<vehicle_local_position_s>	_vehicle_local_position_pub;
+
 	Ekf _ekf;
 
 	parameters *_params;	///< pointer to ekf parameter struct (located in _ekf class instance)
@@ -531,11 +564,17 @@ private:
 
 };
 
-Ekf2::Ekf2(bool replay_mode):
+Ekf2::Ekf2(bool multi_mode, uint8_t instance, const px4::wq_config_t &config, bool replay_mode):
 	ModuleParams(nullptr),
-	ScheduledWorkItem(MODULE_NAME, px4::wq_configurations::att_pos_ctrl),
+	ScheduledWorkItem(MODULE_NAME, config),
 	_replay_mode(replay_mode),
-	_ekf_update_perf(perf_alloc(PC_ELAPSED, MODULE_NAME": update")),
+	_multi_mode(multi_mode),
+	_instance(instance),
+	_ekf_update_perf(perf_alloc(PC_ELAPSED, multi_mode ? ekf_update_perf_name[instance] : MODULE_NAME": update")),
+	_att_pub(multi_mode ? ORB_ID(estimator_attitude) : ORB_ID(vehicle_attitude)),
+	_vehicle_odometry_pub(multi_mode ? ORB_ID(estimator_odometry) : ORB_ID(vehicle_odometry)),
+	_vehicle_global_position_pub(multi_mode ? ORB_ID(estimator_global_position) : ORB_ID(vehicle_global_position)),
+	_vehicle_local_position_pub(multi_mode ? ORB_ID(estimator_local_position) : ORB_ID(vehicle_local_position)),
 	_params(_ekf.getParamHandle()),
 	_param_ekf2_min_obs_dt(_params->sensor_interval_min_ms),
 	_param_ekf2_mag_delay(_params->mag_delay_ms),
@@ -647,11 +686,96 @@ Ekf2::Ekf2(bool replay_mode):
 
 Ekf2::~Ekf2()
 {
+	for (auto &inst : _instances) {
+		delete inst;
+		inst = nullptr;
+	}
+
+	delete _selector;
+	_selector = nullptr;
+
 	perf_free(_ekf_update_perf);
 }
 
+void Ekf2::advertise_topics()
+{
+	_estimator_status_pub.advertise();
+	_estimator_sensor_bias_pub.advertise();
+	_estimator_innovations_pub.advertise();
+	_estimator_innovation_variances_pub.advertise();
+	_estimator_innovation_test_ratios_pub.advertise();
+	_ekf_gps_drift_pub.advertise();
+	_vehicle_visual_odometry_aligned_pub.advertise();
+	_wind_pub.advertise();
+
+	_att_pub.advertise();
+	_vehicle_odometry_pub.advertise();
+	_vehicle_global_position_pub.advertise();
+	_vehicle_local_position_pub.advertise();
+}
+
+void Ekf2::stop_instances()
+{
+	if (_selector != nullptr) {
+		_selector->Stop();
+	}
+
+	for (auto inst : _instances) {
+		if (inst != nullptr) {
+			inst->request_stop();
+			inst->ScheduleNow();
+		}
+	}
+
+	for (auto &inst : _instances) {
+		if (inst == nullptr) {
+			continue;
+		}
+
+		// wait at most 2 seconds for a running update to finish
+		for (int i = 0; (i < 100) && !inst->_stopped.load(); i++) {
+			px4_usleep(20_ms);
+		}
+
+		// only delete an instance that is no longer on its work queue
+		if (inst->_stopped.load()) {
+			delete inst;
+
+		} else {
+			PX4_ERR("%d: instance did not stop, not freed", inst->_instance);
+		}
+
+		inst = nullptr;
+	}
+
+	if (_selector != nullptr) {
+		if (_selector->Stopped()) {
+			delete _selector;
+
+		} else {
+			PX4_ERR("selector did not stop, not freed");
+		}
+
+		_selector = nullptr;
+	}
+}
+
 bool Ekf2::init()
 {
+	if (_multi_mode) {
+		// each instance uses the IMU with the same index
+		if (_vehicle_imu_subs[_instance].registerCallback()) {
+			_imu_sub_index = _instance;
+			_callback_registered = true;
+			return true;
+		}
+
+		PX4_WARN("%d: failed to register callback, retrying in 1 second", _instance);
+		ScheduleDelayed(1_s); // retry in 1 second
+
+		return true;
+	}
+
 	const uint32_t device_id = _param_ekf2_imu_id.get();
 
 	// if EKF2_IMU_ID is non-zero we use the corresponding IMU, otherwise the voted primary (sensor_combined)
@@ -688,6 +812,10 @@ bool Ekf2::init()
 
 int Ekf2::print_status()
 {
+	if (_multi_mode) {
+		PX4_INFO("instance %d: vehicle_imu:%d", _instance, _imu_sub_index);
+	}
+
 	PX4_INFO("local position: %s", (_ekf.local_position_is_valid()) ? "valid" : "invalid");
 	PX4_INFO("global position: %s", (_ekf.global_position_is_valid()) ? "valid" : "invalid");
 
@@ -695,6 +823,16 @@ int Ekf2::print_status()
 
 	perf_print_counter(_ekf_update_perf);
 
+	for (auto inst : _instances) {
+		if (inst != nullptr) {
+			inst->print_status();
+		}
+	}
+
+	if (_selector != nullptr) {
+		_selector->PrintStatus();
+	}
+
 	return 0;
 }
 
@@ -741,7 +879,17 @@ void Ekf2::Run()
 			i.unregisterCallback();
 		}
 
-		exit_and_cleanup();
+		if (_instance == 0) {
+			stop_instances();
+			exit_and_cleanup();
+
+		} else {
+			// secondary instances are deleted by instance 0, once they are off their work queue
+			ScheduleClear();
+			Deinit();
+			_stopped.store(true);
+		}
+
 		return;
 	}
 
@@ -876,7 +1024,9 @@ void Ekf2::Run()
 					}
 				}
 
-				if ((_vehicle_status.arming_state != vehicle_status_s::ARMING_STATE_ARMED) && (_invalid_mag_id_count > 100)) {
+				// only instance 0 writes parameters (multi-instance mode)
+				if ((_instance == 0) && (_vehicle_status.arming_state != vehicle_status_s::ARMING_STATE_ARMED)
+				    && (_invalid_mag_id_count > 100)) {
 					// the sensor ID used for the last saved mag bias is not confirmed to be the same as the current sensor ID
 					// this means we need to reset the learned bias values to zero
 					_param_ekf2_magbias_x.set(0.f);
@@ -994,8 +1144,10 @@ void Ekf2::Run()
 				gps.heading_offset = _gps_output[_gps_select_index].yaw_offset;
 				gps.selected = _gps_select_index;
 
-				// Publish to the EKF blended GPS topic
-				_blended_gps_pub.publish(gps);
+				// Publish to the EKF blended GPS topic (identical for all instances)
+				if (_instance == 0) {
+					_blended_gps_pub.publish(gps);
+				}
 
 				// clear flag to avoid re-use of the same data
 				_gps_new_output_data = false;
@@ -1431,6 +1583,7 @@ void Ekf2::Run()
 
 					// global altitude has opposite sign of local down position
 					global_pos.delta_alt = -lpos.delta_z;
+					global_pos.alt_reset_counter = lpos.z_reset_counter;
 
 					global_pos.vel_n = lpos.vx; // Ground north velocity, m/s
 					global_pos.vel_e = lpos.vy; // Ground east velocity, m/s
@@ -1581,7 +1734,7 @@ void Ekf2::Run()
 				}
 
 				// Check and save the last valid calibration when we are disarmed
-				if ((_vehicle_status.arming_state == vehicle_status_s::ARMING_STATE_STANDBY)
+				if ((_instance == 0) && (_vehicle_status.arming_state == vehicle_status_s::ARMING_STATE_STANDBY)
 				    && (status.filter_fault_flags == 0)
 				    && (_sensor_selection.mag_device_id == (uint32_t)_param_ekf2_magbias_id.get())) {
 
@@ -1597,7 +1750,7 @@ void Ekf2::Run()
 
 			publish_wind_estimate(now);
 
-			if (!_mag_decl_saved && (_vehicle_status.arming_state == vehicle_status_s::ARMING_STATE_STANDBY)) {
+			if ((_instance == 0) && !_mag_decl_saved && (_vehicle_status.arming_state == vehicle_status_s::ARMING_STATE_STANDBY)) {
 				_mag_decl_saved = update_mag_decl(_param_ekf2_mag_decl);
 			}
 
@@ -1684,8 +1837,10 @@ void Ekf2::Run()
 			}
 		}
 
-		// publish ekf2_timestamps
-		_ekf2_timestamps_pub.publish(ekf2_timestamps);
+		// publish ekf2_timestamps (used by replay, which only runs a single instance)
+		if (_instance == 0) {
+			_ekf2_timestamps_pub.publish(ekf2_timestamps);
+		}
 	}
 }
 
@@ -2389,13 +2544,64 @@ int Ekf2::task_spawn(int argc, char *argv[])
 		replay_mode = true;
 	}
 
-	Ekf2 *instance = new Ekf2(replay_mode);
+	int32_t imu_instances = 0;
+	param_get(param_find("EKF2_MULTI_IMU"), &imu_instances);
+
+	const bool multi_mode = (imu_instances > 0) && !replay_mode;
+
+	if (multi_mode) {
+		imu_instances = math::min(imu_instances, (int32_t)MAX_INSTANCES);
+	}
+
+	if ((imu_instances > 0) && replay_mode) {
+		PX4_WARN("multi-instance mode not supported in replay mode");
+	}
+
+	// in multi-instance mode instance 0 owns the other instances and the selector
+	Ekf2 *instance = new Ekf2(multi_mode, 0, multi_mode ? px4::ins_instance_to_wq(0) : px4::wq_configurations::att_pos_ctrl,
+				  replay_mode);
 
 	if (instance) {
 		_object.store(instance);
 		_task_id = task_id_is_work_queue;
 
-		if (instance->init()) {
+		bool success = true;
+
+		if (multi_mode) {
+			// create (and advertise) in instance order, so that the topic instances match the estimator instances
+			instance->advertise_topics();
+
+			for (uint8_t i = 1; i < imu_instances; i++) {
+				instance->_instances[i] = new Ekf2(true, i, px4::ins_instance_to_wq(i), false);
+
+				if (instance->_instances[i] == nullptr) {
+					PX4_ERR("alloc failed");
+					success = false;
+					break;
+				}
+
+				instance->_instances[i]->advertise_topics();
+			}
+
+			instance->_selector = new EKF2Selector();
+
+			if (instance->_selector == nullptr) {
+				PX4_ERR("selector alloc failed");
+				success = false;
+			}
+
+			for (auto inst : instance->_instances) {
+				if (success && (inst != nullptr)) {
+					success = inst->init();
+				}
+			}
+
+			if (success) {
+				success = instance->_selector->Start();
+			}
+		}
+
+		if (success && instance->init()) {
 			return PX4_OK;
 		}
 
@@ -2426,6 +2632,11 @@ The documentation can be found on the [ECL/EKF Overview & Tuning](https://docs.p
 ekf2 can be started in replay mode (`-r`): in this mode it does not access the system time, but only uses the
 timestamps from the sensor topics.
 
+With EKF2_MULTI_IMU > 0 ekf2 runs one estimator instance per IMU (vehicle_imu), each on its own work queue.
+The instances publish the estimator_* topics, and a selector republishes the output of the healthiest
+instance as vehicle_attitude, vehicle_local_position, vehicle_global_position and vehicle_odometry
+(see estimator_selector_status).
+
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("ekf2", "estimator");
@@ -818,6 +818,21 @@ PARAM_DEFINE_FLOAT(EKF2_TERR_GRAD, 0.5f);
  */
 PARAM_DEFINE_INT32(EKF2_IMU_ID, 0);
 
+/**
+ * Multi-EKF IMUs
+ *
+ * Number of estimator instances to run, one per IMU (vehicle_imu).
+ * Set to 0 to run a single estimator (using EKF2_IMU_ID).
+ * The output of the healthiest instance is selected and republished.
+ *
+ * @group EKF2
+ * @min 0
+ * @max 3
+ * @reboot_required true
+ * @category Developer
+ */
+PARAM_DEFINE_INT32(EKF2_MULTI_IMU, 0);
+
 /**
  * X position of IMU in body frame (forward axis with origin relative to vehicle centre of gravity)
  *
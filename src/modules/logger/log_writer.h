@@ -138,6 +138,41 @@ public:
 		return 0;
 	}
 
+	/**
+	 * Use asynchronous direct I/O for the full log file (Linux only). Must be called before init().
+	 */
+	bool enable_async_file_io()
+	{
+#if defined(__PX4_LINUX)
+
+		if (_log_writer_file) { return _log_writer_file->enable_async_io(); }
+
+#endif
+		return false;
+	}
+
+	/**
+	 * Write the full log file as compressed ULog container. Must be called before init().
+	 */
+	bool enable_compression_file()
+	{
+		if (_log_writer_file) { return _log_writer_file->enable_compression(); }
+
+		return false;
+	}
+
+	bool compression_enabled_file(LogType type) const
+	{
+		if (_log_writer_file) { return _log_writer_file->compression_enabled(type); }
+
+		return false;
+	}
+
+	void print_statistics_file(LogType type) const
+	{
+		if (_log_writer_file) { _log_writer_file->print_statistics(type); }
+	}
+
 	pthread_t thread_id_file() const
 	{
 		if (_log_writer_file) { return _log_writer_file->thread_id(); }
@@ -35,6 +35,7 @@
 #include "messages.h"
 
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
@@ -59,11 +60,11 @@ LogWriterFile::LogWriterFile(size_t buffer_size)
 	//needs to be larger than the minimum write chunk (300 is somewhat arbitrary)
 	{
 		math::max(buffer_size, _min_write_chunk + 300),
-		perf_alloc(PC_ELAPSED, "logger_sd_write"), perf_alloc(PC_ELAPSED, "logger_sd_fsync")},
+		perf_alloc(PC_HISTOGRAM, "logger_sd_write"), perf_alloc(PC_HISTOGRAM, "logger_sd_fsync")},
 
 	{
 		300, // buffer size for the mission log (can be kept fairly small)
-		perf_alloc(PC_ELAPSED, "logger_sd_write_mission"), perf_alloc(PC_ELAPSED, "logger_sd_fsync_mission")}
+		perf_alloc(PC_HISTOGRAM, "logger_sd_write_mission"), perf_alloc(PC_HISTOGRAM, "logger_sd_fsync_mission")}
 }
 {
 	pthread_mutex_init(&_mtx, nullptr);
@@ -75,6 +76,18 @@ bool LogWriterFile::init()
 	return true;
 }
 
+bool LogWriterFile::enable_compression()
+{
+	return _buffers[(int)LogType::Full].enable_compression();
+}
+
+#if defined(__PX4_LINUX)
+bool LogWriterFile::enable_async_io()
+{
+	return _buffers[(int)LogType::Full].enable_async_io();
+}
+#endif
+
 LogWriterFile::~LogWriterFile()
 {
 	pthread_mutex_destroy(&_mtx);
@@ -100,7 +113,8 @@ void LogWriterFile::start_log(LogType type, const char *filename)
 		// the hardfault handler will append the crash log to that file on the next reboot.
 		// Note that we don't deregister it when closing the log, so that crashes after disarming
 		// are appended as well (the same holds for crashes before arming, which can be a bit misleading)
-		int ret = hardfault_store_filename(filename);
+		// The hardfault handler can only append to an uncompressed file, so a compressed log deregisters the last one.
+		int ret = hardfault_store_filename(_buffers[(int)type].compressed() ? "" : filename);
 
 		if (ret) {
 			PX4_ERR("Failed to register ULog file to the hardfault handler (%i)", ret);
@@ -245,6 +259,34 @@ void LogWriterFile::run()
 				void *read_ptr;
 				bool is_part;
 				LogFileBuffer &buffer = _buffers[i];
+
+#if defined(__PX4_LINUX)
+
+				if (buffer.async_io()) {
+					if (!buffer.process_async(call_fsync)) {
+						PX4_ERR("write failed (%i)", errno);
+						buffer._should_run = false;
+						buffer.close_file();
+
+					} else if (!buffer._should_run && buffer.fd() >= 0) {
+						// the logger does not write to a stopped buffer anymore
+						pthread_mutex_unlock(&_mtx);
+						const bool finished = buffer.finish_async();
+						pthread_mutex_lock(&_mtx);
+
+						if (!finished) {
+							PX4_ERR("write failed (%i)", errno);
+						}
+
+						buffer.close_file();
+					}
+
+					--i;
+					continue;
+				}
+
+#endif
+
 				size_t available = buffer.get_read_ptr(&read_ptr, &is_part);
 
 				/* if sufficient data available or partial read or terminating, write data */
@@ -292,6 +334,19 @@ void LogWriterFile::run()
 				break;
 			}
 
+#if defined(__PX4_LINUX)
+			LogFileBuffer &full_buffer = _buffers[(int)LogType::Full];
+
+			if (full_buffer.async_io() && full_buffer.async_writes_in_flight()) {
+				// space is freed once a write completes, continue from there
+				pthread_mutex_unlock(&_mtx);
+				full_buffer.wait_async();
+				pthread_mutex_lock(&_mtx);
+				continue;
+			}
+
+#endif
+
 			/* Wait for a call to notify(), which indicates new data is available.
 			 * Note that at this point there could already be new data available (because of a longer write),
 			 * and calling pthread_cond_wait() will still wait for the next notify(). But this is generally
@@ -393,14 +448,26 @@ LogWriterFile::LogFileBuffer::LogFileBuffer(size_t log_buffer_size, perf_counter
 
 LogWriterFile::LogFileBuffer::~LogFileBuffer()
 {
+#if defined(__PX4_LINUX)
+
+	if (_async_io) {
+		delete _async_io; // waits for in-flight requests
+		free(_buffer);
+		_buffer = nullptr;
+	}
+
+#endif
+
 	if (_fd >= 0) {
 		close(_fd);
 	}
 
 	delete[] _buffer;
+	delete _compressor;
 
 	perf_free(_perf_write);
 	perf_free(_perf_fsync);
+	perf_free(_perf_compress);
 }
 
 void LogWriterFile::LogFileBuffer::write_no_check(void *ptr, size_t size)
@@ -445,7 +512,34 @@ size_t LogWriterFile::LogFileBuffer::get_read_ptr(void **ptr, bool *is_part)
 
 bool LogWriterFile::LogFileBuffer::start_log(const char *filename)
 {
-	_fd = ::open(filename, O_CREAT | O_WRONLY, PX4_O_MODE_666);
+	_fd = -1;
+
+#if defined(__PX4_LINUX)
+
+	if (_async_io) {
+		// bypass the page cache if the file system supports it
+		_fd = ::open(filename, O_CREAT | O_WRONLY | O_DIRECT, PX4_O_MODE_666);
+		_direct_io = _fd >= 0;
+		_file_offset = 0;
+
+		if (_buffer == nullptr) {
+			// O_DIRECT needs the buffer aligned to the block size
+			void *buffer = nullptr;
+
+			if (posix_memalign(&buffer, _min_write_chunk, _buffer_size) != 0) {
+				PX4_ERR("Can't create log buffer");
+				return false;
+			}
+
+			_buffer = static_cast<uint8_t *>(buffer);
+		}
+	}
+
+#endif
+
+	if (_fd < 0) {
+		_fd = ::open(filename, O_CREAT | O_WRONLY, PX4_O_MODE_666);
+	}
 
 	if (_fd < 0) {
 		PX4_ERR("Can't open log file %s, errno: %d", filename, errno);
@@ -463,6 +557,18 @@ bool LogWriterFile::LogFileBuffer::start_log(const char *filename)
 		}
 	}
 
+	if (_compressor) {
+		const uint8_t *header;
+		const size_t header_size = _compressor->begin(&header);
+
+		if (!write_all(header, header_size)) {
+			PX4_ERR("Can't write log file header, errno: %d", errno);
+			::close(_fd);
+			_fd = -1;
+			return false;
+		}
+	}
+
 	// Clear buffer and counters
 	_head = 0;
 	_count = 0;
@@ -480,8 +586,12 @@ void LogWriterFile::LogFileBuffer::fsync() const
 	perf_end(_perf_fsync);
 }
 
-ssize_t LogWriterFile::LogFileBuffer::write_to_file(const void *buffer, size_t size, bool call_fsync) const
+ssize_t LogWriterFile::LogFileBuffer::write_to_file(const void *buffer, size_t size, bool call_fsync)
 {
+	if (_compressor) {
+		return write_compressed(buffer, size, call_fsync);
+	}
+
 	perf_begin(_perf_write);
 	ssize_t ret = ::write(_fd, buffer, size);
 	perf_end(_perf_write);
@@ -493,12 +603,129 @@ ssize_t LogWriterFile::LogFileBuffer::write_to_file(const void *buffer, size_t s
 	return ret;
 }
 
+void LogWriterFile::LogFileBuffer::print_statistics() const
+{
+	perf_print_counter(_perf_write);
+	perf_print_counter(_perf_fsync);
+
+	if (_compressor) {
+		const float raw_kibibytes = _compressor->raw_bytes() / 1024.f;
+		const float file_kibibytes = _compressor->file_bytes() / 1024.f;
+
+		PX4_INFO("Compressed %4.2f KiB to %4.2f KiB (ratio %.2f)", (double)raw_kibibytes, (double)file_kibibytes,
+			 (double)(file_kibibytes > 0.f ? raw_kibibytes / file_kibibytes : 0.f));
+		perf_print_counter(_perf_compress);
+	}
+}
+
+bool LogWriterFile::LogFileBuffer::enable_compression()
+{
+	if (_compressor) {
+		return true;
+	}
+
+#if defined(__PX4_LINUX)
+
+	if (_async_io) {
+		PX4_WARN("compression not supported with asynchronous file I/O");
+		return false;
+	}
+
+#endif
+
+	_compressor = new ulog_compression::ULogBlockWriter();
+
+	if (_compressor == nullptr || !_compressor->init()) {
+		PX4_ERR("Can't allocate compression buffers");
+		delete _compressor;
+		_compressor = nullptr;
+		return false;
+	}
+
+	_perf_compress = perf_alloc(PC_ELAPSED, "logger_compress");
+	return true;
+}
+
+bool LogWriterFile::LogFileBuffer::write_all(const uint8_t *data, size_t size)
+{
+	while (size > 0) {
+		perf_begin(_perf_write);
+		const ssize_t ret = ::write(_fd, data, size);
+		perf_end(_perf_write);
+
+		if (ret <= 0) {
+			return false;
+		}
+
+		data += ret;
+		size -= ret;
+	}
+
+	return true;
+}
+
+ssize_t LogWriterFile::LogFileBuffer::write_compressed(const void *buffer, size_t size, bool call_fsync)
+{
+	const uint8_t *data = static_cast<const uint8_t *>(buffer);
+	size_t consumed = 0;
+
+	while (consumed < size) {
+		consumed += _compressor->append(&data[consumed], size - consumed);
+
+		// data is only written in whole blocks, the last partial block is written on close
+		if (_compressor->block_full()) {
+			const uint8_t *output;
+			perf_begin(_perf_compress);
+			const size_t output_size = _compressor->flush_block(&output);
+			perf_end(_perf_compress);
+
+			if (!write_all(output, output_size)) {
+				return -1;
+			}
+		}
+	}
+
+	if (call_fsync) {
+		fsync();
+	}
+
+	return consumed;
+}
+
+bool LogWriterFile::LogFileBuffer::finish_compressed()
+{
+	const uint8_t *output;
+	perf_begin(_perf_compress);
+	const size_t output_size = _compressor->finish(&output);
+	perf_end(_perf_compress);
+
+	return write_all(output, output_size);
+}
+
 void LogWriterFile::LogFileBuffer::close_file()
 {
+#if defined(__PX4_LINUX)
+
+	// the buffer must not change while requests are in flight
+	while (_async_io && _async_io->in_flight() > 0) {
+		_async_io->wait();
+		handle_async_completions();
+	}
+
+	_async_submitted = 0;
+	_async_num_writes = 0;
+	_async_fsync_id = -1;
+
+#endif
+
 	_head = 0;
 	_count = 0;
 
 	if (_fd >= 0) {
+		if (_compressor && !finish_compressed()) {
+			PX4_WARN("writing compressed log index failed (%i)", errno);
+		}
+
 		int res = close(_fd);
 		_fd = -1;
 
@@ -510,6 +737,158 @@ void LogWriterFile::LogFileBuffer::close_file()
 		}
 	}
 }
+#if defined(__PX4_LINUX)
+
+bool LogWriterFile::LogFileBuffer::enable_async_io()
+{
+	if (_async_io) {
+		return true;
+	}
+
+	if (_compressor) {
+		PX4_WARN("asynchronous file I/O not supported with compression");
+		return false;
+	}
+
+	_async_io = new AsyncFileIO();
+
+	if (_async_io == nullptr || !_async_io->init()) {
+		delete _async_io;
+		_async_io = nullptr;
+		return false;
+	}
+
+	// only full, block aligned chunks are written while logging
+	_buffer_size = ((_buffer_size + _min_write_chunk - 1) / _min_write_chunk) * _min_write_chunk;
+
+	PX4_INFO("asynchronous file I/O (%s)", _async_io->backend_name());
+	return true;
+}
+
+bool LogWriterFile::LogFileBuffer::handle_async_completions()
+{
+	AsyncFileIO::Completion completions[AsyncFileIO::MAX_REQUESTS];
+	const int num_completions = _async_io->reap(completions, AsyncFileIO::MAX_REQUESTS);
+	bool ok = num_completions >= 0;
+
+	for (int c = 0; c < num_completions; c++) {
+		const AsyncFileIO::Completion &completion = completions[c];
+
+		if (completion.id == _async_fsync_id) {
+			perf_set_elapsed(_perf_fsync, completion.latency);
+			_async_fsync_id = -1;
+			continue;
+		}
+
+		for (int w = 0; w < _async_num_writes; w++) {
+			AsyncWrite &async_write = _async_writes[w];
+
+			if (async_write.id == completion.id) {
+				perf_set_elapsed(_perf_write, completion.latency);
+				async_write.done = true;
+
+				if (completion.result != (ssize_t)async_write.size) {
+					errno = (completion.result < 0) ? -completion.result : EIO;
+					ok = false;
+				}
+			}
+		}
+	}
+
+	// writes complete in any order, but the buffer is freed in order
+	while (_async_num_writes > 0 && _async_writes[0].done) {
+		mark_read(_async_writes[0].size);
+		_async_submitted -= _async_writes[0].size;
+
+		for (int w = 1; w < _async_num_writes; w++) {
+			_async_writes[w - 1] = _async_writes[w];
+		}
+
+		_async_num_writes--;
+	}
+
+	return ok;
+}
+
+bool LogWriterFile::LogFileBuffer::process_async(bool call_fsync)
+{
+	if (_fd < 0) {
+		return true;
+	}
+
+	if (!handle_async_completions()) {
+		return false;
+	}
+
+	while (_async_num_writes < ASYNC_WRITES) {
+		// contiguous data after the in-flight writes
+		const size_t read_ptr = (_head + _buffer_size - _count) % _buffer_size;
+		const size_t submit_ptr = (read_ptr + _async_submitted) % _buffer_size;
+		size_t size = math::min(_count - _async_submitted, _buffer_size - submit_ptr);
+
+		// whole chunks only, so that writes stay block aligned
+		size -= size % _min_write_chunk;
+
+		if (size == 0) {
+			break;
+		}
+
+		const int id = _async_io->submit_write(_fd, &_buffer[submit_ptr], size, _file_offset);
+
+		if (id < 0) {
+			break;
+		}
+
+		_async_writes[_async_num_writes++] = {id, size, false};
+		_async_submitted += size;
+		_file_offset += size;
+	}
+
+	if (call_fsync && _should_run && _async_fsync_id < 0) {
+		_async_fsync_id = _async_io->submit_fsync(_fd);
+	}
+
+	return true;
+}
+
+bool LogWriterFile::LogFileBuffer::finish_async()
+{
+	while (_async_io->in_flight() > 0) {
+		_async_io->wait();
+
+		if (!handle_async_completions()) {
+			return false;
+		}
+	}
+
+	// the remaining data is not a multiple of the block size
+	if (_direct_io) {
+		fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) & ~O_DIRECT);
+		_direct_io = false;
+	}
+
+	while (_count > 0) {
+		void *read_ptr;
+		bool is_part;
+		const size_t available = get_read_ptr(&read_ptr, &is_part);
+
+		perf_begin(_perf_write);
+		const ssize_t written = ::pwrite(_fd, read_ptr, available, _file_offset);
+		perf_end(_perf_write);
+
+		if (written <= 0) {
+			return false;
+		}
+
+		mark_read(written);
+		_file_offset += written;
+	}
+
+	fsync();
+	return true;
+}
+
+#endif /* __PX4_LINUX */
 
 }
 }
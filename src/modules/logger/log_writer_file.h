@@ -38,6 +38,9 @@
 #include <pthread.h>
 #include <drivers/drv_hrt.h>
 #include <perf/perf_counter.h>
+#include <lib/ulog_compression/ULogBlockWriter.hpp>
+
+#include "log_writer_file_async.h"
 
 namespace px4
 {
@@ -69,6 +72,25 @@ public:
 
 	bool init();
 
+#if defined(__PX4_LINUX)
+	/**
+	 * Write the full log with asynchronous direct I/O (io_uring or I/O threads), so that
+	 * the writer thread never blocks on a write or fsync. Must be called before thread_start().
+	 * @return true on success
+	 */
+	bool enable_async_io();
+#endif
+
+	/**
+	 * Write the full log as compressed ULog container (see ulog_block_format.h). The compression
+	 * runs in the writer thread, so the latency of write_message() is not affected.
+	 * Must be called before thread_start().
+	 * @return true on success
+	 */
+	bool enable_compression();
+
+	bool compression_enabled(LogType type) const { return _buffers[(int)type].compressed(); }
+
 	/**
 	 * start the thread
 	 * @return 0 on success, error number otherwise (@see pthread_create)
@@ -128,6 +150,8 @@ public:
 
 	pthread_t thread_id() const { return _thread; }
 
+	void print_statistics(LogType type) const { _buffers[(int)type].print_statistics(); }
+
 private:
 	static void *run_helper(void *);
 
@@ -171,7 +195,11 @@ private:
 
 		int fd() const { return _fd; }
 
-		inline ssize_t write_to_file(const void *buffer, size_t size, bool call_fsync) const;
+		/**
+		 * Write to the file, or compress and write complete blocks in compressed mode.
+		 * @return number of bytes consumed from buffer, -1 on error
+		 */
+		inline ssize_t write_to_file(const void *buffer, size_t size, bool call_fsync);
 
 		inline void fsync() const;
 
@@ -181,10 +209,68 @@ private:
 		size_t buffer_size() const { return _buffer_size; }
 		size_t count() const { return _count; }
 
+		void print_statistics() const;
+
+		bool enable_compression();
+
+		bool compressed() const { return _compressor != nullptr; }
+
+#if defined(__PX4_LINUX)
+		bool enable_async_io();
+
+		bool async_io() const { return _async_io != nullptr; }
+
+		/**
+		 * Handle completed requests and submit the available data in full chunks (writer lock held).
+		 * @return false on write error
+		 */
+		bool process_async(bool call_fsync);
+
+		/**
+		 * Wait for the in-flight requests and write the remaining data synchronously (writer lock not held).
+		 * @return false on write error
+		 */
+		bool finish_async();
+
+		bool async_writes_in_flight() const { return _async_num_writes > 0; }
+
+		void wait_async() { _async_io->wait(); }
+#endif
+
 		bool _should_run = false;
 
 	private:
-		const size_t _buffer_size;
+		ssize_t write_compressed(const void *buffer, size_t size, bool call_fsync);
+
+		/** write the remaining compressed data and the index (called before closing the file) */
+		bool finish_compressed();
+
+		bool write_all(const uint8_t *data, size_t size);
+
+		ulog_compression::ULogBlockWriter *_compressor = nullptr;
+		perf_counter_t _perf_compress = nullptr;
+
+#if defined(__PX4_LINUX)
+		bool handle_async_completions();
+
+		static constexpr int ASYNC_WRITES = 2; ///< number of writes in flight (double buffering)
+
+		struct AsyncWrite {
+			int id;
+			size_t size;
+			bool done;
+		};
+
+		AsyncFileIO *_async_io = nullptr;
+		AsyncWrite _async_writes[ASYNC_WRITES] {}; ///< in-flight writes, in file order
+		int _async_num_writes = 0;
+		int _async_fsync_id = -1;
+		size_t _async_submitted = 0; ///< bytes in flight
+		off_t _file_offset = 0; ///< file offset of the next submitted write
+		bool _direct_io = false; ///< file opened with O_DIRECT
+#endif
+
+		size_t _buffer_size;
 		int	_fd = -1;
 		uint8_t *_buffer = nullptr;
 		size_t _head = 0; ///< next position to write to
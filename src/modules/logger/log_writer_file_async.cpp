@@ -0,0 +1,527 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#if defined(__PX4_LINUX)
+
+#include "log_writer_file_async.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <px4_platform_common/log.h>
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define LOGGER_HAVE_IO_URING
+#endif
+#endif
+
+namespace px4
+{
+namespace logger
+{
+
+bool AsyncFileIO::init()
+{
+	if (ring_init()) {
+		return true;
+	}
+
+	return pool_init();
+}
+
+void AsyncFileIO::deinit()
+{
+	// wait for all requests to complete, the buffers must stay valid until then
+	Completion completions[MAX_REQUESTS];
+
+	while (_in_flight > 0) {
+		wait();
+
+		if (reap(completions, MAX_REQUESTS) < 0) {
+			break;
+		}
+	}
+
+	ring_deinit();
+	pool_deinit();
+}
+
+int AsyncFileIO::alloc_request()
+{
+	// the pool workers update the request state concurrently
+	const bool pool = _ring_fd < 0;
+	int free_id = -1;
+
+	if (pool) {
+		pthread_mutex_lock(&_pool_mtx);
+	}
+
+	for (int id = 0; id < MAX_REQUESTS; id++) {
+		if (_requests[id].state == State::Free) {
+			free_id = id;
+			break;
+		}
+	}
+
+	if (pool) {
+		pthread_mutex_unlock(&_pool_mtx);
+	}
+
+	return free_id;
+}
+
+int AsyncFileIO::submit_write(int fd, const void *buffer, size_t size, off_t offset)
+{
+	const int id = alloc_request();
+
+	if (id >= 0) {
+		Request &request = _requests[id];
+		request.fd = fd;
+		request.fsync = false;
+		request.iov.iov_base = const_cast<void *>(buffer);
+		request.iov.iov_len = size;
+		request.offset = offset;
+		return submit(id);
+	}
+
+	return -1;
+}
+
+int AsyncFileIO::submit_fsync(int fd)
+{
+	const int id = alloc_request();
+
+	if (id >= 0) {
+		Request &request = _requests[id];
+		request.fd = fd;
+		request.fsync = true;
+		request.iov = {};
+		request.offset = 0;
+		return submit(id);
+	}
+
+	return -1;
+}
+
+int AsyncFileIO::submit(int id)
+{
+	Request &request = _requests[id];
+	request.submit_time = hrt_absolute_time();
+	request.seq = _next_seq++;
+
+	if (_ring_fd >= 0) {
+		if (ring_submit(id) != 0) {
+			return -1;
+		}
+
+		request.state = State::Queued;
+
+	} else {
+		pthread_mutex_lock(&_pool_mtx);
+		request.state = State::Queued;
+		pthread_cond_signal(&_pool_work_cv);
+		pthread_mutex_unlock(&_pool_mtx);
+	}
+
+	_in_flight++;
+	return id;
+}
+
+int AsyncFileIO::reap(Completion *completions, int max)
+{
+	if (_in_flight == 0) {
+		return 0;
+	}
+
+	const int n = (_ring_fd >= 0) ? ring_reap(completions, max) : pool_reap(completions, max);
+
+	if (n > 0) {
+		_in_flight -= n;
+	}
+
+	return n;
+}
+
+void AsyncFileIO::wait()
+{
+	if (_in_flight == 0) {
+		return;
+	}
+
+	if (_ring_fd >= 0) {
+		ring_wait();
+
+	} else {
+		pool_wait();
+	}
+}
+
+#if defined(LOGGER_HAVE_IO_URING)
+
+bool AsyncFileIO::ring_init()
+{
+	io_uring_params params{};
+	_ring_fd = syscall(__NR_io_uring_setup, MAX_REQUESTS, &params);
+
+	if (_ring_fd < 0) {
+		PX4_DEBUG("io_uring not available (%i)", errno);
+		return false;
+	}
+
+	_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		_sq_ring_size = _cq_ring_size = (_sq_ring_size > _cq_ring_size) ? _sq_ring_size : _cq_ring_size;
+	}
+
+	_sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd,
+			IORING_OFF_SQ_RING);
+
+	if (_sq_ring == MAP_FAILED) {
+		_sq_ring = nullptr;
+		ring_deinit();
+		return false;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		_cq_ring = _sq_ring;
+
+	} else {
+		_cq_ring = mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd,
+				IORING_OFF_CQ_RING);
+
+		if (_cq_ring == MAP_FAILED) {
+			_cq_ring = nullptr;
+			ring_deinit();
+			return false;
+		}
+	}
+
+	_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	void *sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd,
+			  IORING_OFF_SQES);
+
+	if (sqes == MAP_FAILED) {
+		ring_deinit();
+		return false;
+	}
+
+	_sqes = static_cast<io_uring_sqe *>(sqes);
+
+	uint8_t *sq = static_cast<uint8_t *>(_sq_ring);
+	_sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+	_sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+	_sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+	uint8_t *cq = static_cast<uint8_t *>(_cq_ring);
+	_cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+	_cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+	_cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+	_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+	return true;
+}
+
+void AsyncFileIO::ring_deinit()
+{
+	if (_sqes) {
+		munmap(_sqes, _sqes_size);
+		_sqes = nullptr;
+	}
+
+	if (_cq_ring && _cq_ring != _sq_ring) {
+		munmap(_cq_ring, _cq_ring_size);
+	}
+
+	_cq_ring = nullptr;
+
+	if (_sq_ring) {
+		munmap(_sq_ring, _sq_ring_size);
+		_sq_ring = nullptr;
+	}
+
+	if (_ring_fd >= 0) {
+		close(_ring_fd);
+		_ring_fd = -1;
+	}
+}
+
+int AsyncFileIO::ring_submit(int id)
+{
+	const Request &request = _requests[id];
+
+	// we are the only producer of the submission queue
+	const unsigned tail = *_sq_tail;
+	const unsigned index = tail & *_sq_mask;
+
+	io_uring_sqe *sqe = &_sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->fd = request.fd;
+	sqe->user_data = id;
+
+	if (request.fsync) {
+		// the writes are submitted separately and can complete in any order, the fsync must not
+		// start before all of them have completed
+		sqe->opcode = IORING_OP_FSYNC;
+		sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+		sqe->flags = IOSQE_IO_DRAIN;
+
+	} else {
+		sqe->opcode = IORING_OP_WRITEV;
+		sqe->addr = (uint64_t)(uintptr_t)&request.iov;
+		sqe->len = 1;
+		sqe->off = request.offset;
+	}
+
+	_sq_array[index] = index;
+	__atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	int ret;
+
+	do {
+		ret = syscall(__NR_io_uring_enter, _ring_fd, 1, 0, 0, nullptr, 0);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret != 1) {
+		PX4_ERR("io_uring submit failed (%i)", errno);
+		return -1;
+	}
+
+	return 0;
+}
+
+void AsyncFileIO::ring_wait()
+{
+	while (*_cq_head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+		int ret = syscall(__NR_io_uring_enter, _ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+		if (ret < 0 && errno != EINTR) {
+			PX4_ERR("io_uring wait failed (%i)", errno);
+			return;
+		}
+	}
+}
+
+int AsyncFileIO::ring_reap(Completion *completions, int max)
+{
+	// we are the only consumer of the completion queue
+	unsigned head = *_cq_head;
+	const hrt_abstime now = hrt_absolute_time();
+	int n = 0;
+
+	while (n < max && head != __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+		const io_uring_cqe &cqe = _cqes[head & *_cq_mask];
+		Request &request = _requests[cqe.user_data];
+
+		completions[n].id = cqe.user_data;
+		completions[n].result = cqe.res;
+		completions[n].latency = now - request.submit_time;
+		request.state = State::Free;
+
+		++head;
+		++n;
+	}
+
+	__atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+	return n;
+}
+
+#else
+
+bool AsyncFileIO::ring_init() { return false; }
+void AsyncFileIO::ring_deinit() {}
+int AsyncFileIO::ring_submit(int id) { return -1; }
+int AsyncFileIO::ring_reap(Completion *completions, int max) { return -1; }
+void AsyncFileIO::ring_wait() {}
+
+#endif /* LOGGER_HAVE_IO_URING */
+
+bool AsyncFileIO::pool_init()
+{
+	pthread_mutex_init(&_pool_mtx, nullptr);
+	pthread_cond_init(&_pool_work_cv, nullptr);
+	pthread_cond_init(&_pool_done_cv, nullptr);
+	_pool_exit = false;
+
+	for (_num_threads = 0; _num_threads < POOL_THREADS; _num_threads++) {
+		if (pthread_create(&_threads[_num_threads], nullptr, &AsyncFileIO::pool_run_helper, this) != 0) {
+			break;
+		}
+	}
+
+	if (_num_threads == 0) {
+		PX4_ERR("failed to create I/O threads");
+		pool_deinit();
+		return false;
+	}
+
+	return true;
+}
+
+void AsyncFileIO::pool_deinit()
+{
+	if (_num_threads == 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&_pool_mtx);
+	_pool_exit = true;
+	pthread_cond_broadcast(&_pool_work_cv);
+	pthread_mutex_unlock(&_pool_mtx);
+
+	for (int i = 0; i < _num_threads; i++) {
+		pthread_join(_threads[i], nullptr);
+	}
+
+	_num_threads = 0;
+
+	pthread_mutex_destroy(&_pool_mtx);
+	pthread_cond_destroy(&_pool_work_cv);
+	pthread_cond_destroy(&_pool_done_cv);
+}
+
+bool AsyncFileIO::pool_writes_before(const Request &fsync) const
+{
+	for (const Request &r : _requests) {
+		if (!r.fsync && r.fd == fsync.fd && (r.state == State::Queued || r.state == State::Running)
+		    && (int32_t)(r.seq - fsync.seq) < 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void *AsyncFileIO::pool_run_helper(void *context)
+{
+	static_cast<AsyncFileIO *>(context)->pool_run();
+	return nullptr;
+}
+
+void AsyncFileIO::pool_run()
+{
+	pthread_mutex_lock(&_pool_mtx);
+
+	while (!_pool_exit) {
+		Request *request = nullptr;
+
+		// oldest queued request first, an fsync waits for the writes submitted before it
+		for (Request &r : _requests) {
+			if (r.state == State::Queued && !(r.fsync && pool_writes_before(r))
+			    && (request == nullptr || (int32_t)(r.seq - request->seq) < 0)) {
+				request = &r;
+			}
+		}
+
+		if (request == nullptr) {
+			pthread_cond_wait(&_pool_work_cv, &_pool_mtx);
+			continue;
+		}
+
+		request->state = State::Running;
+		pthread_mutex_unlock(&_pool_mtx);
+
+		ssize_t result;
+
+		if (request->fsync) {
+			result = (::fdatasync(request->fd) == 0) ? 0 : -errno;
+
+		} else {
+			result = ::pwrite(request->fd, request->iov.iov_base, request->iov.iov_len, request->offset);
+
+			if (result < 0) {
+				result = -errno;
+			}
+		}
+
+		pthread_mutex_lock(&_pool_mtx);
+		request->result = result;
+		request->state = State::Done;
+		pthread_cond_signal(&_pool_done_cv);
+
+		if (!request->fsync) {
+			// an fsync might be waiting for this write
+			pthread_cond_signal(&_pool_work_cv);
+		}
+	}
+
+	pthread_mutex_unlock(&_pool_mtx);
+}
+
+int AsyncFileIO::pool_reap(Completion *completions, int max)
+{
+	pthread_mutex_lock(&_pool_mtx);
+	int n = 0;
+
+	for (int id = 0; id < MAX_REQUESTS && n < max; id++) {
+		Request &request = _requests[id];
+
+		if (request.state == State::Done) {
+			completions[n].id = id;
+			completions[n].result = request.result;
+			completions[n].latency = hrt_elapsed_time(&request.submit_time);
+			request.state = State::Free;
+			n++;
+		}
+	}
+
+	pthread_mutex_unlock(&_pool_mtx);
+	return n;
+}
+
+void AsyncFileIO::pool_wait()
+{
+	pthread_mutex_lock(&_pool_mtx);
+
+	while (true) {
+		for (const Request &request : _requests) {
+			if (request.state == State::Done) {
+				pthread_mutex_unlock(&_pool_mtx);
+				return;
+			}
+		}
+
+		pthread_cond_wait(&_pool_done_cv, &_pool_mtx);
+	}
+}
+
+}
+}
+
+#endif /* __PX4_LINUX */
@@ -0,0 +1,173 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#if defined(__PX4_LINUX)
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <drivers/drv_hrt.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace px4
+{
+namespace logger
+{
+
+/**
+ * @class AsyncFileIO
+ * Asynchronous file writes for LogWriterFile (Linux only).
+ *
+ * Writes and fsyncs are submitted without blocking and completed in the background,
+ * either by the kernel through io_uring (if available) or by a pool of I/O threads.
+ * All methods must be called from the same (writer) thread.
+ */
+class AsyncFileIO
+{
+public:
+	static constexpr int MAX_REQUESTS = 3; ///< two writes (double buffering) and one fsync
+
+	struct Completion {
+		int id;			///< request id returned by submit_*()
+		ssize_t result;		///< number of bytes written, 0 for fsync, or negative errno
+		hrt_abstime latency;	///< time from submission to completion
+	};
+
+	AsyncFileIO() = default;
+	~AsyncFileIO() { deinit(); }
+
+	bool init();
+	void deinit();
+
+	const char *backend_name() const { return _ring_fd >= 0 ? "io_uring" : "thread pool"; }
+
+	/**
+	 * Submit a write of size bytes at a file offset. The buffer must stay valid until completion.
+	 * @return request id, or -1 if no request is available or the submission failed
+	 */
+	int submit_write(int fd, const void *buffer, size_t size, off_t offset);
+
+	/**
+	 * Submit an fdatasync.
+	 * @return request id, or -1 if no request is available or the submission failed
+	 */
+	int submit_fsync(int fd);
+
+	/**
+	 * Collect completed requests (non-blocking).
+	 * @return number of completions stored in completions
+	 */
+	int reap(Completion *completions, int max);
+
+	/**
+	 * Block until at least one request has completed (if any is in flight).
+	 */
+	void wait();
+
+	int in_flight() const { return _in_flight; }
+
+private:
+	enum class State : uint8_t {
+		Free,
+		Queued,
+		Running,
+		Done
+	};
+
+	struct Request {
+		int fd{-1};
+		bool fsync{false};
+		struct iovec iov {};
+		off_t offset{0};
+		hrt_abstime submit_time{0};
+		uint32_t seq{0};	///< submission order
+		ssize_t result{0};
+		State state{State::Free};
+	};
+
+	int alloc_request();
+	int submit(int id);
+
+	bool ring_init();
+	void ring_deinit();
+	int ring_submit(int id);
+	int ring_reap(Completion *completions, int max);
+	void ring_wait();
+
+	bool pool_init();
+	void pool_deinit();
+	int pool_reap(Completion *completions, int max);
+	void pool_wait();
+	bool pool_writes_before(const Request &fsync) const;
+	static void *pool_run_helper(void *context);
+	void pool_run();
+
+	Request _requests[MAX_REQUESTS] {};
+	uint32_t _next_seq{0};
+	int _in_flight{0};
+
+	// io_uring
+	int _ring_fd{-1};
+	void *_sq_ring{nullptr};
+	void *_cq_ring{nullptr};
+	size_t _sq_ring_size{0};
+	size_t _cq_ring_size{0};
+	struct io_uring_sqe *_sqes {nullptr};
+	size_t _sqes_size{0};
+	unsigned *_sq_tail{nullptr};
+	unsigned *_sq_mask{nullptr};
+	unsigned *_sq_array{nullptr};
+	unsigned *_cq_head{nullptr};
+	unsigned *_cq_tail{nullptr};
+	unsigned *_cq_mask{nullptr};
+	struct io_uring_cqe *_cqes {nullptr};
+
+	// thread pool (a later write can complete while an fsync blocks the other thread)
+	static constexpr int POOL_THREADS = 2;
+	pthread_t _threads[POOL_THREADS] {};
+	int _num_threads{0};
+	bool _pool_exit{false};
+	pthread_mutex_t _pool_mtx;
+	pthread_cond_t _pool_work_cv;
+	pthread_cond_t _pool_done_cv;
+};
+
+}
+}
+
+#endif /* __PX4_LINUX */
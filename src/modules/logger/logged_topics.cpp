@@ -53,13 +53,8 @@ void LoggedTopics::add_default_topics()
 	add_topic("camera_trigger_secondary");
 	add_topic("cellular_status", 200);
 	add_topic("cpuload");
-	add_topic("ekf_gps_drift");
 	add_topic("esc_status", 250);
-	add_topic("estimator_innovation_test_ratios", 200);
-	add_topic("estimator_innovation_variances", 200);
-	add_topic("estimator_innovations", 200);
-	add_topic("estimator_sensor_bias", 1000);
-	add_topic("estimator_status", 200);
+	add_topic("estimator_selector_status");
 	add_topic("home_position");
 	add_topic("hover_thrust_estimate", 100);
 	add_topic("input_rc", 200);
@@ -102,6 +97,17 @@ void LoggedTopics::add_default_topics()
 	add_topic_multi("telemetry_status", 1000);
 	add_topic_multi("wind_estimate", 1000);
 
+	// estimator topics (one instance per estimator in ekf2 multi-instance mode)
+	add_topic_multi("ekf_gps_drift");
+	add_topic_multi("estimator_attitude", 500);
+	add_topic_multi("estimator_global_position", 1000);
+	add_topic_multi("estimator_innovation_test_ratios", 200);
+	add_topic_multi("estimator_innovation_variances", 200);
+	add_topic_multi("estimator_innovations", 200);
+	add_topic_multi("estimator_local_position", 500);
+	add_topic_multi("estimator_sensor_bias", 1000);
+	add_topic_multi("estimator_status", 200);
+
 	// log all raw sensors at minimal rate (1 Hz)
 	add_topic_multi("battery_status", 1000);
 	add_topic_multi("differential_pressure", 1000);
@@ -88,6 +88,23 @@ struct timer_callback_data_s {
 	volatile bool watchdog_triggered = false;
 };
 
+static void wakeup_logger(px4_sem_t *semaphore)
+{
+	/* check the value of the semaphore: if the logger cannot keep up with running it's main loop as fast
+	 * as the semaphore is posted, the counter would increase unbounded,
+	 * leading to an overflow at some point. This case we want to avoid here, so we check the current
+	 * value against a (somewhat arbitrary) threshold, and avoid calling sem_post() if it's exceeded.
+	 * (it's not a problem if the threshold is a bit too large, it just means the logger will do
+	 * multiple iterations at once, the next time it's scheduled). */
+	int semaphore_value;
+
+	if (px4_sem_getvalue(semaphore, &semaphore_value) == 0 && semaphore_value > 1) {
+		return;
+	}
+
+	px4_sem_post(semaphore);
+}
+
 /* This is used to schedule work for the logger (periodic scan for updated topics) */
 static void timer_callback(void *arg)
 {
@@ -99,20 +116,18 @@ static void timer_callback(void *arg)
 		data->watchdog_triggered = true;
 	}
 
-	/* check the value of the semaphore: if the logger cannot keep up with running it's main loop as fast
-	 * as the timer_callback here increases the semaphore count, the counter would increase unbounded,
-	 * leading to an overflow at some point. This case we want to avoid here, so we check the current
-	 * value against a (somewhat arbitrary) threshold, and avoid calling sem_post() if it's exceeded.
-	 * (it's not a problem if the threshold is a bit too large, it just means the logger will do
-	 * multiple iterations at once, the next time it's scheduled). */
-	int semaphore_value;
-
-	if (px4_sem_getvalue(&data->semaphore, &semaphore_value) == 0 && semaphore_value > 1) {
-		return;
-	}
+	wakeup_logger(&data->semaphore);
+}
 
-	px4_sem_post(&data->semaphore);
+void LoggerSubscriptionCallback::call()
+{
+	/* Note: called by the publisher, possibly in IRQ context (on NuttX) */
 
+	// wake up only once per queued update, and only if the topic is due to be logged
+	// (otherwise the logger checks it again on the next timer iteration)
+	if (_ready_queue.push(this) && _subscription.interval_elapsed()) {
+		wakeup_logger(_wakeup);
+	}
 }
 
 
@@ -179,6 +194,19 @@ int Logger::print_status()
 	PX4_INFO("Number of subscriptions: %i (%i bytes)", _num_subscriptions,
 		 (int)(_num_subscriptions * sizeof(LoggerSubscription)));
 
+	if (_subscription_callbacks) {
+		int num_callbacks = 0;
+
+		for (int i = 0; i < _num_subscriptions; ++i) {
+			if (_subscription_callbacks[i]) {
+				++num_callbacks;
+			}
+		}
+
+		PX4_INFO("Event-driven: %i update callbacks (%i bytes)", num_callbacks,
+			 (int)(num_callbacks * sizeof(LoggerSubscriptionCallback)));
+	}
+
 	bool is_logging = false;
 
 	if (_writer.is_started(LogType::Full, LogWriter::BackendFile)) {
@@ -232,6 +260,8 @@ void Logger::print_statistics(LogType type)
 	stats.high_water = 0;
 	stats.write_dropouts = 0;
 	stats.max_dropout_duration = 0.f;
+
+	_writer.print_statistics_file(type);
 }
 
 Logger *Logger::instantiate(int argc, char *argv[])
@@ -245,12 +275,14 @@ Logger *Logger::instantiate(int argc, char *argv[])
 	bool log_name_timestamp = false;
 	LogWriter::Backend backend = LogWriter::BackendAll;
 	const char *poll_topic = nullptr;
+	bool async_file_io = false;
+	bool event_driven = false;
 
 	int myoptind = 1;
 	int ch;
 	const char *myoptarg = nullptr;
 
-	while ((ch = px4_getopt(argc, argv, "r:b:etfm:p:x", &myoptind, &myoptarg)) != EOF) {
+	while ((ch = px4_getopt(argc, argv, "r:b:cdetfm:p:x", &myoptind, &myoptarg)) != EOF) {
 		switch (ch) {
 		case 'r': {
 				unsigned long r = strtoul(myoptarg, nullptr, 10);
@@ -286,6 +318,14 @@ Logger *Logger::instantiate(int argc, char *argv[])
 			log_name_timestamp = true;
 			break;
 
+		case 'c':
+			event_driven = true;
+			break;
+
+		case 'd':
+			async_file_io = true;
+			break;
+
 		case 'f':
 			log_on_start = true;
 			log_until_shutdown = true;
@@ -358,6 +398,19 @@ Logger *Logger::instantiate(int argc, char *argv[])
 
 #endif /* __PX4_NUTTX */
 
+		if (async_file_io && !logger->enable_async_file_io()) {
+			PX4_WARN("asynchronous file I/O not available");
+		}
+
+		if (event_driven) {
+			if (poll_topic) {
+				PX4_WARN("update callbacks not used when polling on a topic");
+
+			} else {
+				logger->set_event_driven(true);
+			}
+		}
+
 	}
 
 	return logger;
@@ -376,6 +429,7 @@ Logger::Logger(LogWriter::Backend backend, size_t buffer_size, uint32_t log_inte
 	_sdlog_profile_handle = param_find("SDLOG_PROFILE");
 	_mission_log = param_find("SDLOG_MISSION");
 	_boot_bat_only = param_find("SDLOG_BOOT_BAT");
+	_compress_log = param_find("SDLOG_COMPRESS");
 
 	if (poll_topic_name) {
 		const orb_metadata *const *topics = orb_get_topics();
@@ -399,6 +453,8 @@ Logger::~Logger()
 		free(_replay_file_name);
 	}
 
+	free_update_callbacks();
+
 	delete[](_msg_buffer);
 	delete[](_subscriptions);
 }
@@ -424,6 +480,8 @@ bool Logger::copy_if_updated(int sub_idx, void *buffer, bool try_to_subscribe)
 
 	} else if (try_to_subscribe) {
 		if (sub.subscribe()) {
+			register_update_callback(sub_idx);
+
 			write_add_logged_msg(LogType::Full, sub);
 
 			if (sub_idx < _num_mission_subs) {
@@ -438,6 +496,96 @@ bool Logger::copy_if_updated(int sub_idx, void *buffer, bool try_to_subscribe)
 	return updated;
 }
 
+void Logger::log_subscription(int sub_idx, bool try_to_subscribe, hrt_abstime loop_time, uint32_t &total_bytes)
+{
+	LoggerSubscription &sub = _subscriptions[sub_idx];
+
+	/* if this topic has been updated, copy the new data into the message buffer
+	 * and write a message to the log
+	 */
+	if (copy_if_updated(sub_idx, _msg_buffer + sizeof(ulog_message_data_header_s), try_to_subscribe)) {
+		// each message consists of a header followed by an orb data object
+		const size_t msg_size = sizeof(ulog_message_data_header_s) + sub.get_topic()->o_size_no_padding;
+		const uint16_t write_msg_size = static_cast<uint16_t>(msg_size - ULOG_MSG_HEADER_LEN);
+		const uint16_t write_msg_id = sub.msg_id;
+
+		//write one byte after another (necessary because of alignment)
+		_msg_buffer[0] = (uint8_t)write_msg_size;
+		_msg_buffer[1] = (uint8_t)(write_msg_size >> 8);
+		_msg_buffer[2] = static_cast<uint8_t>(ULogMessageType::DATA);
+		_msg_buffer[3] = (uint8_t)write_msg_id;
+		_msg_buffer[4] = (uint8_t)(write_msg_id >> 8);
+
+		// PX4_INFO("topic: %s, size = %zu, out_size = %zu", sub.get_topic()->o_name, sub.get_topic()->o_size, msg_size);
+
+		// full log
+		if (write_message(LogType::Full, _msg_buffer, msg_size)) {
+
+#ifdef DBGPRINT
+			total_bytes += msg_size;
+#endif /* DBGPRINT */
+		}
+
+		// mission log
+		if (sub_idx < _num_mission_subs) {
+			if (_writer.is_started(LogType::Mission)) {
+				if (_mission_subscriptions[sub_idx].next_write_time < (loop_time / 100000)) {
+					unsigned delta_time = _mission_subscriptions[sub_idx].min_delta_ms;
+
+					if (delta_time > 0) {
+						_mission_subscriptions[sub_idx].next_write_time = (loop_time / 100000) + delta_time / 100;
+					}
+
+					write_message(LogType::Mission, _msg_buffer, msg_size);
+				}
+			}
+		}
+	}
+}
+
+void Logger::register_update_callback(int sub_idx)
+{
+	if (!_event_driven || (_subscription_callbacks == nullptr) || (_subscription_callbacks[sub_idx] != nullptr)) {
+		return;
+	}
+
+	LoggerSubscriptionCallback *callback = new LoggerSubscriptionCallback(_subscriptions[sub_idx], sub_idx, _ready_queue,
+			_wakeup_semaphore);
+
+	if (callback == nullptr) {
+		PX4_ERR("alloc failed");
+		return;
+	}
+
+	if (!callback->registerCallback()) {
+		PX4_ERR("%s: failed to register callback", _subscriptions[sub_idx].get_topic()->o_name);
+		delete callback;
+		return;
+	}
+
+	_subscription_callbacks[sub_idx] = callback;
+
+	// the topic might have been published before the callback was registered
+	_ready_queue.push(callback);
+}
+
+void Logger::free_update_callbacks()
+{
+	if (_subscription_callbacks == nullptr) {
+		return;
+	}
+
+	for (int i = 0; i < _num_subscriptions; ++i) {
+		// unregisters the callback
+		delete _subscription_callbacks[i];
+	}
+
+	delete[](_subscription_callbacks);
+	_subscription_callbacks = nullptr;
+
+	while (_ready_queue.pop() != nullptr) {}
+}
+
 const char *Logger::configured_backend_mode() const
 {
 	switch (_writer.backend()) {
@@ -493,6 +641,8 @@ bool Logger::initialize_topics(MissionLogType mission_log_mode)
 		return false;
 	}
 
+	free_update_callbacks();
+
 	delete[](_subscriptions);
 	_subscriptions = nullptr;
 
@@ -513,6 +663,16 @@ bool Logger::initialize_topics(MissionLogType mission_log_mode)
 	}
 
 	_num_subscriptions = logged_topics.subscriptions().count;
+
+	if (_event_driven && (_num_subscriptions > 0)) {
+		_subscription_callbacks = new LoggerSubscriptionCallback *[_num_subscriptions] {};
+
+		if (!_subscription_callbacks) {
+			PX4_ERR("alloc failed");
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -544,6 +704,16 @@ void Logger::run()
 					   _file_name[(int)LogType::Full].sess_dir_index) == 1) {
 			return;
 		}
+
+		int32_t compress_log = 0;
+
+		if (_compress_log != PARAM_INVALID) {
+			param_get(_compress_log, &compress_log);
+		}
+
+		if (compress_log && !_writer.enable_compression_file()) {
+			PX4_WARN("log compression not available");
+		}
 	}
 
 	uORB::Subscription parameter_update_sub(ORB_ID(parameter_update));
@@ -617,6 +787,10 @@ void Logger::run()
 	/* timer_semaphore use case is a signal */
 	px4_sem_setprotocol(&timer_callback_data.semaphore, SEM_PRIO_NONE);
 
+	// the update callbacks wake up the logger in event-driven mode, the timer is still needed for the watchdog
+	// and the periodic tasks (sync, status, subscribing to new topics)
+	_wakeup_semaphore = &timer_callback_data.semaphore;
+
 	int polling_topic_sub = -1;
 
 	if (_polling_topic_meta) {
@@ -696,51 +870,43 @@ void Logger::run()
 			/* wait for lock on log buffer */
 			_writer.lock();
 
-			for (int sub_idx = 0; sub_idx < _num_subscriptions; ++sub_idx) {
-				LoggerSubscription &sub = _subscriptions[sub_idx];
-				/* if this topic has been updated, copy the new data into the message buffer
-				 * and write a message to the log
-				 */
-				const bool try_to_subscribe = (sub_idx == next_subscribe_topic_index);
-
-				if (copy_if_updated(sub_idx, _msg_buffer + sizeof(ulog_message_data_header_s), try_to_subscribe)) {
-					// each message consists of a header followed by an orb data object
-					const size_t msg_size = sizeof(ulog_message_data_header_s) + sub.get_topic()->o_size_no_padding;
-					const uint16_t write_msg_size = static_cast<uint16_t>(msg_size - ULOG_MSG_HEADER_LEN);
-					const uint16_t write_msg_id = sub.msg_id;
-
-					//write one byte after another (necessary because of alignment)
-					_msg_buffer[0] = (uint8_t)write_msg_size;
-					_msg_buffer[1] = (uint8_t)(write_msg_size >> 8);
-					_msg_buffer[2] = static_cast<uint8_t>(ULogMessageType::DATA);
-					_msg_buffer[3] = (uint8_t)write_msg_id;
-					_msg_buffer[4] = (uint8_t)(write_msg_id >> 8);
+			if (_subscription_callbacks) {
+				// event-driven: only the updated topics, and one not yet subscribed topic per iteration
+				if ((next_subscribe_topic_index != -1) && !_subscriptions[next_subscribe_topic_index].valid()) {
+					log_subscription(next_subscribe_topic_index, true, loop_time, total_bytes);
+				}
 
-					// PX4_INFO("topic: %s, size = %zu, out_size = %zu", sub.get_topic()->o_name, sub.get_topic()->o_size, msg_size);
+				LoggerSubscriptionCallback *callback;
+				LoggerSubscriptionCallback *first_deferred = nullptr;
 
-					// full log
-					if (write_message(LogType::Full, _msg_buffer, msg_size)) {
+				// A callback is queued at most once, so the queue never holds more than _num_subscriptions
+				// entries. Bounding the pops keeps deferred callbacks from being cycled until their interval
+				// elapses (e.g. if first_deferred itself got due and was logged).
+				for (int pops = 0; (pops < _num_subscriptions) && ((callback = _ready_queue.pop()) != nullptr); pops++) {
+					const int sub_idx = callback->sub_idx();
 
-#ifdef DBGPRINT
-						total_bytes += msg_size;
-#endif /* DBGPRINT */
-					}
+					if (_subscriptions[sub_idx].interval_elapsed()) {
+						log_subscription(sub_idx, false, loop_time, total_bytes);
 
-					// mission log
-					if (sub_idx < _num_mission_subs) {
-						if (_writer.is_started(LogType::Mission)) {
-							if (_mission_subscriptions[sub_idx].next_write_time < (loop_time / 100000)) {
-								unsigned delta_time = _mission_subscriptions[sub_idx].min_delta_ms;
+					} else {
+						// logging interval not passed yet, keep it queued for one of the next iterations
+						_ready_queue.push(callback);
 
-								if (delta_time > 0) {
-									_mission_subscriptions[sub_idx].next_write_time = (loop_time / 100000) + delta_time / 100;
-								}
+						if (callback == first_deferred) {
+							break;
+						}
 
-								write_message(LogType::Mission, _msg_buffer, msg_size);
-							}
+						if (first_deferred == nullptr) {
+							first_deferred = callback;
 						}
 					}
 				}
+
+			} else {
+				for (int sub_idx = 0; sub_idx < _num_subscriptions; ++sub_idx) {
+					const bool try_to_subscribe = (sub_idx == next_subscribe_topic_index);
+					log_subscription(sub_idx, try_to_subscribe, loop_time, total_bytes);
+				}
 			}
 
 			// check for new logging message(s)
@@ -855,7 +1021,9 @@ void Logger::run()
 			// - we'll get the data immediately once we start logging (no need to wait for the next subscribe timeout)
 			if (next_subscribe_topic_index != -1) {
 				if (!_subscriptions[next_subscribe_topic_index].valid()) {
-					_subscriptions[next_subscribe_topic_index].subscribe();
+					if (_subscriptions[next_subscribe_topic_index].subscribe()) {
+						register_update_callback(next_subscribe_topic_index);
+					}
 				}
 
 				if (++next_subscribe_topic_index >= _num_subscriptions) {
@@ -901,6 +1069,8 @@ void Logger::run()
 	stop_log_file(LogType::Mission);
 
 	hrt_cancel(&timer_call);
+	free_update_callbacks();
+	_wakeup_semaphore = nullptr;
 	px4_sem_destroy(&timer_callback_data.semaphore);
 
 	// stop the writer thread
@@ -1161,6 +1331,9 @@ int Logger::get_log_file_name(LogType type, char *file_name, size_t file_name_si
 		replay_suffix = "_replayed";
 	}
 
+	// compressed logs are not readable by ULog tools and get a different extension
+	const char *extension = _writer.compression_enabled_file(type) ? "ulgz" : "ulg";
+
 	char *log_file_name = _file_name[(int)type].log_file_name;
 
 	if (time_ok) {
@@ -1172,7 +1345,8 @@ int Logger::get_log_file_name(LogType type, char *file_name, size_t file_name_si
 
 		char log_file_name_time[16] = "";
 		strftime(log_file_name_time, sizeof(log_file_name_time), "%H_%M_%S", &tt);
-		snprintf(log_file_name, sizeof(LogFileName::log_file_name), "%s%s.ulg", log_file_name_time, replay_suffix);
+		snprintf(log_file_name, sizeof(LogFileName::log_file_name), "%s%s.%s", log_file_name_time, replay_suffix,
+			 extension);
 		snprintf(file_name + n, file_name_size - n, "/%s", log_file_name);
 
 	} else {
@@ -1187,7 +1361,8 @@ int Logger::get_log_file_name(LogType type, char *file_name, size_t file_name_si
 		/* look for the next file that does not exist */
 		while (file_number <= MAX_NO_LOGFILE) {
 			/* format log file path: e.g. /fs/microsd/log/sess001/log001.ulg */
-			snprintf(log_file_name, sizeof(LogFileName::log_file_name), "log%03u%s.ulg", file_number, replay_suffix);
+			snprintf(log_file_name, sizeof(LogFileName::log_file_name), "log%03u%s.%s", file_number, replay_suffix,
+				 extension);
 			snprintf(file_name + n, file_name_size - n, "/%s", log_file_name);
 
 			if (!util::file_exist(file_name)) {
@@ -2001,7 +2176,8 @@ The normal log is always a superset of the mission log.
 ### Implementation
 The implementation uses two threads:
 - The main thread, running at a fixed rate (or polling on a topic if started with -p) and checking for
-  data updates
+  data updates. With -c the topics notify the main thread on new publications instead, so that it
+  only checks the updated topics and wakes up on new data in addition to the fixed rate.
 - The writer thread, writing data to the file
 
 In between there is a write buffer with configurable size (and another fixed-size buffer for
@@ -2022,6 +2198,8 @@ $ logger on
 	PRINT_MODULE_USAGE_PARAM_FLAG('e', "Enable logging right after start until disarm (otherwise only when armed)", true);
 	PRINT_MODULE_USAGE_PARAM_FLAG('f', "Log until shutdown (implies -e)", true);
 	PRINT_MODULE_USAGE_PARAM_FLAG('t', "Use date/time for naming log directories and files", true);
+	PRINT_MODULE_USAGE_PARAM_FLAG('d', "Asynchronous direct I/O for the log file (io_uring or I/O threads, Linux only)", true);
+	PRINT_MODULE_USAGE_PARAM_FLAG('c', "Event-driven: only check topics with new publications (uORB callbacks)", true);
 	PRINT_MODULE_USAGE_PARAM_INT('r', 280, 0, 8000, "Log rate in Hz, 0 means unlimited rate", true);
 	PRINT_MODULE_USAGE_PARAM_INT('b', 12, 4, 10000, "Log buffer size in KiB", true);
 	PRINT_MODULE_USAGE_PARAM_STRING('p', nullptr, "<topic_name>",
@@ -36,6 +36,7 @@
 #include "log_writer.h"
 #include "messages.h"
 #include <containers/Array.hpp>
+#include <containers/IntrusiveMPSCQueue.hpp>
 #include "util.h"
 #include <px4_platform_common/defines.h>
 #include <drivers/drv_hrt.h>
@@ -46,6 +47,7 @@
 
 #include <uORB/PublicationMulti.hpp>
 #include <uORB/Subscription.hpp>
+#include <uORB/SubscriptionCallback.hpp>
 #include <uORB/SubscriptionInterval.hpp>
 #include <uORB/topics/logger_status.h>
 #include <uORB/topics/log_message.h>
@@ -74,6 +76,42 @@ struct LoggerSubscription : public uORB::SubscriptionInterval {
 	LoggerSubscription(const orb_metadata *meta, uint32_t interval_ms = 0, uint8_t instance = 0) :
 		uORB::SubscriptionInterval(meta, interval_ms * 1000, instance)
 	{}
+
+	/**
+	 * Check if the logging interval passed since the last copy. Safe to call from any context.
+	 */
+	bool interval_elapsed() const { return (_interval_us == 0) || (hrt_elapsed_time_atomic(&_last_update) >= _interval_us); }
+};
+
+/**
+ * uORB callback of a logged topic (event-driven mode).
+ * On a new publication it queues itself in the logger's ready queue and wakes up the logger,
+ * so that each logger iteration only needs to look at the updated topics.
+ */
+class LoggerSubscriptionCallback : public uORB::SubscriptionCallback,
+	public IntrusiveMPSCQueueNode<LoggerSubscriptionCallback *>
+{
+public:
+	LoggerSubscriptionCallback(const LoggerSubscription &subscription, int sub_idx,
+				   IntrusiveMPSCQueue<LoggerSubscriptionCallback *> &ready_queue, px4_sem_t *wakeup) :
+		uORB::SubscriptionCallback(subscription.get_topic(), 0, subscription.get_instance()),
+		_subscription(subscription),
+		_ready_queue(ready_queue),
+		_wakeup(wakeup),
+		_sub_idx(sub_idx)
+	{}
+
+	~LoggerSubscriptionCallback() override = default;
+
+	void call() override;
+
+	int sub_idx() const { return _sub_idx; }
+
+private:
+	const LoggerSubscription &_subscription;
+	IntrusiveMPSCQueue<LoggerSubscriptionCallback *> &_ready_queue;
+	px4_sem_t *_wakeup;
+	const int _sub_idx;
 };
 
 class Logger : public ModuleBase<Logger>
@@ -116,6 +154,19 @@ public:
 	 */
 	void setReplayFile(const char *file_name);
 
+	/**
+	 * Use asynchronous direct I/O for the full log file (Linux only). This must be called
+	 * before starting the logger.
+	 * @return true on success
+	 */
+	bool enable_async_file_io() { return _writer.enable_async_file_io(); }
+
+	/**
+	 * Use uORB update callbacks instead of checking every logged topic on each iteration.
+	 * This must be called before starting the logger.
+	 */
+	void set_event_driven(bool event_driven) { _event_driven = event_driven; }
+
 	/**
 	 * request the logger thread to stop (this method does not block).
 	 * @return true if the logger is stopped, false if (still) running
@@ -144,7 +195,7 @@ private:
 	struct LogFileName {
 		char log_dir[12];           ///< e.g. "2018-01-01" or "sess001"
 		int sess_dir_index{1};      ///< search starting index for 'sess<i>' directory name
-		char log_file_name[31];     ///< e.g. "log001.ulg" or "12_09_00_replayed.ulg"
+		char log_file_name[31];     ///< e.g. "log001.ulg", "log001.ulgz" or "12_09_00_replayed.ulg"
 		bool has_log_dir{false};
 	};
 
@@ -255,6 +306,22 @@ private:
 
 	inline bool copy_if_updated(int sub_idx, void *buffer, bool try_to_subscribe);
 
+	/**
+	 * Copy a subscription if updated and write it to the full (and mission) log.
+	 * Must be called with _writer.lock() held.
+	 */
+	inline void log_subscription(int sub_idx, bool try_to_subscribe, hrt_abstime loop_time, uint32_t &total_bytes);
+
+	/**
+	 * Register the update callback of a (valid) subscription (event-driven mode).
+	 */
+	void register_update_callback(int sub_idx);
+
+	/**
+	 * Unregister and free all update callbacks (event-driven mode).
+	 */
+	void free_update_callbacks();
+
 	/**
 	 * Write exactly one ulog message to the logger and handle dropouts.
 	 * Must be called with _writer.lock() held.
@@ -322,6 +389,12 @@ private:
 
 	LoggerSubscription	 			*_subscriptions{nullptr}; ///< all subscriptions for full & mission log (in front)
 	int						_num_subscriptions{0};
+
+	// event-driven mode
+	bool						_event_driven{false};
+	LoggerSubscriptionCallback			**_subscription_callbacks{nullptr}; ///< one per subscription, created once subscribed
+	IntrusiveMPSCQueue<LoggerSubscriptionCallback *> _ready_queue; ///< subscriptions with new publications
+	px4_sem_t					*_wakeup_semaphore{nullptr}; ///< posted by the callbacks, owned by run()
 	MissionSubscription 				_mission_subscriptions[MAX_MISSION_TOPICS_NUM] {}; ///< additional data for mission subscriptions
 	int						_num_mission_subs{0};
 
@@ -353,6 +426,7 @@ private:
 	param_t						_log_dirs_max{PARAM_INVALID};
 	param_t						_mission_log{PARAM_INVALID};
 	param_t						_boot_bat_only{PARAM_INVALID};
+	param_t						_compress_log{PARAM_INVALID};
 };
 
 } //namespace logger
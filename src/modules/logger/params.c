@@ -169,3 +169,20 @@ PARAM_DEFINE_INT32(SDLOG_DIRS_MAX, 0);
  * @group SD Logging
  */
 PARAM_DEFINE_INT32(SDLOG_UUID, 1);
+
+/**
+ * Compress the full log
+ *
+ * If enabled, the full log is written as compressed ULog container (.ulgz) with independently
+ * compressed blocks, which typically reduces the file size by a factor of 3 to 5.
+ * The compression runs in the writer thread and needs about 25 KB of RAM.
+ * Compressed logs can be converted back to ULog with Tools/ulog_decompress.py.
+ * Crash information is not appended to compressed logs.
+ *
+ * Note: this does not apply to mission log files.
+ *
+ * @boolean
+ * @reboot_required true
+ * @group SD Logging
+ */
+PARAM_DEFINE_INT32(SDLOG_COMPRESS, 0);
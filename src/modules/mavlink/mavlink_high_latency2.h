@@ -187,6 +187,8 @@ protected:
 
 	void update_data();
 
+	bool has_update_data() const override { return true; }
+
 	void update_airspeed();
 
 	void update_tecs_status();
@@ -106,7 +106,7 @@ void mavlink_start_uart_send(mavlink_channel_t chan, int length)
 	Mavlink *m = Mavlink::get_instance(chan);
 
 	if (m != nullptr) {
-		(void)m->begin_send();
+		m->begin_send(length);
 #ifdef MAVLINK_PRINT_PACKETS
 		printf("START PACKET (%u): ", (unsigned)chan);
 #endif
@@ -183,6 +183,10 @@ Mavlink::Mavlink() :
 	if (_first_start_time == 0) {
 		_first_start_time = hrt_absolute_time();
 	}
+
+	px4_sem_init(&_wakeup_sem, 0, 0);
+	/* _wakeup_sem use case is a signal */
+	px4_sem_setprotocol(&_wakeup_sem, SEM_PRIO_NONE);
 }
 
 Mavlink::~Mavlink()
@@ -209,6 +213,8 @@ Mavlink::~Mavlink()
 
 	perf_free(_loop_perf);
 	perf_free(_loop_interval_perf);
+
+	px4_sem_destroy(&_wakeup_sem);
 }
 
 void
@@ -774,6 +780,22 @@ Mavlink::get_free_tx_buf()
 	return buf_free;
 }
 
+void
+Mavlink::begin_send(unsigned packet_len)
+{
+	pthread_mutex_lock(&_send_mutex);
+
+#if defined(MAVLINK_UDP)
+
+	/* the datagram is full: send the complete messages so far */
+	if (_udp_coalesce && get_protocol() == Protocol::UDP
+	    && _network_buf_len + packet_len > _network_buf_size) {
+		send_network_buf();
+	}
+
+#endif // MAVLINK_UDP
+}
+
 int
 Mavlink::send_packet()
 {
@@ -787,20 +809,38 @@ Mavlink::send_packet()
 		return 0;
 	}
 
-	if (get_protocol() == Protocol::UDP) {
+	_network_buf_msgs++;
 
-#ifdef CONFIG_NET
+	if (_udp_coalesce && get_protocol() == Protocol::UDP) {
+		/* sent by begin_send() once the next packet does not fit, or at the end of the main loop iteration */
+		pthread_mutex_unlock(&_send_mutex);
+		return 0;
+	}
 
-		if (_src_addr_initialized) {
-#endif
-			ret = sendto(_socket_fd, _network_buf, _network_buf_len, 0,
-				     (struct sockaddr *)&_src_addr, sizeof(_src_addr));
-#ifdef CONFIG_NET
-		}
+	ret = send_network_buf();
 
+#endif // MAVLINK_UDP
+
+	pthread_mutex_unlock(&_send_mutex);
+	return ret;
+}
+
+#if defined(MAVLINK_UDP)
+int
+Mavlink::send_network_buf()
+{
+	int ret = -1;
+
+	if (get_protocol() == Protocol::UDP && _network_buf_len > 0) {
+
+		bool send_unicast = true;
+#ifdef CONFIG_NET
+		send_unicast = _src_addr_initialized;
 #endif
 
 		/* resend message via broadcast if no valid connection exists */
+		bool send_broadcast = false;
+
 		if ((_mode != MAVLINK_MODE_ONBOARD) && broadcast_enabled() &&
 		    (!get_client_source_initialized()
 		     || (hrt_elapsed_time(&_tstatus.heartbeat_time) > 3_s))) {
@@ -809,32 +849,92 @@ Mavlink::send_packet()
 				find_broadcast_address();
 			}
 
-			if (_broadcast_address_found && _network_buf_len > 0) {
+			send_broadcast = _broadcast_address_found;
+		}
 
-				int bret = sendto(_socket_fd, _network_buf, _network_buf_len, 0,
-						  (struct sockaddr *)&_bcast_addr, sizeof(_bcast_addr));
+		const bool broadcast = send_broadcast;
+		int bret = 0;
 
-				if (bret <= 0) {
-					if (!_broadcast_failed_warned) {
-						PX4_ERR("sending broadcast failed, errno: %d: %s", errno, strerror(errno));
-						_broadcast_failed_warned = true;
-					}
+#if defined(__PX4_LINUX)
 
-				} else {
-					_broadcast_failed_warned = false;
-				}
+		if (send_unicast && send_broadcast) {
+			/* both destinations in a single system call */
+			struct iovec iov {};
+			iov.iov_base = _network_buf;
+			iov.iov_len = _network_buf_len;
+
+			struct mmsghdr msgs[2] {};
+			msgs[0].msg_hdr.msg_name = &_src_addr;
+			msgs[0].msg_hdr.msg_namelen = sizeof(_src_addr);
+			msgs[0].msg_hdr.msg_iov = &iov;
+			msgs[0].msg_hdr.msg_iovlen = 1;
+			msgs[1].msg_hdr = msgs[0].msg_hdr;
+			msgs[1].msg_hdr.msg_name = &_bcast_addr;
+			msgs[1].msg_hdr.msg_namelen = sizeof(_bcast_addr);
+
+			const int num_sent = sendmmsg(_socket_fd, msgs, 2, 0);
+			_udp_send_calls++;
+
+			if (num_sent > 0) {
+				_udp_datagrams_sent += num_sent;
+				ret = msgs[0].msg_len;
+			}
+
+			bret = (num_sent == 2) ? msgs[1].msg_len : -1;
+			send_unicast = false;
+			send_broadcast = false;
+		}
+
+#endif // __PX4_LINUX
+
+		if (send_unicast) {
+			ret = sendto(_socket_fd, _network_buf, _network_buf_len, 0,
+				     (struct sockaddr *)&_src_addr, sizeof(_src_addr));
+			_udp_send_calls++;
+
+			if (ret > 0) {
+				_udp_datagrams_sent++;
 			}
 		}
 
+		if (send_broadcast) {
+			bret = sendto(_socket_fd, _network_buf, _network_buf_len, 0,
+				      (struct sockaddr *)&_bcast_addr, sizeof(_bcast_addr));
+			_udp_send_calls++;
+
+			if (bret > 0) {
+				_udp_datagrams_sent++;
+			}
+		}
+
+		if (broadcast) {
+			if (bret <= 0) {
+				if (!_broadcast_failed_warned) {
+					PX4_ERR("sending broadcast failed, errno: %d: %s", errno, strerror(errno));
+					_broadcast_failed_warned = true;
+				}
+
+			} else {
+				_broadcast_failed_warned = false;
+			}
+		}
 	}
 
+	_udp_msgs_sent += _network_buf_msgs;
 	_network_buf_len = 0;
+	_network_buf_msgs = 0;
 
-#endif // MAVLINK_UDP
+	return ret;
+}
 
+void
+Mavlink::flush_network_buf()
+{
+	pthread_mutex_lock(&_send_mutex);
+	send_network_buf();
 	pthread_mutex_unlock(&_send_mutex);
-	return ret;
 }
+#endif // MAVLINK_UDP
 
 void
 Mavlink::send_bytes(const uint8_t *buf, unsigned packet_len)
@@ -866,7 +966,7 @@ Mavlink::send_bytes(const uint8_t *buf, unsigned packet_len)
 #if defined(MAVLINK_UDP)
 
 	else {
-		if (_network_buf_len + packet_len < sizeof(_network_buf) / sizeof(_network_buf[0])) {
+		if (_network_buf_len + packet_len <= _network_buf_size) {
 			memcpy(&_network_buf[_network_buf_len], buf, packet_len);
 			_network_buf_len += packet_len;
 
@@ -1280,6 +1380,8 @@ Mavlink::configure_stream(const char *stream_name, const float rate)
 
 	for (const auto &stream : _streams) {
 		if (strcmp(stream_name, stream->get_name()) == 0) {
+			_stream_scheduler.request_rebuild();
+
 			if (interval != 0) {
 				/* set new interval */
 				stream->set_interval(interval);
@@ -1306,6 +1408,7 @@ Mavlink::configure_stream(const char *stream_name, const float rate)
 	if (stream != nullptr) {
 		stream->set_interval(interval);
 		_streams.add(stream);
+		_stream_scheduler.request_rebuild();
 
 		return OK;
 	}
@@ -1856,7 +1959,7 @@ Mavlink::task_main(int argc, char *argv[])
 	int temp_int_arg;
 #endif
 
-	while ((ch = px4_getopt(argc, argv, "b:r:d:n:u:o:m:t:c:fswxz", &myoptind, &myoptarg)) != EOF) {
+	while ((ch = px4_getopt(argc, argv, "b:r:d:n:u:o:m:t:c:fgswxz", &myoptind, &myoptarg)) != EOF) {
 		switch (ch) {
 		case 'b':
 			if (px4_get_parameter_value(myoptarg, _baudrate) != 0) {
@@ -2037,6 +2140,13 @@ Mavlink::task_main(int argc, char *argv[])
 			_forwarding_on = true;
 			break;
 
+#if defined(MAVLINK_UDP)
+
+		case 'g':
+			_udp_coalesce = true;
+			break;
+#endif // MAVLINK_UDP
+
 		case 's':
 			_use_software_mav_throttling = true;
 			break;
@@ -2112,6 +2222,15 @@ Mavlink::task_main(int argc, char *argv[])
 			return PX4_ERROR;
 		}
 
+		/* serial instances write directly, only a full datagram needs the larger buffer */
+		_network_buf_size = _udp_coalesce ? MAVLINK_UDP_MAX_DATAGRAM_LEN : MAVLINK_MAX_PACKET_LEN;
+		_network_buf = new uint8_t[_network_buf_size];
+
+		if (_network_buf == nullptr) {
+			PX4_ERR("network buf alloc fail");
+			return PX4_ERROR;
+		}
+
 		PX4_INFO("mode: %s, data rate: %d B/s on udp port %hu remote port %hu",
 			 mavlink_mode_str(_mode), _datarate, _network_port, _remote_port);
 	}
@@ -2229,12 +2348,17 @@ Mavlink::task_main(int argc, char *argv[])
 		send_autopilot_capabilites();
 	}
 
+	/* wake up the main loop to forward acks and status texts without waiting for the next stream deadline */
+	_command_ack_wakeup.registerCallback();
+	_mavlink_log_wakeup.registerCallback();
+	_vehicle_command_wakeup.registerCallback();
+
 	/* start the MAVLink receiver last to avoid a race */
 	MavlinkReceiver::receive_start(&_receive_thread, this);
 
 	while (!_task_should_exit) {
 		/* main loop */
-		px4_usleep(_main_loop_delay);
+		wait_for_next_update();
 
 		if (!should_transmit()) {
 			check_requested_subscriptions();
@@ -2248,6 +2372,11 @@ Mavlink::task_main(int argc, char *argv[])
 
 		update_rate_mult();
 
+		if (fabsf(_rate_mult - _scheduled_rate_mult) > 0.01f * _scheduled_rate_mult) {
+			/* the stream intervals are scaled by the rate multiplier */
+			_stream_scheduler.request_rebuild();
+		}
+
 		// check for parameter updates
 		if (parameter_update_sub.updated()) {
 			// clear update
@@ -2397,23 +2526,7 @@ Mavlink::task_main(int argc, char *argv[])
 
 		check_requested_subscriptions();
 
-		/* update streams */
-		for (const auto &stream : _streams) {
-			stream->update(t);
-
-			if (!_first_heartbeat_sent) {
-				if (_mode == MAVLINK_MODE_IRIDIUM) {
-					if (stream->get_id() == MAVLINK_MSG_ID_HIGH_LATENCY2) {
-						_first_heartbeat_sent = stream->first_message_sent();
-					}
-
-				} else {
-					if (stream->get_id() == MAVLINK_MSG_ID_HEARTBEAT) {
-						_first_heartbeat_sent = stream->first_message_sent();
-					}
-				}
-			}
-		}
+		update_streams(t);
 
 		/* pass messages from other UARTs */
 		if (_forwarding_on) {
@@ -2463,6 +2576,15 @@ Mavlink::task_main(int argc, char *argv[])
 			}
 		}
 
+#if defined(MAVLINK_UDP)
+
+		/* send the messages coalesced in this iteration */
+		if (_udp_coalesce && get_protocol() == Protocol::UDP) {
+			flush_network_buf();
+		}
+
+#endif // MAVLINK_UDP
+
 		/* update TX/RX rates*/
 		if (t > _bytes_timestamp + 1000000) {
 			if (_bytes_timestamp != 0) {
@@ -2491,6 +2613,10 @@ Mavlink::task_main(int argc, char *argv[])
 	/* first wait for threads to complete before tearing down anything */
 	pthread_join(_receive_thread, nullptr);
 
+	_command_ack_wakeup.unregisterCallback();
+	_mavlink_log_wakeup.unregisterCallback();
+	_vehicle_command_wakeup.unregisterCallback();
+
 	delete _subscribe_to_stream;
 	_subscribe_to_stream = nullptr;
 
@@ -2510,6 +2636,12 @@ Mavlink::task_main(int argc, char *argv[])
 		_socket_fd = -1;
 	}
 
+#if defined(MAVLINK_UDP)
+	delete[] _network_buf;
+	_network_buf = nullptr;
+	_network_buf_size = 0;
+#endif // MAVLINK_UDP
+
 	if (_forwarding_on) {
 		message_buffer_destroy();
 		pthread_mutex_destroy(&_message_buffer_mutex);
@@ -2525,6 +2657,86 @@ Mavlink::task_main(int argc, char *argv[])
 	return OK;
 }
 
+void
+Mavlink::wait_for_next_update()
+{
+	const hrt_abstime now = hrt_absolute_time();
+
+	bool transfer_message = true;
+
+	if (_transfer_message_received.compare_exchange(&transfer_message, false)) {
+		_last_transfer_message = now;
+	}
+
+	const bool transfer_active = (_last_transfer_message != 0) && (now - _last_transfer_message < TRANSFER_TIMEOUT);
+
+	/* the shell, log streaming, forwarding and mission/parameter/FTP/log transfers are polled at the main loop rate,
+	 * everything else at least at 100 Hz */
+	const bool polling = (_mavlink_shell != nullptr) || (_mavlink_ulog != nullptr) || _forwarding_on || transfer_active;
+	hrt_abstime wakeup = now + (polling ? _main_loop_delay : MAVLINK_MAX_INTERVAL);
+
+	if (should_transmit() && !_stream_scheduler.rebuild_requested()) {
+		wakeup = math::min(wakeup, _stream_scheduler.next_deadline());
+	}
+
+	if (wakeup > now) {
+		/* calculate an absolute time in the future */
+		struct timespec ts;
+		px4_clock_gettime(CLOCK_REALTIME, &ts);
+		uint64_t nsecs = ts.tv_nsec + (wakeup - now) * 1000;
+		static constexpr unsigned billion = (1000 * 1000 * 1000);
+		ts.tv_sec += nsecs / billion;
+		nsecs -= (nsecs / billion) * billion;
+		ts.tv_nsec = nsecs;
+
+		px4_sem_timedwait(&_wakeup_sem, &ts);
+	}
+
+	/* the pending wakeups are handled by this iteration */
+	while (px4_sem_trywait(&_wakeup_sem) == 0) {}
+}
+
+void
+Mavlink::update_streams(const hrt_abstime &t)
+{
+	if (_stream_scheduler.rebuild_requested()) {
+		_scheduled_rate_mult = _rate_mult;
+
+		if (!_stream_scheduler.rebuild(_streams, t)) {
+			PX4_ERR("stream scheduler alloc failed");
+			return;
+		}
+	}
+
+	MavlinkStream *stream = nullptr;
+
+	while ((stream = _stream_scheduler.pop_due(t)) != nullptr) {
+		stream->update(t);
+
+		if (!_first_heartbeat_sent) {
+			if (_mode == MAVLINK_MODE_IRIDIUM) {
+				if (stream->get_id() == MAVLINK_MSG_ID_HIGH_LATENCY2) {
+					_first_heartbeat_sent = stream->first_message_sent();
+				}
+
+			} else {
+				if (stream->get_id() == MAVLINK_MSG_ID_HEARTBEAT) {
+					_first_heartbeat_sent = stream->first_message_sent();
+				}
+			}
+		}
+
+		hrt_abstime deadline = stream->get_deadline(t);
+
+		if (deadline <= t) {
+			/* nothing was sent (no new data or unlimited rate): check again in the next period */
+			deadline = t + _main_loop_delay;
+		}
+
+		_stream_scheduler.push(stream, deadline);
+	}
+}
+
 void Mavlink::check_requested_subscriptions()
 {
 	if (_subscribe_to_stream != nullptr) {
@@ -2816,6 +3028,15 @@ Mavlink::display_status()
 		}
 
 #endif
+		printf("\tUDP coalescing: %s, messages: %u, datagrams: %u, send calls: %u",
+		       _udp_coalesce ? "ON" : "OFF", (unsigned)_udp_msgs_sent, (unsigned)_udp_datagrams_sent,
+		       (unsigned)_udp_send_calls);
+
+		if (_udp_send_calls > 0) {
+			printf(", %.2f messages/call", (double)_udp_msgs_sent / _udp_send_calls);
+		}
+
+		printf("\n");
 		break;
 #endif // MAVLINK_UDP
 
@@ -3062,6 +3283,7 @@ $ mavlink stream -u 14556 -s HIGHRES_IMU -r 50
 	PRINT_MODULE_USAGE_PARAM_STRING('c', nullptr, "Multicast address in the range [239.0.0.0,239.255.255.255]", "Multicast address (multicasting can be enabled via MAV_BROADCAST param)", true);
 #endif
 	PRINT_MODULE_USAGE_PARAM_FLAG('f', "Enable message forwarding to other Mavlink instances", true);
+	PRINT_MODULE_USAGE_PARAM_FLAG('g', "Coalesce multiple messages into one UDP datagram (sent once per main loop iteration)", true);
 	PRINT_MODULE_USAGE_PARAM_FLAG('w', "Wait to send, until first message received", true);
 	PRINT_MODULE_USAGE_PARAM_FLAG('x', "Enable FTP", true);
 	PRINT_MODULE_USAGE_PARAM_FLAG('z', "Force flow control always on", true);
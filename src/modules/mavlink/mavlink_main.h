@@ -62,6 +62,7 @@
 #include <drivers/device/ringbuffer.h>
 #include <parameters/param.h>
 #include <perf/perf_counter.h>
+#include <px4_platform_common/atomic.h>
 #include <px4_platform_common/cli.h>
 #include <px4_platform_common/px4_config.h>
 #include <px4_platform_common/defines.h>
@@ -72,15 +73,19 @@
 #include <systemlib/mavlink_log.h>
 #include <systemlib/uthash/utlist.h>
 #include <uORB/PublicationQueued.hpp>
+#include <uORB/SubscriptionCallback.hpp>
 #include <uORB/topics/mavlink_log.h>
 #include <uORB/topics/mission_result.h>
 #include <uORB/topics/radio_status.h>
 #include <uORB/topics/telemetry_status.h>
+#include <uORB/topics/vehicle_command.h>
+#include <uORB/topics/vehicle_command_ack.h>
 
 #include "mavlink_command_sender.h"
 #include "mavlink_messages.h"
 #include "mavlink_orb_subscription.h"
 #include "mavlink_shell.h"
+#include "mavlink_stream_scheduler.h"
 #include "mavlink_ulog.h"
 
 #define DEFAULT_BAUD_RATE       57600
@@ -91,6 +96,7 @@
 #if defined(CONFIG_NET) || defined(__PX4_POSIX)
 # define MAVLINK_UDP
 # define DEFAULT_REMOTE_PORT_UDP 14550 ///< GCS port per MAVLink spec
+# define MAVLINK_UDP_MAX_DATAGRAM_LEN 1472 ///< Ethernet MTU (1500) - IPv4 header (20) - UDP header (8)
 #endif // CONFIG_NET || __PX4_POSIX
 
 enum class Protocol {
@@ -318,8 +324,11 @@ public:
 
 	/**
 	 * This is the beginning of a MAVLINK_START_UART_SEND/MAVLINK_END_UART_SEND transaction
+	 *
+	 * @param packet_len length of the packet that follows, used to send the coalesced UDP
+	 *                   datagram first if the packet does not fit anymore
 	 */
-	void 			begin_send() { pthread_mutex_lock(&_send_mutex); }
+	void 			begin_send(unsigned packet_len = 0);
 
 	/**
 	 * Send bytes out on the link.
@@ -329,7 +338,10 @@ public:
 	void			send_bytes(const uint8_t *buf, unsigned packet_len);
 
 	/**
-	 * Flush the transmit buffer and send one MAVLink packet
+	 * Flush the transmit buffer and send one MAVLink packet.
+	 *
+	 * With UDP coalescing enabled the packet stays in the buffer until it is full or the
+	 * end of the main loop iteration.
 	 *
 	 * @return the number of bytes sent or -1 in case of error
 	 */
@@ -410,6 +422,27 @@ public:
 
 	List<MavlinkStream *> &get_streams() { return _streams; }
 
+	/**
+	 * Recompute the stream deadlines, e.g. if a stream needs to be sent immediately.
+	 * Safe to call from any thread.
+	 */
+	void			reschedule_streams()
+	{
+		_stream_scheduler.request_rebuild();
+		px4_sem_post(&_wakeup_sem);
+	}
+
+	/**
+	 * Wake up the main loop and keep it at the main loop rate while a mission, parameter,
+	 * FTP or log transfer is active. Called by the receiver for every transfer message.
+	 * Safe to call from any thread.
+	 */
+	void			transfer_message_received()
+	{
+		_transfer_message_received.store(true);
+		px4_sem_post(&_wakeup_sem);
+	}
+
 	float			get_rate_mult() const { return _rate_mult; }
 
 	float			get_baudrate() { return _baudrate; }
@@ -568,6 +601,33 @@ private:
 	List<MavlinkOrbSubscription *>	_subscriptions;
 	List<MavlinkStream *>		_streams;
 
+	MavlinkStreamScheduler	_stream_scheduler;
+	float			_scheduled_rate_mult{0.0f};	///< rate multiplier the stream deadlines were computed with
+
+	px4_sem_t		_wakeup_sem;	///< posted to wake up the main loop before the next stream deadline
+
+	px4::atomic_bool	_transfer_message_received{false};	///< set by the receiver, cleared by the main loop
+	hrt_abstime		_last_transfer_message{0};	///< main loop time the last transfer message was seen
+	static constexpr hrt_abstime TRANSFER_TIMEOUT{1000000};	///< a transfer is active until 1 s after its last message
+
+	/**
+	 * Wakes up the main loop on publications of topics that are forwarded as soon as possible
+	 */
+	class WakeupCallback : public uORB::SubscriptionCallback
+	{
+	public:
+		WakeupCallback(px4_sem_t &sem, const orb_metadata *meta) : uORB::SubscriptionCallback(meta), _sem(sem) {}
+
+		void call() override { px4_sem_post(&_sem); }
+
+	private:
+		px4_sem_t &_sem;
+	};
+
+	WakeupCallback		_command_ack_wakeup{_wakeup_sem, ORB_ID(vehicle_command_ack)};
+	WakeupCallback		_mavlink_log_wakeup{_wakeup_sem, ORB_ID(mavlink_log)};
+	WakeupCallback		_vehicle_command_wakeup{_wakeup_sem, ORB_ID(vehicle_command)};
+
 	MavlinkShell		*_mavlink_shell{nullptr};
 	MavlinkULog		*_mavlink_ulog{nullptr};
 
@@ -630,9 +690,16 @@ private:
 	bool			_broadcast_address_found{false};
 	bool			_broadcast_address_not_found_warned{false};
 	bool			_broadcast_failed_warned{false};
-	uint8_t			_network_buf[MAVLINK_MAX_PACKET_LEN] {};
+	uint8_t			*_network_buf{nullptr};		///< UDP only, see task_main()
+	unsigned		_network_buf_size{0};
 	unsigned		_network_buf_len{0};
 
+	bool			_udp_coalesce{false};		///< pack multiple MAVLink messages into one datagram
+	unsigned		_network_buf_msgs{0};		///< number of complete messages in _network_buf
+	uint32_t		_udp_msgs_sent{0};		///< statistics: messages sent
+	uint32_t		_udp_datagrams_sent{0};		///< statistics: datagrams sent (to all destinations)
+	uint32_t		_udp_send_calls{0};		///< statistics: sendto/sendmmsg system calls
+
 	unsigned short		_network_port{14556};
 	unsigned short		_remote_port{DEFAULT_REMOTE_PORT_UDP};
 #endif // MAVLINK_UDP
@@ -682,6 +749,30 @@ private:
 
 	void			mavlink_update_parameters();
 
+	/**
+	 * Sleep until the earliest stream deadline, or until woken up by an event-driven topic
+	 */
+	void			wait_for_next_update();
+
+	/**
+	 * Update all streams which are due and schedule their next update
+	 */
+	void			update_streams(const hrt_abstime &t);
+
+#if defined(MAVLINK_UDP)
+	/**
+	 * Send the content of _network_buf as one datagram to the partner and/or the broadcast
+	 * address, and clear the buffer. _send_mutex must be held.
+	 * @return the number of bytes sent or -1 in case of error
+	 */
+	int			send_network_buf();
+
+	/**
+	 * Send the coalesced UDP messages at the end of a main loop iteration
+	 */
+	void			flush_network_buf();
+#endif // MAVLINK_UDP
+
 	int mavlink_open_uart(const int baudrate = DEFAULT_BAUD_RATE,
 			      const char *uart_name = DEFAULT_DEVICE_NAME,
 			      const bool force_flow_control = false);
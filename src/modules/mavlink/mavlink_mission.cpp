@@ -909,6 +909,7 @@ MavlinkMissionManager::handle_mission_count(const mavlink_message_t *msg)
 			_transfer_partner_sysid = msg->sysid;
 			_transfer_partner_compid = msg->compid;
 			_transfer_count = wpc.count;
+			_transfer_items_count = 0;
 			_transfer_dataman_id = (_dataman_id == DM_KEY_WAYPOINTS_OFFBOARD_0 ? DM_KEY_WAYPOINTS_OFFBOARD_1 :
 						DM_KEY_WAYPOINTS_OFFBOARD_0);	// use inactive storage for transmission
 			_transfer_current_seq = -1;
@@ -1077,10 +1078,19 @@ MavlinkMissionManager::handle_mission_item_both(const mavlink_message_t *msg)
 					check_failed = true;
 
 				} else {
-					dm_item_t dm_item = _transfer_dataman_id;
+					_transfer_items[_transfer_items_count++] = mission_item;
 
-					write_failed = dm_write(dm_item, wp.seq, DM_PERSIST_POWER_ON_RESET, &mission_item,
-								sizeof(struct mission_item_s)) != sizeof(struct mission_item_s);
+					// write the items in batches (one dataman request and storage sync each),
+					// the remaining ones together with the last item
+					if ((_transfer_items_count == TRANSFER_BATCH_SIZE) || (wp.seq + 1 == _transfer_count)) {
+						const uint16_t first_seq = wp.seq + 1 - _transfer_items_count;
+
+						write_failed = dm_write_range(_transfer_dataman_id, first_seq, _transfer_items_count,
+									      DM_PERSIST_POWER_ON_RESET, _transfer_items,
+									      sizeof(struct mission_item_s)) != _transfer_items_count;
+
+						_transfer_items_count = 0;
+					}
 
 					if (!write_failed) {
 						/* waypoint marked as current */
@@ -128,6 +128,11 @@ private:
 
 	void handle_message(mavlink_message_t *msg);
 
+	/**
+	 * @return true for messages of the mission, parameter, FTP and log transfer protocols
+	 */
+	static bool is_transfer_message(uint32_t msgid);
+
 	void handle_message_adsb_vehicle(mavlink_message_t *msg);
 	void handle_message_att_pos_mocap(mavlink_message_t *msg);
 	void handle_message_battery_status(mavlink_message_t *msg);
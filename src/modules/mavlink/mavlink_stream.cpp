@@ -121,3 +121,41 @@ MavlinkStream::update(const hrt_abstime &t)
 
 	return -1;
 }
+
+hrt_abstime
+MavlinkStream::get_deadline(const hrt_abstime &t)
+{
+	const hrt_abstime poll_deadline = t + _mavlink->get_main_loop_delay();
+
+	if (_last_sent == 0) {
+		return t;
+	}
+
+	int interval = (_interval > 0) ? _interval : 0;
+
+	if (!const_rate()) {
+		interval /= _mavlink->get_rate_mult();
+	}
+
+	if (interval == 0) {
+		// unlimited rate: poll at every iteration
+		return t;
+	}
+
+	// first time at which update() sends, see the condition above
+	const int64_t dt_min = interval - (_mavlink->get_main_loop_delay() / 10) * 3;
+	const hrt_abstime deadline = (dt_min > 0) ? _last_sent + dt_min + 1 : _last_sent;
+
+	if (has_update_data() && poll_deadline < deadline) {
+		return poll_deadline;
+	}
+
+	return deadline;
+}
+
+void
+MavlinkStream::reset_last_sent()
+{
+	_last_sent = 0;
+	_mavlink->reschedule_streams();
+}
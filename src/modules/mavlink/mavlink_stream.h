@@ -79,6 +79,12 @@ public:
 	 * @return 0 if updated / sent, -1 if unchanged
 	 */
 	int update(const hrt_abstime &t);
+
+	/**
+	 * @return the time at which update() needs to be called next
+	 */
+	hrt_abstime get_deadline(const hrt_abstime &t);
+
 	virtual const char *get_name() const = 0;
 	virtual uint16_t get_id() = 0;
 
@@ -118,7 +124,7 @@ public:
 	 * Reset the time of last sent to 0. Can be used if a message over this
 	 * stream needs to be sent immediately.
 	 */
-	void reset_last_sent() { _last_sent = 0; }
+	void reset_last_sent();
 
 protected:
 	Mavlink      *const _mavlink;
@@ -134,6 +140,12 @@ protected:
 	 */
 	virtual void update_data() { }
 
+	/**
+	 * @return true if update_data() is implemented, so that the stream is updated
+	 * at the main loop rate and not only when a message is due.
+	 */
+	virtual bool has_update_data() const { return false; }
+
 private:
 	hrt_abstime _last_sent{0};
 	bool _first_message_sent{false};
@@ -0,0 +1,153 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mavlink_stream_scheduler.cpp
+ * Deadline ordered scheduling of the Mavlink streams.
+ */
+
+#include "mavlink_stream_scheduler.h"
+#include "mavlink_stream.h"
+
+bool
+MavlinkStreamScheduler::rebuild(List<MavlinkStream *> &streams, const hrt_abstime &t)
+{
+	_rebuild_requested.store(false);
+	_size = 0;
+
+	const unsigned num_streams = streams.size();
+
+	if (num_streams > _capacity) {
+		delete[] _heap;
+		_heap = new Entry[num_streams];
+
+		if (_heap == nullptr) {
+			_capacity = 0;
+			_rebuild_requested.store(true);
+			return false;
+		}
+
+		_capacity = num_streams;
+	}
+
+	for (const auto &stream : streams) {
+		_heap[_size].deadline = stream->get_deadline(t);
+		_heap[_size].stream = stream;
+		_size++;
+	}
+
+	// heapify bottom-up
+	for (unsigned i = _size / 2; i > 0; i--) {
+		sift_down(i - 1);
+	}
+
+	return true;
+}
+
+MavlinkStream *
+MavlinkStreamScheduler::pop_due(const hrt_abstime &t)
+{
+	if (_size == 0 || _heap[0].deadline > t) {
+		return nullptr;
+	}
+
+	MavlinkStream *stream = _heap[0].stream;
+	_heap[0] = _heap[--_size];
+	sift_down(0);
+
+	return stream;
+}
+
+void
+MavlinkStreamScheduler::push(MavlinkStream *stream, const hrt_abstime &deadline)
+{
+	if (_size >= _capacity) {
+		// stream added without rebuild
+		_rebuild_requested.store(true);
+		return;
+	}
+
+	_heap[_size].deadline = deadline;
+	_heap[_size].stream = stream;
+	sift_up(_size++);
+}
+
+void
+MavlinkStreamScheduler::sift_up(unsigned index)
+{
+	const Entry entry = _heap[index];
+
+	while (index > 0) {
+		const unsigned parent = (index - 1) / 2;
+
+		if (_heap[parent].deadline <= entry.deadline) {
+			break;
+		}
+
+		_heap[index] = _heap[parent];
+		index = parent;
+	}
+
+	_heap[index] = entry;
+}
+
+void
+MavlinkStreamScheduler::sift_down(unsigned index)
+{
+	if (_size == 0) {
+		return;
+	}
+
+	const Entry entry = _heap[index];
+
+	for (;;) {
+		unsigned child = 2 * index + 1;
+
+		if (child >= _size) {
+			break;
+		}
+
+		if (child + 1 < _size && _heap[child + 1].deadline < _heap[child].deadline) {
+			child++;
+		}
+
+		if (entry.deadline <= _heap[child].deadline) {
+			break;
+		}
+
+		_heap[index] = _heap[child];
+		index = child;
+	}
+
+	_heap[index] = entry;
+}
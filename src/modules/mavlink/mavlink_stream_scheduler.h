@@ -0,0 +1,111 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mavlink_stream_scheduler.h
+ * Deadline ordered scheduling of the Mavlink streams.
+ */
+
+#pragma once
+
+#include <drivers/drv_hrt.h>
+#include <containers/List.hpp>
+#include <px4_platform_common/atomic.h>
+
+class MavlinkStream;
+
+/**
+ * Binary min-heap of the streams, ordered by the time their next update is due.
+ *
+ * Only the Mavlink main thread accesses the heap. Changes from other threads
+ * (e.g. a requested message) only set the rebuild flag.
+ */
+class MavlinkStreamScheduler
+{
+public:
+	MavlinkStreamScheduler() = default;
+	~MavlinkStreamScheduler() { delete[] _heap; }
+
+	// no copy, assignment, move, move assignment
+	MavlinkStreamScheduler(const MavlinkStreamScheduler &) = delete;
+	MavlinkStreamScheduler &operator=(const MavlinkStreamScheduler &) = delete;
+	MavlinkStreamScheduler(MavlinkStreamScheduler &&) = delete;
+	MavlinkStreamScheduler &operator=(MavlinkStreamScheduler &&) = delete;
+
+	/**
+	 * Schedule all streams again at the next update, e.g. after the stream list
+	 * or the stream intervals changed. Safe to call from any thread.
+	 */
+	void request_rebuild() { _rebuild_requested.store(true); }
+
+	bool rebuild_requested() const { return _rebuild_requested.load(); }
+
+	/**
+	 * Recreate the heap from the stream deadlines.
+	 * @return false if the allocation failed
+	 */
+	bool rebuild(List<MavlinkStream *> &streams, const hrt_abstime &t);
+
+	/**
+	 * @return the deadline of the earliest stream, or UINT64_MAX if there is none
+	 */
+	hrt_abstime next_deadline() const { return (_size > 0) ? _heap[0].deadline : UINT64_MAX; }
+
+	/**
+	 * Remove and return the earliest stream if it is due at t.
+	 * @return nullptr if no stream is due
+	 */
+	MavlinkStream *pop_due(const hrt_abstime &t);
+
+	/**
+	 * (Re)insert a stream with its next deadline.
+	 */
+	void push(MavlinkStream *stream, const hrt_abstime &deadline);
+
+	unsigned size() const { return _size; }
+
+private:
+	struct Entry {
+		hrt_abstime deadline;
+		MavlinkStream *stream;
+	};
+
+	void sift_up(unsigned index);
+	void sift_down(unsigned index);
+
+	Entry *_heap{nullptr};
+	unsigned _capacity{0};
+	unsigned _size{0};
+
+	px4::atomic_bool _rebuild_requested{true};
+};
@@ -0,0 +1,549 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file MissionItemChecks.cpp
+ *
+ * @author Lorenz Meier <lm@inf.ethz.ch>
+ * @author Thomas Gubler <thomasgubler@student.ethz.ch>
+ * @author Sander Smeets <sander@droneslab.com>
+ * @author Nuno Marques <nuno.marques@dronesolutions.io>
+ */
+
+#include "MissionItemChecks.hpp"
+
+#include <drivers/drv_pwm_output.h>
+#include <lib/ecl/geo/geo.h>
+#include <lib/landing_slope/Landingslope.hpp>
+#include <navigator/mission_block.h>
+#include <systemlib/mavlink_log.h>
+
+bool
+MissionItemChecks::add(MissionItemCheck &check)
+{
+	if (_num_checks >= MAX_CHECKS) {
+		return false;
+	}
+
+	_checks[_num_checks++] = &check;
+	return true;
+}
+
+bool
+MissionItemChecks::visit(size_t index, const mission_item_s &item)
+{
+	for (int i = 0; i < _num_checks; i++) {
+		if (!_checks[i]->visit(index, item)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+MissionItemChecks::finish(size_t count)
+{
+	for (int i = 0; i < _num_checks; i++) {
+		if (!_checks[i]->finish(count)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+MissionItemValidityCheck::visit(size_t index, const mission_item_s &item)
+{
+	// check if we find unsupported items and reject mission if so
+	if (item.nav_cmd != NAV_CMD_IDLE &&
+	    item.nav_cmd != NAV_CMD_WAYPOINT &&
+	    item.nav_cmd != NAV_CMD_LOITER_UNLIMITED &&
+	    item.nav_cmd != NAV_CMD_LOITER_TIME_LIMIT &&
+	    item.nav_cmd != NAV_CMD_RETURN_TO_LAUNCH &&
+	    item.nav_cmd != NAV_CMD_LAND &&
+	    item.nav_cmd != NAV_CMD_TAKEOFF &&
+	    item.nav_cmd != NAV_CMD_LOITER_TO_ALT &&
+	    item.nav_cmd != NAV_CMD_VTOL_TAKEOFF &&
+	    item.nav_cmd != NAV_CMD_VTOL_LAND &&
+	    item.nav_cmd != NAV_CMD_DELAY &&
+	    item.nav_cmd != NAV_CMD_DO_JUMP &&
+	    item.nav_cmd != NAV_CMD_DO_CHANGE_SPEED &&
+	    item.nav_cmd != NAV_CMD_DO_SET_HOME &&
+	    item.nav_cmd != NAV_CMD_DO_SET_SERVO &&
+	    item.nav_cmd != NAV_CMD_DO_LAND_START &&
+	    item.nav_cmd != NAV_CMD_DO_TRIGGER_CONTROL &&
+	    item.nav_cmd != NAV_CMD_DO_DIGICAM_CONTROL &&
+	    item.nav_cmd != NAV_CMD_IMAGE_START_CAPTURE &&
+	    item.nav_cmd != NAV_CMD_IMAGE_STOP_CAPTURE &&
+	    item.nav_cmd != NAV_CMD_VIDEO_START_CAPTURE &&
+	    item.nav_cmd != NAV_CMD_VIDEO_STOP_CAPTURE &&
+	    item.nav_cmd != NAV_CMD_DO_MOUNT_CONFIGURE &&
+	    item.nav_cmd != NAV_CMD_DO_MOUNT_CONTROL &&
+	    item.nav_cmd != NAV_CMD_DO_SET_ROI &&
+	    item.nav_cmd != NAV_CMD_DO_SET_ROI_LOCATION &&
+	    item.nav_cmd != NAV_CMD_DO_SET_ROI_WPNEXT_OFFSET &&
+	    item.nav_cmd != NAV_CMD_DO_SET_ROI_NONE &&
+	    item.nav_cmd != NAV_CMD_DO_SET_CAM_TRIGG_DIST &&
+	    item.nav_cmd != NAV_CMD_DO_SET_CAM_TRIGG_INTERVAL &&
+	    item.nav_cmd != NAV_CMD_SET_CAMERA_MODE &&
+	    item.nav_cmd != NAV_CMD_DO_VTOL_TRANSITION) {
+
+		mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: item %i: unsupported cmd: %d",
+				     (int)(index + 1), (int)item.nav_cmd);
+		return false;
+	}
+
+	/* Check non navigation item */
+	if (item.nav_cmd == NAV_CMD_DO_SET_SERVO) {
+
+		/* check actuator number */
+		if (item.params[0] < 0 || item.params[0] > 5) {
+			mavlink_log_critical(_context.mavlink_log_pub, "Actuator number %d is out of bounds 0..5",
+					     (int)item.params[0]);
+			return false;
+		}
+
+		/* check actuator value */
+		if (item.params[1] < -PWM_DEFAULT_MAX || item.params[1] > PWM_DEFAULT_MAX) {
+			mavlink_log_critical(_context.mavlink_log_pub,
+					     "Actuator value %d is out of bounds -PWM_DEFAULT_MAX..PWM_DEFAULT_MAX", (int)item.params[1]);
+			return false;
+		}
+	}
+
+	// check if the mission starts with a land command while the vehicle is landed
+	if ((index == 0) && item.nav_cmd == NAV_CMD_LAND && _context.landed) {
+
+		mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: starts with landing");
+		return false;
+	}
+
+	return true;
+}
+
+bool
+DistanceToFirstWaypointCheck::visit(size_t index, const mission_item_s &item)
+{
+	/* param not set or first waypoint already checked */
+	if (_max_distance <= 0.0f || _done) {
+		return true;
+	}
+
+	/* check only items with valid lat/lon */
+	if (!MissionBlock::item_contains_position(item)) {
+		return true;
+	}
+
+	_done = true;
+
+	/* check distance from current position to item */
+	const float dist_to_1wp = get_distance_to_next_waypoint(item.lat, item.lon, _context.home_lat, _context.home_lon);
+
+	if (dist_to_1wp < _max_distance) {
+		return true;
+	}
+
+	/* item is too far from home */
+	mavlink_log_critical(_context.mavlink_log_pub, "First waypoint too far away: %d meters, %d max.",
+			     (int)dist_to_1wp, (int)_max_distance);
+
+	_context.warning = true;
+	return false;
+}
+
+bool
+DistancesBetweenWaypointsCheck::visit(size_t index, const mission_item_s &item)
+{
+	/* param not set, check is ok */
+	if (_max_distance <= 0.0f) {
+		return true;
+	}
+
+	/* check only items with valid lat/lon */
+	if (!MissionBlock::item_contains_position(item)) {
+		return true;
+	}
+
+	/* Compare it to last waypoint if already available. */
+	if (PX4_ISFINITE(_last_lat) && PX4_ISFINITE(_last_lon)) {
+
+		/* check distance from current position to item */
+		const float dist_between_waypoints = get_distance_to_next_waypoint(item.lat, item.lon, _last_lat, _last_lon);
+
+		if (dist_between_waypoints > _max_distance) {
+			/* item is too far from home */
+			mavlink_log_critical(_context.mavlink_log_pub, "Distance between waypoints too far: %d meters, %d max.",
+					     (int)dist_between_waypoints, (int)_max_distance);
+
+			_context.warning = true;
+			return false;
+		}
+	}
+
+	_last_lat = item.lat;
+	_last_lon = item.lon;
+
+	return true;
+}
+
+bool
+GeofenceCheck::visit(size_t index, const mission_item_s &item)
+{
+	if (item.altitude_is_relative && !_home_valid) {
+		mavlink_log_critical(_context.mavlink_log_pub, "Geofence requires valid home position");
+		return false;
+	}
+
+	if (!MissionBlock::item_contains_position(item)) {
+		return true;
+	}
+
+	// Geofence function checks against home altitude amsl
+	mission_item_s item_amsl = item;
+	item_amsl.altitude = item.altitude_is_relative ? item.altitude + _context.home_alt : item.altitude;
+
+	if (!_geofence.check(item_amsl)) {
+		mavlink_log_critical(_context.mavlink_log_pub, "Geofence violation for waypoint %zu", index + 1);
+		return false;
+	}
+
+	return true;
+}
+
+bool
+HomePositionAltitudeCheck::visit(size_t index, const mission_item_s &item)
+{
+	/* only the first waypoint below home is reported */
+	if (_done || !MissionBlock::item_contains_position(item)) {
+		return true;
+	}
+
+	/* reject relative alt without home set */
+	if (item.altitude_is_relative && !_context.home_alt_valid) {
+
+		_context.warning = true;
+		_done = true;
+
+		if (_throw_error) {
+			mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: No home pos, WP %zu uses rel alt",
+					     index + 1);
+			return false;
+
+		} else	{
+			mavlink_log_critical(_context.mavlink_log_pub, "Warning: No home pos, WP %zu uses rel alt", index + 1);
+			return true;
+		}
+	}
+
+	/* calculate the global waypoint altitude */
+	const float wp_alt = item.altitude_is_relative ? item.altitude + _context.home_alt : item.altitude;
+
+	if (_context.home_alt > wp_alt) {
+
+		_context.warning = true;
+		_done = true;
+
+		if (_throw_error) {
+			mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: Waypoint %zu below home", index + 1);
+			return false;
+
+		} else	{
+			mavlink_log_critical(_context.mavlink_log_pub, "Warning: Waypoint %zu below home", index + 1);
+			return true;
+		}
+	}
+
+	return true;
+}
+
+bool
+TakeoffCheck::visit(size_t index, const mission_item_s &item)
+{
+	// look for a takeoff waypoint
+	if (item.nav_cmd == NAV_CMD_TAKEOFF) {
+		// make sure that the altitude of the waypoint is at least one meter larger than the acceptance radius
+		// this makes sure that the takeoff waypoint is not reached before we are at least one meter in the air
+
+		const float takeoff_alt = item.altitude_is_relative
+					  ? item.altitude
+					  : item.altitude - _context.home_alt;
+
+		// check if we should use default acceptance radius
+		float acceptance_radius = _context.default_acceptance_radius;
+
+		if (item.acceptance_radius > NAV_EPSILON_POSITION) {
+			acceptance_radius = item.acceptance_radius;
+		}
+
+		if (takeoff_alt - 1.0f < acceptance_radius) {
+			mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: Takeoff altitude too low!");
+			return false;
+		}
+
+		// tell that mission has a takeoff waypoint
+		_has_takeoff = true;
+
+		// tell that a takeoff waypoint is the first "waypoint"
+		// mission item
+		if (index == 0) {
+			_takeoff_first = true;
+
+		} else if (!_takeoff_index_found) {
+			// the first takeoff waypoint after the first item is only the first waypoint item
+			// if the item before it is not a waypoint or position-related item
+			_takeoff_index_found = true;
+			_takeoff_first = _previous_before_takeoff;
+		}
+	}
+
+	// one can set one of the below mission items before a takeoff waypoint
+	_previous_before_takeoff = (item.nav_cmd == NAV_CMD_IDLE ||
+				    item.nav_cmd == NAV_CMD_DELAY ||
+				    item.nav_cmd == NAV_CMD_DO_JUMP ||
+				    item.nav_cmd == NAV_CMD_DO_CHANGE_SPEED ||
+				    item.nav_cmd == NAV_CMD_DO_SET_HOME ||
+				    item.nav_cmd == NAV_CMD_DO_SET_SERVO ||
+				    item.nav_cmd == NAV_CMD_DO_LAND_START ||
+				    item.nav_cmd == NAV_CMD_DO_TRIGGER_CONTROL ||
+				    item.nav_cmd == NAV_CMD_DO_DIGICAM_CONTROL ||
+				    item.nav_cmd == NAV_CMD_IMAGE_START_CAPTURE ||
+				    item.nav_cmd == NAV_CMD_IMAGE_STOP_CAPTURE ||
+				    item.nav_cmd == NAV_CMD_VIDEO_START_CAPTURE ||
+				    item.nav_cmd == NAV_CMD_VIDEO_STOP_CAPTURE ||
+				    item.nav_cmd == NAV_CMD_DO_MOUNT_CONFIGURE ||
+				    item.nav_cmd == NAV_CMD_DO_MOUNT_CONTROL ||
+				    item.nav_cmd == NAV_CMD_DO_SET_ROI ||
+				    item.nav_cmd == NAV_CMD_DO_SET_ROI_LOCATION ||
+				    item.nav_cmd == NAV_CMD_DO_SET_ROI_WPNEXT_OFFSET ||
+				    item.nav_cmd == NAV_CMD_DO_SET_ROI_NONE ||
+				    item.nav_cmd == NAV_CMD_DO_SET_CAM_TRIGG_DIST ||
+				    item.nav_cmd == NAV_CMD_DO_SET_CAM_TRIGG_INTERVAL ||
+				    item.nav_cmd == NAV_CMD_SET_CAMERA_MODE ||
+				    item.nav_cmd == NAV_CMD_DO_VTOL_TRANSITION);
+
+	return true;
+}
+
+bool
+TakeoffCheck::finish(size_t count)
+{
+	if (_context.takeoff_required && _context.landed) {
+		// check for a takeoff waypoint, after the above conditions have been met
+		// MIS_TAKEOFF_REQ param has to be set and the vehicle has to be landed - one can load a mission
+		// while the vehicle is flying and it does not require a takeoff waypoint
+		if (!_has_takeoff) {
+			mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: takeoff waypoint required.");
+			return false;
+
+		} else if (!_takeoff_first) {
+			// check if the takeoff waypoint is the first waypoint item on the mission
+			// i.e, an item with position/attitude change modification
+			// if it is not, the mission should be rejected
+			mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: takeoff not first waypoint item");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+FixedWingLandingCheck::visit(size_t index, const mission_item_s &item)
+{
+	// if DO_LAND_START found then require valid landing AFTER
+	if (item.nav_cmd == NAV_CMD_DO_LAND_START) {
+		if (_land_start_found) {
+			mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: more than one land start.");
+			return false;
+
+		} else {
+			_land_start_found = true;
+			_do_land_start_index = index;
+		}
+	}
+
+	if (item.nav_cmd == NAV_CMD_LAND) {
+		if (index > 0) {
+			_landing_approach_index = index - 1;
+
+			if (!checkLandingApproach(item)) {
+				return false;
+			}
+
+			_landing_valid = true;
+
+		} else {
+			mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: starts with land waypoint.");
+			return false;
+		}
+
+	} else if (item.nav_cmd == NAV_CMD_RETURN_TO_LAUNCH) {
+		if (_land_start_found && _do_land_start_index < index) {
+			mavlink_log_critical(_context.mavlink_log_pub,
+					     "Mission rejected: land start item before RTL item not possible.");
+			return false;
+		}
+	}
+
+	_previous = item;
+
+	return true;
+}
+
+bool
+FixedWingLandingCheck::checkLandingApproach(const mission_item_s &item)
+{
+	/* the previous waypoint is checked to be at a feasible distance and altitude given the landing slope */
+	if (!MissionBlock::item_contains_position(_previous)) {
+		// mission item before land doesn't have a position
+		mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: need landing approach.");
+		return false;
+	}
+
+	const position_controller_landing_status_s &landing_status = _context.landing_status;
+
+	const bool landing_status_valid = (landing_status.timestamp > 0);
+	const float wp_distance = get_distance_to_next_waypoint(_previous.lat, _previous.lon, item.lat, item.lon);
+
+	if (landing_status_valid && (wp_distance > landing_status.flare_length)) {
+		/* Last wp is before flare region */
+
+		const float delta_altitude = item.altitude - _previous.altitude;
+
+		if (delta_altitude < 0) {
+
+			const float horizontal_slope_displacement = landing_status.horizontal_slope_displacement;
+			const float slope_angle_rad = landing_status.slope_angle_rad;
+			const float slope_alt_req = Landingslope::getLandingSlopeAbsoluteAltitude(wp_distance, item.altitude,
+						    horizontal_slope_displacement, slope_angle_rad);
+
+			if (_previous.altitude > slope_alt_req + 1.0f) {
+				/* Landing waypoint is above altitude of slope at the given waypoint distance (with small tolerance for floating point discrepancies) */
+				mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: adjust landing approach.");
+
+				const float wp_distance_req = Landingslope::getLandingSlopeWPDistance(_previous.altitude,
+							      item.altitude, horizontal_slope_displacement, slope_angle_rad);
+
+				mavlink_log_critical(_context.mavlink_log_pub, "Move down %d m or move further away by %d m.",
+						     (int)ceilf(slope_alt_req - _previous.altitude),
+						     (int)ceilf(wp_distance_req - wp_distance));
+
+				return false;
+			}
+
+		} else {
+			/* Landing waypoint is above last waypoint */
+			mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: landing above last waypoint.");
+			return false;
+		}
+
+	} else {
+		/* Last wp is in flare region */
+		mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: waypoint within landing flare.");
+		return false;
+	}
+
+	return true;
+}
+
+bool
+FixedWingLandingCheck::finish(size_t count)
+{
+	if (_land_start_req && !_land_start_found) {
+		mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: landing pattern required.");
+		return false;
+	}
+
+	if (_land_start_found && (!_landing_valid || (_do_land_start_index > _landing_approach_index))) {
+		mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: invalid land start.");
+		return false;
+	}
+
+	/* No landing waypoints or no waypoints */
+	return true;
+}
+
+bool
+VTOLLandingCheck::visit(size_t index, const mission_item_s &item)
+{
+	// if DO_LAND_START found then require valid landing AFTER
+	if (item.nav_cmd == NAV_CMD_DO_LAND_START) {
+		if (_land_start_found) {
+			mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: more than one land start.");
+			return false;
+
+		} else {
+			_land_start_found = true;
+			_do_land_start_index = index;
+		}
+	}
+
+	if (item.nav_cmd == NAV_CMD_LAND || item.nav_cmd == NAV_CMD_VTOL_LAND) {
+		if (index > 0) {
+			_landing_approach_index = index - 1;
+
+		} else {
+			mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: starts with land waypoint.");
+			return false;
+		}
+
+	} else if (item.nav_cmd == NAV_CMD_RETURN_TO_LAUNCH) {
+		if (_land_start_found && _do_land_start_index < index) {
+			mavlink_log_critical(_context.mavlink_log_pub,
+					     "Mission rejected: land start item before RTL item not possible.");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+VTOLLandingCheck::finish(size_t count)
+{
+	if (_land_start_req && !_land_start_found) {
+		mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: landing pattern required.");
+		return false;
+	}
+
+	if (_land_start_found && (_do_land_start_index > _landing_approach_index)) {
+		mavlink_log_critical(_context.mavlink_log_pub, "Mission rejected: invalid land start.");
+		return false;
+	}
+
+	/* No landing waypoints or no waypoints */
+	return true;
+}
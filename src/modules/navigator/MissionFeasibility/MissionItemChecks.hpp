@@ -0,0 +1,271 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file MissionItemChecks.hpp
+ * Mission feasibility checks that run as visitors over the mission items.
+ *
+ * The mission is read once, item by item in mission order, and every item is handed to all
+ * checks (MissionItemChecks::visit()). Each check keeps the state it needs across items
+ * (previous waypoint, takeoff index, land start index, ...) and evaluates whatever needs the whole
+ * mission in finish(). The checks do not depend on the navigator, the vehicle state they need is
+ * captured in a MissionCheckContext before the pass.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+
+#include <navigator/navigation.h>
+#include <uORB/uORB.h>
+#include <uORB/topics/position_controller_landing_status.h>
+
+/**
+ * Vehicle state the checks run against, captured once before the pass
+ */
+struct MissionCheckContext {
+	orb_advert_t *mavlink_log_pub{nullptr};	///< rejection reasons are reported here (can be nullptr)
+
+	double home_lat{0.};
+	double home_lon{0.};
+	float home_alt{0.f};			///< AMSL
+	bool home_alt_valid{false};
+
+	bool landed{false};
+	bool takeoff_required{false};		///< MIS_TAKEOFF_REQ
+	float default_acceptance_radius{0.f};
+
+	position_controller_landing_status_s landing_status{};
+
+	bool warning{false};			///< set by the checks for a mission result warning
+};
+
+class MissionItemCheck
+{
+public:
+	explicit MissionItemCheck(MissionCheckContext &context) : _context(context) {}
+	virtual ~MissionItemCheck() = default;
+
+	/**
+	 * Called for every mission item, in mission order.
+	 * @return false to reject the mission
+	 */
+	virtual bool visit(size_t index, const mission_item_s &item) = 0;
+
+	/**
+	 * Called after the last mission item.
+	 * @return false to reject the mission
+	 */
+	virtual bool finish(size_t count) { return true; }
+
+protected:
+	MissionCheckContext &_context;
+};
+
+/**
+ * Runs a set of checks over the mission items. The checks are called in the order they were added,
+ * the first one rejecting the mission stops the pass (and is the only one reporting).
+ */
+class MissionItemChecks
+{
+public:
+	static constexpr int MAX_CHECKS = 8;
+
+	bool add(MissionItemCheck &check);
+
+	bool visit(size_t index, const mission_item_s &item);
+	bool finish(size_t count);
+
+private:
+	MissionItemCheck *_checks[MAX_CHECKS] {};
+	int _num_checks{0};
+};
+
+/**
+ * All items have to be supported mission commands with valid parameters
+ */
+class MissionItemValidityCheck : public MissionItemCheck
+{
+public:
+	using MissionItemCheck::MissionItemCheck;
+
+	bool visit(size_t index, const mission_item_s &item) override;
+};
+
+/**
+ * The first waypoint has to be closer than max_distance to home (disabled if max_distance <= 0)
+ */
+class DistanceToFirstWaypointCheck : public MissionItemCheck
+{
+public:
+	DistanceToFirstWaypointCheck(MissionCheckContext &context, float max_distance) :
+		MissionItemCheck(context), _max_distance(max_distance) {}
+
+	bool visit(size_t index, const mission_item_s &item) override;
+
+private:
+	const float _max_distance;
+	bool _done{false};
+};
+
+/**
+ * Consecutive waypoints have to be closer than max_distance (disabled if max_distance <= 0)
+ */
+class DistancesBetweenWaypointsCheck : public MissionItemCheck
+{
+public:
+	DistancesBetweenWaypointsCheck(MissionCheckContext &context, float max_distance) :
+		MissionItemCheck(context), _max_distance(max_distance) {}
+
+	bool visit(size_t index, const mission_item_s &item) override;
+
+private:
+	const float _max_distance;
+	double _last_lat{(double)NAN};
+	double _last_lon{(double)NAN};
+};
+
+/**
+ * Geofence the mission items are checked against
+ */
+class MissionGeofence
+{
+public:
+	virtual ~MissionGeofence() = default;
+
+	/**
+	 * @param item mission item with the altitude AMSL
+	 * @return true if the position of the item is inside the geofence
+	 */
+	virtual bool check(const mission_item_s &item) = 0;
+};
+
+/**
+ * All items with a position have to be inside the geofence. Items with a relative altitude need
+ * a valid home position.
+ */
+class GeofenceCheck : public MissionItemCheck
+{
+public:
+	GeofenceCheck(MissionCheckContext &context, MissionGeofence &geofence, bool home_valid) :
+		MissionItemCheck(context), _geofence(geofence), _home_valid(home_valid) {}
+
+	bool visit(size_t index, const mission_item_s &item) override;
+
+private:
+	MissionGeofence &_geofence;
+	const bool _home_valid;
+};
+
+/**
+ * Waypoints have to be above home. Rejects the mission if throw_error is set, only warns
+ * (once) otherwise.
+ */
+class HomePositionAltitudeCheck : public MissionItemCheck
+{
+public:
+	HomePositionAltitudeCheck(MissionCheckContext &context, bool throw_error) :
+		MissionItemCheck(context), _throw_error(throw_error) {}
+
+	bool visit(size_t index, const mission_item_s &item) override;
+
+private:
+	const bool _throw_error;
+	bool _done{false};
+};
+
+/**
+ * Takeoff waypoints have to be high enough, and if a takeoff is required it has to be the first
+ * waypoint item
+ */
+class TakeoffCheck : public MissionItemCheck
+{
+public:
+	using MissionItemCheck::MissionItemCheck;
+
+	bool visit(size_t index, const mission_item_s &item) override;
+	bool finish(size_t count) override;
+
+private:
+	bool _has_takeoff{false};
+	bool _takeoff_first{false};
+	bool _takeoff_index_found{false};
+	bool _previous_before_takeoff{false};	///< previous item is allowed before the takeoff
+};
+
+/**
+ * Landing approach has to be feasible with the landing slope, and a land start item has to be
+ * followed by a valid landing
+ */
+class FixedWingLandingCheck : public MissionItemCheck
+{
+public:
+	FixedWingLandingCheck(MissionCheckContext &context, bool land_start_req) :
+		MissionItemCheck(context), _land_start_req(land_start_req) {}
+
+	bool visit(size_t index, const mission_item_s &item) override;
+	bool finish(size_t count) override;
+
+private:
+	bool checkLandingApproach(const mission_item_s &item);
+
+	const bool _land_start_req;
+
+	mission_item_s _previous{};
+	bool _landing_valid{false};
+	bool _land_start_found{false};
+	size_t _do_land_start_index{0};
+	size_t _landing_approach_index{0};
+};
+
+/**
+ * A land start item has to be followed by a landing
+ */
+class VTOLLandingCheck : public MissionItemCheck
+{
+public:
+	VTOLLandingCheck(MissionCheckContext &context, bool land_start_req) :
+		MissionItemCheck(context), _land_start_req(land_start_req) {}
+
+	bool visit(size_t index, const mission_item_s &item) override;
+	bool finish(size_t count) override;
+
+private:
+	const bool _land_start_req;
+
+	bool _land_start_found{false};
+	size_t _do_land_start_index{0};
+	size_t _landing_approach_index{0};
+};
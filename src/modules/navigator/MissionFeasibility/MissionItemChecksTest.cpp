@@ -0,0 +1,405 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include <gtest/gtest.h>
+#include <drivers/drv_hrt.h>
+
+#include "MissionItemChecks.hpp"
+
+// to run: make tests TESTFILTER=MissionItemChecks
+
+static constexpr double HOME_LAT = 47.397742;
+static constexpr double HOME_LON = 8.545594;
+static constexpr float HOME_ALT = 488.f;
+
+class MissionItemChecksTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		_context.home_lat = HOME_LAT;
+		_context.home_lon = HOME_LON;
+		_context.home_alt = HOME_ALT;
+		_context.home_alt_valid = true;
+		_context.landed = true;
+		_context.takeoff_required = true;
+		_context.default_acceptance_radius = 10.f;
+	}
+
+	static mission_item_s item(uint16_t nav_cmd, double lat = HOME_LAT, double lon = HOME_LON, float altitude = 50.f)
+	{
+		mission_item_s mission_item{};
+		mission_item.nav_cmd = nav_cmd;
+		mission_item.lat = lat;
+		mission_item.lon = lon;
+		mission_item.altitude = altitude;
+		mission_item.altitude_is_relative = true;
+		return mission_item;
+	}
+
+	/* survey like mission: takeoff, lawnmower pattern with ~10 m between the waypoints, land at the last one */
+	static void syntheticMission(mission_item_s *items, size_t count)
+	{
+		items[0] = item(NAV_CMD_TAKEOFF);
+
+		for (size_t i = 1; i < count - 1; i++) {
+			const size_t row = i / 100;
+			const size_t column = (row % 2) ? 99 - (i % 100) : (i % 100);
+			items[i] = item(NAV_CMD_WAYPOINT, HOME_LAT + row * 1e-4, HOME_LON + column * 1e-4);
+		}
+
+		items[count - 1] = item(NAV_CMD_LAND, items[count - 2].lat, items[count - 2].lon, 0.f);
+	}
+
+	bool check(MissionItemChecks &checks, const mission_item_s *items, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			if (!checks.visit(i, items[i])) {
+				return false;
+			}
+		}
+
+		return checks.finish(count);
+	}
+
+	MissionCheckContext _context{};
+};
+
+TEST_F(MissionItemChecksTest, UnsupportedCommand)
+{
+	const mission_item_s items[] {item(NAV_CMD_TAKEOFF), item(NAV_CMD_DO_FOLLOW_REPOSITION), item(NAV_CMD_LAND)};
+
+	MissionItemValidityCheck validity_check{_context};
+	MissionItemChecks checks;
+	checks.add(validity_check);
+
+	EXPECT_FALSE(check(checks, items, 3));
+}
+
+TEST_F(MissionItemChecksTest, TakeoffAltitudeTooLow)
+{
+	const mission_item_s items[] {item(NAV_CMD_TAKEOFF, HOME_LAT, HOME_LON, 5.f), item(NAV_CMD_WAYPOINT)};
+
+	TakeoffCheck takeoff_check{_context};
+	MissionItemChecks checks;
+	checks.add(takeoff_check);
+
+	EXPECT_FALSE(check(checks, items, 2));
+}
+
+TEST_F(MissionItemChecksTest, TakeoffFirstWaypointItem)
+{
+	const mission_item_s takeoff_after_delay[] {
+		item(NAV_CMD_DELAY), item(NAV_CMD_TAKEOFF), item(NAV_CMD_WAYPOINT)
+	};
+	const mission_item_s takeoff_after_waypoint[] {
+		item(NAV_CMD_WAYPOINT), item(NAV_CMD_TAKEOFF), item(NAV_CMD_WAYPOINT)
+	};
+	const mission_item_s no_takeoff[] {item(NAV_CMD_WAYPOINT), item(NAV_CMD_WAYPOINT)};
+
+	{
+		TakeoffCheck takeoff_check{_context};
+		MissionItemChecks checks;
+		checks.add(takeoff_check);
+		EXPECT_TRUE(check(checks, takeoff_after_delay, 3));
+	}
+
+	{
+		TakeoffCheck takeoff_check{_context};
+		MissionItemChecks checks;
+		checks.add(takeoff_check);
+		EXPECT_FALSE(check(checks, takeoff_after_waypoint, 3));
+	}
+
+	{
+		TakeoffCheck takeoff_check{_context};
+		MissionItemChecks checks;
+		checks.add(takeoff_check);
+		EXPECT_FALSE(check(checks, no_takeoff, 2));
+	}
+
+	// no takeoff required when loading a mission in air
+	_context.landed = false;
+
+	{
+		TakeoffCheck takeoff_check{_context};
+		MissionItemChecks checks;
+		checks.add(takeoff_check);
+		EXPECT_TRUE(check(checks, no_takeoff, 2));
+	}
+}
+
+TEST_F(MissionItemChecksTest, DistancesBetweenWaypoints)
+{
+	// second waypoint ~1.1 km north of the first one
+	const mission_item_s items[] {item(NAV_CMD_WAYPOINT), item(NAV_CMD_DELAY), item(NAV_CMD_WAYPOINT, HOME_LAT + 0.01)};
+
+	{
+		DistancesBetweenWaypointsCheck distances_check{_context, 1000.f};
+		MissionItemChecks checks;
+		checks.add(distances_check);
+		EXPECT_FALSE(check(checks, items, 3));
+		EXPECT_TRUE(_context.warning);
+	}
+
+	{
+		DistancesBetweenWaypointsCheck distances_check{_context, 2000.f};
+		MissionItemChecks checks;
+		checks.add(distances_check);
+		EXPECT_TRUE(check(checks, items, 3));
+	}
+}
+
+TEST_F(MissionItemChecksTest, LandStart)
+{
+	const mission_item_s land_start_before_land[] {
+		item(NAV_CMD_TAKEOFF), item(NAV_CMD_DO_LAND_START), item(NAV_CMD_WAYPOINT), item(NAV_CMD_VTOL_LAND)
+	};
+	const mission_item_s land_start_after_land[] {
+		item(NAV_CMD_TAKEOFF), item(NAV_CMD_VTOL_LAND), item(NAV_CMD_DO_LAND_START)
+	};
+
+	{
+		VTOLLandingCheck landing_check{_context, true};
+		MissionItemChecks checks;
+		checks.add(landing_check);
+		EXPECT_TRUE(check(checks, land_start_before_land, 4));
+	}
+
+	{
+		VTOLLandingCheck landing_check{_context, true};
+		MissionItemChecks checks;
+		checks.add(landing_check);
+		EXPECT_FALSE(check(checks, land_start_after_land, 3));
+	}
+}
+
+TEST_F(MissionItemChecksTest, FixedWingLandingSlope)
+{
+	_context.landing_status.timestamp = 1;
+	_context.landing_status.flare_length = 50.f;
+	_context.landing_status.horizontal_slope_displacement = 20.f;
+	_context.landing_status.slope_angle_rad = 0.0873f; // 5 deg, ~47 m at the approach waypoint
+
+	// approach waypoint ~556 m north of the landing point
+	const double approach_lat = HOME_LAT + 0.005;
+
+	const mission_item_s below_slope[] {
+		item(NAV_CMD_TAKEOFF), item(NAV_CMD_WAYPOINT, approach_lat, HOME_LON, 40.f), item(NAV_CMD_LAND, HOME_LAT, HOME_LON, 0.f)
+	};
+	const mission_item_s above_slope[] {
+		item(NAV_CMD_TAKEOFF), item(NAV_CMD_WAYPOINT, approach_lat, HOME_LON, 80.f), item(NAV_CMD_LAND, HOME_LAT, HOME_LON, 0.f)
+	};
+	// approach waypoint ~33 m north of the landing point, inside the flare
+	const mission_item_s within_flare[] {
+		item(NAV_CMD_TAKEOFF), item(NAV_CMD_WAYPOINT, HOME_LAT + 0.0003, HOME_LON, 10.f), item(NAV_CMD_LAND, HOME_LAT, HOME_LON, 0.f)
+	};
+	const mission_item_s above_approach[] {
+		item(NAV_CMD_TAKEOFF), item(NAV_CMD_WAYPOINT, approach_lat, HOME_LON, 40.f), item(NAV_CMD_LAND, HOME_LAT, HOME_LON, 50.f)
+	};
+
+	{
+		FixedWingLandingCheck landing_check{_context, false};
+		MissionItemChecks checks;
+		checks.add(landing_check);
+		EXPECT_TRUE(check(checks, below_slope, 3));
+	}
+
+	{
+		FixedWingLandingCheck landing_check{_context, false};
+		MissionItemChecks checks;
+		checks.add(landing_check);
+		EXPECT_FALSE(check(checks, above_slope, 3));
+	}
+
+	{
+		FixedWingLandingCheck landing_check{_context, false};
+		MissionItemChecks checks;
+		checks.add(landing_check);
+		EXPECT_FALSE(check(checks, within_flare, 3));
+	}
+
+	{
+		FixedWingLandingCheck landing_check{_context, false};
+		MissionItemChecks checks;
+		checks.add(landing_check);
+		EXPECT_FALSE(check(checks, above_approach, 3));
+	}
+
+	// landing slope is unknown without a landing status from the position controller
+	_context.landing_status.timestamp = 0;
+
+	{
+		FixedWingLandingCheck landing_check{_context, false};
+		MissionItemChecks checks;
+		checks.add(landing_check);
+		EXPECT_FALSE(check(checks, below_slope, 3));
+	}
+}
+
+TEST_F(MissionItemChecksTest, HomePositionAltitude)
+{
+	const mission_item_s below_home[] {item(NAV_CMD_WAYPOINT), item(NAV_CMD_WAYPOINT, HOME_LAT, HOME_LON, -10.f)};
+
+	{
+		HomePositionAltitudeCheck home_altitude_check{_context, false};
+		MissionItemChecks checks;
+		checks.add(home_altitude_check);
+		EXPECT_TRUE(check(checks, below_home, 2));
+		EXPECT_TRUE(_context.warning);
+	}
+
+	_context.warning = false;
+
+	{
+		HomePositionAltitudeCheck home_altitude_check{_context, true};
+		MissionItemChecks checks;
+		checks.add(home_altitude_check);
+		EXPECT_FALSE(check(checks, below_home, 2));
+		EXPECT_TRUE(_context.warning);
+	}
+
+	// relative altitudes without a home altitude
+	const mission_item_s relative[] {item(NAV_CMD_WAYPOINT)};
+	_context.home_alt_valid = false;
+	_context.warning = false;
+
+	{
+		HomePositionAltitudeCheck home_altitude_check{_context, false};
+		MissionItemChecks checks;
+		checks.add(home_altitude_check);
+		EXPECT_TRUE(check(checks, relative, 1));
+		EXPECT_TRUE(_context.warning);
+	}
+
+	{
+		HomePositionAltitudeCheck home_altitude_check{_context, true};
+		MissionItemChecks checks;
+		checks.add(home_altitude_check);
+		EXPECT_FALSE(check(checks, relative, 1));
+	}
+}
+
+/* records the altitude of the items checked, rejects everything above max_alt */
+class TestGeofence : public MissionGeofence
+{
+public:
+	bool check(const mission_item_s &item) override
+	{
+		last_altitude = item.altitude;
+		checked++;
+		return item.altitude <= max_alt;
+	}
+
+	float max_alt{1000.f};
+	float last_altitude{NAN};
+	int checked{0};
+};
+
+TEST_F(MissionItemChecksTest, Geofence)
+{
+	const mission_item_s items[] {item(NAV_CMD_TAKEOFF), item(NAV_CMD_DELAY), item(NAV_CMD_WAYPOINT)};
+
+	{
+		TestGeofence geofence;
+		GeofenceCheck geofence_check{_context, geofence, true};
+		MissionItemChecks checks;
+		checks.add(geofence_check);
+		EXPECT_TRUE(check(checks, items, 3));
+
+		// the delay item has no position, relative altitudes are checked AMSL
+		EXPECT_EQ(geofence.checked, 2);
+		EXPECT_FLOAT_EQ(geofence.last_altitude, HOME_ALT + 50.f);
+	}
+
+	{
+		TestGeofence geofence;
+		geofence.max_alt = HOME_ALT;
+		GeofenceCheck geofence_check{_context, geofence, true};
+		MissionItemChecks checks;
+		checks.add(geofence_check);
+		EXPECT_FALSE(check(checks, items, 3));
+		EXPECT_EQ(geofence.checked, 1);
+	}
+
+	// relative altitudes need a valid home position
+	{
+		TestGeofence geofence;
+		GeofenceCheck geofence_check{_context, geofence, false};
+		MissionItemChecks checks;
+		checks.add(geofence_check);
+		EXPECT_FALSE(check(checks, items, 3));
+		EXPECT_EQ(geofence.checked, 0);
+	}
+}
+
+TEST_F(MissionItemChecksTest, Benchmark5000Items)
+{
+	static constexpr size_t COUNT = 5000;
+	static constexpr int RUNS = 20;
+
+	mission_item_s *items = new mission_item_s[COUNT];
+	syntheticMission(items, COUNT);
+
+	hrt_abstime elapsed = 0;
+
+	for (int run = 0; run < RUNS; run++) {
+		// the checks of a multicopter mission without geofence, in the order MissionFeasibilityChecker runs them
+		DistanceToFirstWaypointCheck first_waypoint_check{_context, 900.f};
+		MissionItemValidityCheck validity_check{_context};
+		DistancesBetweenWaypointsCheck waypoint_distances_check{_context, 100.f};
+		HomePositionAltitudeCheck home_altitude_check{_context, false};
+		TakeoffCheck takeoff_check{_context};
+
+		MissionItemChecks checks;
+		checks.add(first_waypoint_check);
+		checks.add(validity_check);
+		checks.add(waypoint_distances_check);
+		checks.add(home_altitude_check);
+		checks.add(takeoff_check);
+
+		const hrt_abstime start = hrt_absolute_time();
+		const bool feasible = check(checks, items, COUNT);
+		elapsed += hrt_elapsed_time(&start);
+
+		ASSERT_TRUE(feasible);
+	}
+
+	EXPECT_FALSE(_context.warning);
+
+	printf("mission feasibility checks, %zu items: %.3f ms per mission (%.3f us per item)\n", COUNT,
+	       (double)elapsed / RUNS / 1e3, (double)elapsed / RUNS / COUNT);
+
+	delete[] items;
+}
@@ -0,0 +1,296 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file dataman_cache.cpp
+ * Read-through cache of the mission, fence and safe point items in dataman.
+ */
+
+#include "dataman_cache.h"
+
+#include <lib/mathlib/mathlib.h>
+#include <px4_platform_common/log.h>
+
+#include <limits.h>
+#include <new>
+#include <string.h>
+
+DatamanCache::DatamanCache() = default;
+
+DatamanCache::~DatamanCache()
+{
+	for (auto &entry : _entries) {
+		delete[] entry.data;
+	}
+
+	perf_free(_load_perf);
+	perf_free(_hit_perf);
+	perf_free(_miss_perf);
+}
+
+size_t DatamanCache::item_size(dm_item_t item)
+{
+	switch (item) {
+	case DM_KEY_SAFE_POINTS:
+		return sizeof(mission_safe_point_s);
+
+	case DM_KEY_FENCE_POINTS:
+		return sizeof(mission_fence_point_s);
+
+	case DM_KEY_WAYPOINTS_OFFBOARD_0:
+	case DM_KEY_WAYPOINTS_OFFBOARD_1:
+	case DM_KEY_WAYPOINTS_ONBOARD:
+		return sizeof(mission_item_s);
+
+	default:
+		// not cached
+		return 0;
+	}
+}
+
+bool DatamanCache::is_mission_key(dm_item_t item)
+{
+	return (item == DM_KEY_WAYPOINTS_OFFBOARD_0) || (item == DM_KEY_WAYPOINTS_OFFBOARD_1)
+	       || (item == DM_KEY_WAYPOINTS_ONBOARD);
+}
+
+bool DatamanCache::is_current(dm_item_t item) const
+{
+	const Entry &entry = _entries[item];
+	return entry.valid && (entry.generation == dm_generation(item));
+}
+
+size_t DatamanCache::available(dm_item_t item) const
+{
+	size_t used_mission = 0;
+	size_t used_points = 0;
+
+	for (int i = 0; i < DM_KEY_NUM_KEYS; i++) {
+		if (i != item) {
+			if (is_mission_key((dm_item_t)i)) {
+				used_mission += allocated((dm_item_t)i);
+
+			} else {
+				used_points += allocated((dm_item_t)i);
+			}
+		}
+	}
+
+	const size_t used = used_mission + (is_mission_key(item) ? math::max(used_points, POINTS_RESERVE) : used_points);
+
+	return (used < CACHE_BUDGET) ? (CACHE_BUDGET - used) : 0;
+}
+
+unsigned DatamanCache::load(dm_item_t item, unsigned num_items)
+{
+	const size_t size = item_size(item);
+
+	if ((item >= DM_KEY_NUM_KEYS) || (size == 0)) {
+		return 0;
+	}
+
+	Entry &entry = _entries[item];
+
+	// outdated copies of the other keys are reloaded on their next use anyway, give their memory back to the budget
+	for (int i = 0; i < DM_KEY_NUM_KEYS; i++) {
+		if ((i != item) && (_entries[i].capacity > 0) && !is_current((dm_item_t)i)) {
+			release((dm_item_t)i);
+		}
+	}
+
+	// the index 0 of the fence and safe points (stats) is included in num_items by the caller
+	num_items = math::min(num_items, (unsigned)math::min(available(item) / (size + 1), (size_t)UINT_MAX));
+
+	if (num_items == 0) {
+		invalidate(item);
+		return 0;
+	}
+
+	if (is_current(item) && (entry.num_items >= num_items)) {
+		return entry.num_items;
+	}
+
+	if (entry.capacity < num_items) {
+		delete[] entry.data;
+		entry.data = new (std::nothrow) uint8_t[num_items * (size + 1)];
+		entry.capacity = (entry.data != nullptr) ? num_items : 0;
+	}
+
+	entry.valid = false;
+	entry.num_items = 0;
+
+	if (entry.data == nullptr) {
+		return 0;
+	}
+
+	perf_begin(_load_perf);
+
+	// changes during the load are detected with the generation from before
+	const uint32_t generation = dm_generation(item);
+
+	while (entry.num_items < num_items) {
+		const unsigned index = entry.num_items;
+
+		// full size items in bulk, the range ends at the first item of a different size (e.g. the stats at index 0)
+		const ssize_t count = dm_read_range(item, index, num_items - index, item_data(item, index), size);
+
+		if (count < 0) {
+			break;
+		}
+
+		for (unsigned i = index; i < index + count; i++) {
+			item_length(item, i) = size;
+		}
+
+		entry.num_items += count;
+
+		if (entry.num_items < num_items) {
+			const ssize_t len = dm_read(item, entry.num_items, item_data(item, entry.num_items), size);
+
+			if (len < 0) {
+				break;
+			}
+
+			item_length(item, entry.num_items) = len;
+			entry.num_items++;
+		}
+	}
+
+	perf_end(_load_perf);
+
+	entry.generation = generation;
+	entry.valid = (entry.num_items > 0);
+
+	return entry.num_items;
+}
+
+ssize_t DatamanCache::read(dm_item_t item, unsigned index, void *buffer, size_t buflen)
+{
+	if ((item < DM_KEY_NUM_KEYS) && is_current(item) && (index < _entries[item].num_items)) {
+		const uint8_t len = item_length(item, index);
+
+		// same semantics as dm_read()
+		if (buflen > item_size(item)) {
+			return -E2BIG;
+		}
+
+		if (len > buflen) {
+			return -1;
+		}
+
+		memcpy(buffer, item_data(item, index), len);
+		perf_count(_hit_perf);
+		return len;
+	}
+
+	perf_count(_miss_perf);
+	return dm_read(item, index, buffer, buflen);
+}
+
+ssize_t DatamanCache::write(dm_item_t item, unsigned index, dm_persitence_t persistence, const void *buffer,
+			    size_t buflen)
+{
+	if (item >= DM_KEY_NUM_KEYS) {
+		return dm_write(item, index, persistence, buffer, buflen);
+	}
+
+	const bool was_current = is_current(item);
+	const uint32_t generation = dm_generation(item);
+
+	const ssize_t ret = dm_write(item, index, persistence, buffer, buflen);
+
+	Entry &entry = _entries[item];
+
+	// keep the copy only if this was the only change to the key
+	if (was_current && (ret >= 0) && (dm_generation(item) == generation + 1)) {
+		if (index < entry.num_items) {
+			item_length(item, index) = ret;
+			memcpy(item_data(item, index), buffer, ret);
+		}
+
+		entry.generation = generation + 1;
+
+	} else {
+		entry.valid = false;
+	}
+
+	return ret;
+}
+
+int DatamanCache::clear(dm_item_t item)
+{
+	const int ret = dm_clear(item);
+
+	if (item < DM_KEY_NUM_KEYS) {
+		invalidate(item);
+	}
+
+	return ret;
+}
+
+void DatamanCache::invalidate(dm_item_t item)
+{
+	if (item < DM_KEY_NUM_KEYS) {
+		_entries[item].valid = false;
+		_entries[item].num_items = 0;
+	}
+}
+
+void DatamanCache::release(dm_item_t item)
+{
+	if (item < DM_KEY_NUM_KEYS) {
+		delete[] _entries[item].data;
+		_entries[item] = Entry{};
+	}
+}
+
+void DatamanCache::print_status() const
+{
+	size_t total = 0;
+
+	for (int item = 0; item < DM_KEY_NUM_KEYS; item++) {
+		const Entry &entry = _entries[item];
+
+		if (entry.capacity > 0) {
+			PX4_INFO("dataman cache key %d: %u items, %zu bytes%s", item, entry.num_items, allocated((dm_item_t)item),
+				 is_current((dm_item_t)item) ? "" : " (outdated)");
+			total += allocated((dm_item_t)item);
+		}
+	}
+
+	PX4_INFO("dataman cache: %zu bytes allocated", total);
+
+	perf_print_counter(_load_perf);
+	perf_print_counter(_hit_perf);
+	perf_print_counter(_miss_perf);
+}
@@ -0,0 +1,135 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file dataman_cache.h
+ * Read-through cache of the mission, fence and safe point items in dataman,
+ * shared by the navigator modes, the geofence and the mission feasibility checker.
+ *
+ * Every dm_read() is a round-trip to the dataman task, so the items of a key are
+ * loaded into memory with bulk reads (dm_read_range()) and served from there until dataman reports a change
+ * of the key (dm_generation()). Writes go to dataman first and then update the copy.
+ */
+
+#pragma once
+
+#include <dataman/dataman.h>
+#include <lib/perf/perf_counter.h>
+
+class DatamanCache
+{
+public:
+	DatamanCache();
+	DatamanCache(const DatamanCache &) = delete;
+	DatamanCache &operator=(const DatamanCache &) = delete;
+	~DatamanCache();
+
+	/**
+	 * Load the items [0, num_items) of a key into memory, unless they are already loaded and unchanged.
+	 * Only the mission, fence and safe point keys are cached. All keys share CACHE_BUDGET bytes,
+	 * of which the mission keys leave enough for the fence and safe points.
+	 *
+	 * @return number of items available from memory
+	 */
+	unsigned load(dm_item_t item, unsigned num_items);
+
+	/**
+	 * dm_read() from memory if the index is loaded and the key is unchanged, from dataman otherwise
+	 */
+	ssize_t read(dm_item_t item, unsigned index, void *buffer, size_t buflen);
+
+	/**
+	 * dm_write() and update the cached copy (write-through)
+	 */
+	ssize_t write(dm_item_t item, unsigned index, dm_persitence_t persistence, const void *buffer, size_t buflen);
+
+	/**
+	 * dm_clear() and drop the cached copy
+	 */
+	int clear(dm_item_t item);
+
+	void invalidate(dm_item_t item);
+
+	/**
+	 * Drop the cached copy and free its memory, e.g. for the offboard mission key that is no longer active
+	 */
+	void release(dm_item_t item);
+
+	void print_status() const;
+
+private:
+#if defined(MEMORY_CONSTRAINED_SYSTEM)
+	static constexpr size_t CACHE_BUDGET = 4 * 1024;
+#elif defined(__PX4_NUTTX)
+	static constexpr size_t CACHE_BUDGET = 64 * 1024;
+#else
+	static constexpr size_t CACHE_BUDGET = SIZE_MAX;
+#endif
+
+	/// memory for all fence and safe points (including the stats at index 0), not used by the mission keys
+	static constexpr size_t POINTS_RESERVE = (DM_KEY_FENCE_POINTS_MAX + 1) * (sizeof(mission_fence_point_s) + 1) +
+			(DM_KEY_SAFE_POINTS_MAX + 1) * (sizeof(mission_safe_point_s) + 1);
+
+	struct Entry {
+		uint8_t *data{nullptr};		///< capacity x item_size bytes, followed by the capacity lengths
+		unsigned capacity{0};		///< allocated items
+		unsigned num_items{0};		///< loaded items
+		uint32_t generation{0};		///< dm_generation() of the loaded items
+		bool valid{false};
+	};
+
+	static size_t item_size(dm_item_t item);
+
+	uint8_t *item_data(dm_item_t item, unsigned index) { return &_entries[item].data[index * item_size(item)]; }
+	uint8_t &item_length(dm_item_t item, unsigned index)
+	{
+		return _entries[item].data[_entries[item].capacity * item_size(item) + index];
+	}
+
+	bool is_current(dm_item_t item) const;
+
+	static bool is_mission_key(dm_item_t item);
+
+	size_t allocated(dm_item_t item) const { return _entries[item].capacity * (item_size(item) + 1); }
+
+	/**
+	 * Bytes of the budget available to a key, including its current allocation
+	 */
+	size_t available(dm_item_t item) const;
+
+	Entry _entries[DM_KEY_NUM_KEYS] {};
+
+	perf_counter_t _load_perf{perf_alloc(PC_ELAPSED, "navigator: dataman cache load")};
+	perf_counter_t _hit_perf{perf_alloc(PC_COUNT, "navigator: dataman cache hit")};
+	perf_counter_t _miss_perf{perf_alloc(PC_COUNT, "navigator: dataman cache miss")};
+};
@@ -46,6 +46,7 @@
 #include <dataman/dataman.h>
 #include <drivers/drv_hrt.h>
 #include <lib/ecl/geo/geo.h>
+#include <lib/mathlib/mathlib.h>
 #include <systemlib/mavlink_log.h>
 
 #include "navigator.h"
@@ -63,6 +64,8 @@ Geofence::Geofence(Navigator *navigator) :
 
 Geofence::~Geofence()
 {
+	freeVertices();
+
 	if (_polygons) {
 		delete[](_polygons);
 	}
@@ -85,15 +88,18 @@ void Geofence::updateFence()
 
 void Geofence::_updateFence()
 {
+	freeVertices();
 
 	// initialize fence points count
+	DatamanCache &dataman_cache = _navigator->get_dataman_cache();
 	mission_stats_entry_s stats;
-	int ret = dm_read(DM_KEY_FENCE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
+	int ret = dataman_cache.read(DM_KEY_FENCE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
 	int num_fence_items = 0;
 
 	if (ret == sizeof(mission_stats_entry_s)) {
 		num_fence_items = stats.num_items;
 		_update_counter = stats.update_counter;
+		dataman_cache.load(DM_KEY_FENCE_POINTS, num_fence_items + 1);
 	}
 
 	// iterate over all polygons and store their starting vertices
@@ -104,7 +110,7 @@ void Geofence::_updateFence()
 		mission_fence_point_s mission_fence_point;
 		bool is_circle_area = false;
 
-		if (dm_read(DM_KEY_FENCE_POINTS, current_seq, &mission_fence_point, sizeof(mission_fence_point_s)) !=
+		if (dataman_cache.read(DM_KEY_FENCE_POINTS, current_seq, &mission_fence_point, sizeof(mission_fence_point_s)) !=
 		    sizeof(mission_fence_point_s)) {
 			PX4_ERR("dm_read failed");
 			break;
@@ -150,6 +156,7 @@ void Geofence::_updateFence()
 				}
 
 				PolygonInfo &polygon = _polygons[_num_polygons];
+				polygon = PolygonInfo{};
 				polygon.dataman_index = current_seq;
 				polygon.fence_type = mission_fence_point.nav_cmd;
 
@@ -175,6 +182,199 @@ void Geofence::_updateFence()
 
 	}
 
+	loadVertices();
+}
+
+static inline bool isCircle(uint16_t fence_type)
+{
+	return fence_type == NAV_CMD_FENCE_CIRCLE_INCLUSION || fence_type == NAV_CMD_FENCE_CIRCLE_EXCLUSION;
+}
+
+static inline int slabIndex(float min_y, float slab_width, int num_slabs, float y)
+{
+	return math::constrain((int)((y - min_y) / slab_width), 0, num_slabs - 1);
+}
+
+void Geofence::loadVertices()
+{
+	int num_vertices = 0;
+
+	for (int polygon_idx = 0; polygon_idx < _num_polygons; ++polygon_idx) {
+		num_vertices += isCircle(_polygons[polygon_idx].fence_type) ? 1 : _polygons[polygon_idx].vertex_count;
+	}
+
+	if (num_vertices == 0) {
+		return;
+	}
+
+	_vertices = new Vertex[num_vertices];
+
+	if (!_vertices) {
+		PX4_ERR("alloc failed");
+		return;
+	}
+
+	_num_vertices = num_vertices;
+
+	DatamanCache &dataman_cache = _navigator->get_dataman_cache();
+	bool reference_set = false;
+	int vertex_index = 0;
+
+	for (int polygon_idx = 0; polygon_idx < _num_polygons; ++polygon_idx) {
+		PolygonInfo &polygon = _polygons[polygon_idx];
+		const bool is_circle = isCircle(polygon.fence_type);
+		const int count = is_circle ? 1 : polygon.vertex_count;
+
+		polygon.vertex_index = vertex_index;
+		polygon.valid = true;
+
+		for (int i = 0; i < count; ++i) {
+			mission_fence_point_s fence_point;
+
+			if (dataman_cache.read(DM_KEY_FENCE_POINTS, polygon.dataman_index + i, &fence_point,
+					       sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
+				PX4_ERR("dm_read failed");
+				polygon.valid = false;
+				break;
+			}
+
+			if (fence_point.frame != NAV_FRAME_GLOBAL && fence_point.frame != NAV_FRAME_GLOBAL_INT
+			    && fence_point.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT
+			    && fence_point.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
+				// TODO: handle different frames
+				PX4_ERR("Frame type %i not supported", (int)fence_point.frame);
+				polygon.valid = false;
+				break;
+			}
+
+			if (!reference_set) {
+				map_projection_init(&_projection_reference, fence_point.lat, fence_point.lon);
+				reference_set = true;
+			}
+
+			Vertex &vertex = _vertices[vertex_index + i];
+			map_projection_project(&_projection_reference, fence_point.lat, fence_point.lon, &vertex.x, &vertex.y);
+		}
+
+		vertex_index += count;
+
+		if (polygon.valid && !is_circle) {
+			buildEdgeIndex(polygon);
+		}
+	}
+}
+
+void Geofence::buildEdgeIndex(PolygonInfo &polygon)
+{
+	const Vertex *vertices = &_vertices[polygon.vertex_index];
+	const int vertex_count = polygon.vertex_count;
+
+	polygon.min_x = polygon.max_x = vertices[0].x;
+	polygon.min_y = polygon.max_y = vertices[0].y;
+
+	for (int i = 1; i < vertex_count; ++i) {
+		polygon.min_x = math::min(polygon.min_x, vertices[i].x);
+		polygon.max_x = math::max(polygon.max_x, vertices[i].x);
+		polygon.min_y = math::min(polygon.min_y, vertices[i].y);
+		polygon.max_y = math::max(polygon.max_y, vertices[i].y);
+	}
+
+	const float height = polygon.max_y - polygon.min_y;
+
+	if (height < FLT_EPSILON) {
+		// degenerate polygon, use the linear search
+		return;
+	}
+
+	// count the index entries: an edge is added to every slab its y range overlaps.
+	// If there are many long edges, reduce the number of slabs to bound the memory usage.
+	int num_slabs = math::constrain(vertex_count / 4, 1, MAX_SLABS_PER_POLYGON);
+	float slab_width;
+	int num_entries;
+
+	while (true) {
+		slab_width = height / num_slabs;
+		num_entries = 0;
+
+		for (int i = 0, j = vertex_count - 1; i < vertex_count; j = i++) {
+			const int first_slab = slabIndex(polygon.min_y, slab_width, num_slabs, math::min(vertices[i].y, vertices[j].y));
+			const int last_slab = slabIndex(polygon.min_y, slab_width, num_slabs, math::max(vertices[i].y, vertices[j].y));
+			num_entries += last_slab - first_slab + 1;
+		}
+
+		if (num_slabs == 1 || num_entries <= MAX_SLAB_EDGES_PER_VERTEX * vertex_count) {
+			break;
+		}
+
+		num_slabs /= 2;
+	}
+
+	if (num_slabs == 1) {
+		// the bounding box check followed by the linear search is as good
+		return;
+	}
+
+	uint16_t *slab_offsets = new uint16_t[num_slabs + 1];
+	uint16_t *slab_edges = new uint16_t[num_entries];
+
+	if (!slab_offsets || !slab_edges) {
+		delete[] slab_offsets;
+		delete[] slab_edges;
+		PX4_ERR("alloc failed");
+		return;
+	}
+
+	// counting sort of the edges into the slabs (slab_offsets[k + 1] counts the entries of slab k first)
+	memset(slab_offsets, 0, sizeof(uint16_t) * (num_slabs + 1));
+
+	for (int i = 0, j = vertex_count - 1; i < vertex_count; j = i++) {
+		const int first_slab = slabIndex(polygon.min_y, slab_width, num_slabs, math::min(vertices[i].y, vertices[j].y));
+		const int last_slab = slabIndex(polygon.min_y, slab_width, num_slabs, math::max(vertices[i].y, vertices[j].y));
+
+		for (int k = first_slab; k <= last_slab; ++k) {
+			++slab_offsets[k + 1];
+		}
+	}
+
+	for (int k = 0; k < num_slabs; ++k) {
+		slab_offsets[k + 1] += slab_offsets[k];
+	}
+
+	for (int i = 0, j = vertex_count - 1; i < vertex_count; j = i++) {
+		const int first_slab = slabIndex(polygon.min_y, slab_width, num_slabs, math::min(vertices[i].y, vertices[j].y));
+		const int last_slab = slabIndex(polygon.min_y, slab_width, num_slabs, math::max(vertices[i].y, vertices[j].y));
+
+		for (int k = first_slab; k <= last_slab; ++k) {
+			// slab_offsets[k] is used as insertion cursor and is restored below
+			slab_edges[slab_offsets[k]++] = i;
+		}
+	}
+
+	for (int k = num_slabs; k > 0; --k) {
+		slab_offsets[k] = slab_offsets[k - 1];
+	}
+
+	slab_offsets[0] = 0;
+
+	polygon.num_slabs = num_slabs;
+	polygon.slab_width = slab_width;
+	polygon.slab_offsets = slab_offsets;
+	polygon.slab_edges = slab_edges;
+}
+
+void Geofence::freeVertices()
+{
+	for (int polygon_idx = 0; polygon_idx < _num_polygons; ++polygon_idx) {
+		delete[] _polygons[polygon_idx].slab_offsets;
+		delete[] _polygons[polygon_idx].slab_edges;
+		_polygons[polygon_idx].slab_offsets = nullptr;
+		_polygons[polygon_idx].slab_edges = nullptr;
+		_polygons[polygon_idx].num_slabs = 0;
+	}
+
+	delete[] _vertices;
+	_vertices = nullptr;
+	_num_vertices = 0;
 }
 
 bool Geofence::checkAll(const struct vehicle_global_position_s &global_position)
@@ -280,22 +480,24 @@ bool Geofence::checkAll(double lat, double lon, float altitude)
 
 bool Geofence::checkPolygons(double lat, double lon, float altitude)
 {
-	// the following uses dm_read, so first we try to lock all items. If that fails, it (most likely) means
-	// the data is currently being updated (via a mavlink geofence transfer), and we do not check for a violation now
+	// the fence is cached in RAM, but we check with dataman if it got updated. So first we try to lock all items.
+	// If that fails, it (most likely) means the data is currently being updated (via a mavlink geofence transfer),
+	// and we do not check for a violation now
 	if (dm_trylock(DM_KEY_FENCE_POINTS) != 0) {
 		return true;
 	}
 
 	// we got the lock, now check if the fence data got updated
 	mission_stats_entry_s stats;
-	int ret = dm_read(DM_KEY_FENCE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
+	int ret = _navigator->get_dataman_cache().read(DM_KEY_FENCE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
 
 	if (ret == sizeof(mission_stats_entry_s) && _update_counter != stats.update_counter) {
 		_updateFence();
 	}
 
+	dm_unlock(DM_KEY_FENCE_POINTS);
+
 	if (isEmpty()) {
-		dm_unlock(DM_KEY_FENCE_POINTS);
 		/* Empty fence -> accept all points */
 		return true;
 	}
@@ -303,11 +505,16 @@ bool Geofence::checkPolygons(double lat, double lon, float altitude)
 	/* Vertical check */
 	if (_altitude_max > _altitude_min) { // only enable vertical check if configured properly
 		if (altitude > _altitude_max || altitude < _altitude_min) {
-			dm_unlock(DM_KEY_FENCE_POINTS);
 			return false;
 		}
 	}
 
+	float x = 0.f;
+	float y = 0.f;
+
+	if (_num_vertices > 0) {
+		map_projection_project(&_projection_reference, lat, lon, &x, &y);
+	}
 
 	/* Horizontal check: iterate all polygons & circles */
 	bool outside_exclusion = true;
@@ -316,7 +523,7 @@ bool Geofence::checkPolygons(double lat, double lon, float altitude)
 
 	for (int polygon_idx = 0; polygon_idx < _num_polygons; ++polygon_idx) {
 		if (_polygons[polygon_idx].fence_type == NAV_CMD_FENCE_CIRCLE_INCLUSION) {
-			bool inside = insideCircle(_polygons[polygon_idx], lat, lon, altitude);
+			bool inside = insideCircle(_polygons[polygon_idx], x, y);
 
 			if (inside) {
 				inside_inclusion = true;
@@ -325,14 +532,14 @@ bool Geofence::checkPolygons(double lat, double lon, float altitude)
 			had_inclusion_areas = true;
 
 		} else if (_polygons[polygon_idx].fence_type == NAV_CMD_FENCE_CIRCLE_EXCLUSION) {
-			bool inside = insideCircle(_polygons[polygon_idx], lat, lon, altitude);
+			bool inside = insideCircle(_polygons[polygon_idx], x, y);
 
 			if (inside) {
 				outside_exclusion = false;
 			}
 
 		} else { // it's a polygon
-			bool inside = insidePolygon(_polygons[polygon_idx], lat, lon, altitude);
+			bool inside = insidePolygon(_polygons[polygon_idx], x, y);
 
 			if (_polygons[polygon_idx].fence_type == NAV_CMD_FENCE_POLYGON_VERTEX_INCLUSION) {
 				if (inside) {
@@ -349,81 +556,71 @@ bool Geofence::checkPolygons(double lat, double lon, float altitude)
 		}
 	}
 
-	dm_unlock(DM_KEY_FENCE_POINTS);
-
 	return (!had_inclusion_areas || inside_inclusion) && outside_exclusion;
 }
 
-bool Geofence::insidePolygon(const PolygonInfo &polygon, double lat, double lon, float altitude)
+bool Geofence::insidePolygon(const PolygonInfo &polygon, float x, float y)
 {
+	if (!polygon.valid || _vertices == nullptr) {
+		return false;
+	}
+
+	if (x < polygon.min_x || x > polygon.max_x || y < polygon.min_y || y > polygon.max_y) {
+		return false;
+	}
 
 	/* Adaptation of algorithm originally presented as
 	 * PNPOLY - Point Inclusion in Polygon Test
 	 * W. Randolph Franklin (WRF)
 	 * Only supports non-complex polygons (not self intersecting)
+	 *
+	 * Only edges whose y range contains y can be crossed, so if there is an edge index
+	 * only the edges of the slab containing y need to be tested.
 	 */
 
-	mission_fence_point_s temp_vertex_i;
-	mission_fence_point_s temp_vertex_j;
+	const Vertex *vertices = &_vertices[polygon.vertex_index];
+	const int vertex_count = polygon.vertex_count;
+
+	const auto crosses = [vertices, x, y](int i, int j) {
+		return ((vertices[i].y >= y) != (vertices[j].y >= y)) &&
+		       (x <= (vertices[j].x - vertices[i].x) * (y - vertices[i].y) / (vertices[j].y - vertices[i].y) + vertices[i].x);
+	};
+
 	bool c = false;
 
-	for (unsigned i = 0, j = polygon.vertex_count - 1; i < polygon.vertex_count; j = i++) {
-		if (dm_read(DM_KEY_FENCE_POINTS, polygon.dataman_index + i, &temp_vertex_i,
-			    sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
-			break;
-		}
+	if (polygon.num_slabs > 0) {
+		const int slab = slabIndex(polygon.min_y, polygon.slab_width, polygon.num_slabs, y);
 
-		if (dm_read(DM_KEY_FENCE_POINTS, polygon.dataman_index + j, &temp_vertex_j,
-			    sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
-			break;
-		}
+		for (int k = polygon.slab_offsets[slab]; k < polygon.slab_offsets[slab + 1]; ++k) {
+			const int i = polygon.slab_edges[k];
+			const int j = (i == 0) ? vertex_count - 1 : i - 1;
 
-		if (temp_vertex_i.frame != NAV_FRAME_GLOBAL && temp_vertex_i.frame != NAV_FRAME_GLOBAL_INT
-		    && temp_vertex_i.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT
-		    && temp_vertex_i.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
-			// TODO: handle different frames
-			PX4_ERR("Frame type %i not supported", (int)temp_vertex_i.frame);
-			break;
+			if (crosses(i, j)) {
+				c = !c;
+			}
 		}
 
-		if (((double)temp_vertex_i.lon >= lon) != ((double)temp_vertex_j.lon >= lon) &&
-		    (lat <= (double)(temp_vertex_j.lat - temp_vertex_i.lat) * (lon - (double)temp_vertex_i.lon) /
-		     (double)(temp_vertex_j.lon - temp_vertex_i.lon) + (double)temp_vertex_i.lat)) {
-			c = !c;
+	} else {
+		for (int i = 0, j = vertex_count - 1; i < vertex_count; j = i++) {
+			if (crosses(i, j)) {
+				c = !c;
+			}
 		}
 	}
 
 	return c;
 }
 
-bool Geofence::insideCircle(const PolygonInfo &polygon, double lat, double lon, float altitude)
+bool Geofence::insideCircle(const PolygonInfo &polygon, float x, float y)
 {
-
-	mission_fence_point_s circle_point;
-
-	if (dm_read(DM_KEY_FENCE_POINTS, polygon.dataman_index, &circle_point,
-		    sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
-		PX4_ERR("dm_read failed");
+	if (!polygon.valid || _vertices == nullptr) {
 		return false;
 	}
 
-	if (circle_point.frame != NAV_FRAME_GLOBAL && circle_point.frame != NAV_FRAME_GLOBAL_INT
-	    && circle_point.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT
-	    && circle_point.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
-		// TODO: handle different frames
-		PX4_ERR("Frame type %i not supported", (int)circle_point.frame);
-		return false;
-	}
-
-	if (!map_projection_initialized(&_projection_reference)) {
-		map_projection_init(&_projection_reference, lat, lon);
-	}
-
-	float x1, y1, x2, y2;
-	map_projection_project(&_projection_reference, lat, lon, &x1, &y1);
-	map_projection_project(&_projection_reference, circle_point.lat, circle_point.lon, &x2, &y2);
-	float dx = x1 - x2, dy = y1 - y2;
-	return dx * dx + dy * dy < circle_point.circle_radius * circle_point.circle_radius;
+	const Vertex &center = _vertices[polygon.vertex_index];
+	const float dx = x - center.x;
+	const float dy = y - center.y;
+	return dx * dx + dy * dy < polygon.circle_radius * polygon.circle_radius;
 }
 
 bool
@@ -441,6 +638,7 @@ Geofence::loadFromFile(const char *filename)
 	bool		gotVertical = false;
 	const char commentChar = '#';
 	int rc = PX4_ERROR;
+	DatamanCache &dataman_cache = _navigator->get_dataman_cache();
 
 	/* Make sure no data is left in the datamanager */
 	clearDm();
@@ -505,8 +703,8 @@ Geofence::loadFromFile(const char *filename)
 				}
 			}
 
-			if (dm_write(DM_KEY_FENCE_POINTS, pointCounter + 1, DM_PERSIST_POWER_ON_RESET, &vertex,
-				     sizeof(vertex)) != sizeof(vertex)) {
+			if (dataman_cache.write(DM_KEY_FENCE_POINTS, pointCounter + 1, DM_PERSIST_POWER_ON_RESET, &vertex,
+						sizeof(vertex)) != sizeof(vertex)) {
 				goto error;
 			}
 
@@ -535,17 +733,17 @@ Geofence::loadFromFile(const char *filename)
 		for (int seq = 1; seq <= pointCounter; ++seq) {
 			mission_fence_point_s mission_fence_point;
 
-			if (dm_read(DM_KEY_FENCE_POINTS, seq, &mission_fence_point, sizeof(mission_fence_point_s)) ==
+			if (dataman_cache.read(DM_KEY_FENCE_POINTS, seq, &mission_fence_point, sizeof(mission_fence_point_s)) ==
 			    sizeof(mission_fence_point_s)) {
 				mission_fence_point.vertex_count = pointCounter;
-				dm_write(DM_KEY_FENCE_POINTS, seq, DM_PERSIST_POWER_ON_RESET, &mission_fence_point,
-					 sizeof(mission_fence_point_s));
+				dataman_cache.write(DM_KEY_FENCE_POINTS, seq, DM_PERSIST_POWER_ON_RESET, &mission_fence_point,
+						    sizeof(mission_fence_point_s));
 			}
 		}
 
 		mission_stats_entry_s stats;
 		stats.num_items = pointCounter;
-		rc = dm_write(DM_KEY_FENCE_POINTS, 0, DM_PERSIST_POWER_ON_RESET, &stats, sizeof(mission_stats_entry_s));
+		rc = dataman_cache.write(DM_KEY_FENCE_POINTS, 0, DM_PERSIST_POWER_ON_RESET, &stats, sizeof(mission_stats_entry_s));
 
 	} else {
 		PX4_ERR("Geofence: import error");
@@ -561,7 +759,7 @@ error:
 
 int Geofence::clearDm()
 {
-	dm_clear(DM_KEY_FENCE_POINTS);
+	_navigator->get_dataman_cache().clear(DM_KEY_FENCE_POINTS);
 	updateFence();
 	return PX4_OK;
 }
@@ -603,4 +801,5 @@ void Geofence::printStatus()
 	PX4_INFO("Geofence: %i inclusion, %i exclusion polygons, %i inclusion, %i exclusion circles, %i total vertices",
 		 num_inclusion_polygons, num_exclusion_polygons, num_inclusion_circles, num_exclusion_circles,
 		 total_num_vertices);
+	PX4_INFO("Geofence: %i cached vertices", _num_vertices);
 }
@@ -151,12 +151,33 @@ private:
 			uint16_t vertex_count;
 			float circle_radius;
 		};
+		uint16_t vertex_index; ///< index of the first vertex (or circle center) in _vertices
+		bool valid; ///< false if the vertices could not be loaded
+		float min_x, max_x, min_y, max_y; ///< bounding box in the local frame [m]
+
+		/** edge index: the y range of the bounding box is split into num_slabs slabs of equal width,
+		 * and slab k contains the edges slab_edges[slab_offsets[k]] ... slab_edges[slab_offsets[k + 1] - 1]
+		 * whose y range overlaps with the slab. */
+		uint16_t num_slabs;
+		float slab_width;
+		uint16_t *slab_offsets;
+		uint16_t *slab_edges;
 	};
 	PolygonInfo *_polygons{nullptr};
 	int _num_polygons{0};
 
+	struct Vertex {
+		float x; ///< local north [m]
+		float y; ///< local east [m]
+	};
+	Vertex *_vertices{nullptr}; ///< in-RAM copy of all polygon vertices and circle centers
+	int _num_vertices{0};
+
 	map_projection_reference_s _projection_reference = {}; ///< reference to convert (lon, lat) to local [m]
 
+	static constexpr int MAX_SLABS_PER_POLYGON = 32;
+	static constexpr int MAX_SLAB_EDGES_PER_VERTEX = 8; ///< limits the memory used by the edge index
+
 	DEFINE_PARAMETERS(
 		(ParamInt<px4::params::GF_ACTION>) _param_gf_action,
 		(ParamInt<px4::params::GF_ALTMODE>) _param_gf_altmode,
@@ -176,6 +197,23 @@ private:
 	 */
 	void _updateFence();
 
+	/**
+	 * Read the vertices of all polygons and circles from dataman into _vertices, and build the
+	 * bounding boxes and edge indexes. Called from _updateFence(), so the fence is only read from
+	 * dataman when it changed.
+	 */
+	void loadVertices();
+
+	/**
+	 * Build the edge index of a polygon with loaded vertices
+	 */
+	void buildEdgeIndex(PolygonInfo &polygon);
+
+	/**
+	 * Free _vertices and the per-polygon edge indexes
+	 */
+	void freeVertices();
+
 	/**
 	 * Check if a point passes the Geofence test.
 	 * This takes all polygons and minimum & maximum altitude into account
@@ -201,14 +239,16 @@ private:
 
 	/**
 	 * Check if a single point is within a polygon
+	 * @param x, y point in the local frame of _projection_reference [m]
 	 * @return true if within polygon
 	 */
-	bool insidePolygon(const PolygonInfo &polygon, double lat, double lon, float altitude);
+	bool insidePolygon(const PolygonInfo &polygon, float x, float y);
 
 	/**
 	 * Check if a single point is within a circle
 	 * @param polygon must be a circle!
+	 * @param x, y point in the local frame of _projection_reference [m]
 	 * @return true if within polygon the circle
 	 */
-	bool insideCircle(const PolygonInfo &polygon, double lat, double lon, float altitude);
+	bool insideCircle(const PolygonInfo &polygon, float x, float y);
 };
@@ -67,7 +67,18 @@ public:
 	MissionBlock(const MissionBlock &) = delete;
 	MissionBlock &operator=(const MissionBlock &) = delete;
 
-	static bool item_contains_position(const mission_item_s &item);
+	static bool item_contains_position(const mission_item_s &item)
+	{
+		return item.nav_cmd == NAV_CMD_WAYPOINT ||
+		       item.nav_cmd == NAV_CMD_LOITER_UNLIMITED ||
+		       item.nav_cmd == NAV_CMD_LOITER_TIME_LIMIT ||
+		       item.nav_cmd == NAV_CMD_LAND ||
+		       item.nav_cmd == NAV_CMD_TAKEOFF ||
+		       item.nav_cmd == NAV_CMD_LOITER_TO_ALT ||
+		       item.nav_cmd == NAV_CMD_VTOL_TAKEOFF ||
+		       item.nav_cmd == NAV_CMD_VTOL_LAND ||
+		       item.nav_cmd == NAV_CMD_DO_FOLLOW_REPOSITION;
+	}
 
 protected:
 	/**
@@ -42,6 +42,8 @@
 
 #pragma once
 
+#include "MissionFeasibility/MissionItemChecks.hpp"
+
 #include <dataman/dataman.h>
 #include <uORB/topics/mission.h>
 
@@ -51,30 +53,48 @@ class Navigator;
 class MissionFeasibilityChecker
 {
 private:
-	Navigator *_navigator{nullptr};
+	/* the navigator geofence, for the GeofenceCheck */
+	class NavigatorGeofence : public MissionGeofence
+	{
+	public:
+		explicit NavigatorGeofence(Geofence &geofence) : _geofence(geofence) {}
+
+		bool check(const mission_item_s &item) override;
 
-	/* Checks for all airframes */
-	bool checkGeofence(const mission_s &mission, float home_alt, bool home_valid);
+	private:
+		Geofence &_geofence;
+	};
 
-	bool checkHomePositionAltitude(const mission_s &mission, float home_alt, bool home_alt_valid, bool throw_error);
+	/* the context and the checks of one pass over the mission */
+	struct Checks {
+		Checks(Geofence &geofence, bool home_valid, float max_distance_to_1st_waypoint,
+		       float max_distance_between_waypoints, bool land_start_req);
 
-	bool checkMissionItemValidity(const mission_s &mission);
+		MissionCheckContext context{};
+		NavigatorGeofence navigator_geofence;
 
-	bool checkDistanceToFirstWaypoint(const mission_s &mission, float max_distance);
-	bool checkDistancesBetweenWaypoints(const mission_s &mission, float max_distance);
+		DistanceToFirstWaypointCheck first_waypoint_check;
+		MissionItemValidityCheck validity_check;
+		DistancesBetweenWaypointsCheck waypoint_distances_check;
+		GeofenceCheck geofence_check;
+		HomePositionAltitudeCheck home_altitude_check;
+		TakeoffCheck takeoff_check;
+		FixedWingLandingCheck fixed_wing_landing_check;
+		VTOLLandingCheck vtol_landing_check;
 
-	bool checkTakeoff(const mission_s &mission, float home_alt);
+		MissionItemChecks checks;
+	};
 
-	/* Checks specific to fixedwing airframes */
-	bool checkFixedwing(const mission_s &mission, float home_alt, bool land_start_req);
-	bool checkFixedWingLanding(const mission_s &mission, bool land_start_req);
+	/* items read from dataman in one request, for the part of the mission that is not cached */
+	static constexpr unsigned ITEMS_PER_READ = 4;
+
+	Navigator *_navigator{nullptr};
 
-	/* Checks specific to rotarywing airframes */
-	bool checkRotarywing(const mission_s &mission, float home_alt);
+	/* read buffer of checkItems(), not on the stack of the navigator task */
+	mission_item_s _items[ITEMS_PER_READ] {};
 
-	/* Checks specific to VTOL airframes */
-	bool checkVTOL(const mission_s &mission, float home_alt, bool land_start_req);
-	bool checkVTOLLanding(const mission_s &mission, bool land_start_req);
+	/* Reads the mission once and feeds every item to the checks */
+	bool checkItems(const mission_s &mission, MissionItemChecks &checks);
 
 public:
 	MissionFeasibilityChecker(Navigator *navigator) : _navigator(navigator) {}
@@ -41,6 +41,7 @@
 
 #pragma once
 
+#include "dataman_cache.h"
 #include "datalinkloss.h"
 #include "enginefailure.h"
 #include "follow_target.h"
@@ -168,6 +169,8 @@ public:
 
 	Geofence	&get_geofence() { return _geofence; }
 
+	DatamanCache	&get_dataman_cache() { return _dataman_cache; }
+
 	bool		get_can_loiter_at_sp() { return _can_loiter_at_sp; }
 	float		get_loiter_radius() { return _param_nav_loiter_rad.get(); }
 
@@ -367,6 +370,8 @@ private:
 
 	perf_counter_t	_loop_perf;			/**< loop performance counter */
 
+	DatamanCache	_dataman_cache;			/**< mission, fence and safe point items, must be constructed before the users */
+
 	Geofence	_geofence;			/**< class that handles the geofence */
 	bool		_geofence_violation_warning_sent{false}; /**< prevents spaming to mavlink */
 
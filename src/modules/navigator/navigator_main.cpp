@@ -740,6 +740,7 @@ Navigator::print_status()
 	PX4_INFO("Running");
 
 	_geofence.printStatus();
+	_dataman_cache.print_status();
 	return 0;
 }
 
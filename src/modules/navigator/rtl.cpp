@@ -107,12 +107,14 @@ RTL::find_RTL_destination()
 
 	// compare to safe landing positions
 	mission_safe_point_s closest_safe_point {} ;
+	DatamanCache &dataman_cache = _navigator->get_dataman_cache();
 	mission_stats_entry_s stats;
-	int ret = dm_read(DM_KEY_SAFE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
+	int ret = dataman_cache.read(DM_KEY_SAFE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
 	int num_safe_points = 0;
 
 	if (ret == sizeof(mission_stats_entry_s)) {
 		num_safe_points = stats.num_items;
+		dataman_cache.load(DM_KEY_SAFE_POINTS, num_safe_points + 1);
 	}
 
 	// check if a safe point is closer than home or landing
@@ -121,7 +123,7 @@ RTL::find_RTL_destination()
 	for (int current_seq = 1; current_seq <= num_safe_points; ++current_seq) {
 		mission_safe_point_s mission_safe_point;
 
-		if (dm_read(DM_KEY_SAFE_POINTS, current_seq, &mission_safe_point, sizeof(mission_safe_point_s)) !=
+		if (dataman_cache.read(DM_KEY_SAFE_POINTS, current_seq, &mission_safe_point, sizeof(mission_safe_point_s)) !=
 		    sizeof(mission_safe_point_s)) {
 			PX4_ERR("dm_read failed");
 			continue;
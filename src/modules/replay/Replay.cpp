@@ -49,6 +49,7 @@
 #include <lib/parameters/param.h>
 
 #include <cstring>
+#include <cinttypes>
 #include <float.h>
 #include <fstream>
 #include <iostream>
@@ -63,10 +64,12 @@
 
 #include "Replay.hpp"
 #include "ReplayEkf2.hpp"
+#include "ReplayFile.hpp"
 
 #define PARAMS_OVERRIDE_FILE PX4_ROOTFSDIR "/replay_params.txt"
 
 using namespace std;
+using namespace time_literals;
 
 namespace px4
 {
@@ -167,7 +170,7 @@ Replay::setUserParams(const char *filename)
 }
 
 bool
-Replay::readFileHeader(std::ifstream &file)
+Replay::readFileHeader(std::istream &file)
 {
 	file.seekg(0);
 	ulog_file_header_s msg_header;
@@ -191,7 +194,7 @@ Replay::readFileHeader(std::ifstream &file)
 }
 
 bool
-Replay::readFileDefinitions(std::ifstream &file)
+Replay::readFileDefinitions(std::istream &file)
 {
 	PX4_INFO("Applying params from ULog file...");
 
@@ -248,7 +251,7 @@ Replay::readFileDefinitions(std::ifstream &file)
 }
 
 bool
-Replay::readFlagBits(std::ifstream &file, uint16_t msg_size)
+Replay::readFlagBits(std::istream &file, uint16_t msg_size)
 {
 	if (msg_size != 40) {
 		PX4_ERR("unsupported message length for FLAG_BITS message (%i)", msg_size);
@@ -295,7 +298,7 @@ Replay::readFlagBits(std::ifstream &file, uint16_t msg_size)
 }
 
 bool
-Replay::readFormat(std::ifstream &file, uint16_t msg_size)
+Replay::readFormat(std::istream &file, uint16_t msg_size)
 {
 	_read_buffer.reserve(msg_size + 1);
 	char *format = (char *)_read_buffer.data();
@@ -320,33 +323,22 @@ Replay::readFormat(std::ifstream &file, uint16_t msg_size)
 	return true;
 }
 
-bool
-Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
+void
+Replay::addSubscription(const uint8_t *message, uint16_t msg_size)
 {
-	_read_buffer.reserve(msg_size + 1);
-	char *message = (char *)_read_buffer.data();
-	streampos this_message_pos = file.tellg() - (streamoff)ULOG_MSG_HEADER_LEN;
-	file.read(message, msg_size);
-	message[msg_size] = 0;
-
-	if (!file) {
-		return false;
-	}
-
-	if (file.tellg() <= _subscription_file_pos) { //already read this subscription
-		return true;
+	if (msg_size < 4) {
+		PX4_ERR("ADD_LOGGED_MSG message too short (%i)", msg_size);
+		return;
 	}
 
-	_subscription_file_pos = file.tellg();
-
-	uint8_t multi_id = *(uint8_t *)message;
+	uint8_t multi_id = message[0];
 	uint16_t msg_id = ((uint16_t) message[1]) | (((uint16_t) message[2]) << 8);
-	string topic_name(message + 3);
+	string topic_name((const char *)message + 3, msg_size - 3);
 	const orb_metadata *orb_meta = findTopic(topic_name);
 
 	if (!orb_meta) {
 		PX4_WARN("Topic %s not found internally. Will ignore it", topic_name.c_str());
-		return true;
+		return;
 	}
 
 	CompatBase *compat = nullptr;
@@ -386,42 +378,31 @@ Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
 			PX4_WARN("Formats for %s don't match. Will ignore it.", topic_name.c_str());
 			PX4_WARN(" Internal format: %s", orb_meta->o_fields);
 			PX4_WARN(" File format    : %s", file_format.c_str());
-			return true; // not a fatal error
+			return; // not a fatal error
 		}
 	}
 
-	Subscription *subscription = new Subscription();
-	subscription->orb_meta = orb_meta;
-	subscription->multi_id = multi_id;
-	subscription->compat = compat;
-
 	//find the timestamp offset
+	int timestamp_offset;
 	int field_size;
-	bool timestamp_found = findFieldOffset(orb_meta->o_fields, "timestamp", subscription->timestamp_offset, field_size);
+	bool timestamp_found = findFieldOffset(orb_meta->o_fields, "timestamp", timestamp_offset, field_size);
 
 	if (!timestamp_found) {
-		return true;
+		delete compat;
+		return;
 	}
 
 	if (field_size != 8) {
 		PX4_ERR("Unsupported timestamp with size %i, ignoring the topic %s", field_size, orb_meta->o_name);
-		return true;
-	}
-
-	//find first data message (and the timestamp)
-	streampos cur_pos = file.tellg();
-	subscription->next_read_pos = this_message_pos; //this will be skipped
-
-	if (!nextDataMessage(file, *subscription, msg_id)) {
-		return false;
+		delete compat;
+		return;
 	}
 
-	file.seekg(cur_pos);
-
-	if (!subscription->orb_meta) {
-		//no message found. This is not a fatal error
-		return true;
-	}
+	Subscription *subscription = new Subscription();
+	subscription->orb_meta = orb_meta;
+	subscription->multi_id = multi_id;
+	subscription->compat = compat;
+	subscription->timestamp_offset = timestamp_offset;
 
 	PX4_DEBUG("adding subscription for %s (msg_id %i)", subscription->orb_meta->o_name, msg_id);
 
@@ -430,11 +411,123 @@ Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
 		_subscriptions.resize(msg_id + 1);
 	}
 
+	if (_subscriptions[msg_id]) {
+		PX4_ERR("duplicate subscription for msg_id %i, ignoring %s", msg_id, topic_name.c_str());
+		delete compat;
+		delete subscription;
+		return;
+	}
+
 	_subscriptions[msg_id] = subscription;
+}
 
-	onSubscriptionAdded(*_subscriptions[msg_id], msg_id);
+bool
+Replay::buildIndex()
+{
+	const hrt_abstime index_start = hrt_absolute_time();
+	const uint8_t *data = _log_file.data();
+	const uint64_t end = _log_file.size() < _read_until_file_position ? _log_file.size() : _read_until_file_position;
+	uint64_t offset = _data_section_start;
 
-	return true;
+	_num_log_messages = 0;
+	_additional_messages.clear();
+	_next_additional_message = 0;
+
+	while (offset + ULOG_MSG_HEADER_LEN <= end) {
+		ulog_message_header_s message_header;
+		memcpy(&message_header, data + offset, ULOG_MSG_HEADER_LEN);
+
+		if (offset + ULOG_MSG_HEADER_LEN + message_header.msg_size > end) {
+			break; // incomplete message at the end of the log
+		}
+
+		const uint8_t *message = data + offset + ULOG_MSG_HEADER_LEN;
+
+		switch (message_header.msg_type) {
+		case (int)ULogMessageType::ADD_LOGGED_MSG:
+			addSubscription(message, message_header.msg_size);
+			break;
+
+		case (int)ULogMessageType::DATA: {
+				if (message_header.msg_size < sizeof(uint16_t)) {
+					break;
+				}
+
+				uint16_t msg_id;
+				memcpy(&msg_id, message, sizeof(msg_id));
+
+				if (msg_id >= _subscriptions.size() || !_subscriptions[msg_id]) {
+					break; // not subscribed
+				}
+
+				Subscription &sub = *_subscriptions[msg_id];
+
+				if (message_header.msg_size == sub.orb_meta->o_size_no_padding + 2) {
+					Subscription::IndexEntry entry;
+					memcpy(&entry.timestamp, message + 2 + sub.timestamp_offset, sizeof(entry.timestamp));
+					entry.offset = offset;
+					sub.index.push_back(entry);
+
+				} else { //sanity check failed!
+					PX4_ERR("data message %s has wrong size %i (expected %i). Skipping",
+						sub.orb_meta->o_name, message_header.msg_size,
+						sub.orb_meta->o_size_no_padding + 2);
+				}
+			}
+			break;
+
+		case (int)ULogMessageType::PARAMETER:
+		case (int)ULogMessageType::DROPOUT:
+			_additional_messages.push_back(offset);
+			break;
+
+		case (int)ULogMessageType::REMOVE_LOGGED_MSG: //skip these
+		case (int)ULogMessageType::INFO:
+		case (int)ULogMessageType::INFO_MULTIPLE:
+		case (int)ULogMessageType::SYNC:
+		case (int)ULogMessageType::LOGGING:
+			break;
+
+		default:
+			//this really should not happen
+			PX4_ERR("unknown log message type %i, size %i (offset %" PRIu64 ")",
+				(int)message_header.msg_type, (int)message_header.msg_size, offset);
+			break;
+		}
+
+		offset += ULOG_MSG_HEADER_LEN + message_header.msg_size;
+		++_num_log_messages;
+	}
+
+	bool has_data = false;
+
+	for (size_t msg_id = 0; msg_id < _subscriptions.size(); ++msg_id) {
+		Subscription *subscription = _subscriptions[msg_id];
+
+		if (!subscription) {
+			continue;
+		}
+
+		if (subscription->index.empty()) {
+			//no message found. This is not a fatal error
+			delete subscription->compat;
+			delete subscription;
+			_subscriptions[msg_id] = nullptr;
+			continue;
+		}
+
+		subscription->next_index = 0;
+		subscription->next_read_pos = subscription->index[0].offset;
+		subscription->next_timestamp = subscription->index[0].timestamp;
+		has_data = true;
+
+		onSubscriptionAdded(*subscription, msg_id);
+	}
+
+	PX4_INFO("Indexed %u messages (%.1f MB) in %.3f s", _num_log_messages,
+		 (double)(offset - _data_section_start) / 1.e6, (double)hrt_elapsed_time(&index_start) / 1.e6);
+
+	return has_data;
 }
 
 bool
@@ -468,41 +561,31 @@ Replay::findFieldOffset(const string &format, const string &field_name, int &off
 	return false;
 }
 
-bool
-Replay::readAndHandleAdditionalMessages(std::ifstream &file, std::streampos end_position)
+void
+Replay::handleAdditionalMessages(uint64_t end_offset)
 {
 	ulog_message_header_s message_header;
 
-	while (file.tellg() < end_position) {
-		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+	while (_next_additional_message < _additional_messages.size()
+	       && _additional_messages[_next_additional_message] < end_offset) {
 
-		if (!file) {
-			return false;
-		}
+		_log_file.seekg(_additional_messages[_next_additional_message]);
+		_log_file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
 
-		switch (message_header.msg_type) {
-		case (int)ULogMessageType::PARAMETER:
-			if (!readAndApplyParameter(file, message_header.msg_size)) {
-				return false;
-			}
-
-			break;
+		if (message_header.msg_type == (int)ULogMessageType::PARAMETER) {
+			readAndApplyParameter(_log_file, message_header.msg_size);
 
-		case (int)ULogMessageType::DROPOUT:
-			readDropout(file, message_header.msg_size);
-			break;
-
-		default: //skip all others
-			file.seekg(message_header.msg_size, ios::cur);
-			break;
+		} else if (message_header.msg_type == (int)ULogMessageType::DROPOUT) {
+			readDropout(_log_file, message_header.msg_size);
 		}
-	}
 
-	return true;
+		_log_file.clear();
+		++_next_additional_message;
+	}
 }
 
 bool
-Replay::readAndApplyParameter(std::ifstream &file, uint16_t msg_size)
+Replay::readAndApplyParameter(std::istream &file, uint16_t msg_size)
 {
 	_read_buffer.reserve(msg_size);
 	uint8_t *message = (uint8_t *)_read_buffer.data();
@@ -544,7 +627,7 @@ Replay::readAndApplyParameter(std::ifstream &file, uint16_t msg_size)
 }
 
 bool
-Replay::readDropout(std::ifstream &file, uint16_t msg_size)
+Replay::readDropout(std::istream &file, uint16_t msg_size)
 {
 	uint16_t duration;
 	file.read((char *)&duration, sizeof(duration));
@@ -554,88 +637,17 @@ Replay::readDropout(std::ifstream &file, uint16_t msg_size)
 }
 
 bool
-Replay::nextDataMessage(std::ifstream &file, Subscription &subscription, int msg_id)
+Replay::nextDataMessage(Subscription &subscription)
 {
-	ulog_message_header_s message_header;
-	file.seekg(subscription.next_read_pos);
-	//ignore the first message (it's data we already read)
-	file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
-
-	if (file) {
-		file.seekg(message_header.msg_size, ios::cur);
-	}
-
-	uint16_t file_msg_id;
-	bool done = false;
-
-	while (file && !done) {
-		streampos cur_pos = file.tellg();
-		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
-
-		if (!file) {
-			break;
-		}
-
-		if (((streamoff)cur_pos) + ULOG_MSG_HEADER_LEN + message_header.msg_size > _read_until_file_position) {
-			file.setstate(std::ios::eofbit);
-			break;
-		}
-
-		switch (message_header.msg_type) {
-		case (int)ULogMessageType::ADD_LOGGED_MSG:
-			readAndAddSubscription(file, message_header.msg_size);
-			break;
-
-		case (int)ULogMessageType::DATA:
-			file.read((char *)&file_msg_id, sizeof(file_msg_id));
-
-			if (file) {
-				if (msg_id == file_msg_id) {
-					if (message_header.msg_size == subscription.orb_meta->o_size_no_padding + 2) {
-						subscription.next_read_pos = cur_pos;
-						file.seekg(subscription.timestamp_offset, ios::cur);
-						file.read((char *)&subscription.next_timestamp, sizeof(subscription.next_timestamp));
-						done = true;
-
-					} else { //sanity check failed!
-						PX4_ERR("data message %s has wrong size %i (expected %i). Skipping",
-							subscription.orb_meta->o_name, message_header.msg_size,
-							subscription.orb_meta->o_size_no_padding + 2);
-						file.seekg(message_header.msg_size - sizeof(file_msg_id), ios::cur);
-					}
-
-				} else { //not the one we are looking for
-					file.seekg(message_header.msg_size - sizeof(file_msg_id), ios::cur);
-				}
-			}
-
-			break;
-
-		case (int)ULogMessageType::REMOVE_LOGGED_MSG: //skip these
-		case (int)ULogMessageType::PARAMETER:
-		case (int)ULogMessageType::DROPOUT:
-		case (int)ULogMessageType::INFO:
-		case (int)ULogMessageType::INFO_MULTIPLE:
-		case (int)ULogMessageType::SYNC:
-		case (int)ULogMessageType::LOGGING:
-			file.seekg(message_header.msg_size, ios::cur);
-			break;
-
-		default:
-			//this really should not happen
-			PX4_ERR("unknown log message type %i, size %i (offset %i)",
-				(int)message_header.msg_type, (int)message_header.msg_size, (int)file.tellg());
-			file.seekg(message_header.msg_size, ios::cur);
-			break;
-		}
-	}
-
-	if (file.eof()) { //no more data messages for this subscription
+	if (++subscription.next_index >= subscription.index.size()) { //no more data messages for this subscription
 		subscription.orb_meta = nullptr;
-		file.clear();
+		return false;
 	}
 
-	return file.good();
+	const Subscription::IndexEntry &entry = subscription.index[subscription.next_index];
+	subscription.next_read_pos = entry.offset;
+	subscription.next_timestamp = entry.timestamp;
+	return true;
 }
 
 const orb_metadata *
@@ -711,7 +723,7 @@ Replay::sizeOfFullType(const std::string &type_name_full)
 }
 
 bool
-Replay::readDefinitionsAndApplyParams(std::ifstream &file)
+Replay::readDefinitionsAndApplyParams(std::istream &file)
 {
 	// log reader currently assumes little endian
 	int num = 1;
@@ -721,7 +733,7 @@ Replay::readDefinitionsAndApplyParams(std::ifstream &file)
 		return false;
 	}
 
-	if (!file.is_open()) {
+	if (!file) {
 		PX4_ERR("Failed to open replay file");
 		return false;
 	}
@@ -744,9 +756,18 @@ Replay::readDefinitionsAndApplyParams(std::ifstream &file)
 void
 Replay::run()
 {
-	ifstream replay_file(_replay_file, ios::in | ios::binary);
+	_log_file.open(_replay_file);
+
+	if (!readDefinitionsAndApplyParams(_log_file)) {
+		return;
+	}
+
+	if (_log_file.compressed()) {
+		PX4_INFO("Replaying compressed log");
+	}
 
-	if (!readDefinitionsAndApplyParams(replay_file)) {
+	if (!buildIndex()) {
+		PX4_ERR("No data to replay");
 		return;
 	}
 
@@ -756,78 +777,102 @@ Replay::run()
 
 	PX4_INFO("Replay in progress...");
 
-	ulog_message_header_s message_header;
-	replay_file.seekg(_data_section_start);
-
-	//we know the next message must be an ADD_LOGGED_MSG
-	replay_file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
-
-	if (!readAndAddSubscription(replay_file, message_header.msg_size)) {
-		PX4_ERR("Failed to read subscription");
-		return;
-	}
-
 	//we update the timestamps from the file by a constant offset to match
 	//the current replay time
 	const uint64_t timestamp_offset = _replay_start_time - _file_start_time;
 	uint32_t nr_published_messages = 0;
-	streampos last_additional_message_pos = _data_section_start;
+	uint64_t first_file_time = 0;
+	uint64_t last_file_time = 0;
+	hrt_abstime last_status_time = _replay_start_time;
+
+	//Messages from different subscriptions don't need to be in chronological order, so they
+	//are merged through a min-heap on (timestamp, msg_id, index entry). A subscription's cursor
+	//can also be advanced outside of the main loop (e.g. in ekf2 replay mode), so stale heap
+	//entries are refreshed when popped.
+	struct HeapEntry {
+		uint64_t timestamp;
+		uint16_t msg_id;
+		size_t index;
+
+		bool operator>(const HeapEntry &other) const
+		{
+			if (timestamp != other.timestamp) {
+				return timestamp > other.timestamp;
+			}
 
-	while (!should_exit() && replay_file) {
+			return msg_id > other.msg_id;
+		}
+	};
 
-		//Find the next message to publish. Messages from different subscriptions don't need
-		//to be in chronological order, so we need to check all subscriptions
-		uint64_t next_file_time = 0;
-		int next_msg_id = -1;
-		bool first_time = true;
+	std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
 
-		for (size_t i = 0; i < _subscriptions.size(); ++i) {
-			const Subscription *subscription = _subscriptions[i];
+	for (size_t i = 0; i < _subscriptions.size(); ++i) {
+		const Subscription *subscription = _subscriptions[i];
 
-			if (!subscription) {
-				continue;
-			}
+		if (subscription && subscription->orb_meta && !subscription->ignored) {
+			heap.push(HeapEntry{subscription->next_timestamp, (uint16_t)i, subscription->next_index});
+		}
+	}
 
-			if (subscription->orb_meta && !subscription->ignored) {
-				if (first_time || subscription->next_timestamp < next_file_time) {
-					first_time = false;
-					next_msg_id = (int)i;
-					next_file_time = subscription->next_timestamp;
-				}
-			}
+	while (!should_exit() && !heap.empty()) {
+
+		const HeapEntry next = heap.top();
+		heap.pop();
+
+		Subscription &sub = *_subscriptions[next.msg_id];
+
+		if (!sub.orb_meta || sub.ignored) {
+			continue; // no more data for this subscription
 		}
 
-		if (next_msg_id == -1) {
-			break; //no active subscription anymore. We're done.
+		if (sub.next_index != next.index) {
+			heap.push(HeapEntry{sub.next_timestamp, next.msg_id, sub.next_index});
+			continue;
 		}
 
-		Subscription &sub = *_subscriptions[next_msg_id];
+		const uint64_t next_file_time = sub.next_timestamp;
 
 		if (next_file_time == 0) {
 			//someone didn't set the timestamp properly. Consider the message invalid
-			nextDataMessage(replay_file, sub, next_msg_id);
+			if (nextDataMessage(sub)) {
+				heap.push(HeapEntry{sub.next_timestamp, next.msg_id, sub.next_index});
+			}
+
 			continue;
 		}
 
 		//handle additional messages between last and next published data
-		replay_file.seekg(last_additional_message_pos);
-		streampos next_additional_message_pos = sub.next_read_pos;
-		readAndHandleAdditionalMessages(replay_file, next_additional_message_pos);
-		last_additional_message_pos = next_additional_message_pos;
+		handleAdditionalMessages(sub.next_read_pos);
 
 		const uint64_t publish_timestamp = handleTopicDelay(next_file_time, timestamp_offset);
 
 		// It's time to publish
-		readTopicDataToBuffer(sub, replay_file);
+		readTopicDataToBuffer(sub);
 		memcpy(_read_buffer.data() + sub.timestamp_offset, &publish_timestamp, sizeof(uint64_t)); //adjust the timestamp
 
-		if (handleTopicUpdate(sub, _read_buffer.data(), replay_file)) {
+		if (handleTopicUpdate(sub, _read_buffer.data())) {
 			++nr_published_messages;
+
+			if (first_file_time == 0) {
+				first_file_time = next_file_time;
+			}
+
+			if (next_file_time > last_file_time) {
+				last_file_time = next_file_time;
+			}
 		}
 
-		nextDataMessage(replay_file, sub, next_msg_id);
+		if (nextDataMessage(sub)) {
+			heap.push(HeapEntry{sub.next_timestamp, next.msg_id, sub.next_index});
+		}
+
+		const hrt_abstime now = hrt_absolute_time();
 
-		// TODO: output status (eg. every sec), including total duration...
+		if (now - last_status_time > 10_s) {
+			PX4_INFO("Replayed %.1f s of log (%u msgs)", (double)(last_file_time - first_file_time) / 1.e6,
+				 nr_published_messages);
+			last_status_time = now;
+		}
 	}
 
 	for (auto &subscription : _subscriptions) {
@@ -847,11 +892,18 @@ Replay::run()
 	}
 
 	if (!should_exit()) {
-		PX4_INFO("Replay done (published %u msgs, %.3lf s)", nr_published_messages,
-			 (double)hrt_elapsed_time(&_replay_start_time) / 1.e6);
+		const double elapsed = (double)hrt_elapsed_time(&_replay_start_time) / 1.e6;
+		const double log_duration = (double)(last_file_time - first_file_time) / 1.e6;
+
+		PX4_INFO("Replay done (published %u msgs, %.3lf s)", nr_published_messages, elapsed);
+
+		if (elapsed > 0.) {
+			PX4_INFO("Throughput: %.0lf msgs/s, realtime factor %.2lf", nr_published_messages / elapsed,
+				 log_duration / elapsed);
+		}
 
 		//TODO: add parameter -q?
-		replay_file.close();
+		_log_file.close();
 		px4_shutdown_request(false, false);
 	}
 
@@ -859,17 +911,17 @@ Replay::run()
 }
 
 void
-Replay::readTopicDataToBuffer(const Subscription &sub, std::ifstream &replay_file)
+Replay::readTopicDataToBuffer(const Subscription &sub)
 {
 	const size_t msg_read_size = sub.orb_meta->o_size_no_padding;
 	const size_t msg_write_size = sub.orb_meta->o_size;
 	_read_buffer.reserve(msg_write_size);
-	replay_file.seekg(sub.next_read_pos + (streamoff)(ULOG_MSG_HEADER_LEN + 2)); //skip header & msg id
-	replay_file.read((char *)_read_buffer.data(), msg_read_size);
+	//decode directly from the mapping, skipping header & msg id
+	memcpy(_read_buffer.data(), _log_file.data() + sub.next_read_pos + ULOG_MSG_HEADER_LEN + 2, msg_read_size);
 }
 
 bool
-Replay::handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file)
+Replay::handleTopicUpdate(Subscription &sub, void *data)
 {
 	return publishTopic(sub, data);
 }
@@ -1002,9 +1054,9 @@ Replay::applyParams(bool quiet)
 		return -ENOMEM;
 	}
 
-	ifstream replay_file(_replay_file, ios::in | ios::binary);
+	r->_log_file.open(_replay_file);
 
-	if (!r->readDefinitionsAndApplyParams(replay_file)) {
+	if (!r->readDefinitionsAndApplyParams(r->_log_file)) {
 		ret = -1;
 	}
 
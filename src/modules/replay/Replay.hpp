@@ -33,13 +33,15 @@
 
 #pragma once
 
-#include <fstream>
+#include <istream>
+#include <queue>
 #include <map>
 #include <vector>
 #include <set>
 #include <string>
 
 #include "definitions.hpp"
+#include "ReplayFile.hpp"
 
 #include <px4_platform_common/module.h>
 #include <uORB/uORBTopics.h>
@@ -51,9 +53,10 @@ namespace px4
 /**
  * @class Replay
  * Parses an ULog file and replays it in 'real-time'. The timestamp of each replayed message is offset
- * to match the starting time of replay. It keeps a stream for each subscription to find the next message
- * to replay. This is necessary because data messages from different subscriptions don't need to be in
- * monotonic increasing order.
+ * to match the starting time of replay. The log is memory mapped and indexed in a single pass, storing
+ * the timestamp and file offset of every data message per subscription. Data messages from different
+ * subscriptions don't need to be in monotonic increasing order, so the subscriptions are merged through
+ * a heap ordered by the timestamp of their next message.
  */
 class Replay : public ModuleBase<Replay>
 {
@@ -134,9 +137,17 @@ protected:
 
 		bool ignored = false; ///< if true, it will not be considered for publication in the main loop
 
-		std::streampos next_read_pos;
+		uint64_t next_read_pos; ///< file offset of the next data message
 		uint64_t next_timestamp; ///< timestamp of the file
 
+		struct IndexEntry {
+			uint64_t timestamp;
+			uint64_t offset;
+		};
+
+		std::vector<IndexEntry> index; ///< all data messages (in file order)
+		size_t next_index = 0; ///< index entry of the next data message
+
 		CompatBase *compat = nullptr;
 
 		// statistics
@@ -189,22 +200,19 @@ protected:
 	 * handle the publication of a topic update
 	 * @return true if published, false otherwise
 	 */
-	virtual bool handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file);
+	virtual bool handleTopicUpdate(Subscription &sub, void *data);
 
 	/**
 	 * read a topic from the file (offset given by the subscription) into _read_buffer
 	 */
-	void readTopicDataToBuffer(const Subscription &sub, std::ifstream &replay_file);
+	void readTopicDataToBuffer(const Subscription &sub);
 
 	/**
-	 * Find next data message for this subscription, starting with the stored file offset.
-	 * Skip the first message, and if found, read the timestamp and store the new file offset.
-	 * This also takes care of new subscriptions and parameter updates. When reaching EOF,
-	 * the subscription is set to invalid.
-	 * File seek position is arbitrary after this call.
-	 * @return false on file error
+	 * Advance the subscription to its next data message (next_read_pos & next_timestamp).
+	 * When reaching the end, the subscription is set to invalid.
+	 * @return false if there is no more data message
 	 */
-	bool nextDataMessage(std::ifstream &file, Subscription &subscription, int msg_id);
+	bool nextDataMessage(Subscription &subscription);
 
 	std::vector<Subscription *> _subscriptions;
 	std::vector<uint8_t> _read_buffer;
@@ -215,43 +223,57 @@ private:
 
 	uint64_t _file_start_time;
 	uint64_t _replay_start_time;
-	std::streampos _data_section_start; ///< first ADD_LOGGED_MSG message
+	uint64_t _data_section_start; ///< first ADD_LOGGED_MSG message
+
+	uint64_t _read_until_file_position = 1ULL << 60; ///< read limit if log contains appended data
 
-	/** keep track of file position to avoid adding a subscription multiple times. */
-	std::streampos _subscription_file_pos = 0;
+	ReplayFile _log_file;
 
-	int64_t _read_until_file_position = 1ULL << 60; ///< read limit if log contains appended data
+	std::vector<uint64_t> _additional_messages; ///< file offsets of parameter updates and dropouts
+	size_t _next_additional_message = 0;
 
-	bool readFileHeader(std::ifstream &file);
+	uint32_t _num_log_messages = 0; ///< number of messages in the data section
+
+	bool readFileHeader(std::istream &file);
 
 	/**
 	 * Read definitions section: check formats, apply parameters and store
 	 * the start of the data section.
 	 * @return true on success
 	 */
-	bool readFileDefinitions(std::ifstream &file);
+	bool readFileDefinitions(std::istream &file);
 
 	///file parsing methods. They return false, when further parsing should be aborted.
-	bool readFormat(std::ifstream &file, uint16_t msg_size);
-	bool readAndAddSubscription(std::ifstream &file, uint16_t msg_size);
-	bool readFlagBits(std::ifstream &file, uint16_t msg_size);
+	bool readFormat(std::istream &file, uint16_t msg_size);
+	bool readFlagBits(std::istream &file, uint16_t msg_size);
+
+	/**
+	 * Add a subscription from an ADD_LOGGED_MSG message
+	 */
+	void addSubscription(const uint8_t *message, uint16_t msg_size);
+
+	/**
+	 * Read the data section once: add the subscriptions, index their data messages and
+	 * store the offsets of parameter updates and dropouts.
+	 * @return false if there is nothing to replay
+	 */
+	bool buildIndex();
 
 	/**
 	 * Read the file header and definitions sections. Apply the parameters from this section
 	 * and apply user-defined overridden parameters.
 	 * @return true on success
 	 */
-	bool readDefinitionsAndApplyParams(std::ifstream &file);
+	bool readDefinitionsAndApplyParams(std::istream &file);
 
 	/**
-	 * Read and handle additional messages starting at current file position, while position < end_position.
+	 * Handle the additional messages that were not handled yet and are located before end_offset.
 	 * This handles dropout and parameter update messages.
 	 * We need to handle these separately, because they have no timestamp. We look at the file position instead.
-	 * @return false on file error
 	 */
-	bool readAndHandleAdditionalMessages(std::ifstream &file, std::streampos end_position);
-	bool readDropout(std::ifstream &file, uint16_t msg_size);
-	bool readAndApplyParameter(std::ifstream &file, uint16_t msg_size);
+	void handleAdditionalMessages(uint64_t end_offset);
+	bool readDropout(std::istream &file, uint16_t msg_size);
+	bool readAndApplyParameter(std::istream &file, uint16_t msg_size);
 
 	static const orb_metadata *findTopic(const std::string &name);
 
@@ -38,6 +38,7 @@
 // for ekf2 replay
 #include <uORB/topics/airspeed.h>
 #include <uORB/topics/distance_sensor.h>
+#include <uORB/topics/estimator_status.h>
 #include <uORB/topics/landing_target_pose.h>
 #include <uORB/topics/optical_flow.h>
 #include <uORB/topics/sensor_combined.h>
@@ -50,19 +51,24 @@
 #include <uORB/topics/vehicle_status.h>
 #include <uORB/topics/vehicle_odometry.h>
 
+#include <math.h>
+#include <stdio.h>
+
 #include "ReplayEkf2.hpp"
 
+#define INNOVATION_STATISTICS_FILE PX4_ROOTFSDIR "/replay_ekf2_statistics.csv"
+
 namespace px4
 {
 
 bool
-ReplayEkf2::handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file)
+ReplayEkf2::handleTopicUpdate(Subscription &sub, void *data)
 {
 	if (sub.orb_meta == ORB_ID(ekf2_timestamps)) {
 		ekf2_timestamps_s ekf2_timestamps;
 		memcpy(&ekf2_timestamps, data, sub.orb_meta->o_size);
 
-		if (!publishEkf2Topics(ekf2_timestamps, replay_file)) {
+		if (!publishEkf2Topics(ekf2_timestamps)) {
 			return false;
 		}
 
@@ -93,6 +99,8 @@ ReplayEkf2::handleTopicUpdate(Subscription &sub, void *data, std::ifstream &repl
 			}
 		}
 
+		updateInnovationStatistics();
+
 		return true;
 
 	} else if (sub.orb_meta == ORB_ID(vehicle_status) || sub.orb_meta == ORB_ID(vehicle_land_detected)
@@ -136,13 +144,13 @@ ReplayEkf2::onSubscriptionAdded(Subscription &sub, uint16_t msg_id)
 }
 
 bool
-ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifstream &replay_file)
+ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps)
 {
 	auto handle_sensor_publication = [&](int16_t timestamp_relative, uint16_t msg_id) {
 		if (timestamp_relative != ekf2_timestamps_s::RELATIVE_TIMESTAMP_INVALID) {
 			// timestamp_relative is already given in 0.1 ms
 			uint64_t t = timestamp_relative + ekf2_timestamps.timestamp / 100; // in 0.1 ms
-			findTimestampAndPublish(t, msg_id, replay_file);
+			findTimestampAndPublish(t, msg_id);
 		}
 	};
 
@@ -154,7 +162,7 @@ ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifs
 	handle_sensor_publication(ekf2_timestamps.visual_odometry_timestamp_rel, _vehicle_visual_odometry_msg_id);
 
 	// sensor_combined: publish last because ekf2 is polling on this
-	if (!findTimestampAndPublish(ekf2_timestamps.timestamp / 100, _sensor_combined_msg_id, replay_file)) {
+	if (!findTimestampAndPublish(ekf2_timestamps.timestamp / 100, _sensor_combined_msg_id)) {
 		if (_sensor_combined_msg_id == msg_id_invalid) {
 			// subscription not found yet or sensor_combined not contained in log
 			return false;
@@ -164,7 +172,7 @@ ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifs
 
 		} else {
 			// we should publish a topic, just publish the same again
-			readTopicDataToBuffer(*_subscriptions[_sensor_combined_msg_id], replay_file);
+			readTopicDataToBuffer(*_subscriptions[_sensor_combined_msg_id]);
 			publishTopic(*_subscriptions[_sensor_combined_msg_id], _read_buffer.data());
 		}
 	}
@@ -173,7 +181,7 @@ ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifs
 }
 
 bool
-ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, std::ifstream &replay_file)
+ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id)
 {
 	if (msg_id == msg_id_invalid) {
 		// could happen if a topic is not logged
@@ -183,7 +191,7 @@ ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, std::if
 	Subscription &sub = *_subscriptions[msg_id];
 
 	while (sub.next_timestamp / 100 < timestamp && sub.orb_meta) {
-		nextDataMessage(replay_file, sub, msg_id);
+		nextDataMessage(sub);
 	}
 
 	if (!sub.orb_meta) { // no messages anymore
@@ -198,7 +206,7 @@ ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, std::if
 		return false;
 	}
 
-	readTopicDataToBuffer(sub, replay_file);
+	readTopicDataToBuffer(sub);
 	publishTopic(sub, _read_buffer.data());
 	return true;
 }
@@ -207,6 +215,7 @@ void
 ReplayEkf2::onEnterMainLoop()
 {
 	_vehicle_attitude_sub = orb_subscribe(ORB_ID(vehicle_attitude));
+	_estimator_status_sub = orb_subscribe(ORB_ID(estimator_status));
 }
 
 void
@@ -234,8 +243,92 @@ ReplayEkf2::onExitMainLoop()
 	print_sensor_statistics(_vehicle_magnetometer_msg_id, "vehicle_magnetometer");
 	print_sensor_statistics(_vehicle_visual_odometry_msg_id, "vehicle_visual_odometry");
 
+	writeInnovationStatistics();
+
 	orb_unsubscribe(_vehicle_attitude_sub);
 	_vehicle_attitude_sub = -1;
+	orb_unsubscribe(_estimator_status_sub);
+	_estimator_status_sub = -1;
+}
+
+static const char *const test_ratio_names[] = {"mag", "vel", "pos", "hgt", "tas", "hagl", "beta"};
+
+void
+ReplayEkf2::updateInnovationStatistics()
+{
+	bool updated = false;
+	orb_check(_estimator_status_sub, &updated);
+
+	if (!updated) {
+		return;
+	}
+
+	estimator_status_s status;
+	orb_copy(ORB_ID(estimator_status), _estimator_status_sub, &status);
+
+	const float test_ratios[num_test_ratios] = {
+		status.mag_test_ratio,
+		status.vel_test_ratio,
+		status.pos_test_ratio,
+		status.hgt_test_ratio,
+		status.tas_test_ratio,
+		status.hagl_test_ratio,
+		status.beta_test_ratio,
+	};
+
+	for (int i = 0; i < num_test_ratios; ++i) {
+		// a test ratio of 0 means that the measurement is not fused
+		if (PX4_ISFINITE(test_ratios[i]) && test_ratios[i] > 0.f) {
+			TestRatioStatistics &stats = _test_ratio_statistics[i];
+			++stats.samples;
+			stats.sum += test_ratios[i];
+			stats.sum_sq += (double)test_ratios[i] * test_ratios[i];
+
+			if (test_ratios[i] > stats.max) {
+				stats.max = test_ratios[i];
+			}
+
+			if (test_ratios[i] > 1.f) {
+				++stats.rejected;
+			}
+		}
+	}
+}
+
+void
+ReplayEkf2::writeInnovationStatistics()
+{
+	FILE *file = fopen(INNOVATION_STATISTICS_FILE, "w");
+
+	if (file) {
+		fprintf(file, "test_ratio,samples,mean,rms,max,rejected\n");
+
+	} else {
+		PX4_ERR("failed to open %s", INNOVATION_STATISTICS_FILE);
+	}
+
+	PX4_INFO("");
+	PX4_INFO("Innovation test ratio, samples, mean, rms, max, rejected:");
+
+	for (int i = 0; i < num_test_ratios; ++i) {
+		const TestRatioStatistics &stats = _test_ratio_statistics[i];
+		const double mean = stats.samples > 0 ? stats.sum / stats.samples : 0.;
+		const double rms = stats.samples > 0 ? sqrt(stats.sum_sq / stats.samples) : 0.;
+
+		if (stats.samples > 0) {
+			PX4_INFO("%s: %u, %.3f, %.3f, %.3f, %u", test_ratio_names[i], stats.samples, mean, rms,
+				 (double)stats.max, stats.rejected);
+		}
+
+		if (file) {
+			fprintf(file, "%s,%u,%.6f,%.6f,%.6f,%u\n", test_ratio_names[i], stats.samples, mean, rms,
+				(double)stats.max, stats.rejected);
+		}
+	}
+
+	if (file) {
+		fclose(file);
+	}
 }
 
 uint64_t
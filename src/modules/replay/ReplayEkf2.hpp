@@ -56,27 +56,48 @@ protected:
 	 * handle ekf2 topic publication in ekf2 replay mode
 	 * @param sub
 	 * @param data
-	 * @param replay_file file currently replayed (file seek position should be considered arbitrary after this call)
 	 * @return true if published, false otherwise
 	 */
-	bool handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file) override;
+	bool handleTopicUpdate(Subscription &sub, void *data) override;
 
 	void onSubscriptionAdded(Subscription &sub, uint16_t msg_id) override;
 
 private:
 
-	bool publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifstream &replay_file);
+	bool publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps);
 
 	/**
 	 * find the next message for a subscription that matches a given timestamp and publish it
 	 * @param timestamp in 0.1 ms
 	 * @param msg_id
-	 * @param replay_file file currently replayed (file seek position should be considered arbitrary after this call)
 	 * @return true if timestamp found and published
 	 */
-	bool findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, std::ifstream &replay_file);
+	bool findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id);
+
+	/**
+	 * accumulate the innovation test ratios of the latest estimator_status update
+	 */
+	void updateInnovationStatistics();
+
+	/**
+	 * print the innovation test ratio statistics and write them to INNOVATION_STATISTICS_FILE
+	 * (one line per test ratio), so that Tools/replay_statistics.py can aggregate them without parsing the output log
+	 */
+	void writeInnovationStatistics();
 
 	int _vehicle_attitude_sub = -1;
+	int _estimator_status_sub = -1;
+
+	struct TestRatioStatistics {
+		uint32_t samples{0};
+		uint32_t rejected{0}; ///< number of samples with a test ratio > 1
+		double sum{0.};
+		double sum_sq{0.};
+		float max{0.f};
+	};
+
+	static constexpr int num_test_ratios = 7;
+	TestRatioStatistics _test_ratio_statistics[num_test_ratios] {};
 
 	static constexpr uint16_t msg_id_invalid = 0xffff;
 
@@ -0,0 +1,174 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "ReplayFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <lib/ulog_compression/ULogBlockReader.hpp>
+#include <px4_platform_common/log.h>
+
+using namespace std;
+
+namespace px4
+{
+
+ReplayFile::MemoryStreamBuf::pos_type
+ReplayFile::MemoryStreamBuf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+	off_type base;
+
+	switch (dir) {
+	case ios_base::beg:
+		base = 0;
+		break;
+
+	case ios_base::cur:
+		base = gptr() - eback();
+		break;
+
+	case ios_base::end:
+		base = egptr() - eback();
+		break;
+
+	default:
+		return pos_type(off_type(-1));
+	}
+
+	return seekpos(pos_type(base + off), which);
+}
+
+ReplayFile::MemoryStreamBuf::pos_type
+ReplayFile::MemoryStreamBuf::seekpos(pos_type pos, ios_base::openmode which)
+{
+	const off_type target = pos;
+
+	if (!(which & ios_base::in) || target < 0 || target > egptr() - eback()) {
+		return pos_type(off_type(-1));
+	}
+
+	setg(eback(), eback() + target, egptr());
+	return pos;
+}
+
+ReplayFile::ReplayFile() :
+	std::istream(nullptr)
+{
+}
+
+ReplayFile::~ReplayFile()
+{
+	close();
+}
+
+bool
+ReplayFile::open(const char *file_name)
+{
+	close();
+
+	if (ulog_compression::ULogBlockReader::is_compressed_file(file_name)) {
+		ulog_compression::ULogBlockReader reader;
+
+		if (reader.open(file_name) && reader.size() > 0) {
+			if (reader.index_rebuilt()) {
+				PX4_WARN("compressed log is incomplete, replaying %llu bytes", (unsigned long long)reader.size());
+			}
+
+			_map_size = reader.size();
+			void *data = mmap(nullptr, _map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+			if (data != MAP_FAILED) {
+				_data = (uint8_t *)data;
+
+				if (reader.read(0, _data, _map_size) == (ssize_t)_map_size) {
+					mprotect(_data, _map_size, PROT_READ);
+					_compressed = true;
+
+				} else {
+					PX4_ERR("failed to decompress %s", file_name);
+					munmap(_data, _map_size);
+					_data = nullptr;
+				}
+			}
+		}
+
+	} else {
+		int fd = ::open(file_name, O_RDONLY);
+		struct stat st;
+
+		if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+			_map_size = st.st_size;
+			void *data = mmap(nullptr, _map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if (data != MAP_FAILED) {
+				_data = (uint8_t *)data;
+			}
+		}
+
+		if (fd >= 0) {
+			::close(fd); // the mapping stays valid
+		}
+	}
+
+	if (!_data) {
+		_map_size = 0;
+		setstate(ios::failbit);
+		return false;
+	}
+
+	_size = _map_size;
+	_buf.set(_data, _size);
+	rdbuf(&_buf);
+	return true;
+}
+
+void
+ReplayFile::close()
+{
+	if (_data) {
+		munmap(_data, _map_size);
+	}
+
+	_data = nullptr;
+	_size = 0;
+	_map_size = 0;
+	_compressed = false;
+	_buf.set(nullptr, 0);
+	rdbuf(nullptr);
+}
+
+} // namespace px4
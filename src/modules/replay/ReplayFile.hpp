@@ -0,0 +1,98 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file ReplayFile.hpp
+ * Read-only memory mapping of the replayed log. Regular ULog files are mapped directly,
+ * compressed ULog containers are decompressed once into an anonymous mapping.
+ */
+
+#pragma once
+
+#include <istream>
+#include <stdint.h>
+#include <streambuf>
+
+namespace px4
+{
+
+/**
+ * @class ReplayFile
+ * Mapped log data, which can be accessed directly or through the input stream interface
+ * (used to parse the definitions section).
+ */
+class ReplayFile : public std::istream
+{
+public:
+	ReplayFile();
+	~ReplayFile();
+
+	ReplayFile(const ReplayFile &) = delete;
+	ReplayFile &operator=(const ReplayFile &) = delete;
+
+	/**
+	 * Map a file. The stream is in a failed state if that does not succeed.
+	 * @return true on success
+	 */
+	bool open(const char *file_name);
+
+	void close();
+
+	bool compressed() const { return _compressed; }
+
+	/** ULog data (uncompressed) */
+	const uint8_t *data() const { return _data; }
+	uint64_t size() const { return _size; }
+
+private:
+	/** stream buffer over the mapped data */
+	class MemoryStreamBuf : public std::streambuf
+	{
+	public:
+		void set(const uint8_t *data, uint64_t size) { setg((char *)data, (char *)data, (char *)data + size); }
+
+	protected:
+		pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+		pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+	};
+
+	MemoryStreamBuf _buf;
+
+	uint8_t *_data{nullptr};
+	uint64_t _size{0};
+	size_t _map_size{0};
+	bool _compressed{false};
+};
+
+} // namespace px4
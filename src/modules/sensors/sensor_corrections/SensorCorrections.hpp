@@ -66,6 +66,9 @@ public:
 	// rotate corrected measurements from sensor to body frame
 	matrix::Vector3f Correct(const matrix::Vector3f &data) const { return _board_rotation * matrix::Vector3f{(data - _offset).emult(_scale)}; }
 
+	// apply scale and rotation only (for differences of measurements, e.g. derivatives)
+	matrix::Vector3f CorrectDelta(const matrix::Vector3f &data) const { return _board_rotation * matrix::Vector3f{data.emult(_scale)}; }
+
 	void ParametersUpdate();
 	void SensorCorrectionsUpdate(bool force = false);
 
@@ -78,7 +78,12 @@ private:
 
 	uORB::Publication<vehicle_acceleration_s> _vehicle_acceleration_pub{ORB_ID(vehicle_acceleration)};
 
-	uORB::Subscription _estimator_sensor_bias_sub{ORB_ID(estimator_sensor_bias)};
+	// one instance per estimator (ekf2 multi-instance mode)
+	uORB::Subscription _estimator_sensor_bias_sub[MAX_SENSOR_COUNT] {
+		{ORB_ID(estimator_sensor_bias), 0},
+		{ORB_ID(estimator_sensor_bias), 1},
+		{ORB_ID(estimator_sensor_bias), 2}
+	};
 	uORB::Subscription _params_sub{ORB_ID(parameter_update)};
 
 	uORB::SubscriptionCallbackWorkItem _sensor_selection_sub{this, ORB_ID(sensor_selection)};
@@ -50,11 +50,18 @@ VehicleAngularVelocity::VehicleAngularVelocity() :
 	_notch_filter_velocity.setParameters(kInitialRateHz, _param_imu_gyro_nf_freq.get(), _param_imu_gyro_nf_bw.get());
 
 	_lp_filter_acceleration.set_cutoff_frequency(kInitialRateHz, _param_imu_dgyro_cutoff.get());
+
+	_notch_filter_velocity_fifo.setParameters(kInitialRateHz, _param_imu_gyro_nf_freq.get(), _param_imu_gyro_nf_bw.get());
+	_lp_filter_velocity_fifo.set_cutoff_frequency(kInitialRateHz, _param_imu_gyro_cutoff.get());
+	_lp_filter_acceleration_fifo.set_cutoff_frequency(kInitialRateHz, _param_imu_dgyro_cutoff.get());
 }
 
 VehicleAngularVelocity::~VehicleAngularVelocity()
 {
 	Stop();
+
+	perf_free(_dynamic_notch_filter_update_perf);
+	perf_free(_dynamic_notch_filter_perf);
 }
 
 bool VehicleAngularVelocity::Start()
@@ -81,6 +88,10 @@ void VehicleAngularVelocity::Stop()
 		sub.unregisterCallback();
 	}
 
+	for (auto &sub : _sensor_fifo_sub) {
+		sub.unregisterCallback();
+	}
+
 	_sensor_selection_sub.unregisterCallback();
 }
 
@@ -127,24 +138,40 @@ void VehicleAngularVelocity::CheckFilters()
 
 			_lp_filter_acceleration.set_cutoff_frequency(_filter_sample_rate, _param_imu_dgyro_cutoff.get());
 			_lp_filter_acceleration.reset(_angular_acceleration_prev);
+
+			_notch_filter_velocity_fifo.setParameters(_filter_sample_rate, _param_imu_gyro_nf_freq.get(), _param_imu_gyro_nf_bw.get());
+			_notch_filter_velocity_fifo.reset(_fifo_velocity_prev);
+
+			_lp_filter_velocity_fifo.set_cutoff_frequency(_filter_sample_rate, _param_imu_gyro_cutoff.get());
+			_lp_filter_velocity_fifo.reset(_fifo_velocity_prev);
+
+			_lp_filter_acceleration_fifo.set_cutoff_frequency(_filter_sample_rate, _param_imu_dgyro_cutoff.get());
+			_lp_filter_acceleration_fifo.reset(_fifo_acceleration_prev);
+
+			// the dynamic notch filters are retuned for the new sample rate
+			DisableDynamicNotch();
 		}
 
 		// reset sample interval accumulator
 		_timestamp_sample_last = 0;
+		_interval_sum = 0.f;
+		_interval_count = 0.f;
 	}
 }
 
 void VehicleAngularVelocity::SensorBiasUpdate(bool force)
 {
-	if (_estimator_sensor_bias_sub.updated() || force) {
-		estimator_sensor_bias_s bias;
+	if (force) {
+		_bias.zero();
+	}
 
-		if (_estimator_sensor_bias_sub.copy(&bias)) {
-			if (bias.gyro_device_id == _selected_sensor_device_id) {
-				_bias = Vector3f{bias.gyro_bias};
+	// use the bias of the estimator instance that uses the selected sensor
+	for (auto &estimator_sensor_bias_sub : _estimator_sensor_bias_sub) {
+		if (estimator_sensor_bias_sub.updated() || force) {
+			estimator_sensor_bias_s bias;
 
-			} else {
-				_bias.zero();
+			if (estimator_sensor_bias_sub.copy(&bias) && (bias.gyro_device_id == _selected_sensor_device_id)) {
+				_bias = Vector3f{bias.gyro_bias};
 			}
 		}
 	}
@@ -162,6 +189,42 @@ bool VehicleAngularVelocity::SensorSelectionUpdate(bool force)
 				sub.unregisterCallback();
 			}
 
+			for (auto &sub : _sensor_fifo_sub) {
+				sub.unregisterCallback();
+			}
+
+			_fifo_available = false;
+
+			// the dynamic notch filter state belongs to the previous sensor (and frame)
+			DisableDynamicNotch();
+
+			// full rate FIFO data if enabled and available, otherwise sensor_gyro
+			if (_param_imu_gyro_fifo.get()) {
+				for (int i = 0; i < MAX_SENSOR_COUNT; i++) {
+					sensor_gyro_fifo_s report{};
+					_sensor_fifo_sub[i].copy(&report);
+
+					if ((report.device_id != 0) && (report.device_id == sensor_selection.gyro_device_id)) {
+						if (_sensor_fifo_sub[i].registerCallback()) {
+							PX4_DEBUG("selected sensor FIFO changed %d -> %d", _selected_sensor_sub_index, i);
+
+							_selected_sensor_sub_index = i;
+							_selected_sensor_device_id = sensor_selection.gyro_device_id;
+							_fifo_available = true;
+
+							_bias.zero();
+							_corrections.set_device_id(report.device_id);
+
+							// reset sample interval accumulator on sensor change
+							_interval_sum = 0.f;
+							_interval_count = 0.f;
+
+							return true;
+						}
+					}
+				}
+			}
+
 			for (int i = 0; i < MAX_SENSOR_COUNT; i++) {
 				sensor_gyro_s report{};
 				_sensor_sub[i].copy(&report);
@@ -204,8 +267,21 @@ void VehicleAngularVelocity::ParametersUpdate(bool force)
 		parameter_update_s param_update;
 		_params_sub.copy(&param_update);
 
+		const bool fifo_enabled = _param_imu_gyro_fifo.get();
+		const float dynamic_notch_bandwidth = _param_imu_gyro_dnf_bw.get();
+
 		updateParams();
 
+		if (_param_imu_gyro_fifo.get() != fifo_enabled) {
+			// select the sensor again (sensor_gyro or sensor_gyro_fifo)
+			_selected_sensor_device_id = 0;
+		}
+
+		if (!_param_imu_gyro_dnf_en.get() || (fabsf(_param_imu_gyro_dnf_bw.get() - dynamic_notch_bandwidth) > 0.01f)) {
+			// retune all dynamic notch filters with the new bandwidth
+			DisableDynamicNotch();
+		}
+
 		_corrections.ParametersUpdate();
 	}
 }
@@ -218,6 +294,12 @@ void VehicleAngularVelocity::Run()
 	_corrections.SensorCorrectionsUpdate(selection_updated);
 	SensorBiasUpdate(selection_updated);
 	ParametersUpdate();
+	UpdateDynamicNotchEscRpm();
+
+	if (_fifo_available) {
+		ProcessSensorFifo();
+		return;
+	}
 
 	bool sensor_updated = _sensor_sub[_selected_sensor_sub_index].updated();
 
@@ -256,8 +338,15 @@ void VehicleAngularVelocity::Run()
 			// correct for in-run bias errors
 			angular_velocity_raw -= _bias;
 
+			Vector3f angular_velocity_notched{_notch_filter_velocity.apply(angular_velocity_raw)};
+
+			if (_param_imu_gyro_dnf_en.get()) {
+				float samples[4] {angular_velocity_notched(0), angular_velocity_notched(1), angular_velocity_notched(2), 0.f};
+				ApplyDynamicNotch(samples, 1);
+				angular_velocity_notched = Vector3f{samples};
+			}
+
 			// Differentiate angular velocity (after notch filter)
-			const Vector3f angular_velocity_notched{_notch_filter_velocity.apply(angular_velocity_raw)};
 			const Vector3f angular_acceleration_raw = (angular_velocity_notched - _angular_velocity_prev) / dt;
 
 			_angular_velocity_prev = angular_velocity_notched;
@@ -273,37 +362,244 @@ void VehicleAngularVelocity::Run()
 			sensor_updated = _sensor_sub[_selected_sensor_sub_index].updated();
 
 			if (!sensor_updated) {
-				bool publish = true;
+				if (Publish(sensor_data.timestamp_sample, angular_velocity, angular_acceleration)) {
+					return;
+				}
+			}
+		}
+	}
+}
 
-				if (_param_imu_gyro_rate_max.get() > 0) {
-					const uint64_t interval = 1e6f / _param_imu_gyro_rate_max.get();
+void VehicleAngularVelocity::ProcessSensorFifo()
+{
+	sensor_gyro_fifo_s sensor_fifo_data;
 
-					if (hrt_elapsed_time(&_last_publish) < interval) {
-						publish = false;
-					}
-				}
+	hrt_abstime timestamp_sample = 0;
+	float angular_velocity_sensor[3] {};
+	float angular_acceleration_sensor[3] {};
 
-				if (publish) {
-					// Publish vehicle_angular_acceleration
-					vehicle_angular_acceleration_s v_angular_acceleration;
-					v_angular_acceleration.timestamp_sample = sensor_data.timestamp_sample;
-					angular_acceleration.copyTo(v_angular_acceleration.xyz);
-					v_angular_acceleration.timestamp = hrt_absolute_time();
-					_vehicle_angular_acceleration_pub.publish(v_angular_acceleration);
-
-					// Publish vehicle_angular_velocity
-					vehicle_angular_velocity_s v_angular_velocity;
-					v_angular_velocity.timestamp_sample = sensor_data.timestamp_sample;
-					angular_velocity.copyTo(v_angular_velocity.xyz);
-					v_angular_velocity.timestamp = hrt_absolute_time();
-					_vehicle_angular_velocity_pub.publish(v_angular_velocity);
-
-					_last_publish = v_angular_velocity.timestamp_sample;
-					return;
+	// process all outstanding messages, every sample of a FIFO goes through the filters
+	while (_sensor_fifo_sub[_selected_sensor_sub_index].update(&sensor_fifo_data)) {
+		const int N = math::min((int)sensor_fifo_data.samples, FIFO_SIZE_MAX);
+
+		if ((N == 0) || !(sensor_fifo_data.dt > 0.f)) {
+			continue;
+		}
+
+		// collect sample interval average for filters
+		_interval_sum += sensor_fifo_data.dt * N;
+		_interval_count += N;
+
+		CheckFilters();
+
+		const int16_t *raw_data[3] {sensor_fifo_data.x, sensor_fifo_data.y, sensor_fifo_data.z};
+
+		// all axes filtered at once, samples interleaved as x, y, z and one unused channel
+		float velocity[FIFO_SIZE_MAX * 4];
+		float acceleration[FIFO_SIZE_MAX * 4];
+
+		for (int n = 0; n < N; n++) {
+			for (int axis = 0; axis < 3; axis++) {
+				velocity[4 * n + axis] = raw_data[axis][n] * sensor_fifo_data.scale;
+			}
+
+			velocity[4 * n + 3] = 0.f;
+		}
+
+		_notch_filter_velocity_fifo.applyArray(velocity, N);
+
+		if (_param_imu_gyro_dnf_en.get()) {
+			ApplyDynamicNotch(velocity, N);
+		}
+
+		// Differentiate angular velocity (after notch filter)
+		const math::FloatVector4 dt_inv{1e6f / sensor_fifo_data.dt};
+		math::FloatVector4 velocity_prev{math::FloatVector4::load(_fifo_velocity_prev)};
+
+		for (int n = 0; n < N; n++) {
+			const math::FloatVector4 velocity_n{math::FloatVector4::load(&velocity[4 * n])};
+			((velocity_n - velocity_prev) * dt_inv).store(&acceleration[4 * n]);
+			velocity_prev = velocity_n;
+		}
+
+		velocity_prev.store(_fifo_velocity_prev);
+		memcpy(_fifo_acceleration_prev, &acceleration[4 * (N - 1)], sizeof(_fifo_acceleration_prev));
+
+		// Filter: apply low-pass
+		_lp_filter_acceleration_fifo.applyArray(acceleration, N);
+		_lp_filter_velocity_fifo.applyArray(velocity, N);
+
+		for (int axis = 0; axis < 3; axis++) {
+			angular_velocity_sensor[axis] = velocity[4 * (N - 1) + axis];
+			angular_acceleration_sensor[axis] = acceleration[4 * (N - 1) + axis];
+		}
+
+		timestamp_sample = sensor_fifo_data.timestamp_sample;
+	}
+
+	if (timestamp_sample != 0) {
+		// the filters are linear, so rotation and calibration are only applied to the latest filtered sample
+		const enum Rotation rotation = static_cast<enum Rotation>(sensor_fifo_data.rotation);
+
+		rotate_3f(rotation, angular_velocity_sensor[0], angular_velocity_sensor[1], angular_velocity_sensor[2]);
+		rotate_3f(rotation, angular_acceleration_sensor[0], angular_acceleration_sensor[1], angular_acceleration_sensor[2]);
+
+		const Vector3f angular_velocity_calibrated{Vector3f{angular_velocity_sensor} - Vector3f{sensor_fifo_data.calibration_offset}};
+
+		// correct for thermal errors and in-run bias errors
+		const Vector3f angular_velocity{_corrections.Correct(angular_velocity_calibrated) - _bias};
+		const Vector3f angular_acceleration{_corrections.CorrectDelta(Vector3f{angular_acceleration_sensor})};
+
+		Publish(timestamp_sample, angular_velocity, angular_acceleration);
+	}
+}
+
+void VehicleAngularVelocity::ApplyDynamicNotch(float samples[], int num_samples)
+{
+	perf_begin(_dynamic_notch_filter_perf);
+
+	for (auto &esc_filters : _dynamic_notch_filter) {
+		for (auto &filter : esc_filters) {
+			if (filter.getNotchFreq() > 0.f) {
+				filter.applyArray(samples, num_samples);
+			}
+		}
+	}
+
+	perf_end(_dynamic_notch_filter_perf);
+
+	_dynamic_notch_samples += num_samples;
+}
+
+void VehicleAngularVelocity::DisableDynamicNotch()
+{
+	for (auto &esc_filters : _dynamic_notch_filter) {
+		for (auto &filter : esc_filters) {
+			filter.setParameters(_filter_sample_rate, 0.f, _param_imu_gyro_dnf_bw.get());
+		}
+	}
+}
+
+void VehicleAngularVelocity::UpdateDynamicNotchEscRpm()
+{
+	if (!_param_imu_gyro_dnf_en.get()) {
+		return;
+	}
+
+	esc_status_s esc_status;
+
+	if (_esc_status_sub.update(&esc_status)) {
+		const int esc_count = math::min((int)esc_status.esc_count, MAX_NUM_ESC_RPM);
+
+		for (int esc = 0; esc < MAX_NUM_ESC_RPM; esc++) {
+			const float frequency = (esc < esc_count) ? abs(esc_status.esc[esc].esc_rpm) / 60.f : 0.f;
+			_esc_rpm_frequency[esc] = (frequency >= _param_imu_gyro_dnf_min.get()) ? frequency : 0.f;
+		}
+
+		_esc_status_timestamp = esc_status.timestamp;
+
+	} else if ((_esc_status_timestamp != 0) && (hrt_elapsed_time(&_esc_status_timestamp) > DYNAMIC_NOTCH_ESC_TIMEOUT)) {
+		// no RPM data, disable all filters
+		for (auto &frequency : _esc_rpm_frequency) {
+			frequency = 0.f;
+		}
+
+		_esc_status_timestamp = 0;
+	}
+
+	// retune at most one ESC (all its harmonics) per update to bound the cost per cycle
+	for (int i = 0; i < MAX_NUM_ESC_RPM; i++) {
+		const int esc = (_dynamic_notch_esc_index + i) % MAX_NUM_ESC_RPM;
+
+		if (RetuneDynamicNotch(esc)) {
+			_dynamic_notch_esc_index = (esc + 1) % MAX_NUM_ESC_RPM;
+			break;
+		}
+	}
+}
+
+bool VehicleAngularVelocity::RetuneDynamicNotch(int esc)
+{
+	const float bandwidth = _param_imu_gyro_dnf_bw.get();
+	const int harmonics = math::constrain(_param_imu_gyro_dnf_hmc.get(), 1, MAX_NUM_HARMONICS);
+
+	bool retuned = false;
+
+	for (int harmonic = 0; harmonic < MAX_NUM_HARMONICS; harmonic++) {
+		math::NotchFilterArray4 &filter = _dynamic_notch_filter[esc][harmonic];
+
+		float frequency = _esc_rpm_frequency[esc] * (harmonic + 1);
+
+		// disabled harmonics and frequencies too close to the Nyquist frequency
+		if ((harmonic >= harmonics) || (frequency > 0.45f * _filter_sample_rate)) {
+			frequency = 0.f;
+		}
+
+		const float frequency_prev = filter.getNotchFreq();
+
+		if (fabsf(frequency - frequency_prev) <= DYNAMIC_NOTCH_FREQ_TOLERANCE) {
+			continue;
+		}
+
+		if (!retuned) {
+			perf_begin(_dynamic_notch_filter_update_perf);
+			retuned = true;
+		}
+
+		if ((frequency > 0.f) && (frequency_prev > 0.f)) {
+			// follow the motor, keep the filter state
+			filter.updateParameters(_filter_sample_rate, frequency, bandwidth);
+
+		} else {
+			filter.setParameters(_filter_sample_rate, frequency, bandwidth);
+
+			if (frequency > 0.f) {
+				// start from the current angular velocity to avoid a transient
+				float sample[4] {_angular_velocity_prev(0), _angular_velocity_prev(1), _angular_velocity_prev(2), 0.f};
+
+				if (_fifo_available) {
+					memcpy(sample, _fifo_velocity_prev, sizeof(sample));
 				}
+
+				filter.reset(sample);
 			}
 		}
 	}
+
+	if (retuned) {
+		perf_end(_dynamic_notch_filter_update_perf);
+	}
+
+	return retuned;
+}
+
+bool VehicleAngularVelocity::Publish(const hrt_abstime &timestamp_sample, const Vector3f &angular_velocity,
+				     const Vector3f &angular_acceleration)
+{
+	if (_param_imu_gyro_rate_max.get() > 0) {
+		const uint64_t interval = 1e6f / _param_imu_gyro_rate_max.get();
+
+		if (hrt_elapsed_time(&_last_publish) < interval) {
+			return false;
+		}
+	}
+
+	// Publish vehicle_angular_acceleration
+	vehicle_angular_acceleration_s v_angular_acceleration;
+	v_angular_acceleration.timestamp_sample = timestamp_sample;
+	angular_acceleration.copyTo(v_angular_acceleration.xyz);
+	v_angular_acceleration.timestamp = hrt_absolute_time();
+	_vehicle_angular_acceleration_pub.publish(v_angular_acceleration);
+
+	// Publish vehicle_angular_velocity
+	vehicle_angular_velocity_s v_angular_velocity;
+	v_angular_velocity.timestamp_sample = timestamp_sample;
+	angular_velocity.copyTo(v_angular_velocity.xyz);
+	v_angular_velocity.timestamp = hrt_absolute_time();
+	_vehicle_angular_velocity_pub.publish(v_angular_velocity);
+
+	_last_publish = v_angular_velocity.timestamp_sample;
+	return true;
 }
 
 void VehicleAngularVelocity::PrintStatus()
@@ -311,7 +607,28 @@ void VehicleAngularVelocity::PrintStatus()
 	PX4_INFO("selected sensor: %d (%d)", _selected_sensor_device_id, _selected_sensor_sub_index);
 	PX4_INFO("bias: [%.3f %.3f %.3f]", (double)_bias(0), (double)_bias(1), (double)_bias(2));
 
-	PX4_INFO("sample rate: %.3f Hz", (double)_update_rate_hz);
+	PX4_INFO("sample rate: %.3f Hz%s", (double)_update_rate_hz, _fifo_available ? " (FIFO)" : "");
+
+	if (_param_imu_gyro_dnf_en.get()) {
+		int active_filters = 0;
+
+		for (auto &esc_filters : _dynamic_notch_filter) {
+			for (auto &filter : esc_filters) {
+				if (filter.getNotchFreq() > 0.f) {
+					active_filters++;
+				}
+			}
+		}
+
+		// mean cost per sample (all axes) of the dynamic notch filter bank
+		const uint64_t blocks = perf_event_count(_dynamic_notch_filter_perf);
+		const double sample_cost_us = (_dynamic_notch_samples > 0) ?
+					      1e6 * (double)perf_mean(_dynamic_notch_filter_perf) * blocks / _dynamic_notch_samples : 0.0;
+
+		PX4_INFO("dynamic notch: %d filters active, %.3f us per sample", active_filters, sample_cost_us);
+		perf_print_counter(_dynamic_notch_filter_update_perf);
+		perf_print_counter(_dynamic_notch_filter_perf);
+	}
 
 	_corrections.PrintStatus();
 }
@@ -35,10 +35,15 @@
 
 #include <sensor_corrections/SensorCorrections.hpp>
 
+#include <lib/conversion/rotation.h>
 #include <lib/mathlib/math/Limits.hpp>
 #include <lib/matrix/matrix/math.hpp>
+#include <lib/mathlib/math/filter/LowPassFilter2p.hpp>
+#include <lib/mathlib/math/filter/LowPassFilter2pArray.hpp>
 #include <lib/mathlib/math/filter/LowPassFilter2pVector3f.hpp>
 #include <lib/mathlib/math/filter/NotchFilter.hpp>
+#include <lib/mathlib/math/filter/NotchFilterArray.hpp>
+#include <lib/perf/perf_counter.h>
 #include <px4_platform_common/log.h>
 #include <px4_platform_common/module_params.h>
 #include <px4_platform_common/px4_config.h>
@@ -46,13 +51,17 @@
 #include <uORB/Publication.hpp>
 #include <uORB/Subscription.hpp>
 #include <uORB/SubscriptionCallback.hpp>
+#include <uORB/topics/esc_status.h>
 #include <uORB/topics/estimator_sensor_bias.h>
 #include <uORB/topics/parameter_update.h>
 #include <uORB/topics/sensor_gyro.h>
+#include <uORB/topics/sensor_gyro_fifo.h>
 #include <uORB/topics/sensor_selection.h>
 #include <uORB/topics/vehicle_angular_acceleration.h>
 #include <uORB/topics/vehicle_angular_velocity.h>
 
+using namespace time_literals;
+
 namespace sensors
 {
 
@@ -72,6 +81,14 @@ private:
 	void Run() override;
 
 	void CheckFilters();
+	void ProcessSensorFifo();
+
+	void ApplyDynamicNotch(float samples[], int num_samples);
+	void DisableDynamicNotch();
+	void UpdateDynamicNotchEscRpm();
+	bool RetuneDynamicNotch(int esc);
+	bool Publish(const hrt_abstime &timestamp_sample, const matrix::Vector3f &angular_velocity,
+		     const matrix::Vector3f &angular_acceleration);
 	void ParametersUpdate(bool force = false);
 	void SensorBiasUpdate(bool force = false);
 	bool SensorSelectionUpdate(bool force = false);
@@ -81,7 +98,13 @@ private:
 	uORB::Publication<vehicle_angular_acceleration_s> _vehicle_angular_acceleration_pub{ORB_ID(vehicle_angular_acceleration)};
 	uORB::Publication<vehicle_angular_velocity_s> _vehicle_angular_velocity_pub{ORB_ID(vehicle_angular_velocity)};
 
-	uORB::Subscription _estimator_sensor_bias_sub{ORB_ID(estimator_sensor_bias)};
+	// one instance per estimator (ekf2 multi-instance mode)
+	uORB::Subscription _estimator_sensor_bias_sub[MAX_SENSOR_COUNT] {
+		{ORB_ID(estimator_sensor_bias), 0},
+		{ORB_ID(estimator_sensor_bias), 1},
+		{ORB_ID(estimator_sensor_bias), 2}
+	};
+	uORB::Subscription _esc_status_sub{ORB_ID(esc_status)};
 	uORB::Subscription _params_sub{ORB_ID(parameter_update)};
 
 	uORB::SubscriptionCallbackWorkItem _sensor_selection_sub{this, ORB_ID(sensor_selection)};
@@ -90,6 +113,11 @@ private:
 		{this, ORB_ID(sensor_gyro), 1},
 		{this, ORB_ID(sensor_gyro), 2}
 	};
+	uORB::SubscriptionCallbackWorkItem _sensor_fifo_sub[MAX_SENSOR_COUNT] {
+		{this, ORB_ID(sensor_gyro_fifo), 0},
+		{this, ORB_ID(sensor_gyro_fifo), 1},
+		{this, ORB_ID(sensor_gyro_fifo), 2}
+	};
 
 	SensorCorrections _corrections;
 
@@ -110,6 +138,35 @@ private:
 	// angular acceleration filter
 	math::LowPassFilter2pVector3f _lp_filter_acceleration{kInitialRateHz, 10.0f};
 
+	// full rate FIFO filtering (IMU_GYRO_FIFO) in the sensor frame, samples interleaved as x, y, z and one unused channel
+	static constexpr int FIFO_SIZE_MAX = sizeof(sensor_gyro_fifo_s::x) / sizeof(sensor_gyro_fifo_s::x[0]);
+
+	math::NotchFilterArray4 _notch_filter_velocity_fifo{};
+	math::LowPassFilter2pArray4 _lp_filter_velocity_fifo{kInitialRateHz, 30.0f};
+	math::LowPassFilter2pArray4 _lp_filter_acceleration_fifo{kInitialRateHz, 10.0f};
+
+	float _fifo_velocity_prev[4] {};	///< last notch filtered sample (sensor frame)
+	float _fifo_acceleration_prev[4] {};	///< last unfiltered derivative (sensor frame)
+
+	bool _fifo_available{false};
+
+	// dynamic notch filters on the motor fundamental and harmonics (IMU_GYRO_DNF_EN), retuned from ESC RPM
+	static constexpr int MAX_NUM_ESC_RPM = sizeof(esc_status_s::esc) / sizeof(esc_status_s::esc[0]);
+	static constexpr int MAX_NUM_HARMONICS = 3;
+	static constexpr float DYNAMIC_NOTCH_FREQ_TOLERANCE = 1.f;	///< [Hz] retune only if the frequency changed by more
+	static constexpr hrt_abstime DYNAMIC_NOTCH_ESC_TIMEOUT = 1_s;	///< disable the filters without RPM data
+
+	math::NotchFilterArray4 _dynamic_notch_filter[MAX_NUM_ESC_RPM][MAX_NUM_HARMONICS] {};
+
+	float _esc_rpm_frequency[MAX_NUM_ESC_RPM] {};	///< [Hz] motor fundamental frequency, 0 if unavailable
+	hrt_abstime _esc_status_timestamp{0};
+	uint8_t _dynamic_notch_esc_index{0};		///< next ESC to retune (round robin)
+
+	uint64_t _dynamic_notch_samples{0};
+
+	perf_counter_t _dynamic_notch_filter_update_perf{perf_alloc(PC_ELAPSED, MODULE_NAME": gyro dynamic notch update")};
+	perf_counter_t _dynamic_notch_filter_perf{perf_alloc(PC_ELAPSED, MODULE_NAME": gyro dynamic notch filter")};
+
 	float _filter_sample_rate{kInitialRateHz};
 
 	uint32_t _selected_sensor_device_id{0};
@@ -124,6 +181,11 @@ private:
 		(ParamFloat<px4::params::IMU_GYRO_NF_FREQ>) _param_imu_gyro_nf_freq,
 		(ParamFloat<px4::params::IMU_GYRO_NF_BW>) _param_imu_gyro_nf_bw,
 		(ParamInt<px4::params::IMU_GYRO_RATEMAX>) _param_imu_gyro_rate_max,
+		(ParamBool<px4::params::IMU_GYRO_FIFO>) _param_imu_gyro_fifo,
+		(ParamBool<px4::params::IMU_GYRO_DNF_EN>) _param_imu_gyro_dnf_en,
+		(ParamInt<px4::params::IMU_GYRO_DNF_HMC>) _param_imu_gyro_dnf_hmc,
+		(ParamFloat<px4::params::IMU_GYRO_DNF_BW>) _param_imu_gyro_dnf_bw,
+		(ParamFloat<px4::params::IMU_GYRO_DNF_MIN>) _param_imu_gyro_dnf_min,
 
 		(ParamFloat<px4::params::IMU_DGYRO_CUTOFF>) _param_imu_dgyro_cutoff
 	)
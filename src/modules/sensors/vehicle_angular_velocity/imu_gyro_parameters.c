@@ -95,6 +95,63 @@ PARAM_DEFINE_FLOAT(IMU_GYRO_CUTOFF, 30.0f);
 */
 PARAM_DEFINE_INT32(IMU_GYRO_RATEMAX, 0);
 
+/**
+* Filter the full rate gyro FIFO data
+*
+* If enabled and the selected gyro publishes FIFO data (sensor_gyro_fifo), the notch and low pass
+* filters run on every raw sample of the FIFO instead of once per sensor_gyro publication,
+* and the latest filtered sample is published. Otherwise sensor_gyro is used.
+*
+* @boolean
+* @group Sensors
+*/
+PARAM_DEFINE_INT32(IMU_GYRO_FIFO, 0);
+
+/**
+* Enable the ESC RPM dynamic notch filters for gyro
+*
+* A bank of notch filters on the fundamental and harmonics of each motor, retuned
+* from the ESC RPM telemetry (esc_status). Requires ESCs reporting RPM.
+* The filters only affect the signal sent to the controllers, not the estimators.
+*
+* @boolean
+* @group Sensors
+*/
+PARAM_DEFINE_INT32(IMU_GYRO_DNF_EN, 0);
+
+/**
+* Number of harmonics of the ESC RPM dynamic notch filters
+*
+* Number of notch filters per motor, on the fundamental (1) and its harmonics.
+*
+* @min 1
+* @max 3
+* @group Sensors
+*/
+PARAM_DEFINE_INT32(IMU_GYRO_DNF_HMC, 3);
+
+/**
+* Bandwidth of the ESC RPM dynamic notch filters
+*
+* @min 5
+* @max 30
+* @unit Hz
+* @group Sensors
+*/
+PARAM_DEFINE_FLOAT(IMU_GYRO_DNF_BW, 15.0f);
+
+/**
+* Minimum frequency of the ESC RPM dynamic notch filters
+*
+* A notch filter is disabled while its frequency is below this value (e.g. motors idle or stopped).
+*
+* @min 0
+* @max 1000
+* @unit Hz
+* @group Sensors
+*/
+PARAM_DEFINE_FLOAT(IMU_GYRO_DNF_MIN, 25.0f);
+
 /**
 * Cutoff frequency for angular acceleration
 *
@@ -81,7 +81,54 @@ int Sih::task_spawn(int argc, char *argv[])
 
 Sih *Sih::instantiate(int argc, char *argv[])
 {
-	Sih *instance = new Sih();
+	bool lockstep = false;
+	float speed_factor = 1.f;
+	bool error_flag = false;
+
+	int myoptind = 1;
+	int ch;
+	const char *myoptarg = nullptr;
+
+	while ((ch = px4_getopt(argc, argv, "ls:", &myoptind, &myoptarg)) != EOF) {
+		switch (ch) {
+		case 'l':
+			lockstep = true;
+			break;
+
+		case 's':
+			speed_factor = strtof(myoptarg, nullptr);
+
+			if (speed_factor < 0.f) {
+				speed_factor = 0.f;
+			}
+
+			break;
+
+		case '?':
+			error_flag = true;
+			break;
+
+		default:
+			PX4_WARN("unrecognized flag");
+			error_flag = true;
+			break;
+		}
+	}
+
+	if (error_flag) {
+		return nullptr;
+	}
+
+#if !defined(ENABLE_LOCKSTEP_SCHEDULER)
+
+	if (lockstep) {
+		PX4_ERR("lockstep mode requires a build with the lockstep scheduler");
+		return nullptr;
+	}
+
+#endif // !ENABLE_LOCKSTEP_SCHEDULER
+
+	Sih *instance = new Sih(lockstep, speed_factor);
 
 	if (instance == nullptr) {
 		PX4_ERR("alloc failed");
@@ -90,8 +137,10 @@ Sih *Sih::instantiate(int argc, char *argv[])
 	return instance;
 }
 
-Sih::Sih() :
+Sih::Sih(bool lockstep, float speed_factor) :
 	ModuleParams(nullptr),
+	_lockstep(lockstep),
+	_speed_factor(speed_factor),
 	_loop_perf(perf_alloc(PC_ELAPSED, MODULE_NAME": execution")),
 	_sampling_perf(perf_alloc(PC_ELAPSED, MODULE_NAME": sampling"))
 {
@@ -105,6 +154,15 @@ void Sih::run()
 	init_variables();
 	init_sensors();
 
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+
+	if (_lockstep) {
+		run_lockstep();
+		return;
+	}
+
+#endif // ENABLE_LOCKSTEP_SCHEDULER
+
 	const hrt_abstime task_start = hrt_absolute_time();
 	_last_run = task_start;
 	_gps_time = task_start;
@@ -139,6 +197,190 @@ void Sih::timer_callback(void *sem)
 	px4_sem_post((px4_sem_t *)sem);
 }
 
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+void Sih::run_lockstep()
+{
+	pthread_mutex_init(&_step_mutex, nullptr);
+	pthread_cond_init(&_step_cond, nullptr);
+
+	for (auto &step_callback : _step_callbacks) {
+		step_callback.registerCallback();
+	}
+
+	// the first step sets the start of the PX4 time (hrt_absolute_time() == 0)
+	_lockstep_time_start = real_time_us();
+	_lockstep_time = _lockstep_time_start;
+	set_lockstep_time(_lockstep_time);
+
+	const hrt_abstime task_start = hrt_absolute_time();
+	_last_run = task_start;
+	_gps_time = task_start;
+	_serial_time = task_start;
+
+	_real_time_start = real_time_us();
+	uint64_t last_report = _real_time_start;
+
+	PX4_INFO("lockstep mode, speed factor: %.1f%s", (double)_speed_factor, _speed_factor > 0.f ? "" : " (as fast as possible)");
+
+	while (!should_exit()) {
+		pthread_mutex_lock(&_step_mutex);
+
+		for (auto &step_callback : _step_callbacks) {
+			step_callback.updated = false;
+		}
+
+		pthread_mutex_unlock(&_step_mutex);
+
+		// advance the time of all the modules, then publish the sensor data of the new step
+		_lockstep_time += LOOP_INTERVAL;
+		set_lockstep_time(_lockstep_time);
+
+		perf_begin(_loop_perf);
+
+		inner_loop();   // main execution function
+
+		perf_end(_loop_perf);
+
+		_step_count++;
+
+		wait_for_step_done();
+
+		const uint64_t now = real_time_us();
+
+		if (_speed_factor > 0.f) {
+			// don't run ahead of the requested speed
+			const uint64_t real_time_target = _real_time_start + (uint64_t)((_lockstep_time - _lockstep_time_start) / _speed_factor);
+
+			if (real_time_target > now) {
+				system_usleep(real_time_target - now);
+			}
+		}
+
+		if (now - last_report >= SPEEDUP_REPORT_INTERVAL_US) {
+			last_report = now;
+			print_speedup("running");
+		}
+	}
+
+	print_speedup("stopped");
+
+	for (auto &step_callback : _step_callbacks) {
+		step_callback.unregisterCallback();
+	}
+
+	pthread_cond_destroy(&_step_cond);
+	pthread_mutex_destroy(&_step_mutex);
+}
+
+void Sih::wait_for_step_done()
+{
+	// the timeout is in real time, the lockstep time does not advance while waiting
+	struct timespec deadline;
+	system_clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_nsec += STEP_TIMEOUT_US * 1000;
+	deadline.tv_sec += deadline.tv_nsec / 1000000000;
+	deadline.tv_nsec %= 1000000000;
+
+	bool any_seen = false;
+
+	pthread_mutex_lock(&_step_mutex);
+
+	while (!should_exit()) {
+		bool done = true;
+		any_seen = false;
+
+		for (auto &step_callback : _step_callbacks) {
+			if (step_callback.seen) {
+				any_seen = true;
+				done = done && step_callback.updated;
+			}
+		}
+
+		if (done) {
+			break;
+		}
+
+		if (system_pthread_cond_timedwait(&_step_cond, &_step_mutex, &deadline) == ETIMEDOUT) {
+			// stop waiting for topics that are no longer published (e.g. estimator stopped)
+			for (auto &step_callback : _step_callbacks) {
+				if (!step_callback.updated) {
+					step_callback.seen = false;
+				}
+			}
+
+			_step_timeouts++;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&_step_mutex);
+
+	if (!any_seen) {
+		// nothing to synchronize with yet (modules starting up): run in real time
+		system_usleep(LOOP_INTERVAL);
+	}
+}
+
+void Sih::StepCallback::call()
+{
+	pthread_mutex_lock(&_sih->_step_mutex);
+	seen = true;
+	updated = true;
+	pthread_cond_signal(&_sih->_step_cond);
+	pthread_mutex_unlock(&_sih->_step_mutex);
+}
+
+void Sih::set_lockstep_time(uint64_t time_us)
+{
+	struct timespec ts;
+	abstime_to_ts(&ts, time_us);
+	px4_clock_settime(CLOCK_MONOTONIC, &ts);
+}
+
+uint64_t Sih::real_time_us()
+{
+	struct timespec ts;
+	system_clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void Sih::print_speedup(const char *reason)
+{
+	if (_step_count == 0) {
+		PX4_INFO("%s: no step done yet", reason);
+		return;
+	}
+
+	const double sim_time = (_lockstep_time - _lockstep_time_start) * 1e-6;
+	const double real_time = (real_time_us() - _real_time_start) * 1e-6;
+
+	PX4_INFO("%s: %.1f s simulated in %.1f s real time (%.1fx), %llu steps, %u step timeouts",
+		 reason, sim_time, real_time, real_time > 0. ? sim_time / real_time : 0.,
+		 (unsigned long long)_step_count, _step_timeouts);
+}
+#endif // ENABLE_LOCKSTEP_SCHEDULER
+
+int Sih::print_status()
+{
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+
+	if (_lockstep) {
+		print_speedup("lockstep");
+
+	} else {
+		PX4_INFO("running in real time");
+	}
+
+#else
+	PX4_INFO("running in real time");
+#endif // ENABLE_LOCKSTEP_SCHEDULER
+
+	perf_print_counter(_loop_perf);
+	perf_print_counter(_sampling_perf);
+
+	return 0;
+}
+
 // this is the main execution waken up periodically by the semaphore
 void Sih::inner_loop()
 {
@@ -462,11 +704,20 @@ Quaternion representation is used for the attitude.
 Forward Euler is used for integration.
 Most of the variables are declared global in the .hpp file to avoid stack overflow.
 
+### Lockstep mode
+In SITL builds with the lockstep scheduler, `sih start -l` runs the simulation headless:
+every simulation step sets the PX4 time directly, and the next step starts as soon as
+"actuator_outputs" and "ekf2_timestamps" have been published for the current one.
+There is no simulator link, so the simulation runs as fast as the autopilot modules allow,
+optionally limited to a multiple of real time with `-s`. The achieved speedup is printed
+periodically and with `sih status`.
 
 )DESCR_STR");
 
     PRINT_MODULE_USAGE_NAME("sih", "simulation");
     PRINT_MODULE_USAGE_COMMAND("start");
+    PRINT_MODULE_USAGE_PARAM_FLAG('l', "Headless lockstep mode (SITL only)", true);
+    PRINT_MODULE_USAGE_PARAM_FLOAT('s', 1.f, 0.f, 1000.f, "Lockstep speed factor relative to real time (0: as fast as possible)", true);
     PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
 
     return 0;
@@ -48,8 +48,10 @@
 #include <perf/perf_counter.h>
 #include <uORB/Publication.hpp>
 #include <uORB/Subscription.hpp>
+#include <uORB/SubscriptionCallback.hpp>
 #include <uORB/topics/parameter_update.h>
 #include <uORB/topics/actuator_outputs.h>
+#include <uORB/topics/ekf2_timestamps.h>
 #include <uORB/topics/vehicle_angular_velocity.h>   // to publish groundtruth
 #include <uORB/topics/vehicle_attitude.h>           // to publish groundtruth
 #include <uORB/topics/vehicle_global_position.h>    // to publish groundtruth
@@ -60,7 +62,7 @@ extern "C" __EXPORT int sih_main(int argc, char *argv[]);
 class Sih : public ModuleBase<Sih>, public ModuleParams
 {
 public:
-	Sih();
+	Sih(bool lockstep = false, float speed_factor = 1.f);
 
 	virtual ~Sih() = default;
 
@@ -79,6 +81,9 @@ public:
 	/** @see ModuleBase::run() */
 	void run() override;
 
+	/** @see ModuleBase::print_status() */
+	int print_status() override;
+
 	static float generate_wgn();    // generate white Gaussian noise sample
 
 	// generate white Gaussian noise sample as a 3D vector with specified std
@@ -140,6 +145,63 @@ private:
 	void publish_sih();
 	void inner_loop();
 
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+	/**
+	 * Headless lockstep mode: the simulation step drives the lockstep scheduler
+	 * directly (no simulator link), and the next step is started as soon as the
+	 * controllers have reacted to the previous one.
+	 */
+	void run_lockstep();
+
+	/**
+	 * Block until all step topics seen so far have been published after the last
+	 * step (or a timeout in real time elapsed).
+	 */
+	void wait_for_step_done();
+
+	void set_lockstep_time(uint64_t time_us);
+
+	void print_speedup(const char *reason);
+
+	static uint64_t real_time_us();
+
+	// signals the simulation thread when a step topic is published
+	class StepCallback : public uORB::SubscriptionCallback
+	{
+	public:
+		StepCallback(Sih *sih, const orb_metadata *meta) : uORB::SubscriptionCallback(meta), _sih(sih) {}
+
+		void call() override;
+
+		bool seen{false};	///< published at least once (and not timed out since)
+		bool updated{false};	///< published since the last step
+
+	private:
+		Sih *_sih;
+	};
+
+	// the step is done when the mixer output and the estimator have reacted to the new sensor data
+	StepCallback _step_callbacks[2] {
+		{this, ORB_ID(actuator_outputs)},
+		{this, ORB_ID(ekf2_timestamps)},
+	};
+
+	static constexpr uint64_t STEP_TIMEOUT_US = 100000;	// real time to wait for a step to complete
+	static constexpr uint64_t SPEEDUP_REPORT_INTERVAL_US = 10000000; // real time between speedup reports
+
+	pthread_mutex_t _step_mutex;
+	pthread_cond_t _step_cond;
+
+	uint64_t _lockstep_time_start{0};	// absolute lockstep time of the first step [us]
+	uint64_t _lockstep_time{0};		// current absolute lockstep time [us]
+	uint64_t _real_time_start{0};		// real time at the first step [us]
+	uint64_t _step_count{0};
+	uint32_t _step_timeouts{0};
+#endif // ENABLE_LOCKSTEP_SCHEDULER
+
+	const bool _lockstep;
+	const float _speed_factor; // lockstep simulation speed relative to real time (0: as fast as possible)
+
 	perf_counter_t  _loop_perf;
 	perf_counter_t  _sampling_perf;
 
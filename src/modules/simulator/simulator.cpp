@@ -77,6 +77,16 @@ void Simulator::print_status()
 
 	PX4_INFO("barometer");
 	_px4_baro.print_status();
+
+	if (_recv_batches > 0) {
+		PX4_INFO("received %llu datagrams in %llu batches (max %u per batch)", (unsigned long long)_recv_datagrams,
+			 (unsigned long long)_recv_batches, _recv_batch_max);
+	}
+
+	// real time per simulation step
+	_latency_simulator.print("controls sent -> sensors received");
+	_latency_actuator_outputs.print("sensors published -> actuator_outputs");
+	_latency_ekf2.print("sensors published -> ekf2_timestamps");
 }
 
 int Simulator::start(int argc, char *argv[])
@@ -51,9 +51,11 @@
 #include <lib/drivers/gyroscope/PX4Gyroscope.hpp>
 #include <lib/drivers/magnetometer/PX4Magnetometer.hpp>
 #include <lib/ecl/geo/geo.h>
+#include <lib/mathlib/mathlib.h>
 #include <lib/perf/perf_counter.h>
 #include <px4_platform_common/atomic.h>
 #include <px4_platform_common/bitmask.h>
+#include <px4_platform_common/log.h>
 #include <px4_platform_common/module_params.h>
 #include <px4_platform_common/posix.h>
 #include <uORB/Publication.hpp>
@@ -165,6 +167,98 @@ private:
 	perf_counter_t _perf_sim_delay{perf_alloc(PC_ELAPSED, MODULE_NAME": network delay")};
 	perf_counter_t _perf_sim_interval{perf_alloc(PC_INTERVAL, MODULE_NAME": network interval")};
 
+	// Gyro and accel samples of one receive batch, published together as one FIFO sample.
+	template<typename FIFOSample>
+	struct ImuFifo {
+		FIFOSample sample{};
+		hrt_abstime timestamp_first{0};	///< sample time of the first sample in the batch
+		hrt_abstime timestamp_prev{0};	///< sample time of the last sample of the previous batch
+
+		bool full() const { return sample.samples >= sizeof(sample.x) / sizeof(sample.x[0]); }
+
+		void push(hrt_abstime timestamp_sample, float x, float y, float z, float scale)
+		{
+			if (sample.samples == 0) {
+				timestamp_first = timestamp_sample;
+			}
+
+			sample.x[sample.samples] = raw(x, scale);
+			sample.y[sample.samples] = raw(y, scale);
+			sample.z[sample.samples] = raw(z, scale);
+			sample.timestamp_sample = timestamp_sample;
+			sample.samples++;
+		}
+
+		/**
+		 * Set the sample interval of the batch.
+		 * @return false if the batch is empty
+		 */
+		bool finish()
+		{
+			if (sample.samples == 0) {
+				return false;
+			}
+
+			if ((timestamp_prev != 0) && (sample.timestamp_sample > timestamp_prev)) {
+				sample.dt = (float)(sample.timestamp_sample - timestamp_prev) / sample.samples;
+
+			} else if (sample.samples > 1) {
+				sample.dt = (float)(sample.timestamp_sample - timestamp_first) / (sample.samples - 1);
+
+			} else {
+				sample.dt = 4000.f; // nominal simulator rate (250 Hz)
+			}
+
+			timestamp_prev = sample.timestamp_sample;
+			return true;
+		}
+
+		static int16_t raw(float value, float scale) { return math::constrainFloatToInt16(roundf(value / scale)); }
+	};
+
+	static constexpr float GYRO_RANGE = math::radians(2000.f);	// rad/s
+	static constexpr float ACCEL_RANGE = 16.f * CONSTANTS_ONE_G;	// m/s^2
+
+	ImuFifo<PX4Accelerometer::FIFOSample> _accel_fifo{};
+	ImuFifo<PX4Gyroscope::FIFOSample> _gyro_fifo{};
+	bool _imu_fifo{false};	///< SIM_IMU_FIFO at startup
+
+	// real time spent in the stages of a simulation step
+	struct LatencyStats {
+		uint64_t count{0};
+		uint64_t sum_us{0};
+		uint64_t max_us{0};
+
+		void add(uint64_t latency_us)
+		{
+			count++;
+			sum_us += latency_us;
+			max_us = math::max(max_us, latency_us);
+		}
+
+		void print(const char *name) const
+		{
+			if (count > 0) {
+				PX4_INFO("%s: avg %.3f ms, max %.3f ms (%llu steps)", name, (double)(sum_us / count) * 1e-3,
+					 (double)max_us * 1e-3, (unsigned long long)count);
+			}
+		}
+	};
+
+	LatencyStats _latency_actuator_outputs{};	///< sensor data published -> actuator_outputs
+	LatencyStats _latency_ekf2{};			///< sensor data published -> ekf2_timestamps
+	LatencyStats _latency_simulator{};		///< controls sent -> next HIL_SENSOR received
+
+	px4::atomic<uint64_t> _sensors_published_real_time{0};
+	px4::atomic<uint64_t> _controls_sent_real_time{0};
+
+	bool _hil_sensor_received{false};
+
+	// receive batching
+	uint64_t _recv_batches{0};
+	uint64_t _recv_datagrams{0};
+	uint32_t _recv_batch_max{0};
+
 	// uORB publisher handlers
 	uORB::Publication<battery_status_s>		_battery_pub{ORB_ID(battery_status)};
 	uORB::Publication<differential_pressure_s>	_differential_pressure_pub{ORB_ID(differential_pressure)};
@@ -228,6 +322,9 @@ private:
 	void send_heartbeat();
 	void send_mavlink_message(const mavlink_message_t &aMsg);
 	void update_sensors(const hrt_abstime &time, const mavlink_hil_sensor_t &sensors);
+	void publish_imu_fifo();
+	void parse_mavlink(const uint8_t *buf, int len, mavlink_status_t &status);
+	int receive_messages(mavlink_status_t &status);
 
 	static void *sending_trampoline(void *);
 
@@ -286,6 +383,7 @@ private:
 		(ParamBool<px4::params::SIM_BARO_BLOCK>) _param_sim_baro_block,
 		(ParamBool<px4::params::SIM_MAG_BLOCK>) _param_sim_mag_block,
 		(ParamBool<px4::params::SIM_DPRES_BLOCK>) _param_sim_dpres_block,
+		(ParamBool<px4::params::SIM_IMU_FIFO>) _param_sim_imu_fifo,
 		(ParamInt<px4::params::MAV_TYPE>) _param_mav_type,
 		(ParamInt<px4::params::MAV_SYS_ID>) _param_mav_sys_id,
 		(ParamInt<px4::params::MAV_COMP_ID>) _param_mav_comp_id
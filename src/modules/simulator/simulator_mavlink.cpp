@@ -67,10 +67,31 @@ static int openUart(const char *uart_name, int baud);
 #endif
 
 static int _fd;
-static unsigned char _buf[2048];
 static sockaddr_in _srcaddr;
 static unsigned _addrlen = sizeof(_srcaddr);
 
+// receive buffer, one slot per datagram of a batch (used as a whole for TCP)
+static constexpr int RECV_BATCH_SIZE = 16;
+static constexpr int RECV_DATAGRAM_SIZE = 2048;
+static unsigned char _buf[RECV_BATCH_SIZE * RECV_DATAGRAM_SIZE];
+
+#if defined(__PX4_LINUX)
+static mmsghdr _recv_msgs[RECV_BATCH_SIZE];
+static iovec _recv_iovecs[RECV_BATCH_SIZE];
+#endif
+
+// real (wall clock) time, the lockstep time does not advance during a simulation step
+static uint64_t real_time_us()
+{
+	struct timespec ts;
+#if defined(__PX4_DARWIN)
+	system_clock_gettime(CLOCK_REALTIME, &ts);
+#else
+	system_clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 const unsigned mode_flag_armed = 128;
 const unsigned mode_flag_custom = 1;
 
@@ -193,16 +214,32 @@ void Simulator::send_controls()
 
 void Simulator::update_sensors(const hrt_abstime &time, const mavlink_hil_sensor_t &sensors)
 {
-	// gyro
+	// gyro (with SIM_IMU_FIFO published as FIFO once the whole receive batch is handled)
 	if ((sensors.fields_updated & SensorSource::GYRO) == SensorSource::GYRO && !_param_sim_gyro_block.get()) {
 		_px4_gyro.set_temperature(sensors.temperature);
-		_px4_gyro.update(time, sensors.xgyro, sensors.ygyro, sensors.zgyro);
+
+		if (_imu_fifo) {
+			_gyro_fifo.push(time, sensors.xgyro, sensors.ygyro, sensors.zgyro, GYRO_RANGE / 32768.f);
+
+		} else {
+			_px4_gyro.update(time, sensors.xgyro, sensors.ygyro, sensors.zgyro);
+		}
 	}
 
 	// accel
 	if ((sensors.fields_updated & SensorSource::ACCEL) == SensorSource::ACCEL && !_param_sim_accel_block.get()) {
 		_px4_accel.set_temperature(sensors.temperature);
-		_px4_accel.update(time, sensors.xacc, sensors.yacc, sensors.zacc);
+
+		if (_imu_fifo) {
+			_accel_fifo.push(time, sensors.xacc, sensors.yacc, sensors.zacc, ACCEL_RANGE / 32768.f);
+
+		} else {
+			_px4_accel.update(time, sensors.xacc, sensors.yacc, sensors.zacc);
+		}
+	}
+
+	if (_gyro_fifo.full() || _accel_fifo.full()) {
+		publish_imu_fifo();
 	}
 
 	// magnetometer
@@ -229,6 +266,63 @@ void Simulator::update_sensors(const hrt_abstime &time, const mavlink_hil_sensor
 	}
 }
 
+void Simulator::publish_imu_fifo()
+{
+	if (_gyro_fifo.finish()) {
+		_px4_gyro.updateFIFO(_gyro_fifo.sample);
+		_gyro_fifo.sample.samples = 0;
+	}
+
+	if (_accel_fifo.finish()) {
+		_px4_accel.updateFIFO(_accel_fifo.sample);
+		_accel_fifo.sample.samples = 0;
+	}
+}
+
+void Simulator::parse_mavlink(const uint8_t *buf, int len, mavlink_status_t &status)
+{
+	mavlink_message_t msg;
+
+	for (int i = 0; i < len; i++) {
+		if (mavlink_parse_char(MAVLINK_COMM_0, buf[i], &msg, &status)) {
+			handle_message(&msg);
+		}
+	}
+}
+
+int Simulator::receive_messages(mavlink_status_t &status)
+{
+#if defined(__PX4_LINUX)
+
+	if (_ip == InternetProtocol::UDP) {
+		// all pending datagrams with a single system call
+		for (int i = 0; i < RECV_BATCH_SIZE; i++) {
+			_recv_msgs[i].msg_hdr.msg_namelen = sizeof(_srcaddr);
+		}
+
+		const int n = ::recvmmsg(_fd, _recv_msgs, RECV_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+
+		for (int i = 0; i < n; i++) {
+			parse_mavlink(&_buf[i * RECV_DATAGRAM_SIZE], _recv_msgs[i].msg_len, status);
+		}
+
+		return math::max(n, 0);
+	}
+
+#endif
+
+	// TCP: everything available at once
+	const size_t size = (_ip == InternetProtocol::UDP) ? RECV_DATAGRAM_SIZE : sizeof(_buf);
+	int len = ::recvfrom(_fd, _buf, size, 0, (struct sockaddr *)&_srcaddr, (socklen_t *)&_addrlen);
+
+	if (len > 0) {
+		parse_mavlink(_buf, len, status);
+		return 1;
+	}
+
+	return 0;
+}
+
 void Simulator::handle_message(const mavlink_message_t *msg)
 {
 	switch (msg->msgid) {
@@ -337,6 +431,7 @@ void Simulator::handle_message_hil_sensor(const mavlink_message_t *msg)
 #endif
 
 	update_sensors(now_us, imu);
+	_hil_sensor_received = true;
 
 	static float battery_percentage = 1.0f;
 	static uint64_t last_integration_us = 0;
@@ -596,8 +691,11 @@ void Simulator::send()
 	fds_ekf2_timestamps[0].events = POLLIN;
 
 	State state = State::WaitingForFirstEkf2Timestamp;
+	uint64_t ekf2_step_measured = 0;
 #endif
 
+	uint64_t outputs_step_measured = 0;
+
 	while (true) {
 
 #if defined(ENABLE_LOCKSTEP_SCHEDULER)
@@ -618,10 +716,18 @@ void Simulator::send()
 			}
 
 			if (fds_actuator_outputs[0].revents & POLLIN) {
+				const uint64_t sensors_published = _sensors_published_real_time.load();
+
+				if ((sensors_published != 0) && (sensors_published != outputs_step_measured)) {
+					_latency_actuator_outputs.add(real_time_us() - sensors_published);
+					outputs_step_measured = sensors_published;
+				}
+
 				// Got new data to read, update all topics.
 				parameters_update(false);
 				_vehicle_status_sub.update(&_vehicle_status);
 				send_controls();
+				_controls_sent_real_time.store(real_time_us());
 #if defined(ENABLE_LOCKSTEP_SCHEDULER)
 				state = State::WaitingForEkf2Timestamp;
 #endif
@@ -648,6 +754,13 @@ void Simulator::send()
 			}
 
 			if (fds_ekf2_timestamps[0].revents & POLLIN) {
+				const uint64_t sensors_published = _sensors_published_real_time.load();
+
+				if ((sensors_published != 0) && (sensors_published != ekf2_step_measured)) {
+					_latency_ekf2.add(real_time_us() - sensors_published);
+					ekf2_step_measured = sensors_published;
+				}
+
 				ekf2_timestamps_s timestamps;
 				orb_copy(ORB_ID(ekf2_timestamps), _ekf2_timestamps_sub, &timestamps);
 				state = State::WaitingForActuatorControls;
@@ -709,7 +822,7 @@ void Simulator::run()
 
 		while (true) {
 			// Once we receive something, we're most probably good and can carry on.
-			int len = ::recvfrom(_fd, _buf, sizeof(_buf), 0,
+			int len = ::recvfrom(_fd, _buf, RECV_DATAGRAM_SIZE, 0,
 					     (struct sockaddr *)&_srcaddr, (socklen_t *)&_addrlen);
 
 			if (len > 0) {
@@ -794,6 +907,30 @@ void Simulator::run()
 
 #endif
 
+#if defined(__PX4_LINUX)
+
+	for (int i = 0; i < RECV_BATCH_SIZE; i++) {
+		_recv_iovecs[i].iov_base = &_buf[i * RECV_DATAGRAM_SIZE];
+		_recv_iovecs[i].iov_len = RECV_DATAGRAM_SIZE;
+		_recv_msgs[i].msg_hdr.msg_name = &_srcaddr;
+		_recv_msgs[i].msg_hdr.msg_iov = &_recv_iovecs[i];
+		_recv_msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+#endif
+
+	// optionally gyro and accel data is published as FIFO (raw int16 samples with scale, like IMU drivers)
+	_imu_fifo = _param_sim_imu_fifo.get();
+
+	if (_imu_fifo) {
+		_px4_gyro.set_range(GYRO_RANGE);
+		_px4_gyro.set_scale(GYRO_RANGE / 32768.f);
+		_px4_gyro.set_update_rate(250);
+		_px4_accel.set_range(ACCEL_RANGE);
+		_px4_accel.set_scale(ACCEL_RANGE / 32768.f);
+		_px4_accel.set_update_rate(250);
+	}
+
 	// Subscribe to topics.
 	// Only subscribe to the first actuator_outputs to fill a single HIL_ACTUATOR_CONTROLS.
 	_actuator_outputs_sub = orb_subscribe_multi(ORB_ID(actuator_outputs), 0);
@@ -827,17 +964,29 @@ void Simulator::run()
 		}
 
 		if (fds[0].revents & POLLIN) {
+			const uint64_t receive_time = real_time_us();
 
-			int len = ::recvfrom(_fd, _buf, sizeof(_buf), 0, (struct sockaddr *)&_srcaddr, (socklen_t *)&_addrlen);
+			_hil_sensor_received = false;
 
-			if (len > 0) {
-				mavlink_message_t msg;
+			const int received = receive_messages(mavlink_status);
 
-				for (int i = 0; i < len; i++) {
-					if (mavlink_parse_char(MAVLINK_COMM_0, _buf[i], &msg, &mavlink_status)) {
-						handle_message(&msg);
-					}
+			if (received > 0) {
+				_recv_batches++;
+				_recv_datagrams += received;
+				_recv_batch_max = math::max(_recv_batch_max, (uint32_t)received);
+			}
+
+			publish_imu_fifo();
+
+			if (_hil_sensor_received) {
+				const uint64_t controls_sent = _controls_sent_real_time.load();
+
+				if (controls_sent != 0) {
+					_latency_simulator.add(receive_time - controls_sent);
+					_controls_sent_real_time.store(0);
 				}
+
+				_sensors_published_real_time.store(real_time_us());
 			}
 		}
 
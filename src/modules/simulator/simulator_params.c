@@ -136,3 +136,18 @@ PARAM_DEFINE_INT32(SIM_BARO_BLOCK, 0);
  * @group SITL
  */
 PARAM_DEFINE_INT32(SIM_DPRES_BLOCK, 0);
+
+/**
+ * Simulator IMU FIFO publication.
+ *
+ * Enable to publish the incoming simulation gyroscope and accelerometer data
+ * of a receive batch at once as FIFO (sensor_gyro_fifo, sensor_accel_fifo),
+ * like the FIFO IMU drivers do. The samples are quantized to 16 bit with a
+ * range of 2000 dps and 16 g. If disabled, every sample is published
+ * unquantized as it arrives.
+ *
+ * @boolean
+ * @reboot_required true
+ * @group SITL
+ */
+PARAM_DEFINE_INT32(SIM_IMU_FIFO, 0);
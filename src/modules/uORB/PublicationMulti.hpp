@@ -66,6 +66,21 @@ public:
 
 	~PublicationMulti() { orb_unadvertise(_handle); }
 
+	/**
+	 * Advertise the topic without waiting for the first real publication.
+	 * This claims the next free instance without publishing any data,
+	 * so that publishers created in a known order get predictable instances.
+	 */
+	bool advertise()
+	{
+		if (_handle == nullptr) {
+			int instance = 0;
+			_handle = orb_advertise_multi(_meta, nullptr, &instance, _priority);
+		}
+
+		return (_handle != nullptr);
+	}
+
 	/**
 	 * Publish the struct
 	 * @param data The uORB message struct we are updating.
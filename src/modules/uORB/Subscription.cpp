@@ -93,6 +93,17 @@ Subscription::unsubscribe()
 	_last_generation = 0;
 }
 
+bool
+Subscription::change_instance(uint8_t instance)
+{
+	if (instance != _instance) {
+		unsubscribe();
+		_instance = instance;
+	}
+
+	return subscribe();
+}
+
 bool
 Subscription::init()
 {
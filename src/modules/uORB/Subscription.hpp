@@ -74,6 +74,13 @@ public:
 	bool subscribe();
 	void unsubscribe();
 
+	/**
+	 * Change the multi-instance this subscription is attached to.
+	 * @param instance The new instance for multi sub.
+	 * @return true if subscribed to the new instance (it might not be advertised yet).
+	 */
+	bool change_instance(uint8_t instance);
+
 	bool valid() const { return _node != nullptr; }
 	bool advertised()
 	{
@@ -52,6 +52,7 @@ struct orb_metadata {
 	const uint16_t o_size;		/**< object size */
 	const uint16_t o_size_no_padding;	/**< object size w/o padding at the end (for logger) */
 	const char *o_fields;		/**< semicolon separated list of fields (with type) */
+	const uint8_t o_id;		/**< ORB_ID enum (ORB_ID::INVALID for topics not generated from msg/) */
 };
 
 typedef const struct orb_metadata *orb_id_t;
@@ -110,13 +111,15 @@ enum ORB_PRIO {
  * @param _struct	The structure the topic provides.
  * @param _size_no_padding	Struct size w/o padding at the end
  * @param _fields	All fields in a semicolon separated list e.g: "float[3] position;bool armed"
+ * @param _orb_id_enum	ORB_ID enum value of the topic
  */
-#define ORB_DEFINE(_name, _struct, _size_no_padding, _fields)		\
+#define ORB_DEFINE(_name, _struct, _size_no_padding, _fields, _orb_id_enum)		\
 	const struct orb_metadata __orb_##_name = {	\
 		#_name,					\
 		sizeof(_struct),		\
 		_size_no_padding,			\
-		_fields					\
+		_fields,				\
+		_orb_id_enum				\
 	}; struct hack
 
 __BEGIN_DECLS
@@ -161,8 +161,8 @@ uORB::DeviceMaster::advertise(const struct orb_metadata *meta, bool is_advertise
 				node->mark_as_advertised();
 			}
 
-			// add to the node map.
-			_node_list.add(node);
+			// add to the node list and table.
+			addDeviceNodeLocked(node);
 		}
 
 		group_tries++;
@@ -467,8 +467,29 @@ uORB::DeviceNode *uORB::DeviceMaster::getDeviceNode(const struct orb_metadata *m
 	return node;
 }
 
+void uORB::DeviceMaster::addDeviceNodeLocked(uORB::DeviceNode *node)
+{
+	_node_list.add(node);
+
+	const orb_metadata *meta = node->get_meta();
+	const uint8_t instance = node->get_instance();
+
+	if (meta->o_id < ORB_TOPICS_COUNT && instance < ORB_MULTI_MAX_INSTANCES) {
+		_node_table[meta->o_id][instance] = node;
+	}
+}
+
 uORB::DeviceNode *uORB::DeviceMaster::getDeviceNodeLocked(const struct orb_metadata *meta, const uint8_t instance)
 {
+	if (meta->o_id < ORB_TOPICS_COUNT) {
+		if (instance < ORB_MULTI_MAX_INSTANCES) {
+			return _node_table[meta->o_id][instance];
+		}
+
+		return nullptr;
+	}
+
+	// topics without a generated id (e.g. uORB tests): linear search
 	for (uORB::DeviceNode *node : _node_list) {
 		if ((strcmp(node->get_name(), meta->o_name) == 0) && (node->get_instance() == instance)) {
 			return node;
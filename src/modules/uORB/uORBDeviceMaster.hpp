@@ -37,6 +37,7 @@
 
 #include "uORBCommon.hpp"
 #include <px4_platform_common/posix.h>
+#include <uORB/topics/uORBTopics.hpp>
 
 namespace uORB
 {
@@ -104,13 +105,25 @@ private:
 	friend class uORB::Manager;
 
 	/**
-	 * Find a node give its name.
+	 * Find a node given its meta data and instance.
 	 * _lock must already be held when calling this.
 	 * @return node if exists, nullptr otherwise
 	 */
 	uORB::DeviceNode *getDeviceNodeLocked(const struct orb_metadata *meta, const uint8_t instance);
 
-	List<uORB::DeviceNode *> _node_list;
+	/**
+	 * Add a newly created node to the node list and the node table.
+	 * _lock must already be held when calling this.
+	 */
+	void addDeviceNodeLocked(uORB::DeviceNode *node);
+
+	List<uORB::DeviceNode *> _node_list; ///< all nodes, used for iteration (statistics, top)
+
+	/**
+	 * Node lookup table indexed by ORB_ID and instance. Nodes are never deleted, so an entry
+	 * does not change once set. Topics with ORB_ID::INVALID are only in _node_list.
+	 */
+	uORB::DeviceNode *_node_table[ORB_TOPICS_COUNT][ORB_MULTI_MAX_INSTANCES] {};
 
 	hrt_abstime       _last_statistics_output;
 
@@ -138,42 +138,110 @@ uORB::DeviceNode::close(cdev::file_t *filp)
 	return CDev::close(filp);
 }
 
+unsigned
+uORB::DeviceNode::copy_from_queue(void *dst, unsigned &generation, unsigned current_generation) const
+{
+	unsigned lost_messages = 0;
+
+	if (current_generation > generation + _queue_size) {
+		// Reader is too far behind: some messages are lost
+		lost_messages = current_generation - (generation + _queue_size);
+		generation = current_generation - _queue_size;
+	}
+
+	if ((current_generation == generation) && (generation > 0)) {
+		/* The subscriber already read the latest message, but nothing new was published yet.
+		 * Return the previous message
+		 */
+		--generation;
+	}
+
+	memcpy(dst, _data + (_meta->o_size * (generation % _queue_size)), _meta->o_size);
+
+	if (generation < current_generation) {
+		++generation;
+	}
+
+	return lost_messages;
+}
+
 bool
 uORB::DeviceNode::copy_locked(void *dst, unsigned &generation)
 {
 	bool updated = false;
 
 	if ((dst != nullptr) && (_data != nullptr)) {
-		unsigned current_generation = _generation.load();
+		const unsigned lost_messages = copy_from_queue(dst, generation, _generation.load());
 
-		if (current_generation > generation + _queue_size) {
-			// Reader is too far behind: some messages are lost
-			_lost_messages += current_generation - (generation + _queue_size);
-			generation = current_generation - _queue_size;
+		if (lost_messages > 0) {
+			_lost_messages.fetch_add(lost_messages);
 		}
 
-		if ((current_generation == generation) && (generation > 0)) {
-			/* The subscriber already read the latest message, but nothing new was published yet.
-			 * Return the previous message
-			 */
-			--generation;
+		updated = true;
+	}
+
+	return updated;
+}
+
+#ifdef ORB_DEVICENODE_SEQLOCK
+bool
+uORB::DeviceNode::copy_seqlock(void *dst, unsigned &generation, hrt_abstime *last_update)
+{
+	if ((dst == nullptr) || (_data == nullptr)) {
+		return false;
+	}
+
+	for (int retry = 0; retry < SEQLOCK_MAX_RETRIES; retry++) {
+		const unsigned seq = _seq.load();
+
+		if (seq & 1) {
+			// publisher is writing
+			continue;
 		}
 
-		memcpy(dst, _data + (_meta->o_size * (generation % _queue_size)), _meta->o_size);
+		unsigned copy_generation = generation;
+		const hrt_abstime update_time = _last_update;
+		const unsigned lost_messages = copy_from_queue(dst, copy_generation, _generation.load());
+
+		// the data reads above must complete before the sequence is checked again
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		if (_seq.load() == seq) {
+			generation = copy_generation;
 
-		if (generation < current_generation) {
-			++generation;
+			if (lost_messages > 0) {
+				_lost_messages.fetch_add(lost_messages);
+			}
+
+			if (last_update) {
+				*last_update = update_time;
+			}
+
+			return true;
 		}
+	}
 
-		updated = true;
+	// contended: wait for the publisher to finish
+	lock();
+
+	if (last_update) {
+		*last_update = _last_update;
 	}
 
+	const bool updated = copy_locked(dst, generation);
+
+	unlock();
+
 	return updated;
 }
+#endif /* ORB_DEVICENODE_SEQLOCK */
 
 bool
 uORB::DeviceNode::copy(void *dst, unsigned &generation)
 {
+#ifdef ORB_DEVICENODE_SEQLOCK
+	return copy_seqlock(dst, generation, nullptr);
+#else
 	ATOMIC_ENTER;
 
 	bool updated = copy_locked(dst, generation);
@@ -181,17 +249,23 @@ uORB::DeviceNode::copy(void *dst, unsigned &generation)
 	ATOMIC_LEAVE;
 
 	return updated;
+#endif /* ORB_DEVICENODE_SEQLOCK */
 }
 
 uint64_t
 uORB::DeviceNode::copy_and_get_timestamp(void *dst, unsigned &generation)
 {
+#ifdef ORB_DEVICENODE_SEQLOCK
+	hrt_abstime update_time = 0;
+	copy_seqlock(dst, generation, &update_time);
+#else
 	ATOMIC_ENTER;
 
 	const hrt_abstime update_time = _last_update;
 	copy_locked(dst, generation);
 
 	ATOMIC_LEAVE;
+#endif /* ORB_DEVICENODE_SEQLOCK */
 
 	return update_time;
 }
@@ -211,6 +285,16 @@ uORB::DeviceNode::read(cdev::file_t *filp, char *buffer, size_t buflen)
 
 	SubscriberData *sd = (SubscriberData *)filp_to_sd(filp);
 
+#ifdef ORB_DEVICENODE_SEQLOCK
+	hrt_abstime last_update = 0;
+	copy_seqlock(buffer, sd->generation, &last_update);
+
+	// if subscriber has an interval track the last update time
+	if (sd->update_interval) {
+		sd->update_interval->last_update = last_update;
+	}
+
+#else
 	/*
 	 * Perform an atomic copy & state update
 	 */
@@ -224,6 +308,7 @@ uORB::DeviceNode::read(cdev::file_t *filp, char *buffer, size_t buflen)
 	}
 
 	ATOMIC_LEAVE;
+#endif /* ORB_DEVICENODE_SEQLOCK */
 
 	return _meta->o_size;
 }
@@ -274,6 +359,12 @@ uORB::DeviceNode::write(cdev::file_t *filp, const char *buffer, size_t buflen)
 
 	/* Perform an atomic copy. */
 	ATOMIC_ENTER;
+
+#ifdef ORB_DEVICENODE_SEQLOCK
+	/* odd sequence: lock-free readers retry until the write is complete */
+	_seq.fetch_add(1);
+#endif /* ORB_DEVICENODE_SEQLOCK */
+
 	/* wrap-around happens after ~49 days, assuming a publisher rate of 1 kHz */
 	unsigned generation = _generation.fetch_add(1);
 
@@ -282,6 +373,10 @@ uORB::DeviceNode::write(cdev::file_t *filp, const char *buffer, size_t buflen)
 	/* update the timestamp and generation count */
 	_last_update = hrt_absolute_time();
 
+#ifdef ORB_DEVICENODE_SEQLOCK
+	_seq.fetch_add(1);
+#endif /* ORB_DEVICENODE_SEQLOCK */
+
 
 	// callbacks
 	for (auto item : _callbacks) {
@@ -530,16 +625,16 @@ uORB::DeviceNode::appears_updated(SubscriberData *sd)
 bool
 uORB::DeviceNode::print_statistics(bool reset)
 {
-	if (!_lost_messages) {
+	if (!_lost_messages.load()) {
 		return false;
 	}
 
 	lock();
 	//This can be wrong: if a reader never reads, _lost_messages will not be increased either
-	uint32_t lost_messages = _lost_messages;
+	uint32_t lost_messages = _lost_messages.load();
 
 	if (reset) {
-		_lost_messages = 0;
+		_lost_messages.store(0);
 	}
 
 	unlock();
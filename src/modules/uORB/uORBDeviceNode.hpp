@@ -41,6 +41,16 @@
 #include <containers/List.hpp>
 #include <px4_platform_common/atomic.h>
 
+#if !defined(__PX4_NUTTX) && !defined(__PX4_QURT)
+/*
+ * On POSIX ATOMIC_ENTER takes the node lock, so subscribers copying data contend with the publisher.
+ * With the seqlock readers copy without the lock and retry if a publisher wrote concurrently.
+ * Publishers still serialize among each other (multi-publisher topics) and with callback
+ * registration through the lock. On NuttX ATOMIC_ENTER is a short critical section instead.
+ */
+#define ORB_DEVICENODE_SEQLOCK
+#endif
+
 namespace uORB
 {
 class DeviceNode;
@@ -186,7 +196,7 @@ public:
 
 	int8_t subscriber_count() const { return _subscriber_count; }
 
-	uint32_t lost_message_count() const { return _lost_messages; }
+	uint32_t lost_message_count() const { return _lost_messages.load(); }
 
 	unsigned published_message_count() const { return _generation.load(); }
 
@@ -254,6 +264,30 @@ private:
 	 */
 	bool copy_locked(void *dst, unsigned &generation);
 
+	/**
+	 * Copies the queue entry for generation to dst and advances generation.
+	 * Caller handles locking (or validation in case of the seqlock).
+	 *
+	 * @param current_generation
+	 *   The published generation to copy against.
+	 * @return
+	 *   Number of messages the reader lost.
+	 */
+	unsigned copy_from_queue(void *dst, unsigned &generation, unsigned current_generation) const;
+
+#ifdef ORB_DEVICENODE_SEQLOCK
+	/**
+	 * Lock-free variant of copy_locked(). Retries if a publisher wrote concurrently and falls back
+	 * to the locked copy after SEQLOCK_MAX_RETRIES (e.g. if the publisher got preempted while writing).
+	 *
+	 * @param last_update
+	 *   If not null, set to the time of the last update that was consistent with the copy.
+	 */
+	bool copy_seqlock(void *dst, unsigned &generation, hrt_abstime *last_update);
+
+	static constexpr int SEQLOCK_MAX_RETRIES{3};
+#endif /* ORB_DEVICENODE_SEQLOCK */
+
 	struct UpdateIntervalData {
 		uint64_t last_update{0}; /**< time at which the last update was provided, used when update_interval is nonzero */
 		unsigned interval{0}; /**< if nonzero minimum interval between updates */
@@ -271,6 +305,9 @@ private:
 	uint8_t     *_data{nullptr};   /**< allocated object buffer */
 	hrt_abstime   _last_update{0}; /**< time the object was last updated */
 	px4::atomic<unsigned>  _generation{0};  /**< object generation count */
+#ifdef ORB_DEVICENODE_SEQLOCK
+	px4::atomic<unsigned>  _seq{0};  /**< seqlock sequence, odd while a publisher is writing */
+#endif /* ORB_DEVICENODE_SEQLOCK */
 	List<uORB::SubscriptionCallback *>	_callbacks;
 	uint8_t   _priority;  /**< priority of the topic */
 	bool _advertised{false};  /**< has ever been advertised (not necessarily published data yet) */
@@ -278,7 +315,7 @@ private:
 	int8_t _subscriber_count{0};
 
 	// statistics
-	uint32_t _lost_messages = 0; /**< nr of lost messages for all subscribers. If two subscribers lose the same
+	px4::atomic<uint32_t> _lost_messages{0}; /**< nr of lost messages for all subscribers. If two subscribers lose the same
 					message, it is counted as two. */
 
 	inline static SubscriberData    *filp_to_sd(cdev::file_t *filp);
@@ -227,12 +227,14 @@ orb_advert_t uORB::Manager::orb_advertise_multi(const struct orb_metadata *meta,
 	uORB::DeviceNode::topic_advertised(meta, priority);
 #endif /* ORB_COMMUNICATOR */
 
-	/* the advertiser must perform an initial publish to initialise the object */
-	result = orb_publish(meta, advertiser, data);
+	/* the advertiser may perform an initial publish to initialise the object */
+	if (data != nullptr) {
+		result = orb_publish(meta, advertiser, data);
 
-	if (result == PX4_ERROR) {
-		PX4_WARN("orb_publish failed");
-		return nullptr;
+		if (result == PX4_ERROR) {
+			PX4_WARN("orb_publish failed");
+			return nullptr;
+		}
 	}
 
 	return advertiser;
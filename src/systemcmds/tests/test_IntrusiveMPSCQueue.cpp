@@ -0,0 +1,228 @@
+/****************************************************************************
+ *
+ *  Copyright (C) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include <unit_test.h>
+#include <containers/IntrusiveMPSCQueue.hpp>
+#include <pthread.h>
+#include <unistd.h>
+
+class testMPSCContainer : public IntrusiveMPSCQueueNode<testMPSCContainer *>
+{
+public:
+	int producer{0};
+	int i{0};
+};
+
+class IntrusiveMPSCQueueTest : public UnitTest
+{
+public:
+	virtual bool run_tests();
+
+	bool test_push_pop();
+	bool test_push_duplicate();
+	bool test_remove();
+	bool test_multiple_producers();
+
+};
+
+bool IntrusiveMPSCQueueTest::run_tests()
+{
+	ut_run_test(test_push_pop);
+	ut_run_test(test_push_duplicate);
+	ut_run_test(test_remove);
+	ut_run_test(test_multiple_producers);
+
+	return (_tests_failed == 0);
+}
+
+bool IntrusiveMPSCQueueTest::test_push_pop()
+{
+	IntrusiveMPSCQueue<testMPSCContainer *> q1;
+	testMPSCContainer nodes[100];
+
+	ut_assert_true(q1.empty());
+	ut_assert_true(q1.pop() == nullptr);
+
+	// insert 50, pop 25, insert 50 more
+	for (int i = 0; i < 50; i++) {
+		nodes[i].i = i;
+		ut_assert_true(q1.push(&nodes[i]));
+		ut_assert_true(q1.pending());
+	}
+
+	for (int i = 0; i < 25; i++) {
+		ut_compare("FIFO order", q1.pop()->i, i);
+	}
+
+	for (int i = 50; i < 100; i++) {
+		nodes[i].i = i;
+		ut_assert_true(q1.push(&nodes[i]));
+	}
+
+	// the remaining nodes come out in order
+	for (int i = 25; i < 100; i++) {
+		ut_assert_true(!q1.empty());
+		ut_compare("FIFO order", q1.pop()->i, i);
+	}
+
+	ut_assert_true(q1.empty());
+	ut_assert_true(!q1.pending());
+	ut_assert_true(q1.pop() == nullptr);
+
+	return true;
+}
+
+bool IntrusiveMPSCQueueTest::test_push_duplicate()
+{
+	IntrusiveMPSCQueue<testMPSCContainer *> q1;
+	testMPSCContainer nodes[3];
+
+	for (int i = 0; i < 3; i++) {
+		nodes[i].i = i;
+		ut_assert_true(q1.push(&nodes[i]));
+	}
+
+	// already queued, not inserted again
+	ut_assert_false(q1.push(&nodes[0]));
+	ut_assert_false(q1.push(&nodes[2]));
+
+	// a popped node can be pushed again
+	testMPSCContainer *head = q1.pop();
+	ut_compare("head", head->i, 0);
+	ut_assert_true(q1.push(head));
+
+	ut_compare("order", q1.pop()->i, 1);
+	ut_compare("order", q1.pop()->i, 2);
+	ut_compare("order", q1.pop()->i, 0);
+	ut_assert_true(q1.empty());
+
+	return true;
+}
+
+bool IntrusiveMPSCQueueTest::test_remove()
+{
+	IntrusiveMPSCQueue<testMPSCContainer *> q1;
+	testMPSCContainer nodes[10];
+
+	for (int i = 0; i < 10; i++) {
+		nodes[i].i = i;
+		q1.push(&nodes[i]);
+	}
+
+	// remove head, tail and one in the middle
+	ut_assert_true(q1.remove(&nodes[0]));
+	ut_assert_true(q1.remove(&nodes[9]));
+	ut_assert_true(q1.remove(&nodes[5]));
+	ut_assert_false(q1.remove(&nodes[5]));
+
+	// a removed node can be pushed again (goes to the back)
+	ut_assert_true(q1.push(&nodes[0]));
+
+	const int expected[] = {1, 2, 3, 4, 6, 7, 8, 0};
+
+	for (int i : expected) {
+		ut_compare("order after remove", q1.pop()->i, i);
+	}
+
+	ut_assert_true(q1.empty());
+
+	return true;
+}
+
+static constexpr int MPSC_PRODUCERS = 4;
+static constexpr int MPSC_NODES = 500;
+
+struct mpsc_producer_context {
+	IntrusiveMPSCQueue<testMPSCContainer *> *queue;
+	testMPSCContainer *nodes;
+};
+
+static void *mpsc_producer(void *arg)
+{
+	mpsc_producer_context *ctx = (mpsc_producer_context *)arg;
+
+	for (int i = 0; i < MPSC_NODES; i++) {
+		ctx->queue->push(&ctx->nodes[i]);
+	}
+
+	return nullptr;
+}
+
+bool IntrusiveMPSCQueueTest::test_multiple_producers()
+{
+	IntrusiveMPSCQueue<testMPSCContainer *> q1;
+	testMPSCContainer *nodes = new testMPSCContainer[MPSC_PRODUCERS * MPSC_NODES];
+	mpsc_producer_context ctx[MPSC_PRODUCERS];
+	pthread_t threads[MPSC_PRODUCERS];
+
+	for (int p = 0; p < MPSC_PRODUCERS; p++) {
+		ctx[p].queue = &q1;
+		ctx[p].nodes = &nodes[p * MPSC_NODES];
+
+		for (int i = 0; i < MPSC_NODES; i++) {
+			ctx[p].nodes[i].producer = p;
+			ctx[p].nodes[i].i = i;
+		}
+
+		ut_assert_true(pthread_create(&threads[p], nullptr, mpsc_producer, &ctx[p]) == 0);
+	}
+
+	// consume while the producers are running, the nodes of each producer must be in order
+	int next[MPSC_PRODUCERS] {};
+	int popped = 0;
+
+	while (popped < MPSC_PRODUCERS * MPSC_NODES) {
+		testMPSCContainer *node = q1.pop();
+
+		if (node == nullptr) {
+			usleep(100);
+			continue;
+		}
+
+		ut_compare("producer order", node->i, next[node->producer]);
+		next[node->producer]++;
+		popped++;
+	}
+
+	for (int p = 0; p < MPSC_PRODUCERS; p++) {
+		pthread_join(threads[p], nullptr);
+	}
+
+	ut_assert_true(q1.empty());
+	delete[] nodes;
+
+	return true;
+}
+
+ut_declare_test_c(test_IntrusiveMPSCQueue, IntrusiveMPSCQueueTest)
@@ -0,0 +1,174 @@
+/****************************************************************************
+ *
+ *  Copyright (C) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file test_WorkQueue.cpp
+ * Stress test of WorkItem scheduling against concurrent removal of the WorkItem.
+ */
+
+#include <unit_test.h>
+
+#include <pthread.h>
+
+#include <px4_platform_common/atomic.h>
+#include <px4_platform_common/time.h>
+#include <px4_platform_common/px4_work_queue/WorkItem.hpp>
+
+class StressWorkItem : public px4::WorkItem
+{
+public:
+	StressWorkItem() : WorkItem("wq_stress", px4::wq_configurations::test1) {}
+	~StressWorkItem() override = default;
+
+	void request_exit() { _exit_requested.store(true); }
+	bool exited() const { return _exited.load(); }
+	int runs_after_exit() const { return _runs_after_exit.load(); }
+
+private:
+	void Run() override
+	{
+		if (_exited.load()) {
+			// the item was left on the queue by a ScheduleNow() racing with Deinit()
+			_runs_after_exit.fetch_add(1);
+			return;
+		}
+
+		// detach from the queue while the producers keep scheduling it (like exit_and_cleanup())
+		if (_exit_requested.load()) {
+			Deinit();
+			_exited.store(true);
+		}
+	}
+
+	px4::atomic_bool _exit_requested{false};
+	px4::atomic_bool _exited{false};
+	px4::atomic_int _runs_after_exit{0};
+};
+
+class WorkQueueTest : public UnitTest
+{
+public:
+	virtual bool run_tests();
+
+	bool test_schedule_during_deinit();
+};
+
+bool WorkQueueTest::run_tests()
+{
+	ut_run_test(test_schedule_during_deinit);
+
+	return (_tests_failed == 0);
+}
+
+static constexpr int STRESS_PRODUCERS = 2;
+static constexpr int STRESS_ROUNDS = 200;
+
+struct stress_context {
+	StressWorkItem *items[STRESS_ROUNDS] {};
+	px4::atomic_int current{-1};
+	px4::atomic_bool stop{false};
+};
+
+static void *stress_producer(void *arg)
+{
+	stress_context *ctx = (stress_context *)arg;
+
+	while (!ctx->stop.load()) {
+		const int current = ctx->current.load();
+
+		if (current >= 0) {
+			ctx->items[current]->ScheduleNow();
+		}
+	}
+
+	return nullptr;
+}
+
+bool WorkQueueTest::test_schedule_during_deinit()
+{
+	// keeps the work queue running while the stress items detach from it
+	StressWorkItem keeper;
+
+	stress_context ctx;
+	pthread_t threads[STRESS_PRODUCERS];
+
+	for (int p = 0; p < STRESS_PRODUCERS; p++) {
+		ut_assert_true(pthread_create(&threads[p], nullptr, stress_producer, &ctx) == 0);
+	}
+
+	bool exited = true;
+
+	for (int round = 0; (round < STRESS_ROUNDS) && exited; round++) {
+		ctx.items[round] = new StressWorkItem();
+		ctx.current.store(round);
+
+		px4_usleep(500);
+
+		ctx.items[round]->request_exit();
+		ctx.items[round]->ScheduleNow();
+
+		// the producers keep scheduling the item until it detached itself
+		for (int i = 0; (i < 1000) && !ctx.items[round]->exited(); i++) {
+			px4_usleep(100);
+		}
+
+		exited = ctx.items[round]->exited();
+	}
+
+	ctx.stop.store(true);
+
+	for (int p = 0; p < STRESS_PRODUCERS; p++) {
+		pthread_join(threads[p], nullptr);
+	}
+
+	ut_assert_true(exited);
+
+	// give the worker time to run anything left on the queue
+	px4_usleep(10000);
+
+	int runs_after_exit = 0;
+
+	for (int round = 0; round < STRESS_ROUNDS; round++) {
+		if (ctx.items[round] != nullptr) {
+			runs_after_exit += ctx.items[round]->runs_after_exit();
+			delete ctx.items[round];
+		}
+	}
+
+	ut_compare("runs after Deinit()", runs_after_exit, 0);
+
+	return true;
+}
+
+ut_declare_test_c(test_WorkQueue, WorkQueueTest)
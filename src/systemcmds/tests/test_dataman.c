@@ -43,6 +43,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -154,13 +155,122 @@ fail:
 	return -1;
 }
 
+static int
+test_range(void)
+{
+	struct mission_item_s *items = (struct mission_item_s *)calloc(NUM_MISSIONS_TEST, sizeof(struct mission_item_s));
+	struct mission_item_s item;
+	int result = -1;
+
+	if (items == NULL) {
+		PX4_ERR("alloc failed");
+		return -1;
+	}
+
+	for (int i = 0; i < NUM_MISSIONS_TEST; i++) {
+		items[i].nav_cmd = i;
+		items[i].altitude = i;
+	}
+
+	if (dm_write_range(DM_KEY_WAYPOINTS_OFFBOARD_1, 0, NUM_MISSIONS_TEST, DM_PERSIST_IN_FLIGHT_RESET, items,
+			   sizeof(struct mission_item_s)) != NUM_MISSIONS_TEST) {
+		PX4_ERR("range write failed");
+		goto out;
+	}
+
+	/* single item reads see the items of the range */
+	for (int i = 0; i < NUM_MISSIONS_TEST; i++) {
+		if (dm_read(DM_KEY_WAYPOINTS_OFFBOARD_1, i, &item, sizeof(item)) != sizeof(item) || item.nav_cmd != i) {
+			PX4_ERR("range write verification failed, index %d", i);
+			goto out;
+		}
+	}
+
+	/* an item with a different length ends the range read */
+	if (dm_write(DM_KEY_WAYPOINTS_OFFBOARD_1, NUM_MISSIONS_TEST / 2, DM_PERSIST_IN_FLIGHT_RESET, &item, 2) != 2) {
+		PX4_ERR("write failed");
+		goto out;
+	}
+
+	memset(items, 0, NUM_MISSIONS_TEST * sizeof(struct mission_item_s));
+
+	if (dm_read_range(DM_KEY_WAYPOINTS_OFFBOARD_1, 0, NUM_MISSIONS_TEST, items,
+			  sizeof(struct mission_item_s)) != NUM_MISSIONS_TEST / 2) {
+		PX4_ERR("range read failed");
+		goto out;
+	}
+
+	for (int i = 0; i < NUM_MISSIONS_TEST / 2; i++) {
+		if (items[i].nav_cmd != i || (int)items[i].altitude != i) {
+			PX4_ERR("range read verification failed, index %d", i);
+			goto out;
+		}
+	}
+
+	/* ranges beyond the last index are rejected */
+	if (dm_write_range(DM_KEY_WAYPOINTS_OFFBOARD_1, DM_KEY_WAYPOINTS_OFFBOARD_1_MAX - 1, 2, DM_PERSIST_IN_FLIGHT_RESET,
+			   items, sizeof(struct mission_item_s)) >= 0) {
+		PX4_ERR("range write beyond the last index failed");
+		goto out;
+	}
+
+	result = 0;
+
+out:
+	free(items);
+	return result;
+}
+
+/**
+ * Persistence across a restart of dataman: 'tests dataman persist_write <seed>', restart
+ * dataman, then 'tests dataman persist_check <seed>'. Each seed writes a different pattern.
+ */
+static int
+test_persist(bool write, int seed)
+{
+	struct mission_item_s item;
+
+	if (write && dm_clear(DM_KEY_WAYPOINTS_OFFBOARD_0) != 0) {
+		PX4_ERR("clear failed");
+		return -1;
+	}
+
+	for (int i = 0; i < NUM_MISSIONS_TEST; i++) {
+		if (write) {
+			memset(&item, 0, sizeof(item));
+			item.nav_cmd = seed * 100 + i;
+			item.altitude = seed;
+
+			if (dm_write(DM_KEY_WAYPOINTS_OFFBOARD_0, i, DM_PERSIST_POWER_ON_RESET, &item, sizeof(item)) != sizeof(item)) {
+				PX4_ERR("persist write failed, index %d", i);
+				return -1;
+			}
+
+		} else {
+			if (dm_read(DM_KEY_WAYPOINTS_OFFBOARD_0, i, &item, sizeof(item)) != sizeof(item)
+			    || item.nav_cmd != seed * 100 + i || (int)item.altitude != seed) {
+				PX4_ERR("persist check failed, index %d", i);
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
 int test_dataman(int argc, char *argv[])
 {
 	int i = 0;
 	unsigned num_tasks = 4;
 	char buffer[DM_MAX_DATA_SIZE];
 
-	if (argc > 1) {
+	if (argc > 2 && !strcmp(argv[1], "persist_write")) {
+		return test_persist(true, atoi(argv[2]));
+
+	} else if (argc > 2 && !strcmp(argv[1], "persist_check")) {
+		return test_persist(false, atoi(argv[2]));
+
+	} else if (argc > 1) {
 		num_tasks = atoi(argv[1]);
 	}
 
@@ -208,6 +318,10 @@ int test_dataman(int argc, char *argv[])
 		return -1;
 	}
 
+	if (test_range() != 0) {
+		return -1;
+	}
+
 	dm_restart(DM_INIT_REASON_IN_FLIGHT);
 
 	for (i = 0; i < NUM_MISSIONS_TEST; i++) {
@@ -0,0 +1,272 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2020 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file test_microbench_filter.cpp
+ * Microbenchmark of the scalar and block (SIMD) filters on 3 axis FIFO sized blocks.
+ */
+
+#include <unit_test.h>
+
+#include <time.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <drivers/drv_hrt.h>
+#include <perf/perf_counter.h>
+#include <px4_platform_common/px4_config.h>
+#include <px4_platform_common/micro_hal.h>
+
+#include <lib/mathlib/math/filter/LowPassFilter2p.hpp>
+#include <lib/mathlib/math/filter/LowPassFilter2pArray.hpp>
+#include <lib/mathlib/math/filter/LowPassFilter2pVector3f.hpp>
+#include <lib/mathlib/math/filter/NotchFilter.hpp>
+#include <lib/mathlib/math/filter/NotchFilterArray.hpp>
+#include <matrix/math.hpp>
+
+namespace MicroBenchFilter
+{
+
+#ifdef __PX4_NUTTX
+#include <nuttx/irq.h>
+static irqstate_t flags;
+#endif
+
+void lock()
+{
+#ifdef __PX4_NUTTX
+	flags = px4_enter_critical_section();
+#endif
+}
+
+void unlock()
+{
+#ifdef __PX4_NUTTX
+	px4_leave_critical_section(flags);
+#endif
+}
+
+#define PERF(name, op, count) do { \
+		px4_usleep(1000); \
+		reset(); \
+		perf_counter_t p = perf_alloc(PC_ELAPSED, name); \
+		for (int i = 0; i < count; i++) { \
+			lock(); \
+			perf_begin(p); \
+			op; \
+			perf_end(p); \
+			unlock(); \
+			reset(); \
+		} \
+		perf_print_counter(p); \
+		perf_free(p); \
+	} while (0)
+
+static constexpr float SAMPLE_RATE = 8000.f;
+static constexpr int NUM_SAMPLES = 32;	// samples per axis in one block (sensor_gyro_fifo)
+static constexpr int NUM_HARMONICS = 4;	// notch bank size
+
+class MicroBenchFilter : public UnitTest
+{
+public:
+	virtual bool run_tests();
+
+private:
+	bool time_notch();
+	bool time_low_pass();
+	bool time_notch_bank();
+
+	void reset();
+
+	void notchVector3f();
+	void notchArray();
+	void notchArray4();
+
+	void lowPassVector3f();
+	void lowPassArray();
+	void lowPassArray4();
+
+	void notchBankArray();
+	void notchBankArray4();
+
+	// the same data in the layouts used by the different filters
+	matrix::Vector3f _samples_vector3f[NUM_SAMPLES];
+	float _samples_axis[3][NUM_SAMPLES];	// structure of arrays
+	float _samples_interleaved[NUM_SAMPLES * 4];	// x, y, z and one unused channel per sample
+
+	math::NotchFilter<matrix::Vector3f> _notch_vector3f;
+	math::NotchFilterArray<float> _notch_array[3];
+	math::NotchFilterArray4 _notch_array4;
+
+	math::LowPassFilter2pVector3f _lpf_vector3f{SAMPLE_RATE, 30.f};
+	math::LowPassFilter2p _lpf_array[3] {{SAMPLE_RATE, 30.f}, {SAMPLE_RATE, 30.f}, {SAMPLE_RATE, 30.f}};
+	math::LowPassFilter2pArray4 _lpf_array4{SAMPLE_RATE, 30.f};
+
+	math::NotchFilterArray<float> _notch_bank_array[NUM_HARMONICS][3];
+	math::NotchFilterArray4 _notch_bank_array4[NUM_HARMONICS];
+};
+
+bool MicroBenchFilter::run_tests()
+{
+	_notch_vector3f.setParameters(SAMPLE_RATE, 200.f, 30.f);
+	_notch_array4.setParameters(SAMPLE_RATE, 200.f, 30.f);
+
+	for (int axis = 0; axis < 3; axis++) {
+		_notch_array[axis].setParameters(SAMPLE_RATE, 200.f, 30.f);
+	}
+
+	for (int harmonic = 0; harmonic < NUM_HARMONICS; harmonic++) {
+		const float notch_freq = 200.f * (harmonic + 1);
+
+		for (int axis = 0; axis < 3; axis++) {
+			_notch_bank_array[harmonic][axis].setParameters(SAMPLE_RATE, notch_freq, 30.f);
+		}
+
+		_notch_bank_array4[harmonic].setParameters(SAMPLE_RATE, notch_freq, 30.f);
+	}
+
+	ut_run_test(time_notch);
+	ut_run_test(time_low_pass);
+	ut_run_test(time_notch_bank);
+
+	return (_tests_failed == 0);
+}
+
+template<typename T>
+T random(T min, T max)
+{
+	const T scale = rand() / (T) RAND_MAX; /* [0, 1.0] */
+	return min + scale * (max - min);      /* [min, max] */
+}
+
+void MicroBenchFilter::reset()
+{
+	srand(time(nullptr));
+
+	// initialize with random data
+	for (int n = 0; n < NUM_SAMPLES; n++) {
+		for (int axis = 0; axis < 3; axis++) {
+			const float sample = random(-10.f, 10.f);
+			_samples_vector3f[n](axis) = sample;
+			_samples_axis[axis][n] = sample;
+			_samples_interleaved[4 * n + axis] = sample;
+		}
+
+		_samples_interleaved[4 * n + 3] = 0.f;
+	}
+}
+
+ut_declare_test_c(test_microbench_filter, MicroBenchFilter)
+
+void MicroBenchFilter::notchVector3f()
+{
+	for (int n = 0; n < NUM_SAMPLES; n++) {
+		_samples_vector3f[n] = _notch_vector3f.apply(_samples_vector3f[n]);
+	}
+}
+
+void MicroBenchFilter::notchArray()
+{
+	for (int axis = 0; axis < 3; axis++) {
+		_notch_array[axis].apply(_samples_axis[axis], NUM_SAMPLES);
+	}
+}
+
+void MicroBenchFilter::notchArray4()
+{
+	_notch_array4.applyArray(_samples_interleaved, NUM_SAMPLES);
+}
+
+void MicroBenchFilter::lowPassVector3f()
+{
+	for (int n = 0; n < NUM_SAMPLES; n++) {
+		_samples_vector3f[n] = _lpf_vector3f.apply(_samples_vector3f[n]);
+	}
+}
+
+void MicroBenchFilter::lowPassArray()
+{
+	for (int axis = 0; axis < 3; axis++) {
+		_lpf_array[axis].applyArray(_samples_axis[axis], NUM_SAMPLES);
+	}
+}
+
+void MicroBenchFilter::lowPassArray4()
+{
+	_lpf_array4.applyArray(_samples_interleaved, NUM_SAMPLES);
+}
+
+void MicroBenchFilter::notchBankArray()
+{
+	for (int harmonic = 0; harmonic < NUM_HARMONICS; harmonic++) {
+		for (int axis = 0; axis < 3; axis++) {
+			_notch_bank_array[harmonic][axis].apply(_samples_axis[axis], NUM_SAMPLES);
+		}
+	}
+}
+
+void MicroBenchFilter::notchBankArray4()
+{
+	for (int harmonic = 0; harmonic < NUM_HARMONICS; harmonic++) {
+		_notch_bank_array4[harmonic].applyArray(_samples_interleaved, NUM_SAMPLES);
+	}
+}
+
+bool MicroBenchFilter::time_notch()
+{
+	PERF("NotchFilter<Vector3f> 32 samples", notchVector3f(), 1000);
+	PERF("NotchFilterArray<float> 3x32 samples", notchArray(), 1000);
+	PERF("NotchFilterArray4 32 samples", notchArray4(), 1000);
+
+	return true;
+}
+
+bool MicroBenchFilter::time_low_pass()
+{
+	PERF("LowPassFilter2pVector3f 32 samples", lowPassVector3f(), 1000);
+	PERF("LowPassFilter2p 3x32 samples", lowPassArray(), 1000);
+	PERF("LowPassFilter2pArray4 32 samples", lowPassArray4(), 1000);
+
+	return true;
+}
+
+bool MicroBenchFilter::time_notch_bank()
+{
+	PERF("NotchFilterArray<float> 4 harmonics 3x32 samples", notchBankArray(), 1000);
+	PERF("NotchFilterArray4 4 harmonics 32 samples", notchBankArray4(), 1000);
+
+	return true;
+}
+
+} // namespace MicroBenchFilter
@@ -46,13 +46,26 @@
 #include <perf/perf_counter.h>
 #include <px4_platform_common/px4_config.h>
 #include <px4_platform_common/micro_hal.h>
+#include <px4_platform_common/atomic.h>
+#include <px4_platform_common/tasks.h>
 
+#include <uORB/Publication.hpp>
 #include <uORB/Subscription.hpp>
 #include <uORB/topics/sensor_accel.h>
 #include <uORB/topics/sensor_gyro.h>
 #include <uORB/topics/vehicle_local_position.h>
 #include <uORB/topics/vehicle_status.h>
 
+// test-only topic for the contention benchmark, so nothing is published into a live system topic
+struct orb_test_contention {
+	uint64_t timestamp;
+	int val;
+	char junk[64];
+};
+
+ORB_DEFINE(orb_test_contention, struct orb_test_contention, sizeof(orb_test_contention),
+	   "ORB_TEST_CONTENTION:uint64_t timestamp;int val;char[64] junk;", static_cast<uint8_t>(ORB_ID::INVALID));
+
 namespace MicroBenchORB
 {
 
@@ -100,9 +113,15 @@ private:
 
 	bool time_px4_uorb();
 	bool time_px4_uorb_direct();
+	bool time_px4_uorb_contention();
 
 	void reset();
 
+	static int contention_publisher_main(int argc, char *argv[]);
+	static int contention_subscriber_main(int argc, char *argv[]);
+
+	static px4::atomic_bool _contention_run;
+
 	vehicle_status_s status;
 	vehicle_local_position_s lpos;
 	sensor_gyro_s gyro;
@@ -112,10 +131,13 @@ bool MicroBenchORB::run_tests()
 {
 	ut_run_test(time_px4_uorb);
 	ut_run_test(time_px4_uorb_direct);
+	ut_run_test(time_px4_uorb_contention);
 
 	return (_tests_failed == 0);
 }
 
+px4::atomic_bool MicroBenchORB::_contention_run{false};
+
 template<typename T>
 T random(T min, T max)
 {
@@ -205,4 +227,78 @@ bool MicroBenchORB::time_px4_uorb_direct()
 	return true;
 }
 
+int MicroBenchORB::contention_publisher_main(int argc, char *argv[])
+{
+	uORB::Publication<orb_test_contention> test_pub{ORB_ID(orb_test_contention)};
+	orb_test_contention test{};
+
+	while (_contention_run.load()) {
+		test.timestamp = hrt_absolute_time();
+		test.val++;
+		test_pub.publish(test);
+		px4_usleep(100);
+	}
+
+	return 0;
+}
+
+int MicroBenchORB::contention_subscriber_main(int argc, char *argv[])
+{
+	uORB::Subscription test_sub{ORB_ID(orb_test_contention)};
+	orb_test_contention test{};
+
+	while (_contention_run.load()) {
+		test_sub.copy(&test);
+		px4_usleep(100);
+	}
+
+	return 0;
+}
+
+bool MicroBenchORB::time_px4_uorb_contention()
+{
+	static constexpr int NUM_SUBSCRIBERS = 4;
+
+	bool ret = false;
+
+	// subscribers copying while a publisher is active
+	_contention_run.store(true);
+
+	if (px4_task_spawn_cmd("ubench_pub", SCHED_DEFAULT, SCHED_PRIORITY_DEFAULT, 1500,
+			       (px4_main_t)&MicroBenchORB::contention_publisher_main, nullptr) < 0) {
+		PX4_ERR("task spawn failed");
+		return false;
+	}
+
+	orb_test_contention test{};
+
+	uORB::Subscription test_sub{ORB_ID(orb_test_contention)};
+	PERF("contention uORB::Subscription orb_copy orb_test_contention (1 publisher)", ret = test_sub.copy(&test), 1000);
+
+	_contention_run.store(false);
+	px4_usleep(10000);
+
+	printf("\n");
+
+	// publishing while several subscribers are copying
+	_contention_run.store(true);
+
+	for (int i = 0; i < NUM_SUBSCRIBERS; i++) {
+		if (px4_task_spawn_cmd("ubench_sub", SCHED_DEFAULT, SCHED_PRIORITY_DEFAULT, 1500,
+				       (px4_main_t)&MicroBenchORB::contention_subscriber_main, nullptr) < 0) {
+			PX4_ERR("task spawn failed");
+			_contention_run.store(false);
+			return false;
+		}
+	}
+
+	uORB::Publication<orb_test_contention> test_pub{ORB_ID(orb_test_contention)};
+	PERF("contention uORB::Publication publish orb_test_contention (4 subscribers)", ret = test_pub.publish(test), 1000);
+
+	_contention_run.store(false);
+	px4_usleep(10000);
+
+	return ret;
+}
+
 } // namespace MicroBenchORB
@@ -75,6 +75,8 @@ private:
 
 	// tests on the test parameters (TEST_RC_X, TEST_RC2_X, TEST_1, TEST_2, TEST_3)
 	bool SimpleFind();
+	bool FindAll();
+	bool ResetSingle();
 	bool ResetAll();
 	bool ResetAllExcludesOne();
 	bool ResetAllExcludesTwo();
@@ -139,6 +141,52 @@ bool ParameterTest::SimpleFind()
 	return true;
 }
 
+bool ParameterTest::FindAll()
+{
+	// every parameter must be found by its own name
+	for (param_t param = 0; param < param_count(); param++) {
+		const char *name = param_name(param);
+		ut_assert_true(name != nullptr);
+		ut_compare("param_find returned wrong handle", param, param_find_no_notification(name));
+	}
+
+	// names not in the list must not match another parameter
+	ut_assert_true(PARAM_INVALID == param_find_no_notification(""));
+	ut_assert_true(PARAM_INVALID == param_find_no_notification("TEST_"));
+	ut_assert_true(PARAM_INVALID == param_find_no_notification("TEST_22"));
+	ut_assert_true(PARAM_INVALID == param_find_no_notification("test_2"));
+
+	return true;
+}
+
+bool ParameterTest::ResetSingle()
+{
+	int32_t value = 50;
+	param_set(p0, &value);
+	value = 51;
+	param_set(p1, &value);
+	value = 52;
+	param_set(p2, &value);
+
+	// removing a modified value must not affect the others
+	param_reset(p0);
+
+	ut_assert_true(param_value_is_default(p0));
+	ut_assert_true(!param_value_is_default(p1));
+	ut_assert_true(!param_value_is_default(p2));
+	ut_assert_true(param_value_is_default(p3));
+
+	// every value has to match (each check reports its own failure)
+	bool ret = _assert_parameter_int_value(p0, 8);
+	ret &= _assert_parameter_int_value(p1, 51);
+	ret &= _assert_parameter_int_value(p2, 52);
+	ret &= _assert_parameter_int_value(p3, 4);
+
+	param_reset_all();
+
+	return ret;
+}
+
 bool ParameterTest::ResetAll()
 {
 	_set_all_int_parameters_to(50);
@@ -539,6 +587,8 @@ bool ParameterTest::run_tests()
 
 	ut_run_test(ResetAll);
 	ut_run_test(SimpleFind);
+	ut_run_test(FindAll);
+	ut_run_test(ResetSingle);
 	ut_run_test(ResetAll);
 	ut_run_test(ResetAllExcludesOne);
 	ut_run_test(ResetAllExcludesTwo);
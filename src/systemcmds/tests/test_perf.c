@@ -48,8 +48,9 @@ test_perf(int argc, char *argv[])
 {
 	perf_counter_t cc = perf_alloc(PC_COUNT, "test_count");
 	perf_counter_t ec = perf_alloc(PC_ELAPSED, "test_elapsed");
+	perf_counter_t hc = perf_alloc(PC_HISTOGRAM, "test_histogram");
 
-	if ((cc == NULL) || (ec == NULL)) {
+	if ((cc == NULL) || (ec == NULL) || (hc == NULL)) {
 		printf("perf: counter alloc failed\n");
 		return 1;
 	}
@@ -64,11 +65,25 @@ test_perf(int argc, char *argv[])
 	perf_end(ec);
 	printf("perf: expect count of 1\n");
 	perf_print_counter(ec);
-	printf("perf: expect at least two counters\n");
+
+	for (int i = 1; i <= 100; i++) {
+		perf_set_elapsed(hc, i);
+	}
+
+	printf("perf: expect 100 events, p50 50us p99 99us max 100us (+-12.5%%)\n");
+	perf_print_counter(hc);
+
+	if (perf_event_count(hc) != 100) {
+		printf("perf: histogram count wrong\n");
+		return 1;
+	}
+
+	printf("perf: expect at least three counters\n");
 	perf_print_all(1);
 
 	perf_free(cc);
 	perf_free(ec);
+	perf_free(hc);
 
 	return OK;
 }
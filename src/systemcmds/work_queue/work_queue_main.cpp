@@ -36,6 +36,8 @@
 #include <px4_platform_common/getopt.h>
 #include <px4_platform_common/px4_work_queue/WorkQueueManager.hpp>
 
+#include <stdlib.h>
+
 static void	usage();
 
 extern "C" {
@@ -45,7 +47,7 @@ extern "C" {
 int
 work_queue_main(int argc, char *argv[])
 {
-	if (argc != 2) {
+	if (argc < 2) {
 		usage();
 		return 1;
 	}
@@ -61,6 +63,26 @@ work_queue_main(int argc, char *argv[])
 	} else if (!strcmp(argv[1], "status")) {
 		px4::WorkQueueManagerStatus();
 		return 0;
+
+	} else if (!strcmp(argv[1], "isolate") && argc == 3) {
+		// comma separated list of CPUs, e.g. 2,3
+		uint32_t cpus = 0;
+		char *cpu_list = argv[2];
+
+		while (*cpu_list != '\0') {
+			char *end = nullptr;
+			const long cpu = strtol(cpu_list, &end, 10);
+
+			if (end == cpu_list || cpu < 0 || cpu > 31 || (*end != ',' && *end != '\0')) {
+				PX4_ERR("invalid cpu list: %s", argv[2]);
+				return 1;
+			}
+
+			cpus |= 1u << cpu;
+			cpu_list = (*end == ',') ? end + 1 : end;
+		}
+
+		return (px4::WorkQueueManagerIsolateCpus(cpus) == PX4_OK) ? 0 : 1;
 	}
 
 	usage();
@@ -78,9 +100,21 @@ usage()
 
 Command-line tool to show work queue status.
 
+The status shows the run latency of each work queue (time from scheduling a work item until it runs) and its jitter
+(standard deviation of the latency).
+
+On Linux, 'isolate' reserves CPUs for the real-time work queues (rate_ctrl, SPI, I2C, att_pos_ctrl and INS). All other
+threads are moved to the remaining CPUs. It should be called early in the startup script.
+
+### Examples
+Run the real-time work queues on CPUs 2 and 3:
+$ work_queue isolate 2,3
+
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("work_queue", "system");
 	PRINT_MODULE_USAGE_COMMAND("start");
+	PRINT_MODULE_USAGE_COMMAND_DESCR("isolate", "Reserve CPUs for the real-time work queues (Linux only)");
+	PRINT_MODULE_USAGE_ARG("<cpus>", "Comma separated list of CPUs", false);
 	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
 }